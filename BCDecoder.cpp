@@ -0,0 +1,803 @@
+#include "BCDecoder.h"
+#include "HalfFloat.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BC_USE_SSE2 1
+#endif
+
+// The float formats reproduce DirectXTex's arithmetic step by step (same
+// constants, same operation order), so the decoder must not be compiled with
+// floating point contraction into FMA instructions.
+
+namespace {
+
+uint16_t ReadU16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+uint32_t ReadU32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t ReadU64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/**
+ * @brief Reads little-endian bit fields from a 128-bit block.
+ */
+class BitReader {
+public:
+  explicit BitReader(const uint8_t *block)
+      : m_lo(ReadU64(block)), m_hi(ReadU64(block + 8)) {}
+
+  uint32_t Read(int count) {
+    uint64_t bits;
+    if (m_pos >= 64)
+      bits = m_hi >> (m_pos - 64);
+    else if (m_pos + count <= 64)
+      bits = m_lo >> m_pos;
+    else
+      bits = (m_lo >> m_pos) | (m_hi << (64 - m_pos));
+    m_pos += count;
+    return (uint32_t)bits & ((1u << count) - 1);
+  }
+
+  int GetPosition() const { return m_pos; }
+
+private:
+  uint64_t m_lo;
+  uint64_t m_hi;
+  int m_pos = 0;
+};
+
+// ---- BC1-BC5 ----
+
+void Decode565(uint16_t color, float *rgba) {
+  rgba[0] = (float)((color >> 11) & 31) * (1.0f / 31.0f);
+  rgba[1] = (float)((color >> 5) & 63) * (1.0f / 63.0f);
+  rgba[2] = (float)(color & 31) * (1.0f / 31.0f);
+  rgba[3] = 1.0f;
+}
+
+// Same form as XMVectorLerp: (c1 - c0) * t + c0
+void Lerp(const float *c0, const float *c1, float t, float *out) {
+  for (int i = 0; i < 4; i++)
+    out[i] = (c1[i] - c0[i]) * t + c0[i];
+}
+
+void DecodeBC1Colors(const uint8_t *block, bool punchThrough, float *rgba) {
+  uint16_t color0 = ReadU16(block);
+  uint16_t color1 = ReadU16(block + 2);
+
+  float palette[4][4];
+  Decode565(color0, palette[0]);
+  Decode565(color1, palette[1]);
+  if (punchThrough && color0 <= color1) {
+    Lerp(palette[0], palette[1], 0.5f, palette[2]);
+    memset(palette[3], 0, sizeof(palette[3])); // Transparent black
+  } else {
+    Lerp(palette[0], palette[1], 1.0f / 3.0f, palette[2]);
+    Lerp(palette[0], palette[1], 2.0f / 3.0f, palette[3]);
+  }
+
+  uint32_t indices = ReadU32(block + 4);
+  for (int i = 0; i < 16; i++, indices >>= 2)
+    memcpy(rgba + i * 4, palette[indices & 3], sizeof(palette[0]));
+}
+
+void DecodeBC2Alpha(const uint8_t *block, float *rgba) {
+  uint64_t alpha = ReadU64(block);
+  for (int i = 0; i < 16; i++, alpha >>= 4)
+    rgba[i * 4 + 3] = (float)(alpha & 0xf) * (1.0f / 15.0f);
+}
+
+void DecodeBC3Alpha(const uint8_t *block, float *rgba) {
+  float palette[8];
+  palette[0] = (float)block[0] * (1.0f / 255.0f);
+  palette[1] = (float)block[1] * (1.0f / 255.0f);
+  if (block[0] > block[1]) {
+    for (int i = 1; i < 7; i++)
+      palette[i + 1] =
+          (palette[0] * (float)(7 - i) + palette[1] * (float)i) * (1.0f / 7.0f);
+  } else {
+    for (int i = 1; i < 5; i++)
+      palette[i + 1] =
+          (palette[0] * (float)(5 - i) + palette[1] * (float)i) * (1.0f / 5.0f);
+    palette[6] = 0.0f;
+    palette[7] = 1.0f;
+  }
+
+  uint64_t indices = ReadU64(block) >> 16;
+  for (int i = 0; i < 16; i++, indices >>= 3)
+    rgba[i * 4 + 3] = palette[indices & 7];
+}
+
+/**
+ * @brief Decodes one BC4 channel into every 4th float of rgba.
+ */
+void DecodeBC4Channel(const uint8_t *block, bool isSigned, float *rgba) {
+  float palette[8];
+  if (isSigned) {
+    int8_t red0 = (int8_t)block[0];
+    int8_t red1 = (int8_t)block[1];
+    palette[0] = (float)(red0 == -128 ? -127 : red0) / 127.0f;
+    palette[1] = (float)(red1 == -128 ? -127 : red1) / 127.0f;
+    if (red0 > red1) {
+      for (int i = 1; i < 7; i++)
+        palette[i + 1] =
+            (palette[0] * (float)(7 - i) + palette[1] * (float)i) / 7.0f;
+    } else {
+      for (int i = 1; i < 5; i++)
+        palette[i + 1] =
+            (palette[0] * (float)(5 - i) + palette[1] * (float)i) / 5.0f;
+      palette[6] = -1.0f;
+      palette[7] = 1.0f;
+    }
+  } else {
+    palette[0] = (float)block[0] / 255.0f;
+    palette[1] = (float)block[1] / 255.0f;
+    if (block[0] > block[1]) {
+      for (int i = 1; i < 7; i++)
+        palette[i + 1] =
+            (palette[0] * (float)(7 - i) + palette[1] * (float)i) / 7.0f;
+    } else {
+      for (int i = 1; i < 5; i++)
+        palette[i + 1] =
+            (palette[0] * (float)(5 - i) + palette[1] * (float)i) / 5.0f;
+      palette[6] = 0.0f;
+      palette[7] = 1.0f;
+    }
+  }
+
+  uint64_t indices = ReadU64(block) >> 16;
+  for (int i = 0; i < 16; i++, indices >>= 3)
+    rgba[i * 4] = palette[indices & 7];
+}
+
+// ---- BC6H / BC7 shared tables ----
+
+// Subset of each pixel for the 64 two-subset partitions, one bit per pixel
+const uint16_t g_Partitions2[64] = {
+    0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+    0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+    0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+    0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+    0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+    0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+    0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+    0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+};
+
+// Subset of each pixel for the 64 three-subset partitions
+const uint8_t g_Partitions3[64][16] = {
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+    {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+    {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2},
+    {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+    {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+    {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0},
+    {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0},
+    {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+    {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+    {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2},
+    {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0},
+    {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+    {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0},
+    {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1},
+    {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1},
+    {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+    {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2},
+    {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2},
+    {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+    {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+    {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1},
+    {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+// Anchor (fix-up) pixel of the second subset, two-subset partitions
+const uint8_t g_Anchors2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 2,  8,  2,  2,  8,  8,  15, 2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15, 6,  8,  2,  8,  15, 15, 2,  8,  2,  2,  2,  15, 15, 6,
+    6,  2,  6,  8,  15, 15, 2,  2,  15, 15, 15, 15, 15, 2,  2,  15,
+};
+
+// Anchor pixels of the second and third subsets, three-subset partitions
+const uint8_t g_Anchors3[2][64] = {
+    {3,  3, 15, 15, 8, 3,  15, 15, 8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3, 8,  15, 3, 3,  6,  10, 5,  8,  8,  6,  8,  5,  15, 15,
+     8,  15, 3, 5,  6, 10, 8,  15, 15, 3,  15, 5,  15, 15, 15, 15,
+     3,  15, 5, 5,  5, 8,  5,  10, 5,  10, 8,  13, 15, 12, 3,  3},
+    {15, 8,  8,  3,  15, 15, 3,  8,  15, 15, 15, 15, 15, 15, 15, 8,
+     15, 8,  15, 3,  15, 8,  15, 8,  3,  15, 6,  10, 15, 15, 10, 8,
+     15, 3,  15, 10, 10, 8,  9,  10, 6,  15, 8,  15, 3,  6,  6,  8,
+     15, 3,  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3,  15, 15, 8},
+};
+
+const int g_Weights2[4] = {0, 21, 43, 64};
+const int g_Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+const int g_Weights4[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                            34, 38, 43, 47, 51, 55, 60, 64};
+
+const int *GetWeights(int indexBits) {
+  return indexBits == 2 ? g_Weights2 : indexBits == 3 ? g_Weights3 : g_Weights4;
+}
+
+/**
+ * @brief Gets the subset of a pixel for a partition.
+ */
+int GetSubset(int subsetCount, int partition, int pixel) {
+  if (subsetCount == 2)
+    return (g_Partitions2[partition] >> pixel) & 1;
+  if (subsetCount == 3)
+    return g_Partitions3[partition][pixel];
+  return 0;
+}
+
+/**
+ * @brief Checks whether a pixel is a subset anchor, whose index has its top
+ * bit dropped.
+ */
+bool IsAnchor(int subsetCount, int partition, int pixel) {
+  if (pixel == 0)
+    return true;
+  if (subsetCount == 2)
+    return pixel == g_Anchors2[partition];
+  if (subsetCount == 3)
+    return pixel == g_Anchors3[0][partition] ||
+           pixel == g_Anchors3[1][partition];
+  return false;
+}
+
+/**
+ * @brief Reads 16 interpolation indices.
+ */
+void ReadIndices(BitReader &reader, int indexBits, int subsetCount,
+                 int partition, int *indices) {
+  for (int i = 0; i < 16; i++) {
+    int bits = IsAnchor(subsetCount, partition, i) ? indexBits - 1 : indexBits;
+    indices[i] = (int)reader.Read(bits);
+  }
+}
+
+// ---- BC7 ----
+
+struct BC7Mode {
+  int subsets;
+  int partitionBits;
+  int rotationBits;
+  int indexSelectionBits;
+  int colorBits;
+  int alphaBits;
+  int endpointPBits; // One p-bit per endpoint
+  int sharedPBits;   // One p-bit per subset
+  int indexBits;
+  int indexBits2;
+};
+
+const BC7Mode g_BC7Modes[8] = {
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0}, {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0}, {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3}, {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0}, {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+/**
+ * @brief Expands a quantized endpoint component to 8 bits.
+ */
+int Unquantize8(int value, int bits) {
+  value <<= 8 - bits;
+  return value | (value >> bits);
+}
+
+/**
+ * @brief Interpolates RGBA8 endpoints with separate color and alpha weights
+ * and stores the result as floats scaled by 1/255.
+ */
+void InterpolateBC7(const int *e0, const int *e1, int colorWeight,
+                    int alphaWeight, int rotation, float *out) {
+#ifdef BC_USE_SSE2
+  // Endpoints interleaved as 16-bit pairs; madd gives e0*(64-w) + e1*w
+  __m128i endpoints = _mm_setr_epi16(
+      (short)e0[0], (short)e1[0], (short)e0[1], (short)e1[1], (short)e0[2],
+      (short)e1[2], (short)e0[3], (short)e1[3]);
+  __m128i weights = _mm_setr_epi16(
+      (short)(64 - colorWeight), (short)colorWeight, (short)(64 - colorWeight),
+      (short)colorWeight, (short)(64 - colorWeight), (short)colorWeight,
+      (short)(64 - alphaWeight), (short)alphaWeight);
+  __m128i sum = _mm_add_epi32(_mm_madd_epi16(endpoints, weights),
+                              _mm_set1_epi32(32));
+  __m128i color = _mm_srai_epi32(sum, 6);
+  switch (rotation) { // Swap alpha with red, green or blue
+  case 1:
+    color = _mm_shuffle_epi32(color, _MM_SHUFFLE(0, 2, 1, 3));
+    break;
+  case 2:
+    color = _mm_shuffle_epi32(color, _MM_SHUFFLE(1, 2, 3, 0));
+    break;
+  case 3:
+    color = _mm_shuffle_epi32(color, _MM_SHUFFLE(2, 3, 1, 0));
+    break;
+  }
+  _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(color),
+                                _mm_set1_ps(1.0f / 255.0f)));
+#else
+  int c[4];
+  for (int i = 0; i < 4; i++) {
+    int w = i < 3 ? colorWeight : alphaWeight;
+    c[i] = (e0[i] * (64 - w) + e1[i] * w + 32) >> 6;
+  }
+  if (rotation > 0)
+    std::swap(c[3], c[rotation - 1]);
+  for (int i = 0; i < 4; i++)
+    out[i] = (float)c[i] * (1.0f / 255.0f);
+#endif
+}
+
+void DecodeBC7(const uint8_t *block, float *rgba) {
+  int mode = 0;
+  while (mode < 8 && !(block[0] & (1 << mode)))
+    mode++;
+  if (mode == 8) {
+    memset(rgba, 0, 16 * 4 * sizeof(float)); // Reserved mode
+    return;
+  }
+
+  const BC7Mode &info = g_BC7Modes[mode];
+  BitReader reader(block);
+  reader.Read(mode + 1);
+  int partition = (int)reader.Read(info.partitionBits);
+  int rotation = (int)reader.Read(info.rotationBits);
+  int indexSelection = (int)reader.Read(info.indexSelectionBits);
+
+  // Endpoints stored channel by channel, two per subset
+  int endpoints[6][4];
+  int endpointCount = info.subsets * 2;
+  for (int c = 0; c < 3; c++) {
+    for (int e = 0; e < endpointCount; e++)
+      endpoints[e][c] = (int)reader.Read(info.colorBits);
+  }
+  for (int e = 0; e < endpointCount; e++)
+    endpoints[e][3] = info.alphaBits ? (int)reader.Read(info.alphaBits) : 255;
+
+  int colorBits = info.colorBits;
+  int alphaBits = info.alphaBits;
+  if (info.endpointPBits || info.sharedPBits) {
+    int pBits[6];
+    if (info.endpointPBits) {
+      for (int e = 0; e < endpointCount; e++)
+        pBits[e] = (int)reader.Read(1);
+    } else {
+      for (int s = 0; s < info.subsets; s++)
+        pBits[s * 2] = pBits[s * 2 + 1] = (int)reader.Read(1);
+    }
+    for (int e = 0; e < endpointCount; e++) {
+      for (int c = 0; c < 3; c++)
+        endpoints[e][c] = (endpoints[e][c] << 1) | pBits[e];
+      if (info.alphaBits)
+        endpoints[e][3] = (endpoints[e][3] << 1) | pBits[e];
+    }
+    colorBits++;
+    if (alphaBits)
+      alphaBits++;
+  }
+
+  for (int e = 0; e < endpointCount; e++) {
+    for (int c = 0; c < 3; c++)
+      endpoints[e][c] = Unquantize8(endpoints[e][c], colorBits);
+    if (alphaBits)
+      endpoints[e][3] = Unquantize8(endpoints[e][3], alphaBits);
+  }
+
+  int indices[16];
+  int indices2[16];
+  ReadIndices(reader, info.indexBits, info.subsets, partition, indices);
+  if (info.indexBits2)
+    ReadIndices(reader, info.indexBits2, 1, 0, indices2);
+
+  const int *weights = GetWeights(info.indexBits);
+  const int *weights2 = info.indexBits2 ? GetWeights(info.indexBits2) : weights;
+  for (int i = 0; i < 16; i++) {
+    int subset = GetSubset(info.subsets, partition, i);
+    int colorWeight = weights[indices[i]];
+    int alphaWeight = colorWeight;
+    if (info.indexBits2) {
+      alphaWeight = weights2[indices2[i]];
+      if (indexSelection)
+        std::swap(colorWeight, alphaWeight);
+    }
+    InterpolateBC7(endpoints[subset * 2], endpoints[subset * 2 + 1],
+                   colorWeight, alphaWeight, rotation, rgba + i * 4);
+  }
+}
+
+// ---- BC6H ----
+
+// Endpoint components: w/x are subset 0, y/z subset 1
+enum BC6HField : uint8_t {
+  RW, GW, BW, RX, GX, BX, RY, GY, BY, RZ, GZ, BZ, D, End
+};
+
+// A run of header bits: `count` bits of `field` starting at bit `shift`
+struct BC6HBits {
+  uint8_t field;
+  uint8_t shift;
+  uint8_t count;
+};
+
+struct BC6HMode {
+  uint8_t mode;       // Value of the 2 or 5 mode bits
+  uint8_t modeBits;
+  bool transformed;   // Endpoints after the first are deltas
+  int subsets;
+  int endpointBits;
+  int deltaBits[3];
+  BC6HBits layout[40];
+};
+
+// Header layouts from the BC6H specification, in stream order
+const BC6HMode g_BC6HModes[14] = {
+    {0x00, 2, true, 2, 10, {5, 5, 5},
+     {{GY, 4, 1}, {BY, 4, 1}, {BZ, 4, 1}, {RW, 0, 10}, {GW, 0, 10},
+      {BW, 0, 10}, {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5},
+      {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4},
+      {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}, {End, 0, 0}}},
+    {0x01, 2, true, 2, 7, {6, 6, 6},
+     {{GY, 5, 1}, {GZ, 4, 1}, {GZ, 5, 1}, {RW, 0, 7}, {BZ, 0, 1},
+      {BZ, 1, 1}, {BY, 4, 1}, {GW, 0, 7}, {BY, 5, 1}, {BZ, 2, 1},
+      {GY, 4, 1}, {BW, 0, 7}, {BZ, 3, 1}, {BZ, 5, 1}, {BZ, 4, 1},
+      {RX, 0, 6}, {GY, 0, 4}, {GX, 0, 6}, {GZ, 0, 4}, {BX, 0, 6},
+      {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}, {D, 0, 5}, {End, 0, 0}}},
+    {0x02, 5, true, 2, 11, {5, 4, 4},
+     {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 5}, {RW, 10, 1},
+      {GY, 0, 4}, {GX, 0, 4}, {GW, 10, 1}, {BZ, 0, 1}, {GZ, 0, 4},
+      {BX, 0, 4}, {BW, 10, 1}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5},
+      {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}, {End, 0, 0}}},
+    {0x06, 5, true, 2, 11, {4, 5, 4},
+     {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 10, 1},
+      {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5}, {GW, 10, 1}, {GZ, 0, 4},
+      {BX, 0, 4}, {BW, 10, 1}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 4},
+      {BZ, 0, 1}, {BZ, 2, 1}, {RZ, 0, 4}, {GY, 4, 1}, {BZ, 3, 1},
+      {D, 0, 5}, {End, 0, 0}}},
+    {0x0a, 5, true, 2, 11, {4, 4, 5},
+     {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 10, 1},
+      {BY, 4, 1}, {GY, 0, 4}, {GX, 0, 4}, {GW, 10, 1}, {BZ, 0, 1},
+      {GZ, 0, 4}, {BX, 0, 5}, {BW, 10, 1}, {BY, 0, 4}, {RY, 0, 4},
+      {BZ, 1, 1}, {BZ, 2, 1}, {RZ, 0, 4}, {BZ, 4, 1}, {BZ, 3, 1},
+      {D, 0, 5}, {End, 0, 0}}},
+    {0x0e, 5, true, 2, 9, {5, 5, 5},
+     {{RW, 0, 9}, {BY, 4, 1}, {GW, 0, 9}, {GY, 4, 1}, {BW, 0, 9},
+      {BZ, 4, 1}, {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5},
+      {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4},
+      {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}, {End, 0, 0}}},
+    {0x12, 5, true, 2, 8, {6, 5, 5},
+     {{RW, 0, 8}, {GZ, 4, 1}, {BY, 4, 1}, {GW, 0, 8}, {BZ, 2, 1},
+      {GY, 4, 1}, {BW, 0, 8}, {BZ, 3, 1}, {BZ, 4, 1}, {RX, 0, 6},
+      {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5},
+      {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}, {D, 0, 5}, {End, 0, 0}}},
+    {0x16, 5, true, 2, 8, {5, 6, 5},
+     {{RW, 0, 8}, {BZ, 0, 1}, {BY, 4, 1}, {GW, 0, 8}, {GY, 5, 1},
+      {GY, 4, 1}, {BW, 0, 8}, {GZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 5},
+      {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 6}, {GZ, 0, 4}, {BX, 0, 5},
+      {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5},
+      {BZ, 3, 1}, {D, 0, 5}, {End, 0, 0}}},
+    {0x1a, 5, true, 2, 8, {5, 5, 6},
+     {{RW, 0, 8}, {BZ, 1, 1}, {BY, 4, 1}, {GW, 0, 8}, {BY, 5, 1},
+      {GY, 4, 1}, {BW, 0, 8}, {BZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 5},
+      {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4},
+      {BX, 0, 6}, {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5},
+      {BZ, 3, 1}, {D, 0, 5}, {End, 0, 0}}},
+    {0x1e, 5, false, 2, 6, {6, 6, 6},
+     {{RW, 0, 6}, {GZ, 4, 1}, {BZ, 0, 1}, {BZ, 1, 1}, {BY, 4, 1},
+      {GW, 0, 6}, {GY, 5, 1}, {BY, 5, 1}, {BZ, 2, 1}, {GY, 4, 1},
+      {BW, 0, 6}, {GZ, 5, 1}, {BZ, 3, 1}, {BZ, 5, 1}, {BZ, 4, 1},
+      {RX, 0, 6}, {GY, 0, 4}, {GX, 0, 6}, {GZ, 0, 4}, {BX, 0, 6},
+      {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}, {D, 0, 5}, {End, 0, 0}}},
+    {0x03, 5, false, 1, 10, {10, 10, 10},
+     {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 10}, {GX, 0, 10},
+      {BX, 0, 10}, {End, 0, 0}}},
+    {0x07, 5, true, 1, 11, {9, 9, 9},
+     {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 9}, {RW, 10, 1},
+      {GX, 0, 9}, {GW, 10, 1}, {BX, 0, 9}, {BW, 10, 1}, {End, 0, 0}}},
+    // The high endpoint bits of the last two modes are stored reversed
+    {0x0b, 5, true, 1, 12, {8, 8, 8},
+     {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 8}, {RW, 11, 1},
+      {RW, 10, 1}, {GX, 0, 8}, {GW, 11, 1}, {GW, 10, 1}, {BX, 0, 8},
+      {BW, 11, 1}, {BW, 10, 1}, {End, 0, 0}}},
+    {0x0f, 5, true, 1, 16, {4, 4, 4},
+     {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 15, 1},
+      {RW, 14, 1}, {RW, 13, 1}, {RW, 12, 1}, {RW, 11, 1}, {RW, 10, 1},
+      {GX, 0, 4}, {GW, 15, 1}, {GW, 14, 1}, {GW, 13, 1}, {GW, 12, 1},
+      {GW, 11, 1}, {GW, 10, 1}, {BX, 0, 4}, {BW, 15, 1}, {BW, 14, 1},
+      {BW, 13, 1}, {BW, 12, 1}, {BW, 11, 1}, {BW, 10, 1}, {End, 0, 0}}},
+};
+
+int SignExtend(int value, int bits) {
+  int sign = 1 << (bits - 1);
+  return (value & sign) ? (value | ~((1 << bits) - 1)) : value;
+}
+
+int UnquantizeBC6H(int value, int bits, bool isSigned) {
+  if (isSigned) {
+    if (bits >= 16)
+      return value;
+    bool negative = value < 0;
+    if (negative)
+      value = -value;
+    int result;
+    if (value == 0)
+      result = 0;
+    else if (value >= (1 << (bits - 1)) - 1)
+      result = 0x7fff;
+    else
+      result = ((value << 15) + 0x4000) >> (bits - 1);
+    return negative ? -result : result;
+  }
+
+  if (bits >= 15 || value == 0)
+    return value;
+  if (value == (1 << bits) - 1)
+    return 0xffff;
+  return ((value << 16) + 0x8000) >> bits;
+}
+
+/**
+ * @brief Scales an interpolated value to half-float bits.
+ */
+uint16_t FinishUnquantizeBC6H(int value, bool isSigned) {
+  if (!isSigned)
+    return (uint16_t)((value * 31) >> 6);
+  if (value < 0)
+    return (uint16_t)(0x8000 | (((-value) * 31) >> 5));
+  return (uint16_t)((value * 31) >> 5);
+}
+
+void DecodeBC6H(const uint8_t *block, bool isSigned, float *rgba) {
+  int modeValue = block[0] & 3;
+  if (modeValue >= 2)
+    modeValue = block[0] & 0x1f;
+
+  const BC6HMode *info = nullptr;
+  for (const BC6HMode &mode : g_BC6HModes) {
+    if (mode.mode == modeValue) {
+      info = &mode;
+      break;
+    }
+  }
+
+  if (!info) {
+    // Reserved modes decode to opaque black
+    for (int i = 0; i < 16; i++) {
+      rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = 0.0f;
+      rgba[i * 4 + 3] = 1.0f;
+    }
+    return;
+  }
+
+  BitReader reader(block);
+  reader.Read(info->modeBits);
+
+  int fields[D + 1] = {};
+  for (const BC6HBits *bits = info->layout; bits->field != End; bits++)
+    fields[bits->field] |= (int)reader.Read(bits->count) << bits->shift;
+
+  // endpoints[subset * 2 + (0 = A, 1 = B)][channel]
+  int endpoints[4][3];
+  int endpointCount = info->subsets * 2;
+  for (int e = 0; e < endpointCount; e++) {
+    for (int c = 0; c < 3; c++)
+      endpoints[e][c] = fields[e * 3 + c];
+  }
+
+  for (int c = 0; c < 3; c++) {
+    if (isSigned)
+      endpoints[0][c] = SignExtend(endpoints[0][c], info->endpointBits);
+    if (isSigned || info->transformed) {
+      int bits = info->transformed ? info->deltaBits[c] : info->endpointBits;
+      for (int e = 1; e < endpointCount; e++)
+        endpoints[e][c] = SignExtend(endpoints[e][c], bits);
+    }
+    if (info->transformed) {
+      int mask = (1 << info->endpointBits) - 1;
+      for (int e = 1; e < endpointCount; e++) {
+        endpoints[e][c] = (endpoints[e][c] + endpoints[0][c]) & mask;
+        if (isSigned)
+          endpoints[e][c] = SignExtend(endpoints[e][c], info->endpointBits);
+      }
+    }
+    for (int e = 0; e < endpointCount; e++)
+      endpoints[e][c] =
+          UnquantizeBC6H(endpoints[e][c], info->endpointBits, isSigned);
+  }
+
+  int partition = info->subsets == 2 ? fields[D] : 0;
+  int indexBits = info->subsets == 2 ? 3 : 4;
+  int indices[16];
+  ReadIndices(reader, indexBits, info->subsets, partition, indices);
+
+  const int *weights = GetWeights(indexBits);
+  for (int i = 0; i < 16; i++) {
+    int subset = GetSubset(info->subsets, partition, i);
+    const int *e0 = endpoints[subset * 2];
+    const int *e1 = endpoints[subset * 2 + 1];
+    int w = weights[indices[i]];
+    for (int c = 0; c < 3; c++) {
+      int value = (e0[c] * (64 - w) + e1[c] * w + 32) >> 6;
+      rgba[i * 4 + c] = HalfToFloat(FinishUnquantizeBC6H(value, isSigned));
+    }
+    rgba[i * 4 + 3] = 1.0f;
+  }
+}
+
+} // namespace
+
+size_t GetBCBlockSize(BCFormat format) {
+  switch (format) {
+  case BCFormat::BC1:
+  case BCFormat::BC4U:
+  case BCFormat::BC4S:
+    return 8;
+  default:
+    return 16;
+  }
+}
+
+const char *GetBCFormatName(BCFormat format) {
+  switch (format) {
+  case BCFormat::BC1:
+    return "BC1";
+  case BCFormat::BC2:
+    return "BC2";
+  case BCFormat::BC3:
+    return "BC3";
+  case BCFormat::BC4U:
+    return "BC4";
+  case BCFormat::BC4S:
+    return "BC4 SNORM";
+  case BCFormat::BC5U:
+    return "BC5";
+  case BCFormat::BC5S:
+    return "BC5 SNORM";
+  case BCFormat::BC6HU:
+    return "BC6H UF16";
+  case BCFormat::BC6HS:
+    return "BC6H SF16";
+  case BCFormat::BC7:
+    return "BC7";
+  }
+  return "Unknown";
+}
+
+void DecodeBCBlock(BCFormat format, const uint8_t *block, float *rgba) {
+  switch (format) {
+  case BCFormat::BC1:
+    DecodeBC1Colors(block, true, rgba);
+    break;
+  case BCFormat::BC2:
+    DecodeBC1Colors(block + 8, false, rgba);
+    DecodeBC2Alpha(block, rgba);
+    break;
+  case BCFormat::BC3:
+    DecodeBC1Colors(block + 8, false, rgba);
+    DecodeBC3Alpha(block, rgba);
+    break;
+  case BCFormat::BC4U:
+  case BCFormat::BC4S:
+    for (int i = 0; i < 16; i++) {
+      rgba[i * 4 + 1] = rgba[i * 4 + 2] = 0.0f;
+      rgba[i * 4 + 3] = 1.0f;
+    }
+    DecodeBC4Channel(block, format == BCFormat::BC4S, rgba);
+    break;
+  case BCFormat::BC5U:
+  case BCFormat::BC5S:
+    for (int i = 0; i < 16; i++) {
+      rgba[i * 4 + 2] = 0.0f;
+      rgba[i * 4 + 3] = 1.0f;
+    }
+    DecodeBC4Channel(block, format == BCFormat::BC5S, rgba);
+    DecodeBC4Channel(block + 8, format == BCFormat::BC5S, rgba + 1);
+    break;
+  case BCFormat::BC6HU:
+  case BCFormat::BC6HS:
+    DecodeBC6H(block, format == BCFormat::BC6HS, rgba);
+    break;
+  case BCFormat::BC7:
+    DecodeBC7(block, rgba);
+    break;
+  }
+}
+
+bool DecodeBCRegion(BCFormat format, const uint8_t *blocks, size_t rowPitch,
+                    int width, int height, int x, int y, int regionWidth,
+                    int regionHeight, float *dst, int threadCount) {
+  PROFILE_SCOPE("DecodeBCRegion");
+  if (regionWidth <= 0 || regionHeight <= 0 || x < 0 || y < 0 ||
+      x + regionWidth > width || y + regionHeight > height)
+    return false;
+
+  size_t blockSize = GetBCBlockSize(format);
+  int blocksWide = (width + 3) / 4;
+  if (rowPitch == 0)
+    rowPitch = (size_t)blocksWide * blockSize;
+
+  int firstBlockX = x / 4;
+  int lastBlockX = (x + regionWidth - 1) / 4;
+  int firstBlockY = y / 4;
+  int lastBlockY = (y + regionHeight - 1) / 4;
+
+  ParallelFor(lastBlockY - firstBlockY + 1, threadCount, [&](int begin,
+                                                             int end) {
+    alignas(16) float decoded[16 * 4];
+    for (int by = firstBlockY + begin; by < firstBlockY + end; by++) {
+      const uint8_t *blockRow = blocks + (size_t)by * rowPitch;
+      int y0 = std::max(by * 4, y);
+      int y1 = std::min(by * 4 + 4, y + regionHeight);
+
+      for (int bx = firstBlockX; bx <= lastBlockX; bx++) {
+        DecodeBCBlock(format, blockRow + (size_t)bx * blockSize, decoded);
+
+        // Copy the part of the block inside the region
+        int x0 = std::max(bx * 4, x);
+        int x1 = std::min(bx * 4 + 4, x + regionWidth);
+        for (int py = y0; py < y1; py++) {
+          const float *src = decoded + ((py - by * 4) * 4 + (x0 - bx * 4)) * 4;
+          float *out = dst + ((size_t)(py - y) * regionWidth + (x0 - x)) * 4;
+          memcpy(out, src, (size_t)(x1 - x0) * 4 * sizeof(float));
+        }
+      }
+    }
+  });
+  return true;
+}
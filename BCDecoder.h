@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Block-compressed (BCn) formats understood by the decoder.
+ */
+enum class BCFormat {
+  BC1,   ///< RGB + 1-bit alpha, 8 bytes per block
+  BC2,   ///< BC1 color + explicit 4-bit alpha
+  BC3,   ///< BC1 color + interpolated alpha
+  BC4U,  ///< Single channel, unsigned
+  BC4S,  ///< Single channel, signed
+  BC5U,  ///< Two channels, unsigned
+  BC5S,  ///< Two channels, signed
+  BC6HU, ///< HDR RGB, unsigned half floats
+  BC6HS, ///< HDR RGB, signed half floats
+  BC7,   ///< High quality RGBA
+};
+
+/**
+ * @brief Gets the size of one 4x4 block in bytes (8 or 16).
+ */
+size_t GetBCBlockSize(BCFormat format);
+
+/**
+ * @brief Gets a short name (e.g., "BC7") for display.
+ */
+const char *GetBCFormatName(BCFormat format);
+
+/**
+ * @brief Decodes one 4x4 block into 16 RGBA32F pixels, row by row.
+ *
+ * Output matches DirectXTex's decoders bit for bit: unsigned formats are in
+ * [0, 1], signed BC4/BC5 in [-1, 1], BC6H gives half-float values. Channels a
+ * format does not store are 0 (color) and 1 (alpha).
+ */
+void DecodeBCBlock(BCFormat format, const uint8_t *block, float *rgba);
+
+/**
+ * @brief Decodes the blocks covering a region of a BCn surface to RGBA32F.
+ *
+ * Only block rows and columns that intersect the region are decoded, so a
+ * small visible window of a large texture costs only its own blocks. Block
+ * rows are split across threads.
+ *
+ * @param blocks Surface data, rows of ceil(width / 4) blocks.
+ * @param rowPitch Bytes between block rows (0 = tightly packed).
+ * @param width Surface width in pixels.
+ * @param height Surface height in pixels.
+ * @param x Left edge of the region.
+ * @param y Top edge of the region.
+ * @param regionWidth Region width; the region must lie inside the surface.
+ * @param regionHeight Region height.
+ * @param dst Receives regionWidth * regionHeight RGBA pixels.
+ * @param threadCount Number of threads to use (0 = hardware threads).
+ * @return False if the region is empty or outside the surface.
+ */
+bool DecodeBCRegion(BCFormat format, const uint8_t *blocks, size_t rowPitch,
+                    int width, int height, int x, int y, int regionWidth,
+                    int regionHeight, float *dst, int threadCount = 0);
+
+/**
+ * @brief Decodes a whole BCn surface to RGBA32F.
+ * @see DecodeBCRegion
+ */
+inline bool DecodeBCImage(BCFormat format, const uint8_t *blocks,
+                          size_t rowPitch, int width, int height, float *dst,
+                          int threadCount = 0) {
+  return DecodeBCRegion(format, blocks, rowPitch, width, height, 0, 0, width,
+                        height, dst, threadCount);
+}
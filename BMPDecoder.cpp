@@ -0,0 +1,429 @@
+#include "BMPDecoder.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BMP_DECODER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const size_t g_FileHeaderSize = 14;
+const uint32_t g_CoreHeaderSize = 12;
+const uint32_t g_InfoHeaderSize = 40;
+const uint32_t g_OS2HeaderSize = 64;
+
+// biCompression values
+const uint32_t g_BI_RGB = 0;
+const uint32_t g_BI_BITFIELDS = 3;
+const uint32_t g_BI_ALPHABITFIELDS = 6;
+
+// Sizes above this are taken as a damaged header
+const int64_t g_MaxDimension = 1 << 24;
+
+const uint32_t g_OpaqueAlpha = 0xff000000u;
+
+uint16_t ReadLE16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+uint32_t ReadLE32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+int GetFieldShift(uint32_t mask) {
+  int shift = 0;
+  while (mask && !(mask & 1)) {
+    mask >>= 1;
+    shift++;
+  }
+  return shift;
+}
+
+int GetFieldWidth(uint32_t mask) {
+  mask >>= GetFieldShift(mask);
+  int width = 0;
+  while (mask) {
+    mask >>= 1;
+    width++;
+  }
+  return width;
+}
+
+// One bit field of 16 and 32-bit pixels, widened to 8 bits as
+// (pixel >> shift & mask) * scale + 0.5 + fill
+struct BitField {
+  int shift = 0;
+  uint32_t mask = 0;
+  float scale = 0.0f;
+  uint32_t fill = 0; ///< 255 for missing alpha
+};
+
+BitField GetBitField(uint32_t mask, bool alpha) {
+  BitField field;
+  if (!mask) {
+    field.fill = alpha ? 255 : 0;
+    return field;
+  }
+  // Fields wider than 8 bits keep their top 8 bits
+  int width = GetFieldWidth(mask);
+  int dropped = std::max(0, width - 8);
+  field.shift = GetFieldShift(mask) + dropped;
+  field.mask = (1u << (width - dropped)) - 1;
+  field.scale = 255.0f / (float)field.mask;
+  return field;
+}
+
+uint32_t ExpandField(uint32_t pixel, const BitField &field) {
+  uint32_t value = pixel >> field.shift & field.mask;
+  return (uint32_t)((float)value * field.scale + 0.5f) + field.fill;
+}
+
+bool IsBGRX(const DIBHeader &header) {
+  return header.bitCount == 32 && header.masks[0] == 0xff0000 &&
+         header.masks[1] == 0xff00 && header.masks[2] == 0xff &&
+         (header.masks[3] == 0 || header.masks[3] == g_OpaqueAlpha);
+}
+
+// 8-bit B, G, R to an RGBA word
+uint32_t BGRToRGBA(uint32_t b, uint32_t g, uint32_t r) {
+  return r | g << 8 | b << 16 | g_OpaqueAlpha;
+}
+
+void DecodePaletteRow(const uint8_t *src, int bitCount, int width,
+                      const uint32_t *palette, uint32_t *dst) {
+  if (bitCount == 8) {
+    for (int x = 0; x < width; x++)
+      dst[x] = palette[src[x]];
+    return;
+  }
+  // Leftmost pixel in the high bits
+  const int perByte = 8 / bitCount;
+  const unsigned indexMask = (1u << bitCount) - 1;
+  for (int x = 0; x < width; x++) {
+    int shift = 8 - bitCount * (x % perByte + 1);
+    dst[x] = palette[src[x / perByte] >> shift & indexMask];
+  }
+}
+
+void DecodeBGRRow(const uint8_t *src, int width, uint32_t *dst) {
+  int x = 0;
+#ifdef BMP_DECODER_SSE2
+  const __m128i vGA = _mm_set1_epi32((int)0xff00ff00u);
+  const __m128i vByte = _mm_set1_epi32(0xff);
+  const __m128i vAlpha = _mm_set1_epi32((int)g_OpaqueAlpha);
+  // Each 4-byte load takes one byte of the next pixel, so the last group
+  // of four needs a pixel after it
+  for (; x + 5 <= width; x += 4) {
+    const uint8_t *p = src + x * 3;
+    uint32_t words[4];
+    for (int i = 0; i < 4; i++)
+      memcpy(&words[i], p + i * 3, 4);
+    __m128i bgr = _mm_loadu_si128((const __m128i *)words);
+    __m128i rb = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(bgr, 16), vByte),
+                              _mm_slli_epi32(_mm_and_si128(bgr, vByte), 16));
+    __m128i rgba =
+        _mm_or_si128(_mm_or_si128(_mm_and_si128(bgr, vGA), rb), vAlpha);
+    _mm_storeu_si128((__m128i *)(dst + x), rgba);
+  }
+#endif
+  for (; x < width; x++) {
+    const uint8_t *p = src + x * 3;
+    dst[x] = BGRToRGBA(p[0], p[1], p[2]);
+  }
+}
+
+// B, G, R and alpha or padding bytes, the layout of nearly all 32-bit DIBs
+void DecodeBGRXRow(const uint8_t *src, int width, bool alpha,
+                   uint32_t *dst) {
+  const uint32_t alphaFill = alpha ? 0 : g_OpaqueAlpha;
+  int x = 0;
+#ifdef BMP_DECODER_SSE2
+  const __m128i vGA = _mm_set1_epi32((int)0xff00ff00u);
+  const __m128i vByte = _mm_set1_epi32(0xff);
+  const __m128i vAlphaFill = _mm_set1_epi32((int)alphaFill);
+  for (; x + 4 <= width; x += 4) {
+    __m128i bgra = _mm_loadu_si128((const __m128i *)(src + x * 4));
+    __m128i rb =
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(bgra, 16), vByte),
+                     _mm_slli_epi32(_mm_and_si128(bgra, vByte), 16));
+    __m128i rgba =
+        _mm_or_si128(_mm_or_si128(_mm_and_si128(bgra, vGA), rb), vAlphaFill);
+    _mm_storeu_si128((__m128i *)(dst + x), rgba);
+  }
+#endif
+  for (; x < width; x++) {
+    uint32_t bgra;
+    memcpy(&bgra, src + x * 4, 4);
+    dst[x] = (bgra & 0xff00ff00u) | (bgra >> 16 & 0xff) |
+             (bgra & 0xff) << 16 | alphaFill;
+  }
+}
+
+// 16 or 32-bit pixels with arbitrary bit fields
+void DecodeFieldRow(const uint8_t *src, int bytesPerPixel, int width,
+                    const BitField *fields, uint32_t *dst) {
+  int x = 0;
+#ifdef BMP_DECODER_SSE2
+  const __m128i vZero = _mm_setzero_si128();
+  const __m128 vHalf = _mm_set1_ps(0.5f);
+  __m128i vShift[4], vMask[4], vFill[4];
+  __m128 vScale[4];
+  for (int c = 0; c < 4; c++) {
+    vShift[c] = _mm_cvtsi32_si128(fields[c].shift);
+    vMask[c] = _mm_set1_epi32((int)fields[c].mask);
+    vFill[c] = _mm_set1_epi32((int)fields[c].fill);
+    vScale[c] = _mm_set1_ps(fields[c].scale);
+  }
+  auto expand = [&](__m128i pixels, int c) {
+    __m128i value = _mm_and_si128(_mm_srl_epi32(pixels, vShift[c]), vMask[c]);
+    __m128 scaled =
+        _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(value), vScale[c]), vHalf);
+    return _mm_add_epi32(_mm_cvttps_epi32(scaled), vFill[c]);
+  };
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels =
+        bytesPerPixel == 2
+            ? _mm_unpacklo_epi16(
+                  _mm_loadl_epi64((const __m128i *)(src + x * 2)), vZero)
+            : _mm_loadu_si128((const __m128i *)(src + x * 4));
+    __m128i rgba = _mm_or_si128(
+        _mm_or_si128(expand(pixels, 0), _mm_slli_epi32(expand(pixels, 1), 8)),
+        _mm_or_si128(_mm_slli_epi32(expand(pixels, 2), 16),
+                     _mm_slli_epi32(expand(pixels, 3), 24)));
+    _mm_storeu_si128((__m128i *)(dst + x), rgba);
+  }
+#endif
+  for (; x < width; x++) {
+    uint32_t pixel;
+    if (bytesPerPixel == 2) {
+      uint16_t word;
+      memcpy(&word, src + x * 2, 2);
+      pixel = word;
+    } else {
+      memcpy(&pixel, src + x * 4, 4);
+    }
+    dst[x] = ExpandField(pixel, fields[0]) |
+             ExpandField(pixel, fields[1]) << 8 |
+             ExpandField(pixel, fields[2]) << 16 |
+             ExpandField(pixel, fields[3]) << 24;
+  }
+}
+
+bool HasNonZeroAlpha(const uint32_t *row, int width) {
+  uint32_t any = 0;
+  for (int x = 0; x < width; x++)
+    any |= row[x];
+  return (any & g_OpaqueAlpha) != 0;
+}
+
+// Parses the DIB at data + start; offsets are relative to data.
+// pixelOffset is bfOffBits of files, 0 for clipboard data.
+bool ParseDIB(const uint8_t *data, size_t size, size_t start,
+              uint32_t pixelOffset, DIBHeader &header) {
+  if (size < start + 4)
+    return false;
+  const uint8_t *dib = data + start;
+  uint32_t headerSize = ReadLE32(dib);
+  if (headerSize > size - start)
+    return false;
+
+  int64_t width, height;
+  int bitCount;
+  uint32_t compression = g_BI_RGB;
+  uint32_t colorsUsed = 0;
+  if (headerSize == g_CoreHeaderSize) {
+    width = ReadLE16(dib + 4);
+    height = ReadLE16(dib + 6);
+    bitCount = ReadLE16(dib + 10);
+    header.paletteEntrySize = 3;
+  } else if (headerSize == g_InfoHeaderSize || headerSize == 52 ||
+             headerSize == 56 || headerSize == g_OS2HeaderSize ||
+             headerSize == 108 || headerSize == 124) {
+    width = (int32_t)ReadLE32(dib + 4);
+    height = (int32_t)ReadLE32(dib + 8); // Negative for top-down rows
+    bitCount = ReadLE16(dib + 14);
+    compression = ReadLE32(dib + 16);
+    colorsUsed = ReadLE32(dib + 32);
+    header.paletteEntrySize = 4;
+  } else {
+    return false;
+  }
+
+  header.bottomUp = height > 0;
+  height = height < 0 ? -height : height;
+  if (width <= 0 || height <= 0 || width > g_MaxDimension ||
+      height > g_MaxDimension)
+    return false;
+  header.width = (int)width;
+  header.height = (int)height;
+  header.bitCount = bitCount;
+
+  size_t pos = start + headerSize;
+  if (compression == g_BI_RGB) {
+    if (bitCount != 1 && bitCount != 2 && bitCount != 4 && bitCount != 8 &&
+        bitCount != 16 && bitCount != 24 && bitCount != 32)
+      return false;
+    static const uint32_t s_Masks16[4] = {0x7c00, 0x3e0, 0x1f, 0};
+    static const uint32_t s_Masks32[4] = {0xff0000, 0xff00, 0xff,
+                                          g_OpaqueAlpha};
+    const uint32_t *masks = bitCount == 16 ? s_Masks16 : s_Masks32;
+    memcpy(header.masks, masks, sizeof(header.masks));
+  } else if (compression == g_BI_BITFIELDS ||
+             compression == g_BI_ALPHABITFIELDS) {
+    // OS/2 2.x headers use 3 for Huffman coding
+    if ((bitCount != 16 && bitCount != 32) || headerSize == g_OS2HeaderSize)
+      return false;
+    int maskCount = compression == g_BI_ALPHABITFIELDS ? 4 : 3;
+    if (headerSize == g_InfoHeaderSize) {
+      // The masks follow the header
+      if (size - pos < (size_t)maskCount * 4)
+        return false;
+      for (int i = 0; i < maskCount; i++)
+        header.masks[i] = ReadLE32(data + pos + i * 4);
+      pos += maskCount * 4;
+    } else {
+      // V2+ headers hold them, with alpha from V3 on
+      for (int i = 0; i < 3; i++)
+        header.masks[i] = ReadLE32(dib + 40 + i * 4);
+      header.masks[3] = headerSize >= 56 ? ReadLE32(dib + 52) : 0;
+    }
+  } else {
+    // RLE, JPEG and PNG bitmaps
+    return false;
+  }
+
+  // 1 to 8-bit pixels index a color table; others may have a table of
+  // colors to prefer, which only needs to be skipped
+  size_t tableSize = colorsUsed;
+  if (bitCount <= 8) {
+    if (colorsUsed > 256)
+      return false;
+    if (colorsUsed == 0)
+      tableSize = (size_t)1 << bitCount;
+    header.paletteSize = (int)std::min<size_t>(tableSize, 1 << bitCount);
+  } else {
+    header.paletteSize = 0;
+  }
+  header.paletteOffset = pos;
+  if ((size - pos) / header.paletteEntrySize < tableSize)
+    return false;
+  pos += tableSize * header.paletteEntrySize;
+
+  header.dataOffset = pixelOffset >= pos ? pixelOffset : pos;
+  uint64_t rowBits = (uint64_t)width * bitCount;
+  header.rowPitch = (size_t)((rowBits + 31) / 32 * 4);
+  // The padding of the last row is often left out
+  uint64_t pixelBytes =
+      (uint64_t)header.rowPitch * (height - 1) + (rowBits + 7) / 8;
+  return header.dataOffset <= size && pixelBytes <= size - header.dataOffset;
+}
+
+} // namespace
+
+bool ReadDIBHeader(const uint8_t *data, size_t size, DIBHeader &header) {
+  header = DIBHeader();
+  return ParseDIB(data, size, 0, 0, header);
+}
+
+bool ReadBMPHeader(const uint8_t *data, size_t size, DIBHeader &header) {
+  header = DIBHeader();
+  if (size < g_FileHeaderSize || data[0] != 'B' || data[1] != 'M')
+    return false;
+  return ParseDIB(data, size, g_FileHeaderSize, ReadLE32(data + 10), header);
+}
+
+std::string GetDIBFormatName(const DIBHeader &header) {
+  if (header.bitCount <= 8)
+    return "P" + std::to_string(header.bitCount);
+  if (header.bitCount == 24)
+    return "R8G8B8";
+
+  struct Field {
+    char name;
+    int shift;
+    int width;
+  };
+  std::vector<Field> fields;
+  static const char s_Names[4] = {'R', 'G', 'B', 'A'};
+  for (int c = 0; c < 4; c++) {
+    if (header.masks[c])
+      fields.push_back({s_Names[c], GetFieldShift(header.masks[c]),
+                        GetFieldWidth(header.masks[c])});
+  }
+  std::sort(fields.begin(), fields.end(), [](const Field &a, const Field &b) {
+    return a.shift > b.shift;
+  });
+
+  // Unused bits show as X
+  std::string name;
+  int top = header.bitCount;
+  for (const Field &field : fields) {
+    int gap = top - (field.shift + field.width);
+    if (gap > 0)
+      name += "X" + std::to_string(gap);
+    name += field.name + std::to_string(field.width);
+    top = std::min(top, field.shift);
+  }
+  if (top > 0)
+    name += "X" + std::to_string(top);
+  return name;
+}
+
+void DecodeDIBImage(const uint8_t *data, const DIBHeader &header,
+                    uint8_t *dst, int threadCount) {
+  PROFILE_SCOPE("DecodeDIBImage");
+  const int width = header.width;
+  const int height = header.height;
+
+  // Color tables are BGR(X); missing entries are black
+  uint32_t palette[256];
+  std::fill(palette, palette + 256, g_OpaqueAlpha);
+  for (int i = 0; i < header.paletteSize; i++) {
+    const uint8_t *entry =
+        data + header.paletteOffset + (size_t)i * header.paletteEntrySize;
+    palette[i] = BGRToRGBA(entry[0], entry[1], entry[2]);
+  }
+
+  BitField fields[4];
+  for (int c = 0; c < 4; c++)
+    fields[c] = GetBitField(header.masks[c], c == 3);
+  const bool bgrx = IsBGRX(header);
+  const bool alpha = header.bitCount >= 16 && header.masks[3] != 0;
+
+  int chunkCount = GetParallelChunkCount(height, threadCount);
+  std::vector<char> chunkAlpha(chunkCount, 0);
+  ParallelForChunks(height, threadCount, [&](int chunk, int begin, int end) {
+    bool anyAlpha = false;
+    for (int y = begin; y < end; y++) {
+      int row = header.bottomUp ? height - 1 - y : y;
+      const uint8_t *src = data + header.dataOffset + header.rowPitch * row;
+      uint32_t *out = (uint32_t *)(dst + (size_t)width * 4 * y);
+      if (header.bitCount <= 8)
+        DecodePaletteRow(src, header.bitCount, width, palette, out);
+      else if (header.bitCount == 24)
+        DecodeBGRRow(src, width, out);
+      else if (bgrx)
+        DecodeBGRXRow(src, width, alpha, out);
+      else
+        DecodeFieldRow(src, header.bitCount / 8, width, fields, out);
+      if (alpha && !anyAlpha)
+        anyAlpha = HasNonZeroAlpha(out, width);
+    }
+    chunkAlpha[chunk] = anyAlpha;
+  });
+
+  // Alpha that is 0 everywhere is padding
+  if (!alpha ||
+      std::find(chunkAlpha.begin(), chunkAlpha.end(), 1) != chunkAlpha.end())
+    return;
+  ParallelFor(height, threadCount, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      uint32_t *out = (uint32_t *)(dst + (size_t)width * 4 * y);
+      for (int x = 0; x < width; x++)
+        out[x] |= g_OpaqueAlpha;
+    }
+  });
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Layout of the pixels of a device-independent bitmap (DIB), as
+ * found in .bmp files and on the Windows clipboard (CF_DIB, CF_DIBV5).
+ */
+struct DIBHeader {
+  int width = 0;
+  int height = 0;
+  int bitCount = 0;         ///< 1, 2, 4, 8, 16, 24 or 32
+  bool bottomUp = true;     ///< Positive height: rows start at the bottom
+  uint32_t masks[4] = {};   ///< R, G, B, A bit fields of 16 and 32-bit pixels
+  size_t paletteOffset = 0; ///< Offset of the color table
+  int paletteSize = 0;      ///< Colors of 1 to 8-bit pixels
+  int paletteEntrySize = 4; ///< 3 for OS/2 core headers
+  size_t dataOffset = 0;    ///< Offset of the first stored row
+  size_t rowPitch = 0;      ///< Bytes per stored row, padded to 4
+};
+
+/**
+ * @brief Parses a DIB: a BITMAPCOREHEADER, BITMAPINFOHEADER or one of its
+ * V2-V5 extensions, then bit masks, color table and pixels.
+ *
+ * This is the layout of CF_DIB and CF_DIBV5 clipboard data. BI_RGB,
+ * BI_BITFIELDS and BI_ALPHABITFIELDS are read; 16-bit BI_RGB pixels are
+ * X1R5G5B5 and 32-bit ones have alpha in the top byte. Alpha masks are
+ * taken from V3+ headers and BI_ALPHABITFIELDS.
+ * @return False if the header is not such a header, the compression is not
+ * supported or the pixels do not fit in size.
+ */
+bool ReadDIBHeader(const uint8_t *data, size_t size, DIBHeader &header);
+
+/**
+ * @brief Parses a .bmp file: the BITMAPFILEHEADER, then the DIB.
+ *
+ * Offsets in the result are relative to the start of the file.
+ * @see ReadDIBHeader
+ */
+bool ReadBMPHeader(const uint8_t *data, size_t size, DIBHeader &header);
+
+/**
+ * @brief Gets a name for the stored pixel layout (e.g., "P8", "R5G6B5",
+ * "A8R8G8B8"), with bit fields listed from the top bit down.
+ */
+std::string GetDIBFormatName(const DIBHeader &header);
+
+/**
+ * @brief Decodes the pixels of a DIB to RGBA8.
+ *
+ * Rows are decoded in parallel. BGR(X/A) pixels are swizzled with SSE2
+ * four at a time; other bit fields are extracted with SSE2 and widened to
+ * 8 bits with rounding, keeping the top 8 bits of wider fields. Color
+ * tables are expanded per pixel. If every alpha value is 0, which is how
+ * most programs write 32-bit bitmaps without alpha, the result is opaque.
+ *
+ * @param data The data given to ReadDIBHeader() or ReadBMPHeader().
+ * @param dst Receives width * height RGBA pixels, top row first.
+ * @param threadCount Number of threads to use (0 = hardware threads).
+ */
+void DecodeDIBImage(const uint8_t *data, const DIBHeader &header,
+                    uint8_t *dst, int threadCount = 0);
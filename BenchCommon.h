@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Helpers shared by the benchmark executables
+
+/**
+ * @brief Parses a comma separated list of integers ("1,4,16").
+ * \note Throws std::invalid_argument on malformed items, like std::stoi.
+ */
+inline std::vector<int> ParseIntList(const std::string &text) {
+  std::vector<int> values;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty())
+      values.push_back(std::stoi(item));
+  }
+  return values;
+}
+
+/**
+ * @brief Reads name -> value pairs from a results file written by one of the
+ * benchmarks.
+ *
+ * The benchmarks write one JSON result object per line, so this only looks
+ * for `"name": "..."` and `"<valueKey>": <number>` on the same line.
+ */
+inline bool ReadBaselineValues(const std::string &path,
+                               const std::string &valueKey,
+                               std::map<std::string, double> &values) {
+  std::ifstream file(path);
+  if (!file)
+    return false;
+
+  const std::string namePrefix = "\"name\": \"";
+  const std::string valuePrefix = "\"" + valueKey + "\": ";
+
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t name = line.find(namePrefix);
+    size_t value = line.find(valuePrefix);
+    if (name == std::string::npos || value == std::string::npos)
+      continue;
+    name += namePrefix.size();
+    size_t nameEnd = line.find('"', name);
+    if (nameEnd == std::string::npos)
+      continue;
+    values[line.substr(name, nameEnd - name)] =
+        std::atof(line.c_str() + value + valuePrefix.size());
+  }
+  return true;
+}
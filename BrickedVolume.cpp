@@ -0,0 +1,347 @@
+#include "BrickedVolume.h"
+#include "Logger.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+// Volumes whose bricks would take more than this are sliced by the source
+const size_t g_MaxBrickedBytes = 4ull * 1024 * 1024 * 1024;
+
+// Copies count voxels of Size bytes that are stride bytes apart
+template <size_t Size>
+void GatherVoxels(uint8_t *dst, const uint8_t *src, int count,
+                  size_t stride) {
+  for (int i = 0; i < count; i++)
+    memcpy(dst + i * Size, src + i * stride, Size);
+}
+
+void GatherVoxels(uint8_t *dst, const uint8_t *src, int count, size_t stride,
+                  size_t size) {
+  switch (size) {
+  case 1:
+    GatherVoxels<1>(dst, src, count, stride);
+    break;
+  case 2:
+    GatherVoxels<2>(dst, src, count, stride);
+    break;
+  case 4:
+    GatherVoxels<4>(dst, src, count, stride);
+    break;
+  case 8:
+    GatherVoxels<8>(dst, src, count, stride);
+    break;
+  case 16:
+    GatherVoxels<16>(dst, src, count, stride);
+    break;
+  default:
+    for (int i = 0; i < count; i++)
+      memcpy(dst + i * size, src + i * stride, size);
+    break;
+  }
+}
+
+// Copies a run of count voxels of size bytes; whole brick rows of the
+// common voxel sizes are copied with a fixed size
+void CopyRun(uint8_t *dst, const uint8_t *src, int count, size_t size) {
+  const int n = BrickedVolume::BrickSize;
+  if (count == n) {
+    switch (size) {
+    case 1:
+      memcpy(dst, src, n);
+      return;
+    case 2:
+      memcpy(dst, src, n * 2);
+      return;
+    case 4:
+      memcpy(dst, src, n * 4);
+      return;
+    case 8:
+      memcpy(dst, src, n * 8);
+      return;
+    case 16:
+      memcpy(dst, src, n * 16);
+      return;
+    }
+  }
+  memcpy(dst, src, count * size);
+}
+
+// Widens total to include part
+void MergeRange(ValueRange &total, const ValueRange &part) {
+  total.hasNaN |= part.hasNaN;
+  if (!part.valid)
+    return;
+  if (!total.valid) {
+    bool hasNaN = total.hasNaN;
+    total = part;
+    total.hasNaN = hasNaN;
+    return;
+  }
+  total.minValue = std::min(total.minValue, part.minValue);
+  total.maxValue = std::max(total.maxValue, part.maxValue);
+  total.minInteger = std::min(total.minInteger, part.minInteger);
+  total.maxInteger = std::max(total.maxInteger, part.maxInteger);
+}
+
+} // namespace
+
+BrickedVolume::BrickedVolume(std::shared_ptr<ImageSource> source)
+    : m_source(std::move(source)) {}
+
+BrickedVolume::~BrickedVolume() {}
+
+bool BrickedVolume::Build(const SubresourceIndex &index) {
+  SubresourceIndex volume = index;
+  volume.slice = 0;
+  volume.axis = SliceAxis::Z;
+  if ((m_built || m_failed) && volume == m_bricked)
+    return m_built;
+
+  PROFILE_SCOPE("BrickedVolume Build");
+  const SubresourceLayout &layout = GetLayout();
+  m_bricked = volume;
+  m_built = false;
+  m_failed = true;
+  m_bricks.reset();
+  m_histogram = Histogram();
+  m_range = ValueRange();
+  m_width = std::max(1, layout.width >> volume.mip);
+  m_height = std::max(1, layout.height >> volume.mip);
+  m_depth = layout.GetMipDepth(volume.mip);
+  m_bricksX = (m_width + BrickSize - 1) / BrickSize;
+  m_bricksY = (m_height + BrickSize - 1) / BrickSize;
+  m_bricksZ = (m_depth + BrickSize - 1) / BrickSize;
+  const size_t brickCount = (size_t)m_bricksX * m_bricksY * m_bricksZ;
+
+  ImageData slice;
+  for (int z = 0; z < m_depth; z++) {
+    SubresourceIndex source = volume;
+    source.slice = z;
+    if (!m_source->Decode(source, slice)) {
+      LOG_ERROR("Failed to decode volume slice %d", z);
+      return false;
+    }
+    PixelFormat format =
+        slice.HasStoredPixels() ? slice.stored.format : PixelFormat::RGBA32F;
+    if (z == 0) {
+      m_float = !slice.HasStoredPixels();
+      m_format = format;
+      m_pixelSize = GetPixelSize(format);
+      m_brickBytes = m_pixelSize * BrickSize * BrickSize * BrickSize;
+      if (brickCount > g_MaxBrickedBytes / m_brickBytes) {
+        LOG("Volume of %dx%dx%d is too large to brick", m_width, m_height,
+            m_depth);
+        return false;
+      }
+      PROFILE_SCOPE("Allocate");
+      m_bricks.reset(new (std::nothrow) uint8_t[brickCount * m_brickBytes]);
+      if (!m_bricks) {
+        LOG_ERROR("Out of memory bricking a volume of %dx%dx%d", m_width,
+                  m_height, m_depth);
+        return false;
+      }
+      m_header = slice;
+      m_header.pixels = std::vector<float>();
+      m_header.stored = PixelBuffer();
+    }
+    if (slice.width != m_width || slice.height != m_height ||
+        format != m_format || (!m_float) != slice.HasStoredPixels()) {
+      LOG_ERROR("Volume slice %d does not match the first slice", z);
+      m_bricks.reset();
+      return false;
+    }
+    MergeRange(m_range,
+               ComputeValueRange(slice, ChannelRGBA, m_threadCount));
+
+    // Each row of the slice is split into runs of one brick row
+    const int bz = z / BrickSize;
+    const size_t zOffset = (size_t)(z % BrickSize) * BrickSize * BrickSize;
+    const size_t pixelSize = m_pixelSize;
+    ParallelFor(m_height, m_threadCount, [&](int begin, int end) {
+      for (int y = begin; y < end; y++) {
+        const uint8_t *src =
+            m_float ? (const uint8_t *)(slice.pixels.data() +
+                                        (size_t)y * m_width * 4)
+                    : slice.stored.GetRow(y);
+        size_t voxel = zOffset + (size_t)(y % BrickSize) * BrickSize;
+        for (int bx = 0; bx < m_bricksX; bx++) {
+          int count = std::min(BrickSize, m_width - bx * BrickSize);
+          uint8_t *dst = GetBrick(bx, y / BrickSize, bz);
+          CopyRun(dst + voxel * pixelSize,
+                  src + (size_t)bx * BrickSize * pixelSize, count, pixelSize);
+        }
+      }
+    });
+  }
+
+  m_built = true;
+  m_failed = false;
+  return true;
+}
+
+void BrickedVolume::Extract(SliceAxis axis, int slice, ImageData &out) const {
+  const int width = axis == SliceAxis::X ? m_depth : m_width;
+  const int height = axis == SliceAxis::Y ? m_depth : m_height;
+  out = m_header;
+  out.width = width;
+  out.height = height;
+
+  uint8_t *pixels;
+  ptrdiff_t pitch;
+  if (m_float) {
+    PROFILE_SCOPE("Allocate");
+    out.pixels.resize((size_t)width * height * 4);
+    pixels = (uint8_t *)out.pixels.data();
+    pitch = (ptrdiff_t)width * 4 * sizeof(float);
+  } else {
+    PROFILE_SCOPE("Allocate");
+    out.stored = AllocatePixelBuffer(m_format, width, height, pixels);
+    pitch = out.stored.rowPitch;
+  }
+
+  // Rows of Z and Y slices are runs of brick rows; rows of X slices step
+  // through one voxel of each brick layer
+  const size_t pixelSize = m_pixelSize;
+  const int sb = slice / BrickSize;
+  const size_t so = slice % BrickSize;
+  const size_t layerBytes = (size_t)BrickSize * BrickSize * pixelSize;
+  ParallelFor(height, m_threadCount, [&](int begin, int end) {
+    for (int row = begin; row < end; row++) {
+      uint8_t *dst = pixels + pitch * row;
+      const int rb = row / BrickSize;
+      const size_t ro = row % BrickSize;
+      switch (axis) {
+      case SliceAxis::Z: // Row y at z = slice
+        for (int bx = 0; bx < m_bricksX; bx++) {
+          int count = std::min(BrickSize, m_width - bx * BrickSize);
+          CopyRun(dst + (size_t)bx * BrickSize * pixelSize,
+                  GetBrick(bx, rb, sb) + (so * BrickSize + ro) * BrickSize *
+                                             pixelSize,
+                  count, pixelSize);
+        }
+        break;
+      case SliceAxis::Y: // Row z at y = slice
+        for (int bx = 0; bx < m_bricksX; bx++) {
+          int count = std::min(BrickSize, m_width - bx * BrickSize);
+          CopyRun(dst + (size_t)bx * BrickSize * pixelSize,
+                  GetBrick(bx, sb, rb) + (ro * BrickSize + so) * BrickSize *
+                                             pixelSize,
+                  count, pixelSize);
+        }
+        break;
+      case SliceAxis::X: // Row y at x = slice, z across
+        for (int bz = 0; bz < m_bricksZ; bz++) {
+          int count = std::min(BrickSize, m_depth - bz * BrickSize);
+          GatherVoxels(dst + (size_t)bz * BrickSize * pixelSize,
+                       GetBrick(sb, rb, bz) +
+                           (ro * BrickSize + so) * pixelSize,
+                       count, layerBytes, pixelSize);
+        }
+        break;
+      }
+    }
+  });
+}
+
+bool BrickedVolume::Decode(const SubresourceIndex &index, ImageData &out) {
+  PROFILE_SCOPE("BrickedVolume Decode");
+  if (!GetLayout().Contains(index))
+    return false;
+  if (!Build(index)) {
+    // Z slices are stored as such; other axes need the bricks
+    return index.axis == SliceAxis::Z && m_source->Decode(index, out);
+  }
+  PROFILE_SCOPE("BrickedVolume Extract");
+  Extract(index.axis, index.slice, out);
+  return true;
+}
+
+bool BrickedVolume::GetRange(const SubresourceIndex &index,
+                             ValueRange &range) {
+  if (!GetLayout().Contains(index) || !Build(index))
+    return false;
+  range = m_range;
+  return true;
+}
+
+template <typename Fn>
+void BrickedVolume::AccumulateHistogram(int binCount, int *histR, int *histG,
+                                        int *histB, Fn &&fn) const {
+  std::fill(histR, histR + binCount, 0);
+  std::fill(histG, histG + binCount, 0);
+  std::fill(histB, histB + binCount, 0);
+  std::vector<int> r(binCount), g(binCount), b(binCount);
+  ImageData slice;
+  for (int z = 0; z < m_depth; z++) {
+    Extract(SliceAxis::Z, z, slice);
+    fn(slice, r.data(), g.data(), b.data());
+    for (int i = 0; i < binCount; i++) {
+      histR[i] += r[i];
+      histG[i] += g[i];
+      histB[i] += b[i];
+    }
+  }
+}
+
+bool BrickedVolume::ComputeHistogram(const SubresourceIndex &index,
+                                     float rangeMin, float rangeMax,
+                                     int binCount, int *histR, int *histG,
+                                     int *histB) {
+  PROFILE_SCOPE("BrickedVolume ComputeHistogram");
+  if (!GetLayout().Contains(index) || !Build(index))
+    return false;
+  Histogram &last = m_histogram;
+  if (last.integer || last.rangeMin != rangeMin ||
+      last.rangeMax != rangeMax || (int)last.r.size() != binCount) {
+    last.integer = false;
+    last.rangeMin = rangeMin;
+    last.rangeMax = rangeMax;
+    last.r.resize(binCount);
+    last.g.resize(binCount);
+    last.b.resize(binCount);
+    AccumulateHistogram(
+        binCount, last.r.data(), last.g.data(), last.b.data(),
+        [&](const ImageData &slice, int *r, int *g, int *b) {
+          ::ComputeHistogram(slice, rangeMin, rangeMax, binCount, r, g, b,
+                             m_threadCount);
+        });
+  }
+  std::copy(last.r.begin(), last.r.end(), histR);
+  std::copy(last.g.begin(), last.g.end(), histG);
+  std::copy(last.b.begin(), last.b.end(), histB);
+  return true;
+}
+
+bool BrickedVolume::ComputeIntegerHistogram(const SubresourceIndex &index,
+                                            int64_t rangeMin,
+                                            int64_t rangeMax, int binCount,
+                                            int *histR, int *histG,
+                                            int *histB) {
+  PROFILE_SCOPE("BrickedVolume ComputeIntegerHistogram");
+  if (!GetLayout().Contains(index) || !Build(index) || m_float)
+    return false;
+  Histogram &last = m_histogram;
+  if (!last.integer || last.rangeMin != (double)rangeMin ||
+      last.rangeMax != (double)rangeMax || (int)last.r.size() != binCount) {
+    last.integer = true;
+    last.rangeMin = (double)rangeMin;
+    last.rangeMax = (double)rangeMax;
+    last.r.resize(binCount);
+    last.g.resize(binCount);
+    last.b.resize(binCount);
+    AccumulateHistogram(
+        binCount, last.r.data(), last.g.data(), last.b.data(),
+        [&](const ImageData &slice, int *r, int *g, int *b) {
+          ::ComputeIntegerHistogram(slice.stored, rangeMin, rangeMax,
+                                    binCount, r, g, b, m_threadCount);
+        });
+  }
+  std::copy(last.r.begin(), last.r.end(), histR);
+  std::copy(last.g.begin(), last.g.end(), histG);
+  std::copy(last.b.begin(), last.b.end(), histB);
+  return true;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "ImageAnalysis.h"
+#include "ImageSource.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Volume texture kept in bricks, sliced across any axis.
+ *
+ * Wraps the source of a volume (DDS, KTX2). The first Decode() of a mip
+ * decodes all of its Z slices from the source once and scatters them into
+ * bricks of 16x16x16 voxels, each stored contiguously, in the decoded pixel
+ * format. Slices across Z, Y or X are then gathered from the bricks, rows in
+ * parallel: a slice touches only the bricks it crosses, instead of striding
+ * through the whole volume as a slab layout does for X and Y slices.
+ *
+ * The value range of the whole bricked volume is found while it is built, so
+ * slices can share one color mapping and histogram. One mip, layer and face
+ * is bricked at a time.
+ */
+class BrickedVolume : public ImageSource {
+public:
+  /// Voxels along each side of a brick
+  static constexpr int BrickSize = 16;
+
+  explicit BrickedVolume(std::shared_ptr<ImageSource> source);
+  ~BrickedVolume() override;
+
+  const SubresourceLayout &GetLayout() const override {
+    return m_source->GetLayout();
+  }
+
+  /**
+   * @brief Gathers one slice from the bricks, bricking the volume it belongs
+   * to first if needed.
+   * \note Z slices of volumes too large to brick are decoded by the source.
+   */
+  bool Decode(const SubresourceIndex &index, ImageData &out) override;
+
+  /**
+   * @brief Gets the value range of all voxels of the volume an index belongs
+   * to, bricking it if needed.
+   * @return False if the volume cannot be bricked.
+   */
+  bool GetRange(const SubresourceIndex &index, ValueRange &range);
+
+  /**
+   * @brief ComputeHistogram over all voxels of the volume an index belongs
+   * to. The last result is kept, so asking again with the same arguments
+   * does not scan the volume.
+   */
+  bool ComputeHistogram(const SubresourceIndex &index, float rangeMin,
+                        float rangeMax, int binCount, int *histR, int *histG,
+                        int *histB);
+
+  /**
+   * @brief ComputeIntegerHistogram over all voxels of the volume an index
+   * belongs to.
+   */
+  bool ComputeIntegerHistogram(const SubresourceIndex &index,
+                               int64_t rangeMin, int64_t rangeMax,
+                               int binCount, int *histR, int *histG,
+                               int *histB);
+
+  /**
+   * @brief Sets the number of threads used to build and slice the volume
+   * (0 = hardware threads).
+   */
+  void SetThreadCount(int threadCount) { m_threadCount = threadCount; }
+
+private:
+  /**
+   * @brief Bricks the volume of index's mip, layer and face, unless it is the
+   * one already bricked.
+   * @return False if it cannot be decoded or does not fit in the budget;
+   * that is remembered until another volume is bricked.
+   */
+  bool Build(const SubresourceIndex &index);
+
+  /**
+   * @brief Gathers a slice of the bricked volume into out.
+   */
+  void Extract(SliceAxis axis, int slice, ImageData &out) const;
+
+  /**
+   * @brief Gets the first voxel of brick (bx, by, bz).
+   */
+  uint8_t *GetBrick(int bx, int by, int bz) const {
+    size_t brick = ((size_t)bz * m_bricksY + by) * m_bricksX + bx;
+    return m_bricks.get() + brick * m_brickBytes;
+  }
+
+  /**
+   * @brief Calls fn(slice, histR, histG, histB) for each Z slice, into
+   * scratch histograms that are summed into the given ones.
+   */
+  template <typename Fn>
+  void AccumulateHistogram(int binCount, int *histR, int *histG, int *histB,
+                           Fn &&fn) const;
+
+  std::shared_ptr<ImageSource> m_source;
+  int m_threadCount = 0;
+
+  // Volume in the bricks
+  SubresourceIndex m_bricked; ///< Mip, layer and face; slice 0 across Z
+  bool m_built = false;
+  bool m_failed = false; ///< Bricking m_bricked failed
+  int m_width = 0;
+  int m_height = 0;
+  int m_depth = 0;
+  int m_bricksX = 0;
+  int m_bricksY = 0;
+  int m_bricksZ = 0;
+  bool m_float = false; ///< RGBA32F pixels instead of stored ones
+  PixelFormat m_format = PixelFormat::RGBA32F;
+  size_t m_pixelSize = 0;
+  size_t m_brickBytes = 0;
+  std::unique_ptr<uint8_t[]> m_bricks;
+  ImageData m_header; ///< Fields of a decoded slice other than the pixels
+  ValueRange m_range;
+
+  // Last histogram asked for
+  struct Histogram {
+    bool integer = false;
+    double rangeMin = 0.0;
+    double rangeMax = 0.0;
+    std::vector<int> r, g, b;
+  };
+  Histogram m_histogram;
+};
@@ -0,0 +1,490 @@
+#include "DDSImage.h"
+#include "BCDecoder.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <DirectXTex.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Magic number and DDS_HEADER; the DX10 extension header follows when the
+// pixel format's FourCC is 'DX10'
+const size_t g_DDSHeaderSize = 4 + 124;
+const size_t g_DDSHeaderDX10Size = 20;
+const size_t g_DDSPixelFlagsOffset = 4 + 72 + 4;
+const size_t g_DDSFourCCOffset = 4 + 72 + 8;
+const uint32_t g_DDPFFourCC = 0x4;
+
+// Maps DXGI block-compressed formats to the BCn decoder. sRGB variants are
+// decoded as stored, like every other format.
+bool GetBCFormat(DXGI_FORMAT format, BCFormat &bcFormat, int &channels) {
+  channels = 4;
+  switch (format) {
+  case DXGI_FORMAT_BC1_UNORM:
+  case DXGI_FORMAT_BC1_UNORM_SRGB:
+    bcFormat = BCFormat::BC1;
+    return true;
+  case DXGI_FORMAT_BC2_UNORM:
+  case DXGI_FORMAT_BC2_UNORM_SRGB:
+    bcFormat = BCFormat::BC2;
+    return true;
+  case DXGI_FORMAT_BC3_UNORM:
+  case DXGI_FORMAT_BC3_UNORM_SRGB:
+    bcFormat = BCFormat::BC3;
+    return true;
+  case DXGI_FORMAT_BC4_UNORM:
+  case DXGI_FORMAT_BC4_SNORM:
+    bcFormat =
+        format == DXGI_FORMAT_BC4_SNORM ? BCFormat::BC4S : BCFormat::BC4U;
+    channels = 1;
+    return true;
+  case DXGI_FORMAT_BC5_UNORM:
+  case DXGI_FORMAT_BC5_SNORM:
+    bcFormat =
+        format == DXGI_FORMAT_BC5_SNORM ? BCFormat::BC5S : BCFormat::BC5U;
+    channels = 2;
+    return true;
+  case DXGI_FORMAT_BC6H_UF16:
+  case DXGI_FORMAT_BC6H_SF16:
+    bcFormat =
+        format == DXGI_FORMAT_BC6H_SF16 ? BCFormat::BC6HS : BCFormat::BC6HU;
+    channels = 3;
+    return true;
+  case DXGI_FORMAT_BC7_UNORM:
+  case DXGI_FORMAT_BC7_UNORM_SRGB:
+    bcFormat = BCFormat::BC7;
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Integer formats (IDs, stencil, visibility buffers) are kept bit-exact
+struct IntegerFormat {
+  DXGI_FORMAT dxgiFormat;
+  PixelFormat pixelFormat;
+};
+
+const IntegerFormat g_IntegerFormats[] = {
+    {DXGI_FORMAT_R8_UINT, PixelFormat::R8UI},
+    {DXGI_FORMAT_R8_SINT, PixelFormat::R8I},
+    {DXGI_FORMAT_R8G8_UINT, PixelFormat::RG8UI},
+    {DXGI_FORMAT_R8G8_SINT, PixelFormat::RG8I},
+    {DXGI_FORMAT_R8G8B8A8_UINT, PixelFormat::RGBA8UI},
+    {DXGI_FORMAT_R8G8B8A8_SINT, PixelFormat::RGBA8I},
+    {DXGI_FORMAT_R16_UINT, PixelFormat::R16UI},
+    {DXGI_FORMAT_R16_SINT, PixelFormat::R16I},
+    {DXGI_FORMAT_R16G16_UINT, PixelFormat::RG16UI},
+    {DXGI_FORMAT_R16G16_SINT, PixelFormat::RG16I},
+    {DXGI_FORMAT_R16G16B16A16_UINT, PixelFormat::RGBA16UI},
+    {DXGI_FORMAT_R16G16B16A16_SINT, PixelFormat::RGBA16I},
+    {DXGI_FORMAT_R32_UINT, PixelFormat::R32UI},
+    {DXGI_FORMAT_R32_SINT, PixelFormat::R32I},
+    {DXGI_FORMAT_R32G32_UINT, PixelFormat::RG32UI},
+    {DXGI_FORMAT_R32G32_SINT, PixelFormat::RG32I},
+    {DXGI_FORMAT_R32G32B32_UINT, PixelFormat::RGB32UI},
+    {DXGI_FORMAT_R32G32B32_SINT, PixelFormat::RGB32I},
+    {DXGI_FORMAT_R32G32B32A32_UINT, PixelFormat::RGBA32UI},
+    {DXGI_FORMAT_R32G32B32A32_SINT, PixelFormat::RGBA32I},
+};
+
+// Depth buffer formats, typeless and view variants included
+enum class DepthLayout {
+  None,
+  D32F,   ///< float depth
+  D24S8,  ///< 24-bit UNORM depth in the low bits, 8-bit stencil on top
+  D16,    ///< 16-bit UNORM depth
+  D32FS8, ///< float depth, 8-bit stencil, 24 unused bits
+};
+
+DepthLayout GetDepthLayout(DXGI_FORMAT format) {
+  switch (format) {
+  case DXGI_FORMAT_R32_TYPELESS:
+  case DXGI_FORMAT_D32_FLOAT:
+    return DepthLayout::D32F;
+  case DXGI_FORMAT_R24G8_TYPELESS:
+  case DXGI_FORMAT_D24_UNORM_S8_UINT:
+  case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+  case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+    return DepthLayout::D24S8;
+  case DXGI_FORMAT_R16_TYPELESS:
+  case DXGI_FORMAT_D16_UNORM:
+    return DepthLayout::D16;
+  case DXGI_FORMAT_R32G8X24_TYPELESS:
+  case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+  case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+  case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+    return DepthLayout::D32FS8;
+  default:
+    return DepthLayout::None;
+  }
+}
+
+const char *GetDepthLayoutName(DepthLayout layout) {
+  switch (layout) {
+  case DepthLayout::D32F:
+    return "D32F";
+  case DepthLayout::D24S8:
+    return "D24S8";
+  case DepthLayout::D16:
+    return "D16";
+  case DepthLayout::D32FS8:
+    return "D32FS8";
+  default:
+    return "Unknown";
+  }
+}
+
+bool HasStencil(DepthLayout layout) {
+  return layout == DepthLayout::D24S8 || layout == DepthLayout::D32FS8;
+}
+
+// Copies one plane of a depth buffer surface: depth as L32F (D16 stays
+// L16), stencil as R8UI
+void DecodeDepthPlane(DepthLayout layout, bool stencil, const uint8_t *src,
+                      size_t srcRowPitch, int width, int height,
+                      ImageData &out) {
+  uint8_t *dst;
+  if (stencil) {
+    // The stencil byte follows 24 bits of depth, or the float depth
+    size_t pixelSize = layout == DepthLayout::D24S8 ? 4 : 8;
+    size_t offset = layout == DepthLayout::D24S8 ? 3 : 4;
+    out.stored = AllocatePixelBuffer(PixelFormat::R8UI, width, height, dst);
+    for (int y = 0; y < height; y++) {
+      const uint8_t *row = src + y * srcRowPitch;
+      for (int x = 0; x < width; x++)
+        dst[(size_t)y * width + x] = row[x * pixelSize + offset];
+    }
+    return;
+  }
+
+  if (layout == DepthLayout::D16) {
+    out.stored = AllocatePixelBuffer(PixelFormat::L16, width, height, dst);
+    for (int y = 0; y < height; y++)
+      memcpy(dst + (size_t)y * width * 2, src + y * srcRowPitch,
+             (size_t)width * 2);
+    return;
+  }
+
+  out.stored = AllocatePixelBuffer(PixelFormat::L32F, width, height, dst);
+  const float unorm24Scale = 1.0f / 16777215.0f;
+  for (int y = 0; y < height; y++) {
+    const uint8_t *row = src + y * srcRowPitch;
+    float *depth = (float *)(dst + (size_t)y * width * 4);
+    switch (layout) {
+    case DepthLayout::D32F:
+      memcpy(depth, row, (size_t)width * 4);
+      break;
+    case DepthLayout::D24S8:
+      for (int x = 0; x < width; x++) {
+        uint32_t word;
+        memcpy(&word, row + x * 4, sizeof(word));
+        depth[x] = (word & 0xFFFFFF) * unorm24Scale;
+      }
+      break;
+    default:
+      for (int x = 0; x < width; x++)
+        memcpy(depth + x, row + x * 8, sizeof(float));
+      break;
+    }
+  }
+}
+
+// Formats kept as stored: halves, packed render target formats and
+// integers, which are widened where values are read
+bool GetStoredFormat(DXGI_FORMAT format, PixelFormat &pixelFormat) {
+  switch (format) {
+  case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    pixelFormat = PixelFormat::RGBA16F;
+    return true;
+  case DXGI_FORMAT_R11G11B10_FLOAT:
+    pixelFormat = PixelFormat::R11G11B10F;
+    return true;
+  case DXGI_FORMAT_R10G10B10A2_UNORM:
+    pixelFormat = PixelFormat::RGB10A2;
+    return true;
+  case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    pixelFormat = PixelFormat::RGB9E5;
+    return true;
+  case DXGI_FORMAT_B5G6R5_UNORM:
+    pixelFormat = PixelFormat::B5G6R5;
+    return true;
+  default:
+    break;
+  }
+  for (const IntegerFormat &entry : g_IntegerFormats) {
+    if (entry.dxgiFormat == format) {
+      pixelFormat = entry.pixelFormat;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *GetPixelFormatName(DXGI_FORMAT format) {
+  PixelFormat stored;
+  if (GetStoredFormat(format, stored))
+    return GetPixelFormatInfo(stored).name;
+  DepthLayout depthLayout = GetDepthLayout(format);
+  if (depthLayout != DepthLayout::None)
+    return GetDepthLayoutName(depthLayout);
+  switch (format) {
+  case DXGI_FORMAT_R8G8B8A8_UNORM:
+    return "RGBA8";
+  case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    return "RGBA32F";
+  case DXGI_FORMAT_R16G16_FLOAT:
+    return "RG16F";
+  case DXGI_FORMAT_R32G32_FLOAT:
+    return "RG32F";
+  default:
+    return "Unknown";
+  }
+}
+
+// Two-channel float formats hold motion vectors and velocities
+bool IsVectorFormat(DXGI_FORMAT format) {
+  return format == DXGI_FORMAT_R16G16_FLOAT ||
+         format == DXGI_FORMAT_R32G32_FLOAT;
+}
+
+} // namespace
+
+DDSImage::DDSImage() {}
+
+DDSImage::~DDSImage() = default;
+
+bool DDSImage::Open(const std::string &filepath) {
+  PROFILE_SCOPE("DDS Open");
+  using namespace DirectX;
+
+  m_surfaces.clear();
+  m_scratch.reset();
+
+  if (!m_file.Open(filepath)) {
+    LOG_ERROR("Failed to open DDS file: %s", filepath.c_str());
+    return false;
+  }
+
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+
+  // FourCC formats are stored exactly as DirectXTex describes them, so their
+  // surfaces are used from the mapping. Legacy bit mask formats may need
+  // expanding, swizzling or an alpha fixup.
+  TexMetadata metadata;
+  uint32_t pixelFlags = 0;
+  if (size >= g_DDSHeaderSize)
+    memcpy(&pixelFlags, data + g_DDSPixelFlagsOffset, sizeof(pixelFlags));
+  bool mapped = (pixelFlags & g_DDPFFourCC) &&
+                SUCCEEDED(GetMetadataFromDDSMemory(
+                    data, size, DDS_FLAGS_NO_LEGACY_EXPANSION, metadata));
+
+  if (mapped) {
+    size_t offset = g_DDSHeaderSize;
+    if (memcmp(data + g_DDSFourCCOffset, "DX10", 4) == 0)
+      offset += g_DDSHeaderDX10Size;
+
+    auto addSurface = [&](size_t width, size_t height) {
+      size_t rowPitch = 0, slicePitch = 0;
+      if (FAILED(ComputePitch(metadata.format, width, height, rowPitch,
+                              slicePitch)) ||
+          offset > size || slicePitch > size - offset)
+        return false;
+      m_surfaces.push_back({data + offset, rowPitch, slicePitch});
+      offset += slicePitch;
+      return true;
+    };
+
+    if (metadata.IsVolumemap()) {
+      for (size_t mip = 0; mip < metadata.mipLevels && mapped; mip++) {
+        size_t width = std::max<size_t>(1, metadata.width >> mip);
+        size_t height = std::max<size_t>(1, metadata.height >> mip);
+        size_t depth = std::max<size_t>(1, metadata.depth >> mip);
+        for (size_t slice = 0; slice < depth && mapped; slice++)
+          mapped = addSurface(width, height);
+      }
+    } else {
+      for (size_t item = 0; item < metadata.arraySize && mapped; item++) {
+        for (size_t mip = 0; mip < metadata.mipLevels && mapped; mip++) {
+          mapped = addSurface(std::max<size_t>(1, metadata.width >> mip),
+                              std::max<size_t>(1, metadata.height >> mip));
+        }
+      }
+    }
+
+    if (!mapped) {
+      LOG_ERROR("DDS file is truncated: %s", filepath.c_str());
+      return false;
+    }
+  } else {
+    // Legacy formats are expanded by DirectXTex when the file is loaded
+    PROFILE_SCOPE("LoadFromDDSMemory");
+    m_scratch = std::make_unique<ScratchImage>();
+    if (FAILED(LoadFromDDSMemory(data, size, DDS_FLAGS_NONE, &metadata,
+                                 *m_scratch))) {
+      LOG_ERROR("Failed to load DDS file: %s", filepath.c_str());
+      return false;
+    }
+    const Image *images = m_scratch->GetImages();
+    for (size_t i = 0; i < m_scratch->GetImageCount(); i++) {
+      m_surfaces.push_back(
+          {images[i].pixels, images[i].rowPitch, images[i].slicePitch});
+    }
+    m_file.Close();
+  }
+
+  m_dxgiFormat = metadata.format;
+  m_volume = metadata.IsVolumemap();
+
+  BCFormat bcFormat;
+  PixelFormat storedFormat;
+  DepthLayout depthLayout = GetDepthLayout(metadata.format);
+  m_layout = SubresourceLayout();
+  m_layout.width = (int)metadata.width;
+  m_layout.height = (int)metadata.height;
+  m_layout.depth = (int)metadata.depth;
+  m_layout.mipLevels = (int)metadata.mipLevels;
+  m_layout.faceCount = metadata.IsCubemap() ? 6 : 1;
+  m_layout.arraySize = (int)metadata.arraySize / m_layout.faceCount;
+  m_layout.format = "DDS";
+  if (GetBCFormat(metadata.format, bcFormat, m_layout.channels)) {
+    m_layout.pixelFormat = GetBCFormatName(bcFormat);
+  } else if (GetStoredFormat(metadata.format, storedFormat)) {
+    m_layout.pixelFormat = GetPixelFormatName(metadata.format);
+    m_layout.channels = GetPixelFormatInfo(storedFormat).channels;
+  } else if (depthLayout != DepthLayout::None) {
+    m_layout.pixelFormat = GetPixelFormatName(metadata.format);
+    m_layout.channels = 1;
+  } else {
+    m_layout.pixelFormat = GetPixelFormatName(metadata.format);
+    m_layout.channels = IsVectorFormat(metadata.format) ? 2 : 4;
+  }
+
+  // Depth and stencil are shown as layers of their own
+  m_planes = HasStencil(depthLayout) ? 2 : 1;
+  if (m_planes == 2) {
+    int fileLayers = m_layout.arraySize;
+    m_layout.arraySize *= 2;
+    for (int layer = 0; layer < fileLayers; layer++) {
+      std::string suffix =
+          fileLayers > 1 ? " " + std::to_string(layer) : std::string();
+      m_layout.layerNames.push_back("Depth" + suffix);
+      m_layout.layerNames.push_back("Stencil" + suffix);
+    }
+  }
+
+  LOG("Opened DDS %dx%dx%d, %d mips, %d layers, %d faces, %s%s",
+      m_layout.width, m_layout.height, m_layout.depth, m_layout.mipLevels,
+      m_layout.arraySize, m_layout.faceCount, m_layout.pixelFormat.c_str(),
+      m_scratch ? " (expanded)" : "");
+  return true;
+}
+
+bool DDSImage::Decode(const SubresourceIndex &index, ImageData &out) {
+  PROFILE_SCOPE("DDS Decode");
+  using namespace DirectX;
+
+  // Only stored slices; BrickedVolume slices volumes across other axes
+  if (!m_layout.Contains(index) || index.axis != SliceAxis::Z)
+    return false;
+
+  size_t surfaceIndex;
+  if (m_volume) {
+    surfaceIndex = index.slice;
+    for (int mip = 0; mip < index.mip; mip++)
+      surfaceIndex += m_layout.GetMipDepth(mip);
+  } else {
+    size_t item =
+        (size_t)(index.layer / m_planes) * m_layout.faceCount + index.face;
+    surfaceIndex = item * m_layout.mipLevels + index.mip;
+  }
+  if (surfaceIndex >= m_surfaces.size())
+    return false;
+  const Surface &surface = m_surfaces[surfaceIndex];
+
+  int width = std::max(1, m_layout.width >> index.mip);
+  int height = std::max(1, m_layout.height >> index.mip);
+  DXGI_FORMAT format = static_cast<DXGI_FORMAT>(m_dxgiFormat);
+
+  out.width = width;
+  out.height = height;
+  out.channels = m_layout.channels;
+  out.format = m_layout.format;
+  out.pixelFormat = m_layout.pixelFormat;
+  out.vectors = IsVectorFormat(format);
+
+  // Depth buffers are split into their depth and stencil planes
+  DepthLayout depthLayout = GetDepthLayout(format);
+  if (depthLayout != DepthLayout::None) {
+    PROFILE_SCOPE("DDS DecodeDepth");
+    bool stencil = index.layer % m_planes == 1;
+    out.pixels.clear();
+    out.channels = 1;
+    out.depth = !stencil;
+    if (m_planes == 2)
+      out.pixelFormat += stencil ? " stencil" : " depth";
+    DecodeDepthPlane(depthLayout, stencil, surface.pixels, surface.rowPitch,
+                     width, height, out);
+    return true;
+  }
+
+  // Half floats, packed and integer formats are kept as stored; they are
+  // widened where values are read
+  PixelFormat storedFormat;
+  if (GetStoredFormat(format, storedFormat)) {
+    out.pixels.clear();
+    uint8_t *dst;
+    out.stored = AllocatePixelBuffer(storedFormat, width, height, dst);
+    size_t rowSize = (size_t)out.stored.rowPitch;
+    for (int y = 0; y < height; y++)
+      memcpy(dst + y * rowSize, surface.pixels + y * surface.rowPitch, rowSize);
+    return true;
+  }
+
+  out.stored = PixelBuffer();
+  out.pixels.resize((size_t)width * height * 4);
+
+  // Block-compressed surfaces go through our own decoder
+  BCFormat bcFormat;
+  int channels;
+  if (GetBCFormat(format, bcFormat, channels)) {
+    PROFILE_SCOPE("DDS DecodeBC");
+    return DecodeBCImage(bcFormat, surface.pixels, surface.rowPitch, width,
+                         height, out.pixels.data());
+  }
+
+  const uint8_t *src = surface.pixels;
+  size_t srcRowPitch = surface.rowPitch;
+
+  // Convert to RGBA32F if not already
+  ScratchImage converted;
+  if (format != DXGI_FORMAT_R32G32B32A32_FLOAT) {
+    PROFILE_SCOPE("DDS Convert");
+    Image image = {};
+    image.width = width;
+    image.height = height;
+    image.format = format;
+    image.rowPitch = surface.rowPitch;
+    image.slicePitch = surface.slicePitch;
+    image.pixels = const_cast<uint8_t *>(surface.pixels);
+
+    if (FAILED(Convert(image, DXGI_FORMAT_R32G32B32A32_FLOAT,
+                       TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT,
+                       converted))) {
+      LOG_ERROR("Failed to convert DDS format %u", m_dxgiFormat);
+      return false;
+    }
+    src = converted.GetImage(0, 0, 0)->pixels;
+    srcRowPitch = converted.GetImage(0, 0, 0)->rowPitch;
+  }
+
+  // Copy pixel data
+  size_t rowSize = (size_t)width * 4 * sizeof(float);
+  for (int y = 0; y < height; y++) {
+    memcpy(out.pixels.data() + (size_t)y * width * 4, src + y * srcRowPitch,
+           rowSize);
+  }
+  return true;
+}
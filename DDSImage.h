@@ -0,0 +1,59 @@
+#pragma once
+#include "ImageSource.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace DirectX {
+class ScratchImage;
+}
+
+/**
+ * @brief DDS texture with all of its mips, array slices, cube faces and
+ * volume slices.
+ *
+ * Open() reads the header through a memory mapping and records where each
+ * 2D surface lives; Decode() converts only the requested surface. Legacy
+ * pixel formats that DirectXTex has to expand (24 bpp, palettes, ...) are
+ * loaded into memory whole instead, but are still converted per surface.
+ *
+ * Depth buffers are kept as depth (L32F, or L16 for D16) and flagged for
+ * linearization. Formats with stencil show it as a second layer (R8UI)
+ * after each layer's depth.
+ */
+class DDSImage : public ImageSource {
+public:
+  DDSImage();
+  ~DDSImage() override;
+
+  /**
+   * @brief Maps the file and reads its header.
+   * @return False if the file is not a valid DDS file.
+   */
+  bool Open(const std::string &filepath);
+
+  const SubresourceLayout &GetLayout() const override { return m_layout; }
+
+  bool Decode(const SubresourceIndex &index, ImageData &out) override;
+
+private:
+  struct Surface {
+    const uint8_t *pixels;
+    size_t rowPitch;
+    size_t slicePitch;
+  };
+
+  MappedFile m_file;
+  SubresourceLayout m_layout;
+  uint32_t m_dxgiFormat = 0;
+  bool m_volume = false;
+  int m_planes = 1; ///< 2 for depth-stencil formats: depth, stencil layers
+
+  // Surfaces in DirectXTex order: items (layers * faces) then mips for 2D
+  // textures, mips then slices for volumes
+  std::vector<Surface> m_surfaces;
+
+  // Expanded copy of legacy-format files, owns the surface memory
+  std::unique_ptr<DirectX::ScratchImage> m_scratch;
+};
@@ -1,290 +1,290 @@
-#include "pch.h"
-#include "DX12Renderer.h"
-#include <stdexcept>
-
-DX12Renderer::DX12Renderer()
-    : m_frameIndex(0)
-    , m_rtvDescriptorSize(0)
-    , m_fenceEvent(nullptr)
-    , m_hwnd(nullptr)
-    , m_width(0)
-    , m_height(0)
-{
-    for (UINT i = 0; i < FrameCount; i++)
-    {
-        m_fenceValues[i] = 0;
-    }
-}
-
-DX12Renderer::~DX12Renderer()
-{
-    Cleanup();
-}
-
-bool DX12Renderer::Initialize(HWND hwnd, UINT width, UINT height)
-{
-    m_hwnd = hwnd;
-    m_width = width;
-    m_height = height;
-
-    m_viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f };
-    m_scissorRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
-
-    UINT dxgiFactoryFlags = 0;
-
-#ifdef _DEBUG
-    // Enable the debug layer
-    ComPtr<ID3D12Debug> debugController;
-    if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
-    {
-        debugController->EnableDebugLayer();
-        dxgiFactoryFlags |= DXGI_CREATE_FACTORY_DEBUG;
-    }
-#endif
-
-    // Create factory
-    ComPtr<IDXGIFactory4> factory;
-    if (FAILED(CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&factory))))
-        return false;
-
-    // Create device
-    ComPtr<IDXGIAdapter1> hardwareAdapter;
-    for (UINT adapterIndex = 0; ; ++adapterIndex)
-    {
-        hardwareAdapter = nullptr;
-        if (DXGI_ERROR_NOT_FOUND == factory->EnumAdapters1(adapterIndex, &hardwareAdapter))
-            break;
-
-        if (SUCCEEDED(D3D12CreateDevice(hardwareAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&m_device))))
-            break;
-    }
-
-    if (!m_device)
-        return false;
-
-    // Create command queue
-    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
-    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-
-    if (FAILED(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue))))
-        return false;
-
-    // Create swap chain
-    DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-    swapChainDesc.BufferCount = FrameCount;
-    swapChainDesc.Width = width;
-    swapChainDesc.Height = height;
-    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapChainDesc.SampleDesc.Count = 1;
-
-    ComPtr<IDXGISwapChain1> swapChain;
-    if (FAILED(factory->CreateSwapChainForHwnd(
-        m_commandQueue.Get(),
-        hwnd,
-        &swapChainDesc,
-        nullptr,
-        nullptr,
-        &swapChain)))
-        return false;
-
-    if (FAILED(swapChain.As(&m_swapChain)))
-        return false;
-
-    // Disable Alt+Enter fullscreen
-    factory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER);
-
-    m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
-
-    // Create descriptor heaps
-    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-    rtvHeapDesc.NumDescriptors = FrameCount;
-    rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-    rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-
-    if (FAILED(m_device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap))))
-        return false;
-
-    m_rtvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-
-    // Create SRV heap for ImGui
-    D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-    srvHeapDesc.NumDescriptors = 100;  // Space for ImGui and textures
-    srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-
-    if (FAILED(m_device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_srvHeap))))
-        return false;
-
-    // Create frame resources
-    CreateRenderTargetViews();
-
-    // Create command allocators
-    for (UINT i = 0; i < FrameCount; i++)
-    {
-        if (FAILED(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocators[i]))))
-            return false;
-    }
-
-    // Create command list
-    if (FAILED(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[m_frameIndex].Get(), nullptr, IID_PPV_ARGS(&m_commandList))))
-        return false;
-
-    // Command lists are created in the recording state, close it now
-    m_commandList->Close();
-
-    // Create synchronization objects
-    if (FAILED(m_device->CreateFence(m_fenceValues[m_frameIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence))))
-        return false;
-
-    m_fenceValues[m_frameIndex]++;
-
-    m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    if (!m_fenceEvent)
-        return false;
-
-    return true;
-}
-
-void DX12Renderer::CreateRenderTargetViews()
-{
-    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-
-    for (UINT i = 0; i < FrameCount; i++)
-    {
-        m_swapChain->GetBuffer(i, IID_PPV_ARGS(&m_renderTargets[i]));
-        m_device->CreateRenderTargetView(m_renderTargets[i].Get(), nullptr, rtvHandle);
-        rtvHandle.ptr += m_rtvDescriptorSize;
-    }
-}
-
-void DX12Renderer::PopulateCommandList()
-{
-    m_commandAllocators[m_frameIndex]->Reset();
-    m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), nullptr);
-
-    // Set viewport and scissor
-    m_commandList->RSSetViewports(1, &m_viewport);
-    m_commandList->RSSetScissorRects(1, &m_scissorRect);
-
-    // Transition to render target state
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    barrier.Transition.pResource = m_renderTargets[m_frameIndex].Get();
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-
-    m_commandList->ResourceBarrier(1, &barrier);
-
-    // Get RTV handle
-    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-    rtvHandle.ptr += m_frameIndex * m_rtvDescriptorSize;
-
-    // Clear render target
-    const float clearColor[] = { 0.1f, 0.1f, 0.1f, 1.0f };  // Dark gray
-    m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-    m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
-
-    // Set descriptor heaps for ImGui
-    ID3D12DescriptorHeap* heaps[] = { m_srvHeap.Get() };
-    m_commandList->SetDescriptorHeaps(_countof(heaps), heaps);
-}
-
-void DX12Renderer::BeginRender()
-{
-    // Record commands
-    PopulateCommandList();
-    // Command list is now open and ready for ImGui to render
-}
-
-void DX12Renderer::EndRender()
-{
-    // Transition back to present state
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    barrier.Transition.pResource = m_renderTargets[m_frameIndex].Get();
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-
-    m_commandList->ResourceBarrier(1, &barrier);
-    m_commandList->Close();
-
-    // Execute command list
-    ID3D12CommandList* commandLists[] = { m_commandList.Get() };
-    m_commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
-
-    // Present
-    m_swapChain->Present(1, 0);
-
-    MoveToNextFrame();
-}
-
-void DX12Renderer::WaitForGpu()
-{
-    m_commandQueue->Signal(m_fence.Get(), m_fenceValues[m_frameIndex]);
-    m_fence->SetEventOnCompletion(m_fenceValues[m_frameIndex], m_fenceEvent);
-    WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
-    m_fenceValues[m_frameIndex]++;
-}
-
-void DX12Renderer::MoveToNextFrame()
-{
-    const UINT64 currentFenceValue = m_fenceValues[m_frameIndex];
-    m_commandQueue->Signal(m_fence.Get(), currentFenceValue);
-
-    m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
-
-    if (m_fence->GetCompletedValue() < m_fenceValues[m_frameIndex])
-    {
-        m_fence->SetEventOnCompletion(m_fenceValues[m_frameIndex], m_fenceEvent);
-        WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
-    }
-
-    m_fenceValues[m_frameIndex] = currentFenceValue + 1;
-}
-
-void DX12Renderer::OnResize(UINT width, UINT height)
-{
-    if (!m_device || width == 0 || height == 0)
-        return;
-
-    WaitForGpu();
-
-    for (UINT i = 0; i < FrameCount; i++)
-    {
-        m_renderTargets[i].Reset();
-        m_fenceValues[i] = m_fenceValues[m_frameIndex];
-    }
-
-    DXGI_SWAP_CHAIN_DESC desc = {};
-    m_swapChain->GetDesc(&desc);
-    m_swapChain->ResizeBuffers(FrameCount, width, height, desc.BufferDesc.Format, desc.Flags);
-
-    m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
-    CreateRenderTargetViews();
-
-    m_width = width;
-    m_height = height;
-    m_viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f };
-    m_scissorRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
-}
-
-void DX12Renderer::Cleanup()
-{
-    if (m_device)
-    {
-        WaitForGpu();
-    }
-
-    if (m_fenceEvent)
-    {
-        CloseHandle(m_fenceEvent);
-        m_fenceEvent = nullptr;
-    }
-}
+#include "pch.h"
+#include "DX12Renderer.h"
+#include <stdexcept>
+
+DX12Renderer::DX12Renderer()
+    : m_frameIndex(0)
+    , m_rtvDescriptorSize(0)
+    , m_fenceEvent(nullptr)
+    , m_hwnd(nullptr)
+    , m_width(0)
+    , m_height(0)
+{
+    for (UINT i = 0; i < FrameCount; i++)
+    {
+        m_fenceValues[i] = 0;
+    }
+}
+
+DX12Renderer::~DX12Renderer()
+{
+    Cleanup();
+}
+
+bool DX12Renderer::Initialize(HWND hwnd, UINT width, UINT height)
+{
+    m_hwnd = hwnd;
+    m_width = width;
+    m_height = height;
+
+    m_viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f };
+    m_scissorRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+
+    UINT dxgiFactoryFlags = 0;
+
+#ifdef _DEBUG
+    // Enable the debug layer
+    ComPtr<ID3D12Debug> debugController;
+    if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
+    {
+        debugController->EnableDebugLayer();
+        dxgiFactoryFlags |= DXGI_CREATE_FACTORY_DEBUG;
+    }
+#endif
+
+    // Create factory
+    ComPtr<IDXGIFactory4> factory;
+    if (FAILED(CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&factory))))
+        return false;
+
+    // Create device
+    ComPtr<IDXGIAdapter1> hardwareAdapter;
+    for (UINT adapterIndex = 0; ; ++adapterIndex)
+    {
+        hardwareAdapter = nullptr;
+        if (DXGI_ERROR_NOT_FOUND == factory->EnumAdapters1(adapterIndex, &hardwareAdapter))
+            break;
+
+        if (SUCCEEDED(D3D12CreateDevice(hardwareAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&m_device))))
+            break;
+    }
+
+    if (!m_device)
+        return false;
+
+    // Create command queue
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+    if (FAILED(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue))))
+        return false;
+
+    // Create swap chain
+    DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+    swapChainDesc.BufferCount = FrameCount;
+    swapChainDesc.Width = width;
+    swapChainDesc.Height = height;
+    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    swapChainDesc.SampleDesc.Count = 1;
+
+    ComPtr<IDXGISwapChain1> swapChain;
+    if (FAILED(factory->CreateSwapChainForHwnd(
+        m_commandQueue.Get(),
+        hwnd,
+        &swapChainDesc,
+        nullptr,
+        nullptr,
+        &swapChain)))
+        return false;
+
+    if (FAILED(swapChain.As(&m_swapChain)))
+        return false;
+
+    // Disable Alt+Enter fullscreen
+    factory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER);
+
+    m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+
+    // Create descriptor heaps
+    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+    rtvHeapDesc.NumDescriptors = FrameCount;
+    rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+    if (FAILED(m_device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap))))
+        return false;
+
+    m_rtvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+    // Create SRV heap for ImGui
+    D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
+    srvHeapDesc.NumDescriptors = 100;  // Space for ImGui and textures
+    srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+    if (FAILED(m_device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_srvHeap))))
+        return false;
+
+    // Create frame resources
+    CreateRenderTargetViews();
+
+    // Create command allocators
+    for (UINT i = 0; i < FrameCount; i++)
+    {
+        if (FAILED(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocators[i]))))
+            return false;
+    }
+
+    // Create command list
+    if (FAILED(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[m_frameIndex].Get(), nullptr, IID_PPV_ARGS(&m_commandList))))
+        return false;
+
+    // Command lists are created in the recording state, close it now
+    m_commandList->Close();
+
+    // Create synchronization objects
+    if (FAILED(m_device->CreateFence(m_fenceValues[m_frameIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence))))
+        return false;
+
+    m_fenceValues[m_frameIndex]++;
+
+    m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!m_fenceEvent)
+        return false;
+
+    return true;
+}
+
+void DX12Renderer::CreateRenderTargetViews()
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
+
+    for (UINT i = 0; i < FrameCount; i++)
+    {
+        m_swapChain->GetBuffer(i, IID_PPV_ARGS(&m_renderTargets[i]));
+        m_device->CreateRenderTargetView(m_renderTargets[i].Get(), nullptr, rtvHandle);
+        rtvHandle.ptr += m_rtvDescriptorSize;
+    }
+}
+
+void DX12Renderer::PopulateCommandList()
+{
+    m_commandAllocators[m_frameIndex]->Reset();
+    m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), nullptr);
+
+    // Set viewport and scissor
+    m_commandList->RSSetViewports(1, &m_viewport);
+    m_commandList->RSSetScissorRects(1, &m_scissorRect);
+
+    // Transition to render target state
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource = m_renderTargets[m_frameIndex].Get();
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+    m_commandList->ResourceBarrier(1, &barrier);
+
+    // Get RTV handle
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
+    rtvHandle.ptr += m_frameIndex * m_rtvDescriptorSize;
+
+    // Clear render target
+    const float clearColor[] = { 0.1f, 0.1f, 0.1f, 1.0f };  // Dark gray
+    m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+    m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+
+    // Set descriptor heaps for ImGui
+    ID3D12DescriptorHeap* heaps[] = { m_srvHeap.Get() };
+    m_commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+}
+
+void DX12Renderer::BeginRender()
+{
+    // Record commands
+    PopulateCommandList();
+    // Command list is now open and ready for ImGui to render
+}
+
+void DX12Renderer::EndRender()
+{
+    // Transition back to present state
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource = m_renderTargets[m_frameIndex].Get();
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+    m_commandList->ResourceBarrier(1, &barrier);
+    m_commandList->Close();
+
+    // Execute command list
+    ID3D12CommandList* commandLists[] = { m_commandList.Get() };
+    m_commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+    // Present
+    m_swapChain->Present(1, 0);
+
+    MoveToNextFrame();
+}
+
+void DX12Renderer::WaitForGpu()
+{
+    m_commandQueue->Signal(m_fence.Get(), m_fenceValues[m_frameIndex]);
+    m_fence->SetEventOnCompletion(m_fenceValues[m_frameIndex], m_fenceEvent);
+    WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+    m_fenceValues[m_frameIndex]++;
+}
+
+void DX12Renderer::MoveToNextFrame()
+{
+    const UINT64 currentFenceValue = m_fenceValues[m_frameIndex];
+    m_commandQueue->Signal(m_fence.Get(), currentFenceValue);
+
+    m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+
+    if (m_fence->GetCompletedValue() < m_fenceValues[m_frameIndex])
+    {
+        m_fence->SetEventOnCompletion(m_fenceValues[m_frameIndex], m_fenceEvent);
+        WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+    }
+
+    m_fenceValues[m_frameIndex] = currentFenceValue + 1;
+}
+
+void DX12Renderer::OnResize(UINT width, UINT height)
+{
+    if (!m_device || width == 0 || height == 0)
+        return;
+
+    WaitForGpu();
+
+    for (UINT i = 0; i < FrameCount; i++)
+    {
+        m_renderTargets[i].Reset();
+        m_fenceValues[i] = m_fenceValues[m_frameIndex];
+    }
+
+    DXGI_SWAP_CHAIN_DESC desc = {};
+    m_swapChain->GetDesc(&desc);
+    m_swapChain->ResizeBuffers(FrameCount, width, height, desc.BufferDesc.Format, desc.Flags);
+
+    m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+    CreateRenderTargetViews();
+
+    m_width = width;
+    m_height = height;
+    m_viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f };
+    m_scissorRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+}
+
+void DX12Renderer::Cleanup()
+{
+    if (m_device)
+    {
+        WaitForGpu();
+    }
+
+    if (m_fenceEvent)
+    {
+        CloseHandle(m_fenceEvent);
+        m_fenceEvent = nullptr;
+    }
+}
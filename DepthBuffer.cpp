@@ -0,0 +1,176 @@
+#include "DepthBuffer.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEPTH_BUFFER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// distance = a / (b + c * depth)
+struct DepthMapping {
+  float a, b, c;
+};
+
+DepthMapping GetDepthMapping(const DepthSettings &settings) {
+  float n = settings.nearPlane;
+  float f = settings.farPlane;
+  if (settings.infiniteFar) {
+    // depth = 1 - n / z, or n / z with reverse-Z
+    return settings.reverseZ ? DepthMapping{n, 0.0f, 1.0f}
+                             : DepthMapping{n, 1.0f, -1.0f};
+  }
+  // depth = f / (f - n) * (1 - n / z), or 1 minus that with reverse-Z
+  return settings.reverseZ ? DepthMapping{n * f, n, f - n}
+                           : DepthMapping{n * f, f, n - f};
+}
+
+// Linearizes one row of L32F (unorm16 false) or L16 depth
+void LinearizeRow(const uint8_t *src, bool unorm16, int width,
+                  const DepthMapping &m, float *dst) {
+  const float unormScale = 1.0f / 65535.0f;
+  int x = 0;
+#ifdef DEPTH_BUFFER_SSE2
+  const __m128 vA = _mm_set1_ps(m.a);
+  const __m128 vB = _mm_set1_ps(m.b);
+  const __m128 vC = _mm_set1_ps(m.c);
+  const __m128 vUnormScale = _mm_set1_ps(unormScale);
+  const __m128i vZero = _mm_setzero_si128();
+  for (; x + 4 <= width; x += 4) {
+    __m128 depth;
+    if (unorm16) {
+      __m128i codes = _mm_loadl_epi64((const __m128i *)(src + x * 2));
+      depth = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(codes, vZero)),
+                         vUnormScale);
+    } else {
+      depth = _mm_loadu_ps((const float *)src + x);
+    }
+    __m128 distance = _mm_div_ps(vA, _mm_add_ps(vB, _mm_mul_ps(vC, depth)));
+    _mm_storeu_ps(dst + x, distance);
+  }
+#endif
+  for (; x < width; x++) {
+    float depth;
+    if (unorm16) {
+      uint16_t code;
+      memcpy(&code, src + x * 2, sizeof(code));
+      depth = code * unormScale;
+    } else {
+      memcpy(&depth, src + x * 4, sizeof(depth));
+    }
+    dst[x] = m.a / (m.b + m.c * depth);
+  }
+}
+
+// Finite min/max of one row of distances; NaN and infinities are skipped
+void ScanDistanceRow(const float *row, int width, float &minValue,
+                     float &maxValue, bool &hasNaN) {
+  int x = 0;
+#ifdef DEPTH_BUFFER_SSE2
+  const __m128 vAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 vInf = _mm_set1_ps(INFINITY);
+  const __m128 vFltMax = _mm_set1_ps(FLT_MAX);
+  const __m128 vNegFltMax = _mm_set1_ps(-FLT_MAX);
+  __m128 vMin = _mm_set1_ps(minValue);
+  __m128 vMax = _mm_set1_ps(maxValue);
+  __m128 vNaN = _mm_setzero_ps();
+  for (; x + 4 <= width; x += 4) {
+    __m128 v = _mm_loadu_ps(row + x);
+    // |v| < inf is false for NaN and infinities; those lanes become
+    // +FLT_MAX for the min and -FLT_MAX for the max
+    __m128 finite = _mm_cmplt_ps(_mm_and_ps(v, vAbsMask), vInf);
+    __m128 kept = _mm_and_ps(finite, v);
+    vMin = _mm_min_ps(vMin, _mm_or_ps(kept, _mm_andnot_ps(finite, vFltMax)));
+    vMax = _mm_max_ps(vMax, _mm_or_ps(kept, _mm_andnot_ps(finite, vNegFltMax)));
+    vNaN = _mm_or_ps(vNaN, _mm_cmpunord_ps(v, v));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, vMin);
+  minValue = std::min({lanes[0], lanes[1], lanes[2], lanes[3]});
+  _mm_storeu_ps(lanes, vMax);
+  maxValue = std::max({lanes[0], lanes[1], lanes[2], lanes[3]});
+  hasNaN = hasNaN || _mm_movemask_ps(vNaN) != 0;
+#endif
+  for (; x < width; x++) {
+    float value = row[x];
+    if (std::isnan(value)) {
+      hasNaN = true;
+    } else if (std::isfinite(value)) {
+      minValue = std::min(minValue, value);
+      maxValue = std::max(maxValue, value);
+    }
+  }
+}
+
+} // namespace
+
+bool IsSameProjection(const DepthSettings &a, const DepthSettings &b) {
+  return a.nearPlane == b.nearPlane && a.farPlane == b.farPlane &&
+         a.reverseZ == b.reverseZ && a.infiniteFar == b.infiniteFar;
+}
+
+PixelBuffer LinearizeDepth(const PixelBuffer &depth,
+                           const DepthSettings &settings, int threadCount) {
+  PROFILE_SCOPE("LinearizeDepth");
+  if (depth.format != PixelFormat::L32F && depth.format != PixelFormat::L16)
+    return PixelBuffer();
+
+  bool unorm16 = depth.format == PixelFormat::L16;
+  DepthMapping mapping = GetDepthMapping(settings);
+  uint8_t *dst;
+  PixelBuffer result =
+      AllocatePixelBuffer(PixelFormat::L32F, depth.width, depth.height, dst);
+  ptrdiff_t pitch = result.rowPitch;
+  ParallelFor(depth.height, threadCount, [&](int begin, int end) {
+    for (int y = begin; y < end; y++)
+      LinearizeRow(depth.GetRow(y), unorm16, depth.width, mapping,
+                   (float *)(dst + pitch * y));
+  });
+  return result;
+}
+
+ValueRange ComputeDistanceRange(const PixelBuffer &distances,
+                                int threadCount) {
+  PROFILE_SCOPE("ComputeDistanceRange");
+  ValueRange result;
+  if (distances.format != PixelFormat::L32F || !distances.data)
+    return result;
+
+  struct Partial {
+    float minValue = FLT_MAX;
+    float maxValue = -FLT_MAX;
+    bool hasNaN = false;
+  };
+  std::vector<Partial> partials(
+      GetParallelChunkCount(distances.height, threadCount));
+  ParallelForChunks(distances.height, threadCount,
+                    [&](int chunk, int begin, int end) {
+                      Partial &partial = partials[chunk];
+                      for (int y = begin; y < end; y++)
+                        ScanDistanceRow((const float *)distances.GetRow(y),
+                                        distances.width, partial.minValue,
+                                        partial.maxValue, partial.hasNaN);
+                    });
+
+  float minValue = FLT_MAX;
+  float maxValue = -FLT_MAX;
+  for (const Partial &partial : partials) {
+    minValue = std::min(minValue, partial.minValue);
+    maxValue = std::max(maxValue, partial.maxValue);
+    result.hasNaN = result.hasNaN || partial.hasNaN;
+  }
+  result.valid = minValue <= maxValue;
+  if (result.valid) {
+    result.minValue = minValue;
+    result.maxValue = maxValue;
+  }
+  return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ImageAnalysis.h"
+#include "PixelFormat.h"
+
+/**
+ * @brief How the depth planes of depth buffers are shown.
+ */
+struct DepthSettings {
+  bool linearize = false;   ///< Show view-space distance instead of depth
+  float nearPlane = 0.1f;   ///< Distance to the near plane
+  float farPlane = 1000.0f; ///< Distance to the far plane, if there is one
+  bool reverseZ = false;    ///< Depth is 1 at the near plane, 0 at the far
+  bool infiniteFar = false; ///< The projection has no far plane
+};
+
+/**
+ * @brief Checks if two settings map depth to the same distances.
+ */
+bool IsSameProjection(const DepthSettings &a, const DepthSettings &b);
+
+/**
+ * @brief Converts depth as a D3D projection writes it to view-space
+ * distance.
+ *
+ * For a standard projection, distance = near * far / (far - depth * (far -
+ * near)); reverse-Z and infinite projections use the matching inverses. All
+ * of them are evaluated as a / (b + c * depth), with SSE2 where available,
+ * in parallel over rows. Depth at an infinite far plane becomes +Inf.
+ * @param depth L32F or L16 depth.
+ * @param threadCount 0 = hardware threads.
+ * @return L32F distances, or an empty buffer for other formats.
+ */
+PixelBuffer LinearizeDepth(const PixelBuffer &depth,
+                           const DepthSettings &settings, int threadCount = 0);
+
+/**
+ * @brief Finds the range of the finite distances of LinearizeDepth output.
+ *
+ * Infinite distances (the cleared far plane of an infinite projection) are
+ * skipped like NaN, so they show at the far end of the range instead of
+ * stretching it to +Inf.
+ * @param distances L32F distances.
+ * @param threadCount 0 = hardware threads.
+ */
+ValueRange ComputeDistanceRange(const PixelBuffer &distances,
+                                int threadCount = 0);
@@ -0,0 +1,1226 @@
+#include "EXRImage.h"
+#include "HalfFloat.h"
+#include "Logger.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <zlib.h>
+
+namespace {
+
+// Compression methods (OpenEXR file layout, "compression" attribute)
+enum : int {
+  CompressionNone = 0,
+  CompressionRLE = 1,
+  CompressionZIPS = 2,
+  CompressionZIP = 3,
+  CompressionPIZ = 4,
+  CompressionPXR24 = 5,
+};
+
+enum : int { ChannelUInt = 0, ChannelHalf = 1, ChannelFloat = 2 };
+enum : int { LevelOne = 0, LevelMipmap = 1, LevelRipmap = 2 };
+
+// Version field flags
+const uint32_t g_TiledFlag = 0x200;
+const uint32_t g_DeepFlag = 0x800;
+const uint32_t g_MultiPartFlag = 0x1000;
+
+// Largest tile width or height; tiles past the data window are pointless
+const int g_MaxTileSize = 1 << 24;
+
+const char *g_CompressionNames[] = {"NONE", "RLE",   "ZIPS", "ZIP", "PIZ",
+                                    "PXR24", "B44", "B44A", "DWAA", "DWAB"};
+
+int32_t ReadI32(const uint8_t *p) {
+  int32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t ReadU64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Most bytes a chunk unpacks to per packed byte: RLE repeats a byte up to
+// 128 times in 2, zlib inflates at most about 1032 to 1 (PXR24 then widens
+// 24-bit floats by a third) and PIZ runs repeat a value 255 times in 9 bits
+uint64_t GetMaxUnpackRatio(int compression) {
+  switch (compression) {
+  case CompressionNone:
+    return 1;
+  case CompressionRLE:
+    return 64;
+  case CompressionPIZ:
+    return 512;
+  default:
+    return 1376;
+  }
+}
+
+int GetLinesPerChunk(int compression) {
+  switch (compression) {
+  case CompressionZIP:
+  case CompressionPXR24:
+    return 16;
+  case CompressionPIZ:
+    return 32;
+  default:
+    return 1;
+  }
+}
+
+// Division and modulo rounding towards minus infinity, for sampled channels
+int FloorDiv(int x, int y) { return x >= 0 ? x / y : -((-x + y - 1) / y); }
+int FloorMod(int x, int y) { return x - y * FloorDiv(x, y); }
+
+// Number of samples of a channel with the given sampling in [min, max]
+int NumSamples(int sampling, int min, int max) {
+  return FloorDiv(max, sampling) - FloorDiv(min - 1, sampling);
+}
+
+int RoundLog2(int x, int roundingMode) {
+  int log = 0;
+  bool remainder = false;
+  while (x > 1) {
+    remainder |= (x & 1) != 0;
+    log++;
+    x >>= 1;
+  }
+  return log + (roundingMode == 1 && remainder ? 1 : 0);
+}
+
+int GetLevelSize(int size, int level, int roundingMode) {
+  int levelSize = size >> level;
+  if (roundingMode == 1 && (levelSize << level) < size)
+    levelSize++;
+  return std::max(levelSize, 1);
+}
+
+// Pixels of one chunk, in data window coordinates scaled to its level
+struct ChunkRect {
+  int minX, minY, maxX, maxY;
+  int tileX, tileY; // Tile coordinates of tiled chunks
+};
+
+// What the unpacking code needs to know about a channel
+struct ChunkChannel {
+  int type;
+  int size;
+  int xSampling;
+  int ySampling;
+  bool needed; // Shown by the layer being decoded
+};
+
+size_t GetUnpackedSize(const std::vector<ChunkChannel> &channels,
+                       const ChunkRect &rect) {
+  size_t size = 0;
+  for (const ChunkChannel &channel : channels) {
+    size_t lines = NumSamples(channel.ySampling, rect.minY, rect.maxY);
+    size += lines * NumSamples(channel.xSampling, rect.minX, rect.maxX) *
+            channel.size;
+  }
+  return size;
+}
+
+// ---- RLE and ZIP ----
+
+bool UnpackRLE(const uint8_t *src, size_t size, uint8_t *dst,
+               size_t dstSize) {
+  const uint8_t *end = src + size;
+  uint8_t *dstEnd = dst + dstSize;
+  while (src < end) {
+    int count = (int8_t)*src++;
+    if (count < 0) {
+      count = -count;
+      if (end - src < count || dstEnd - dst < count)
+        return false;
+      memcpy(dst, src, count);
+      src += count;
+    } else {
+      if (src == end || dstEnd - dst < count + 1)
+        return false;
+      memset(dst, *src++, count + 1);
+      count++;
+    }
+    dst += count;
+  }
+  return dst == dstEnd;
+}
+
+// Undoes the delta predictor and byte split applied before RLE and zlib
+void UndoZipFilter(uint8_t *data, size_t size, uint8_t *dst) {
+  for (size_t i = 1; i < size; i++)
+    data[i] = (uint8_t)(data[i - 1] + data[i] - 128);
+
+  const uint8_t *first = data;
+  const uint8_t *second = data + (size + 1) / 2;
+  for (size_t i = 0; i + 1 < size; i += 2) {
+    dst[i] = *first++;
+    dst[i + 1] = *second++;
+  }
+  if (size & 1)
+    dst[size - 1] = *first;
+}
+
+bool Inflate(const uint8_t *src, size_t size, uint8_t *dst, size_t dstSize) {
+  uLongf length = (uLongf)dstSize;
+  return uncompress(dst, &length, src, (uLong)size) == Z_OK &&
+         length == dstSize;
+}
+
+// ---- PIZ: Huffman coded wavelet transform ----
+
+const int g_HufEncodeSize = (1 << 16) + 1;
+const int g_HufDecodeBits = 14;
+const int g_HufDecodeSize = 1 << g_HufDecodeBits;
+const int g_ShortZeroRun = 59;
+const int g_LongZeroRun = 63;
+const int g_ShortestLongRun = 2 + g_LongZeroRun - g_ShortZeroRun;
+
+struct HufDecodeEntry {
+  int length;  // Code length for short codes, 0 for long ones
+  int symbol;  // Symbol of a short code, count of long codes
+  int first;   // First long code sharing this prefix, -1 if none
+};
+
+// Huffman tables, reused across the chunks a thread decodes
+struct HufTables {
+  std::vector<uint64_t> codes; // Length in the low 6 bits, code above
+  std::vector<HufDecodeEntry> decode;
+  std::vector<int> nextLong; // Next long code with the same prefix
+};
+
+// Bit reader over the code table and the coded data
+struct BitReader {
+  const uint8_t *pos;
+  const uint8_t *end;
+  uint64_t bits = 0;
+  int count = 0;
+
+  bool Fill() {
+    if (pos >= end)
+      return false;
+    bits = (bits << 8) | *pos++;
+    count += 8;
+    return true;
+  }
+
+  bool Read(int n, uint64_t &value) {
+    while (count < n) {
+      if (!Fill())
+        return false;
+    }
+    count -= n;
+    value = (bits >> count) & ((1ull << n) - 1);
+    return true;
+  }
+};
+
+// Reads the code lengths of symbols min..max and assigns canonical codes
+bool ReadHufCodeTable(BitReader &reader, int min, int max,
+                      std::vector<uint64_t> &codes) {
+  codes.assign(g_HufEncodeSize, 0);
+  for (int symbol = min; symbol <= max; symbol++) {
+    uint64_t length;
+    if (!reader.Read(6, length))
+      return false;
+    int zeroRun = 0;
+    if (length == g_LongZeroRun) {
+      uint64_t run;
+      if (!reader.Read(8, run))
+        return false;
+      zeroRun = (int)run + g_ShortestLongRun;
+    } else if (length >= g_ShortZeroRun) {
+      zeroRun = (int)length - g_ShortZeroRun + 2;
+    }
+    if (zeroRun > 0) {
+      if (symbol + zeroRun > max + 1)
+        return false;
+      symbol += zeroRun - 1; // Lengths are already 0
+      continue;
+    }
+    codes[symbol] = length;
+  }
+
+  // Canonical codes: longer codes first, consecutive within a length
+  uint64_t lengthCounts[59] = {};
+  for (uint64_t length : codes)
+    lengthCounts[length]++;
+  uint64_t code = 0;
+  for (int length = 58; length > 0; length--) {
+    uint64_t next = (code + lengthCounts[length]) >> 1;
+    lengthCounts[length] = code;
+    code = next;
+  }
+  for (uint64_t &entry : codes) {
+    if (entry > 0)
+      entry |= lengthCounts[entry]++ << 6;
+  }
+  return true;
+}
+
+bool BuildHufDecodeTable(int min, int max, HufTables &tables) {
+  tables.decode.assign(g_HufDecodeSize, HufDecodeEntry{0, 0, -1});
+  tables.nextLong.resize(g_HufEncodeSize);
+  for (int symbol = min; symbol <= max; symbol++) {
+    uint64_t code = tables.codes[symbol] >> 6;
+    int length = (int)(tables.codes[symbol] & 63);
+    if (length == 0)
+      continue;
+    if (code >> length)
+      return false;
+
+    if (length > g_HufDecodeBits) {
+      // Long codes are searched among those sharing their first bits
+      HufDecodeEntry &entry =
+          tables.decode[code >> (length - g_HufDecodeBits)];
+      if (entry.length)
+        return false;
+      entry.symbol++;
+      tables.nextLong[symbol] = entry.first;
+      entry.first = symbol;
+    } else {
+      int shift = g_HufDecodeBits - length;
+      HufDecodeEntry *entry = &tables.decode[code << shift];
+      for (int i = 0; i < (1 << shift); i++, entry++) {
+        if (entry->length || entry->first >= 0)
+          return false;
+        entry->length = length;
+        entry->symbol = symbol;
+      }
+    }
+  }
+  return true;
+}
+
+// Emits a symbol; the run-length symbol repeats the previous value
+bool EmitHufSymbol(int symbol, int runSymbol, BitReader &reader,
+                   uint16_t *&out, uint16_t *begin, uint16_t *end) {
+  if (symbol != runSymbol) {
+    if (out >= end)
+      return false;
+    *out++ = (uint16_t)symbol;
+    return true;
+  }
+  if (reader.count < 8 && !reader.Fill())
+    return false;
+  reader.count -= 8;
+  int run = (int)(uint8_t)(reader.bits >> reader.count);
+  if (end - out < run || out == begin)
+    return false;
+  uint16_t value = out[-1];
+  while (run-- > 0)
+    *out++ = value;
+  return true;
+}
+
+bool DecodeHuffman(const uint8_t *src, size_t size, uint16_t *out,
+                   size_t outCount, HufTables &tables) {
+  if (size < 20)
+    return false;
+  int min = ReadI32(src);
+  int max = ReadI32(src + 4);
+  int64_t bitCount = ReadI32(src + 12);
+  if (min < 0 || min >= g_HufEncodeSize || max < 0 ||
+      max >= g_HufEncodeSize || bitCount < 0)
+    return false;
+
+  BitReader tableReader{src + 20, src + size};
+  if (!ReadHufCodeTable(tableReader, min, max, tables.codes) ||
+      !BuildHufDecodeTable(min, max, tables))
+    return false;
+
+  const uint8_t *data = tableReader.pos;
+  if (bitCount > 8 * (int64_t)(src + size - data))
+    return false;
+
+  BitReader reader{data, data + (bitCount + 7) / 8};
+  uint16_t *begin = out;
+  uint16_t *end = out + outCount;
+  const uint64_t mask = g_HufDecodeSize - 1;
+  while (reader.pos < reader.end) {
+    reader.Fill();
+    while (reader.count >= g_HufDecodeBits) {
+      const HufDecodeEntry &entry =
+          tables.decode[(reader.bits >> (reader.count - g_HufDecodeBits)) &
+                        mask];
+      if (entry.length) {
+        reader.count -= entry.length;
+        if (!EmitHufSymbol(entry.symbol, max, reader, out, begin, end))
+          return false;
+        continue;
+      }
+
+      int symbol = entry.first;
+      for (; symbol >= 0; symbol = tables.nextLong[symbol]) {
+        int length = (int)(tables.codes[symbol] & 63);
+        while (reader.count < length && reader.Fill()) {
+        }
+        if (reader.count >= length &&
+            (tables.codes[symbol] >> 6) ==
+                ((reader.bits >> (reader.count - length)) &
+                 ((1ull << length) - 1))) {
+          reader.count -= length;
+          break;
+        }
+      }
+      if (symbol < 0 || !EmitHufSymbol(symbol, max, reader, out, begin, end))
+        return false;
+    }
+  }
+
+  // Padding bits of the last byte are not part of the data
+  int padding = (int)((8 - bitCount) & 7);
+  reader.bits >>= padding;
+  reader.count -= padding;
+  while (reader.count > 0) {
+    const HufDecodeEntry &entry =
+        tables.decode[(reader.bits << (g_HufDecodeBits - reader.count)) &
+                      mask];
+    if (!entry.length || entry.length > reader.count)
+      return false;
+    reader.count -= entry.length;
+    if (!EmitHufSymbol(entry.symbol, max, reader, out, begin, end))
+      return false;
+  }
+  return out == end;
+}
+
+inline void WaveletDecode14(uint16_t l, uint16_t h, uint16_t &a,
+                            uint16_t &b) {
+  int hi = (int16_t)h;
+  int ai = (int16_t)l + (hi & 1) + (hi >> 1);
+  a = (uint16_t)ai;
+  b = (uint16_t)(ai - hi);
+}
+
+inline void WaveletDecode16(uint16_t l, uint16_t h, uint16_t &a,
+                            uint16_t &b) {
+  int m = l;
+  int d = h;
+  int bb = (m - (d >> 1)) & 0xffff;
+  a = (uint16_t)((d + bb - 0x8000) & 0xffff);
+  b = (uint16_t)bb;
+}
+
+// Inverse 2D Haar wavelet of an nx * ny plane with strides ox and oy
+void WaveletDecode(uint16_t *in, int nx, int ox, int ny, int oy,
+                   uint16_t maxValue) {
+  auto decode =
+      maxValue < (1 << 14) ? WaveletDecode14 : WaveletDecode16;
+  int n = std::min(nx, ny);
+  int p = 1;
+  while (p <= n)
+    p <<= 1;
+  p >>= 1;
+  int p2 = p;
+  p >>= 1;
+
+  while (p >= 1) {
+    size_t ox1 = (size_t)ox * p, ox2 = (size_t)ox * p2;
+    size_t oy1 = (size_t)oy * p, oy2 = (size_t)oy * p2;
+    size_t lastY = (size_t)oy * (ny - p2);
+    size_t lastX = (size_t)ox * (nx - p2);
+    uint16_t i00, i01, i10, i11;
+
+    size_t py = 0;
+    for (; py <= lastY; py += oy2) {
+      size_t px = py;
+      for (; px <= py + lastX; px += ox2) {
+        size_t p01 = px + ox1, p10 = px + oy1, p11 = p10 + ox1;
+        decode(in[px], in[p10], i00, i10);
+        decode(in[p01], in[p11], i01, i11);
+        decode(i00, i01, in[px], in[p01]);
+        decode(i10, i11, in[p10], in[p11]);
+      }
+      if (nx & p) {
+        size_t p10 = px + oy1;
+        decode(in[px], in[p10], i00, in[p10]);
+        in[px] = i00;
+      }
+    }
+    if (ny & p) {
+      for (size_t px = py; px <= py + lastX; px += ox2) {
+        size_t p01 = px + ox1;
+        decode(in[px], in[p01], i00, in[p01]);
+        in[px] = i00;
+      }
+    }
+    p2 = p;
+    p >>= 1;
+  }
+}
+
+// ---- Chunk unpacking ----
+
+// Buffers reused across the chunks a thread decodes
+struct ChunkScratch {
+  std::vector<uint8_t> unpacked;
+  std::vector<uint8_t> temp;
+  std::vector<uint16_t> planes;
+  std::vector<uint16_t> lut;
+  HufTables huffman;
+  std::vector<uint16_t> halfRow;
+  std::vector<uint32_t> uintRow;
+  std::vector<float> floatRow;
+};
+
+bool UnpackPIZ(const uint8_t *src, size_t size,
+               const std::vector<ChunkChannel> &channels,
+               const ChunkRect &rect, uint8_t *dst, size_t dstSize,
+               ChunkScratch &scratch) {
+  // Bitmap of the 16-bit values present, then Huffman coded wavelet planes
+  const int bitmapSize = 8192;
+  if (size < 4)
+    return false;
+  int minNonZero = src[0] | (src[1] << 8);
+  int maxNonZero = src[2] | (src[3] << 8);
+  size_t pos = 4;
+  uint8_t bitmap[bitmapSize] = {};
+  if (maxNonZero >= bitmapSize)
+    return false;
+  if (minNonZero <= maxNonZero) {
+    size_t count = maxNonZero - minNonZero + 1;
+    if (size - pos < count)
+      return false;
+    memcpy(bitmap + minNonZero, src + pos, count);
+    pos += count;
+  }
+
+  // Values were remapped to their index among the values present
+  std::vector<uint16_t> &lut = scratch.lut;
+  lut.assign(1 << 16, 0);
+  int lutSize = 0;
+  for (int i = 0; i < (1 << 16); i++) {
+    if (i == 0 || (bitmap[i >> 3] & (1 << (i & 7))))
+      lut[lutSize++] = (uint16_t)i;
+  }
+  uint16_t maxValue = (uint16_t)(lutSize - 1);
+
+  if (size - pos < 4)
+    return false;
+  int32_t length = ReadI32(src + pos);
+  pos += 4;
+  if (length < 0 || (size_t)length > size - pos)
+    return false;
+
+  std::vector<uint16_t> &planes = scratch.planes;
+  planes.resize(dstSize / 2);
+  if (!DecodeHuffman(src + pos, length, planes.data(), planes.size(),
+                     scratch.huffman))
+    return false;
+
+  // Channels are stored as separate planes; skipped ones stay transformed
+  std::vector<size_t> starts;
+  size_t start = 0;
+  for (const ChunkChannel &channel : channels) {
+    int nx = NumSamples(channel.xSampling, rect.minX, rect.maxX);
+    int ny = NumSamples(channel.ySampling, rect.minY, rect.maxY);
+    int words = channel.size / 2;
+    size_t count = (size_t)nx * ny * words;
+    if (channel.needed) {
+      for (int j = 0; j < words; j++)
+        WaveletDecode(&planes[start + j], nx, words, ny, nx * words,
+                      maxValue);
+      for (size_t i = start; i < start + count; i++)
+        planes[i] = lut[planes[i]];
+    }
+    starts.push_back(start);
+    start += count;
+  }
+
+  for (int y = rect.minY; y <= rect.maxY; y++) {
+    for (size_t c = 0; c < channels.size(); c++) {
+      const ChunkChannel &channel = channels[c];
+      if (FloorMod(y, channel.ySampling) != 0)
+        continue;
+      size_t bytes =
+          (size_t)NumSamples(channel.xSampling, rect.minX, rect.maxX) *
+          channel.size;
+      memcpy(dst, &planes[starts[c]], bytes);
+      dst += bytes;
+      starts[c] += bytes / 2;
+    }
+  }
+  return true;
+}
+
+bool UnpackPXR24(const uint8_t *src, size_t size,
+                 const std::vector<ChunkChannel> &channels,
+                 const ChunkRect &rect, uint8_t *dst, ChunkScratch &scratch) {
+  // Samples are split into byte planes of their differences; floats keep
+  // only their top 24 bits
+  auto planeCount = [](const ChunkChannel &channel) {
+    return channel.type == ChannelHalf ? 2 : channel.type == ChannelFloat ? 3
+                                                                          : 4;
+  };
+  size_t planesSize = 0;
+  for (const ChunkChannel &channel : channels) {
+    size_t lines = NumSamples(channel.ySampling, rect.minY, rect.maxY);
+    planesSize += lines *
+                  NumSamples(channel.xSampling, rect.minX, rect.maxX) *
+                  planeCount(channel);
+  }
+  scratch.temp.resize(planesSize);
+  if (!Inflate(src, size, scratch.temp.data(), planesSize))
+    return false;
+
+  const uint8_t *in = scratch.temp.data();
+  for (int y = rect.minY; y <= rect.maxY; y++) {
+    for (const ChunkChannel &channel : channels) {
+      if (FloorMod(y, channel.ySampling) != 0)
+        continue;
+      int n = NumSamples(channel.xSampling, rect.minX, rect.maxX);
+      const uint8_t *p0 = in, *p1 = p0 + n, *p2 = p1 + n, *p3 = p2 + n;
+      in += (size_t)n * planeCount(channel);
+      if (!channel.needed) {
+        dst += (size_t)n * channel.size;
+        continue;
+      }
+
+      uint32_t pixel = 0;
+      for (int i = 0; i < n; i++) {
+        if (channel.type == ChannelHalf) {
+          pixel += (p0[i] << 8) | p1[i];
+          uint16_t half = (uint16_t)pixel;
+          memcpy(dst, &half, 2);
+          dst += 2;
+        } else {
+          if (channel.type == ChannelFloat)
+            pixel += ((uint32_t)p0[i] << 24) | (p1[i] << 16) | (p2[i] << 8);
+          else
+            pixel += ((uint32_t)p0[i] << 24) | (p1[i] << 16) |
+                     (p2[i] << 8) | p3[i];
+          memcpy(dst, &pixel, 4);
+          dst += 4;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Gets the uncompressed bytes of a chunk: lines, then channels, then
+ * samples, as in an uncompressed file.
+ * @return src itself for uncompressed chunks, nullptr on corrupt data.
+ */
+const uint8_t *UnpackChunk(int compression, const uint8_t *src, size_t size,
+                           const std::vector<ChunkChannel> &channels,
+                           const ChunkRect &rect, ChunkScratch &scratch) {
+  // Chunks that would not shrink are always stored uncompressed
+  size_t unpackedSize = GetUnpackedSize(channels, rect);
+  if (compression == CompressionNone || size >= unpackedSize)
+    return size == unpackedSize ? src : nullptr;
+
+  std::vector<uint8_t> &unpacked = scratch.unpacked;
+  unpacked.resize(unpackedSize);
+  bool ok = false;
+  switch (compression) {
+  case CompressionRLE:
+    scratch.temp.resize(unpackedSize);
+    ok = UnpackRLE(src, size, scratch.temp.data(), unpackedSize);
+    if (ok)
+      UndoZipFilter(scratch.temp.data(), unpackedSize, unpacked.data());
+    break;
+  case CompressionZIPS:
+  case CompressionZIP:
+    scratch.temp.resize(unpackedSize);
+    ok = Inflate(src, size, scratch.temp.data(), unpackedSize);
+    if (ok)
+      UndoZipFilter(scratch.temp.data(), unpackedSize, unpacked.data());
+    break;
+  case CompressionPIZ:
+    ok = UnpackPIZ(src, size, channels, rect, unpacked.data(), unpackedSize,
+                   scratch);
+    break;
+  case CompressionPXR24:
+    ok = UnpackPXR24(src, size, channels, rect, unpacked.data(), scratch);
+    break;
+  }
+  return ok ? unpacked.data() : nullptr;
+}
+
+} // namespace
+
+EXRImage::EXRImage() = default;
+
+EXRImage::~EXRImage() = default;
+
+bool EXRImage::ReadPartHeader(size_t &pos, bool singleTiled, Part &part) {
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+  bool hasChannels = false, hasCompression = false, hasDataWindow = false;
+  bool hasTiles = false;
+  std::string type = singleTiled ? "tiledimage" : "scanlineimage";
+  int chunkCount = -1;
+
+  auto readString = [&](std::string &text) {
+    const uint8_t *end =
+        (const uint8_t *)memchr(data + pos, 0, size - pos);
+    if (!end)
+      return false;
+    text.assign((const char *)data + pos, end - (data + pos));
+    pos = end - data + 1;
+    return true;
+  };
+
+  for (;;) {
+    std::string name, attributeType;
+    if (!readString(name))
+      return false;
+    if (name.empty())
+      break;
+    if (!readString(attributeType) || size - pos < 4)
+      return false;
+    int32_t attributeSize = ReadI32(data + pos);
+    pos += 4;
+    if (attributeSize < 0 || (size_t)attributeSize > size - pos)
+      return false;
+    const uint8_t *value = data + pos;
+    pos += attributeSize;
+
+    if (name == "channels" && attributeType == "chlist") {
+      const uint8_t *p = value;
+      const uint8_t *end = value + attributeSize;
+      while (p < end && *p) {
+        const uint8_t *nameEnd = (const uint8_t *)memchr(p, 0, end - p);
+        if (!nameEnd || end - nameEnd < 17)
+          return false;
+        Channel channel;
+        channel.name.assign((const char *)p, nameEnd - p);
+        channel.type = ReadI32(nameEnd + 1);
+        channel.xSampling = ReadI32(nameEnd + 9);
+        channel.ySampling = ReadI32(nameEnd + 13);
+        if (channel.type < ChannelUInt || channel.type > ChannelFloat ||
+            channel.xSampling < 1 || channel.ySampling < 1)
+          return false;
+        channel.size = channel.type == ChannelHalf ? 2 : 4;
+        part.channels.push_back(channel);
+        p = nameEnd + 17;
+      }
+      hasChannels = true;
+    } else if (name == "compression" && attributeSize == 1) {
+      part.compression = value[0];
+      hasCompression = true;
+    } else if (name == "dataWindow" && attributeSize == 16) {
+      part.minX = ReadI32(value);
+      part.minY = ReadI32(value + 4);
+      part.maxX = ReadI32(value + 8);
+      part.maxY = ReadI32(value + 12);
+      hasDataWindow = true;
+    } else if (name == "tiles" && attributeSize == 9) {
+      part.tileWidth = ReadI32(value);
+      part.tileHeight = ReadI32(value + 4);
+      part.levelMode = value[8] & 0xf;
+      part.roundingMode = value[8] >> 4;
+      hasTiles = true;
+    } else if (name == "type" && attributeType == "string") {
+      type.assign((const char *)value, attributeSize);
+    } else if (name == "name" && attributeType == "string") {
+      part.name.assign((const char *)value, attributeSize);
+    } else if (name == "chunkCount" && attributeSize == 4) {
+      chunkCount = ReadI32(value);
+    }
+  }
+
+  if (!hasChannels || !hasCompression || !hasDataWindow ||
+      part.maxX < part.minX || part.maxY < part.minY ||
+      (int64_t)part.maxX - part.minX >= (1 << 24) ||
+      (int64_t)part.maxY - part.minY >= (1 << 24))
+    return false;
+
+  // Deep parts are skipped, but their offsets still take up the table
+  part.tiled = type == "tiledimage";
+  bool supported = part.tiled || type == "scanlineimage";
+  if (part.tiled && (!hasTiles || part.tileWidth <= 0 ||
+                     part.tileHeight <= 0 || part.tileWidth > g_MaxTileSize ||
+                     part.tileHeight > g_MaxTileSize ||
+                     part.levelMode > LevelRipmap || part.roundingMode > 1))
+    return false;
+
+  int width = part.maxX - part.minX + 1;
+  int height = part.maxY - part.minY + 1;
+  int64_t chunks = 0;
+  if (part.tiled) {
+    if (part.levelMode == LevelMipmap) {
+      part.xLevels = part.yLevels =
+          RoundLog2(std::max(width, height), part.roundingMode) + 1;
+    } else if (part.levelMode == LevelRipmap) {
+      part.xLevels = RoundLog2(width, part.roundingMode) + 1;
+      part.yLevels = RoundLog2(height, part.roundingMode) + 1;
+    }
+    for (int ly = 0; ly < part.yLevels; ly++) {
+      for (int lx = 0; lx < part.xLevels; lx++) {
+        if (part.levelMode == LevelMipmap && lx != ly)
+          continue;
+        int levelWidth = GetLevelSize(width, lx, part.roundingMode);
+        int levelHeight = GetLevelSize(height, ly, part.roundingMode);
+        chunks += (((int64_t)levelWidth + part.tileWidth - 1) /
+                   part.tileWidth) *
+                  (((int64_t)levelHeight + part.tileHeight - 1) /
+                   part.tileHeight);
+      }
+    }
+  } else {
+    int lines = GetLinesPerChunk(part.compression);
+    chunks = (height + lines - 1) / lines;
+  }
+
+  if (chunkCount < 0) {
+    if (!supported)
+      return false;
+    chunkCount = (int)std::min<int64_t>(chunks, INT32_MAX);
+  } else if (supported && chunkCount != chunks) {
+    return false;
+  }
+  // The offset table follows the headers, so it fits in what is left
+  if (chunkCount <= 0 ||
+      (uint64_t)chunkCount > (size - pos) / sizeof(uint64_t))
+    return false;
+  part.offsets.resize(chunkCount);
+  if (!supported || part.compression > CompressionPXR24)
+    part.channels.clear(); // No layers are made from it
+  return true;
+}
+
+bool EXRImage::Open(const std::string &filepath) {
+  PROFILE_SCOPE("EXR Open");
+  m_parts.clear();
+  m_layers.clear();
+
+  if (!m_file.Open(filepath)) {
+    LOG_ERROR("Failed to open EXR file: %s", filepath.c_str());
+    return false;
+  }
+
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+  if (size < 8 || ReadI32(data) != 20000630 || (data[4] & 0xff) != 2) {
+    LOG_ERROR("Not an OpenEXR file: %s", filepath.c_str());
+    return false;
+  }
+  uint32_t flags = (uint32_t)ReadI32(data + 4);
+  m_multiPart = (flags & g_MultiPartFlag) != 0;
+  if (!m_multiPart && (flags & g_DeepFlag)) {
+    LOG_ERROR("Deep EXR files are not supported: %s", filepath.c_str());
+    return false;
+  }
+  // Multi-part files list headers until an empty one
+  size_t pos = 8;
+  do {
+    Part part;
+    if (!ReadPartHeader(pos, !m_multiPart && (flags & g_TiledFlag), part)) {
+      LOG_ERROR("Invalid or unsupported EXR header: %s", filepath.c_str());
+      return false;
+    }
+    m_parts.push_back(std::move(part));
+  } while (m_multiPart && pos < size && data[pos] != 0);
+  if (m_multiPart)
+    pos++;
+
+  for (Part &part : m_parts) {
+    size_t tableSize = part.offsets.size() * sizeof(uint64_t);
+    if (size - pos < tableSize) {
+      LOG_ERROR("Truncated EXR offset table: %s", filepath.c_str());
+      return false;
+    }
+    for (size_t i = 0; i < part.offsets.size(); i++) {
+      part.offsets[i] = ReadU64(data + pos + i * sizeof(uint64_t));
+      if (!part.channels.empty() && (part.offsets[i] < pos + tableSize ||
+                                     part.offsets[i] >= size)) {
+        LOG_ERROR("EXR chunk %zu is out of bounds (incomplete file?): %s", i,
+                  filepath.c_str());
+        return false;
+      }
+    }
+    pos += tableSize;
+  }
+
+  BuildLayers();
+  if (m_layers.empty()) {
+    const Part &part = m_parts[0];
+    LOG_ERROR("No readable layers in EXR file (compression %s): %s",
+              part.compression < 10 ? g_CompressionNames[part.compression]
+                                    : "unknown",
+              filepath.c_str());
+    return false;
+  }
+
+  const Part &first = m_parts[m_layers[0].part];
+  m_layout = SubresourceLayout();
+  m_layout.width = first.maxX - first.minX + 1;
+  m_layout.height = first.maxY - first.minY + 1;
+  m_layout.mipLevels = std::min(first.xLevels, first.yLevels);
+  m_layout.arraySize = (int)m_layers.size();
+  m_layout.format = "EXR";
+  m_layout.pixelFormat = g_CompressionNames[first.compression];
+  m_layout.channels = m_layers[0].channelCount;
+  for (const Layer &layer : m_layers)
+    m_layout.layerNames.push_back(layer.name);
+
+  LOG("Opened EXR %dx%d, %zu parts, %d layers, %d mips, %s",
+      m_layout.width, m_layout.height, m_parts.size(), m_layout.arraySize,
+      m_layout.mipLevels, m_layout.pixelFormat.c_str());
+  return true;
+}
+
+void EXRImage::BuildLayers() {
+  for (int p = 0; p < (int)m_parts.size(); p++) {
+    const Part &part = m_parts[p];
+
+    // Channels grouped by the name before their last '.'
+    std::vector<std::string> prefixes;
+    std::map<std::string, std::vector<int>> groups;
+    for (int c = 0; c < (int)part.channels.size(); c++) {
+      const std::string &name = part.channels[c].name;
+      size_t dot = name.find_last_of('.');
+      std::string prefix = dot == std::string::npos ? "" : name.substr(0, dot);
+      if (groups.find(prefix) == groups.end())
+        prefixes.push_back(prefix);
+      groups[prefix].push_back(c);
+    }
+    // The unnamed layer (usually the beauty pass) comes first
+    std::stable_partition(prefixes.begin(), prefixes.end(),
+                          [](const std::string &s) { return s.empty(); });
+
+    for (const std::string &prefix : prefixes) {
+      const std::vector<int> &group = groups[prefix];
+      auto find = [&](const char *suffix) {
+        for (int c : group) {
+          const std::string &name = part.channels[c].name;
+          std::string last = name.substr(prefix.empty() ? 0
+                                                        : prefix.size() + 1);
+          if (last.size() == strlen(suffix) &&
+              std::equal(last.begin(), last.end(), suffix,
+                         [](char a, char b) {
+                           return toupper((unsigned char)a) == b;
+                         }))
+            return c;
+        }
+        return -1;
+      };
+
+      Layer layer;
+      layer.part = p;
+      int r = find("R"), g = find("G"), b = find("B"), a = find("A");
+      int x = find("X"), y = find("Y"), z = find("Z");
+      int color[3] = {r, g, b};
+      if (r < 0 && g < 0 && b < 0) {
+        if ((x >= 0) + (y >= 0) + (z >= 0) >= 2) {
+          color[0] = x, color[1] = y, color[2] = z; // Vectors and normals
+        } else if (y >= 0) {
+          color[0] = color[1] = color[2] = y; // Luminance, chroma ignored
+        } else {
+          // Anything else: first three channels, or gray for a single one
+          std::vector<int> others;
+          for (int c : group) {
+            if (c != a)
+              others.push_back(c);
+          }
+          if (others.size() == 1)
+            color[0] = color[1] = color[2] = others[0];
+          for (size_t i = 0; i < others.size() && i < 3 && others.size() > 1;
+               i++)
+            color[i] = others[i];
+        }
+      }
+      layer.channels[0] = color[0];
+      layer.channels[1] = color[1];
+      layer.channels[2] = color[2];
+      layer.channels[3] = a;
+
+      // Named after its channels when there is no prefix
+      std::string channelList;
+      layer.channelCount = 0;
+      for (int i = 0; i < 4; i++) {
+        int c = layer.channels[i];
+        if (c < 0 || std::find(layer.channels, layer.channels + i, c) !=
+                         layer.channels + i)
+          continue;
+        const std::string &name = part.channels[c].name;
+        if (!channelList.empty())
+          channelList += ",";
+        channelList += name.substr(prefix.empty() ? 0 : prefix.size() + 1);
+        layer.channelCount++;
+      }
+      if (layer.channelCount == 0)
+        continue;
+
+      if (m_multiPart && (prefix.empty() || prefix == part.name))
+        layer.name = part.name.empty() ? channelList : part.name;
+      else if (m_multiPart && !part.name.empty())
+        layer.name = part.name + "." + prefix;
+      else
+        layer.name = prefix.empty() ? channelList : prefix;
+      m_layers.push_back(layer);
+    }
+  }
+}
+
+bool EXRImage::Decode(const SubresourceIndex &index, ImageData &out) {
+  PROFILE_SCOPE("EXR Decode");
+  if (!m_layout.Contains(index))
+    return false;
+
+  const Layer &layer = m_layers[index.layer];
+  const Part &part = m_parts[layer.part];
+  int level = index.mip;
+  if (level >= std::min(part.xLevels, part.yLevels))
+    return false;
+
+  // Ripmaps are shown through their levels with equal x and y reduction
+  int width = GetLevelSize(part.maxX - part.minX + 1, level, part.roundingMode);
+  int height =
+      GetLevelSize(part.maxY - part.minY + 1, level, part.roundingMode);
+
+  std::vector<ChunkRect> rects;
+  size_t firstChunk = 0;
+  if (part.tiled) {
+    for (int ly = 0; ly < part.yLevels; ly++) {
+      for (int lx = 0; lx < part.xLevels; lx++) {
+        if (part.levelMode == LevelMipmap && lx != ly)
+          continue;
+        int levelWidth =
+            GetLevelSize(part.maxX - part.minX + 1, lx, part.roundingMode);
+        int levelHeight =
+            GetLevelSize(part.maxY - part.minY + 1, ly, part.roundingMode);
+        int64_t tilesX =
+            ((int64_t)levelWidth + part.tileWidth - 1) / part.tileWidth;
+        int64_t tilesY =
+            ((int64_t)levelHeight + part.tileHeight - 1) / part.tileHeight;
+        // Offsets are ordered by level, then by tile row
+        if (lx != level || ly != level) {
+          if (rects.empty())
+            firstChunk += (size_t)tilesX * tilesY;
+          continue;
+        }
+        if (firstChunk + tilesX * tilesY > part.offsets.size())
+          return false;
+        for (int ty = 0; ty < tilesY; ty++) {
+          for (int tx = 0; tx < tilesX; tx++) {
+            int x = part.minX + tx * part.tileWidth;
+            int y = part.minY + ty * part.tileHeight;
+            int maxX = (int)std::min<int64_t>((int64_t)x + part.tileWidth - 1,
+                                              part.minX + levelWidth - 1);
+            int maxY = (int)std::min<int64_t>((int64_t)y + part.tileHeight - 1,
+                                              part.minY + levelHeight - 1);
+            rects.push_back({x, y, maxX, maxY, tx, ty});
+          }
+        }
+      }
+    }
+  } else {
+    int lines = GetLinesPerChunk(part.compression);
+    for (int y = part.minY; y <= part.maxY; y += lines)
+      rects.push_back(
+          {part.minX, y, part.maxX, std::min(y + lines - 1, part.maxY), 0, 0});
+  }
+  if (firstChunk + rects.size() > part.offsets.size())
+    return false;
+
+  std::vector<ChunkChannel> channels;
+  bool allHalf = true;
+  for (int c = 0; c < (int)part.channels.size(); c++) {
+    const Channel &channel = part.channels[c];
+    bool needed = std::find(layer.channels, layer.channels + 4, c) !=
+                  layer.channels + 4;
+    channels.push_back({channel.type, channel.size, channel.xSampling,
+                        channel.ySampling, needed});
+    if (needed && channel.type != ChannelHalf)
+      allHalf = false;
+  }
+
+  // Windows the file cannot hold are rejected before allocating them
+  const uint8_t *data = m_file.GetData();
+  size_t fileSize = m_file.GetSize();
+  uint64_t maxUnpacked = fileSize * GetMaxUnpackRatio(part.compression);
+  uint64_t unpacked = 0;
+  for (const ChunkRect &rect : rects) {
+    for (const ChunkChannel &channel : channels) {
+      unpacked +=
+          (uint64_t)NumSamples(channel.ySampling, rect.minY, rect.maxY) *
+          NumSamples(channel.xSampling, rect.minX, rect.maxX) * channel.size;
+    }
+    if (unpacked > maxUnpacked) {
+      LOG_ERROR("EXR data window of %dx%d is larger than the file holds",
+                width, height);
+      return false;
+    }
+  }
+
+  out.width = width;
+  out.height = height;
+  out.channels = layer.channelCount;
+  out.vectors = layer.channelCount == 2 && layer.channels[3] < 0;
+  out.format = m_layout.format;
+  out.pixelFormat = std::string(allHalf ? "half" : "float") + ", " +
+                    g_CompressionNames[part.compression];
+
+  // Layers of halves are kept as halves, others are converted to float
+  uint16_t *halfPixels = nullptr;
+  float *floatPixels = nullptr;
+  if (allHalf) {
+    out.pixels = std::vector<float>();
+    uint8_t *dst;
+    out.stored = AllocatePixelBuffer(PixelFormat::RGBA16F, width, height, dst);
+    halfPixels = (uint16_t *)dst;
+  } else {
+    out.stored = PixelBuffer();
+    {
+      PROFILE_SCOPE("Allocate");
+      out.pixels.resize((size_t)width * height * 4);
+    }
+    floatPixels = out.pixels.data();
+  }
+
+  size_t headerSize = (m_multiPart ? 4 : 0) + (part.tiled ? 16 : 4) + 4;
+  std::atomic<bool> failed(false);
+
+  auto decodeChunk = [&](size_t chunk, ChunkScratch &scratch) {
+    const ChunkRect &rect = rects[chunk];
+    uint64_t offset = part.offsets[firstChunk + chunk];
+    if (fileSize - offset < headerSize)
+      return false;
+    const uint8_t *p = data + offset;
+    if (m_multiPart) {
+      if (ReadI32(p) != layer.part)
+        return false;
+      p += 4;
+    }
+    if (part.tiled) {
+      if (ReadI32(p) != rect.tileX || ReadI32(p + 4) != rect.tileY ||
+          ReadI32(p + 8) != level || ReadI32(p + 12) != level)
+        return false;
+      p += 16;
+    } else {
+      if (ReadI32(p) != rect.minY)
+        return false;
+      p += 4;
+    }
+    int32_t dataSize = ReadI32(p);
+    p += 4;
+    if (dataSize < 0 || (uint64_t)dataSize > fileSize - offset - headerSize)
+      return false;
+
+    const uint8_t *src = UnpackChunk(part.compression, p, dataSize, channels,
+                                     rect, scratch);
+    if (!src)
+      return false;
+
+    // Lines hold each channel's samples in turn; only the layer's are read
+    for (int y = rect.minY; y <= rect.maxY; y++) {
+      int row = y - part.minY;
+      const uint8_t *channelData[4] = {};
+      for (size_t c = 0; c < channels.size(); c++) {
+        const ChunkChannel &channel = channels[c];
+        if (FloorMod(y, channel.ySampling) != 0)
+          continue;
+        for (int slot = 0; slot < 4; slot++) {
+          if (layer.channels[slot] == (int)c)
+            channelData[slot] = src;
+        }
+        src += (size_t)NumSamples(channel.xSampling, rect.minX, rect.maxX) *
+               channel.size;
+      }
+
+      for (int slot = 0; slot < 4; slot++) {
+        int c = layer.channels[slot];
+        if (c < 0) {
+          // Missing color channels are 0, missing alpha is 1
+          for (int x = rect.minX; x <= rect.maxX; x++) {
+            size_t i = ((size_t)row * width + (x - part.minX)) * 4 + slot;
+            if (halfPixels)
+              halfPixels[i] = slot == 3 ? 0x3c00 : 0;
+            else
+              floatPixels[i] = slot == 3 ? 1.0f : 0.0f;
+          }
+          continue;
+        }
+        if (!channelData[slot])
+          continue; // Line of a vertically subsampled channel
+
+        const ChunkChannel &channel = channels[c];
+        int count = NumSamples(channel.xSampling, rect.minX, rect.maxX);
+        if (halfPixels) {
+          scratch.halfRow.resize(count);
+          memcpy(scratch.halfRow.data(), channelData[slot], count * 2);
+        } else {
+          scratch.floatRow.resize(count);
+          float *values = scratch.floatRow.data();
+          if (channel.type == ChannelHalf) {
+            scratch.halfRow.resize(count);
+            memcpy(scratch.halfRow.data(), channelData[slot], count * 2);
+            HalfToFloatArray(scratch.halfRow.data(), values, count);
+          } else if (channel.type == ChannelFloat) {
+            memcpy(values, channelData[slot], count * 4);
+          } else {
+            scratch.uintRow.resize(count);
+            memcpy(scratch.uintRow.data(), channelData[slot], count * 4);
+            for (int i = 0; i < count; i++)
+              values[i] = (float)scratch.uintRow[i];
+          }
+        }
+
+        if (channel.xSampling == 1 && channel.ySampling == 1) {
+          size_t base =
+              ((size_t)row * width + (rect.minX - part.minX)) * 4 + slot;
+          for (int i = 0; i < count; i++) {
+            if (halfPixels)
+              halfPixels[base + (size_t)i * 4] = scratch.halfRow[i];
+            else
+              floatPixels[base + (size_t)i * 4] = scratch.floatRow[i];
+          }
+          continue;
+        }
+
+        // Subsampled channels cover xSampling * ySampling pixels per sample
+        int firstX =
+            (FloorDiv(rect.minX - 1, channel.xSampling) + 1) *
+                channel.xSampling -
+            part.minX;
+        int rows = std::min(channel.ySampling, height - row);
+        for (int i = 0; i < count; i++) {
+          int x0 = firstX + i * channel.xSampling;
+          int x1 = std::min(x0 + channel.xSampling, width);
+          for (int dy = 0; dy < rows; dy++) {
+            size_t base = (size_t)(row + dy) * width;
+            for (int x = std::max(x0, 0); x < x1; x++) {
+              if (halfPixels)
+                halfPixels[(base + x) * 4 + slot] = scratch.halfRow[i];
+              else
+                floatPixels[(base + x) * 4 + slot] = scratch.floatRow[i];
+            }
+          }
+        }
+      }
+    }
+    return true;
+  };
+
+  {
+    PROFILE_SCOPE("EXR Chunks");
+    ParallelFor((int)rects.size(), m_threadCount, [&](int begin, int end) {
+      ChunkScratch scratch;
+      for (int i = begin; i < end && !failed; i++) {
+        if (!decodeChunk(i, scratch))
+          failed = true;
+      }
+    });
+  }
+
+  if (failed) {
+    LOG_ERROR("EXR layer %s is truncated or corrupt", layer.name.c_str());
+    out.pixels = std::vector<float>();
+    out.stored = PixelBuffer();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "ImageSource.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief OpenEXR image read through a memory mapping.
+ *
+ * Open() parses the headers and chunk offset tables only. Each layer (the
+ * channels sharing a name prefix, such as "diffuse.R/G/B") is exposed as an
+ * array layer, and the levels of mipmapped tiled files as mips. Decode()
+ * decompresses the chunks of one level in parallel and converts only the
+ * channels of the requested layer.
+ *
+ * Scanline and tiled, single and multi-part files are read, with NONE, RLE,
+ * ZIPS, ZIP, PIZ and PXR24 compression and UINT, HALF and FLOAT channels.
+ * Deep data and B44/DWA compression are not supported.
+ */
+class EXRImage : public ImageSource {
+public:
+  EXRImage();
+  ~EXRImage() override;
+
+  /**
+   * @brief Maps the file and reads its headers and offset tables.
+   * @return False if the file is not an OpenEXR file or has no part this
+   * reader can decode.
+   */
+  bool Open(const std::string &filepath);
+
+  const SubresourceLayout &GetLayout() const override { return m_layout; }
+
+  bool Decode(const SubresourceIndex &index, ImageData &out) override;
+
+  /**
+   * @brief Sets the number of threads used by Decode() (0 = hardware
+   * threads).
+   */
+  void SetThreadCount(int threadCount) { m_threadCount = threadCount; }
+
+private:
+  struct Channel {
+    std::string name;
+    int type;      ///< 0 = UINT, 1 = HALF, 2 = FLOAT
+    int size;      ///< Bytes per sample
+    int xSampling;
+    int ySampling;
+  };
+
+  struct Part {
+    std::string name;
+    std::vector<Channel> channels; ///< Sorted by name, as stored
+    int compression = 0;
+    int minX = 0, minY = 0, maxX = -1, maxY = -1; ///< Data window
+    bool tiled = false;
+    int tileWidth = 0;
+    int tileHeight = 0;
+    int levelMode = 0;    ///< 0 = one level, 1 = mipmap, 2 = ripmap
+    int roundingMode = 0; ///< 0 = round down, 1 = round up
+    int xLevels = 1;
+    int yLevels = 1;
+    std::vector<uint64_t> offsets; ///< Chunk offsets in the file
+  };
+
+  struct Layer {
+    std::string name;
+    int part;
+    int channels[4];  ///< Channel of R, G, B and A in the part; -1 = none
+    int channelCount; ///< Channels of the file shown by this layer
+  };
+
+  /**
+   * @brief Reads one part header starting at pos, leaving pos after it.
+   */
+  bool ReadPartHeader(size_t &pos, bool singleTiled, Part &part);
+
+  /**
+   * @brief Sorts the channels of every part into display layers.
+   */
+  void BuildLayers();
+
+  MappedFile m_file;
+  SubresourceLayout m_layout;
+  bool m_multiPart = false;
+  std::vector<Part> m_parts;
+  std::vector<Layer> m_layers;
+  int m_threadCount = 0;
+};
@@ -0,0 +1,328 @@
+#include "EnvironmentLighting.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include "Reprojection.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+const double g_Pi = 3.14159265358979323846;
+
+// Largest CDF grid; larger maps add up several texels per cell
+const int g_MaxCdfWidth = 512;
+const int g_MaxCdfHeight = 256;
+
+// Band 0 basis function, a constant
+const double g_SH00 = 0.282095;
+
+// Sums of one chunk of rows
+struct LightingSums {
+  double sh[9][3] = {};
+  std::vector<double> cells; ///< Luminance times solid angle per CDF cell
+};
+
+// Real spherical harmonics of bands 0-2 at a unit direction
+void EvaluateSH9(const float dir[3], double basis[9]) {
+  double x = dir[0], y = dir[1], z = dir[2];
+  basis[0] = g_SH00;
+  basis[1] = 0.488603 * y;
+  basis[2] = 0.488603 * z;
+  basis[3] = 0.488603 * x;
+  basis[4] = 1.092548 * x * y;
+  basis[5] = 1.092548 * y * z;
+  basis[6] = 0.315392 * (3.0 * z * z - 1.0);
+  basis[7] = 1.092548 * x * z;
+  basis[8] = 0.546274 * (x * x - y * y);
+}
+
+double GetLuminance(double r, double g, double b) {
+  return 0.2126 * r + 0.7152 * g + 0.0722 * b;
+}
+
+// Adds one texel seen in a unit direction, covering solidAngle, to the
+// coefficients of a row and to its CDF cell. The row's coefficients are a
+// local array, so they stay apart from the cells in memory.
+inline void AddTexel(const float *rgba, const float dir[3], double solidAngle,
+                     double sh[9][3], double &cell) {
+  if (!std::isfinite(rgba[0] + rgba[1] + rgba[2]))
+    return;
+  double basis[9];
+  EvaluateSH9(dir, basis);
+  for (int k = 0; k < 9; k++) {
+    double weight = basis[k] * solidAngle;
+    for (int c = 0; c < 3; c++)
+      sh[k][c] += weight * rgba[c];
+  }
+  cell += std::max(GetLuminance(rgba[0], rgba[1], rgba[2]), 0.0) * solidAngle;
+}
+
+void AddRow(const double sh[9][3], LightingSums &sums) {
+  for (int k = 0; k < 9; k++) {
+    for (int c = 0; c < 3; c++)
+      sums.sh[k][c] += sh[k][c];
+  }
+}
+
+void SetCdfSize(EnvironmentLighting &lighting, int width, int height) {
+  lighting.cdfWidth = std::min(width, g_MaxCdfWidth);
+  lighting.cdfHeight = std::min(height, g_MaxCdfHeight);
+}
+
+// Turns a run of weights into a CDF, uniform if they add up to nothing
+void AccumulateCdf(const double *weights, int count, float *cdf) {
+  double total = 0.0;
+  for (int i = 0; i < count; i++)
+    total += weights[i];
+  double sum = 0.0;
+  for (int i = 0; i < count; i++) {
+    sum += weights[i];
+    cdf[i] = total > 0.0 ? (float)(sum / total) : (float)(i + 1) / count;
+  }
+  cdf[count - 1] = 1.0f;
+}
+
+// Adds up the sums of all chunks and derives the lighting from them
+void FinishLighting(std::vector<LightingSums> &chunks,
+                    EnvironmentLighting &lighting) {
+  LightingSums &total = chunks[0];
+  for (size_t i = 1; i < chunks.size(); i++) {
+    for (int k = 0; k < 9; k++) {
+      for (int c = 0; c < 3; c++)
+        total.sh[k][c] += chunks[i].sh[k][c];
+    }
+    for (size_t cell = 0; cell < total.cells.size(); cell++)
+      total.cells[cell] += chunks[i].cells[cell];
+  }
+
+  for (int k = 0; k < 9; k++) {
+    for (int c = 0; c < 3; c++)
+      lighting.sh[k][c] = (float)total.sh[k][c];
+  }
+  for (int c = 0; c < 3; c++)
+    lighting.irradiance[c] = (float)(total.sh[0][c] / g_SH00);
+
+  // L11, L1-1 and L10 point along x, y and z
+  double dir[3];
+  double length = 0.0;
+  for (int axis = 0; axis < 3; axis++) {
+    const double *rgb = total.sh[axis == 0 ? 3 : axis];
+    dir[axis] = GetLuminance(rgb[0], rgb[1], rgb[2]);
+    length += dir[axis] * dir[axis];
+  }
+  length = std::sqrt(length);
+  if (length > 0.0) {
+    for (int axis = 0; axis < 3; axis++)
+      lighting.dominantDirection[axis] = (float)(dir[axis] / length);
+  }
+
+  int width = lighting.cdfWidth;
+  int height = lighting.cdfHeight;
+  std::vector<double> rows(height, 0.0);
+  lighting.conditionalCdf.resize((size_t)width * height);
+  lighting.marginalCdf.resize(height);
+  for (int y = 0; y < height; y++) {
+    const double *cells = &total.cells[(size_t)y * width];
+    for (int x = 0; x < width; x++)
+      rows[y] += cells[x];
+    AccumulateCdf(cells, width, &lighting.conditionalCdf[(size_t)y * width]);
+  }
+  AccumulateCdf(rows.data(), height, lighting.marginalCdf.data());
+}
+
+// Sums for each chunk ParallelForChunks splits count rows into
+std::vector<LightingSums> AllocateChunks(int count, int threadCount,
+                                         const EnvironmentLighting &lighting) {
+  std::vector<LightingSums> chunks(GetParallelChunkCount(count, threadCount));
+  for (LightingSums &chunk : chunks)
+    chunk.cells.assign((size_t)lighting.cdfWidth * lighting.cdfHeight, 0.0);
+  return chunks;
+}
+
+// Signed solid angle of the rectangle from the center of a cube face, at
+// distance 1, to (s, t)
+double GetCubeArea(double s, double t) {
+  return std::atan2(s * t, std::sqrt(s * s + t * t + 1.0));
+}
+
+void WriteArray(std::ostream &out, const float *values, size_t count) {
+  char number[32];
+  out << '[';
+  for (size_t i = 0; i < count; i++) {
+    snprintf(number, sizeof(number), "%s%.9g", i > 0 ? ", " : "",
+             values[i]);
+    out << number;
+  }
+  out << ']';
+}
+
+} // namespace
+
+bool ComputeLatLongLighting(const ImageData &image,
+                            EnvironmentLighting &lighting, int threadCount) {
+  PROFILE_SCOPE("ComputeLatLongLighting");
+  int width = image.width;
+  int height = image.height;
+  if (width <= 0 || height <= 0 ||
+      image.GetPixelCount() != (size_t)width * height)
+    return false;
+  SetCdfSize(lighting, width, height);
+  int cdfWidth = lighting.cdfWidth;
+  int cdfHeight = lighting.cdfHeight;
+
+  // Longitude only depends on the column and latitude on the row
+  std::vector<float> sinLongitude(width), cosLongitude(width);
+  std::vector<int> cellColumn(width);
+  for (int x = 0; x < width; x++) {
+    double longitude = ((x + 0.5) / width - 0.5) * 2.0 * g_Pi;
+    sinLongitude[x] = (float)std::sin(longitude);
+    cosLongitude[x] = (float)std::cos(longitude);
+    cellColumn[x] = (int)((int64_t)x * cdfWidth / width);
+  }
+
+  std::vector<LightingSums> chunks =
+      AllocateChunks(height, threadCount, lighting);
+  ParallelForChunks(height, threadCount, [&](int chunk, int begin, int end) {
+    LightingSums &sums = chunks[chunk];
+    std::vector<float> converted;
+    for (int y = begin; y < end; y++) {
+      const float *row;
+      if (image.HasStoredPixels()) {
+        converted.resize((size_t)width * 4);
+        ConvertPixels(image.stored, (size_t)y * width, (size_t)(y + 1) * width,
+                      converted.data());
+        row = converted.data();
+      } else {
+        row = image.pixels.data() + (size_t)y * width * 4;
+      }
+
+      // Texels of a row cover a band between two latitudes
+      double top = (0.5 - (double)y / height) * g_Pi;
+      double bottom = (0.5 - (double)(y + 1) / height) * g_Pi;
+      double solidAngle =
+          2.0 * g_Pi / width * (std::sin(top) - std::sin(bottom));
+      float latitude = (float)((top + bottom) * 0.5);
+      float cosLatitude = std::cos(latitude);
+      float dir[3];
+      dir[1] = std::sin(latitude);
+      double *cells =
+          &sums.cells[(size_t)((int64_t)y * cdfHeight / height) * cdfWidth];
+      double sh[9][3] = {};
+      for (int x = 0; x < width; x++) {
+        dir[0] = cosLatitude * sinLongitude[x];
+        dir[2] = cosLatitude * cosLongitude[x];
+        AddTexel(row + x * 4, dir, solidAngle, sh, cells[cellColumn[x]]);
+      }
+      AddRow(sh, sums);
+    }
+  });
+  FinishLighting(chunks, lighting);
+  return true;
+}
+
+bool ComputeCubeLighting(const float *faces, int faceSize,
+                         EnvironmentLighting &lighting, int threadCount) {
+  PROFILE_SCOPE("ComputeCubeLighting");
+  if (faceSize <= 0)
+    return false;
+  SetCdfSize(lighting, 4 * faceSize, 2 * faceSize);
+  int cdfWidth = lighting.cdfWidth;
+  int cdfHeight = lighting.cdfHeight;
+
+  // Face coordinates of the texel edges and centers, and the longitude of
+  // each column of +Z; the other side faces are a quarter turn apart
+  std::vector<double> edges(faceSize + 1);
+  for (int i = 0; i <= faceSize; i++)
+    edges[i] = 2.0 * i / faceSize - 1.0;
+  std::vector<float> centers(faceSize), sideU(faceSize);
+  for (int i = 0; i < faceSize; i++) {
+    centers[i] = (float)((edges[i] + edges[i + 1]) * 0.5);
+    sideU[i] = (float)(std::atan(centers[i]) / (2.0 * g_Pi) + 0.5);
+  }
+  const float sideOffsets[6] = {0.25f, -0.25f, 0.0f, 0.0f, 0.0f, 0.5f};
+  const size_t faceFloats = (size_t)faceSize * faceSize * 4;
+
+  // Rows are the same row of all six faces, which share their solid angles
+  std::vector<LightingSums> chunks =
+      AllocateChunks(faceSize, threadCount, lighting);
+  ParallelForChunks(faceSize, threadCount, [&](int chunk, int begin, int end) {
+    LightingSums &sums = chunks[chunk];
+    std::vector<double> areaTop(faceSize + 1), areaBottom(faceSize + 1);
+    for (int y = begin; y < end; y++) {
+      for (int i = 0; i <= faceSize; i++) {
+        areaTop[i] = GetCubeArea(edges[i], edges[y]);
+        areaBottom[i] = GetCubeArea(edges[i], edges[y + 1]);
+      }
+      float t = centers[y];
+      double sh[9][3] = {};
+      for (int x = 0; x < faceSize; x++) {
+        double solidAngle = areaBottom[x + 1] - areaBottom[x] -
+                            areaTop[x + 1] + areaTop[x];
+        float s = centers[x];
+        float invLength = 1.0f / std::sqrt(s * s + t * t + 1.0f);
+        float sideV = 0.5f - std::asin(-t * invLength) / (float)g_Pi;
+        float poleV = std::asin(invLength) / (float)g_Pi;
+        size_t offset = ((size_t)y * faceSize + x) * 4;
+        for (int face = 0; face < 6; face++) {
+          float u, v;
+          if (face == 2) {
+            u = std::atan2(s, t) / (2.0f * (float)g_Pi) + 0.5f;
+            v = 0.5f - poleV;
+          } else if (face == 3) {
+            u = std::atan2(s, -t) / (2.0f * (float)g_Pi) + 0.5f;
+            v = 0.5f + poleV;
+          } else {
+            u = sideU[x] + sideOffsets[face];
+            u -= std::floor(u);
+            v = sideV;
+          }
+          float dir[3];
+          GetCubeFaceDirection(face, s, t, dir);
+          for (int c = 0; c < 3; c++)
+            dir[c] *= invLength;
+
+          int cellX = std::min((int)(u * cdfWidth), cdfWidth - 1);
+          int cellY = std::min((int)(v * cdfHeight), cdfHeight - 1);
+          AddTexel(faces + faceFloats * face + offset, dir, solidAngle, sh,
+                   sums.cells[(size_t)cellY * cdfWidth + cellX]);
+        }
+      }
+      AddRow(sh, sums);
+    }
+  });
+  FinishLighting(chunks, lighting);
+  return true;
+}
+
+bool WriteEnvironmentLighting(const std::string &filepath,
+                              const EnvironmentLighting &lighting) {
+  std::ofstream file(std::filesystem::u8path(filepath),
+                     std::ios::out | std::ios::trunc);
+  if (!file.is_open())
+    return false;
+
+  file << "{\n  \"sh9\": [";
+  for (int k = 0; k < 9; k++) {
+    file << (k > 0 ? ",\n          " : "");
+    WriteArray(file, lighting.sh[k], 3);
+  }
+  file << "],\n  \"irradiance\": ";
+  WriteArray(file, lighting.irradiance, 3);
+  file << ",\n  \"dominantDirection\": ";
+  WriteArray(file, lighting.dominantDirection, 3);
+  file << ",\n  \"cdf\": {\n    \"width\": " << lighting.cdfWidth
+       << ",\n    \"height\": " << lighting.cdfHeight
+       << ",\n    \"marginal\": ";
+  WriteArray(file, lighting.marginalCdf.data(), lighting.marginalCdf.size());
+  file << ",\n    \"conditional\": [";
+  for (int y = 0; y < lighting.cdfHeight; y++) {
+    file << (y > 0 ? ",\n      " : "\n      ");
+    WriteArray(file, &lighting.conditionalCdf[(size_t)y * lighting.cdfWidth],
+               lighting.cdfWidth);
+  }
+  file << "]\n  }\n}\n";
+  return file.good();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "ImageData.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lighting of an environment map, for image-based lighting.
+ *
+ * Directions are those of Reprojection.h: +Y up and +Z at the center of
+ * lat-long images, D3D order for cube faces. Every texel is weighted by the
+ * solid angle it covers; texels that are not finite are skipped.
+ */
+struct EnvironmentLighting {
+  /// Radiance projected on the real spherical harmonics of bands 0-2, RGB,
+  /// in the order L00, L1-1, L10, L11, L2-2, L2-1, L20, L21, L22. The basis
+  /// has no Condon-Shortley phase: Y1-1, Y10 and Y11 grow with y, z and x.
+  float sh[9][3] = {};
+  /// Radiance integrated over the sphere, RGB
+  float irradiance[3] = {};
+  /// Unit direction the linear band of the luminance points to
+  float dominantDirection[3] = {0.0f, 1.0f, 0.0f};
+
+  /// Luminance CDF over a lat-long grid, for importance sampling: a row is
+  /// picked with marginalCdf, then a column with that row's conditionalCdf.
+  /// Entries are the probability of a cell and the cells before it, so the
+  /// last of each run is 1. Rows without light are uniform.
+  int cdfWidth = 0;
+  int cdfHeight = 0;
+  std::vector<float> marginalCdf;    ///< cdfHeight entries
+  std::vector<float> conditionalCdf; ///< cdfWidth entries per row
+};
+
+/**
+ * @brief Analyzes a lat-long environment map in one pass over its rows, in
+ * parallel; stored pixels are converted a row at a time.
+ *
+ * The CDF has a cell per texel, up to 512 x 256 cells; larger images add up
+ * several texels per cell.
+ * @param threadCount 0 = hardware threads.
+ * @return False if the image has no pixels.
+ */
+bool ComputeLatLongLighting(const ImageData &image,
+                            EnvironmentLighting &lighting,
+                            int threadCount = 0);
+
+/**
+ * @brief Analyzes a cubemap in one pass over face rows, in parallel; each
+ * row is read from all six faces, which share its solid angles. The CDF is
+ * over a lat-long grid 4 faces wide, up to 512 x 256 cells.
+ * @param faces Six RGBA32F faces of faceSize x faceSize texels, one after
+ * another.
+ * @param threadCount 0 = hardware threads.
+ */
+bool ComputeCubeLighting(const float *faces, int faceSize,
+                         EnvironmentLighting &lighting, int threadCount = 0);
+
+/**
+ * @brief Writes the lighting as JSON: "sh9" (9 RGB triples), "irradiance",
+ * "dominantDirection" and "cdf" with "width", "height", "marginal" and
+ * "conditional" (one array per row).
+ */
+bool WriteEnvironmentLighting(const std::string &filepath,
+                              const EnvironmentLighting &lighting);
@@ -0,0 +1,169 @@
+#include "FrameCache.h"
+#include "ImageAnalysis.h"
+#include "Logger.h"
+#include "Profiler.h"
+
+namespace {
+
+size_t GetImageBytes(const ImageData &image) {
+  return image.pixels.size() * sizeof(float) + image.stored.GetByteSize();
+}
+
+// Moves float pixels to shared storage, so that copies of the image share
+// them like stored pixels
+void SharePixels(ImageData &image) {
+  if (image.pixels.empty())
+    return;
+  auto pixels = std::make_shared<std::vector<float>>(std::move(image.pixels));
+  image.pixels = std::vector<float>();
+
+  PixelBuffer &stored = image.stored;
+  stored.format = PixelFormat::RGBA32F;
+  stored.width = image.width;
+  stored.height = image.height;
+  stored.data = reinterpret_cast<const uint8_t *>(pixels->data());
+  stored.rowPitch = (ptrdiff_t)image.width * 4 * sizeof(float);
+  stored.owner = pixels;
+}
+
+} // namespace
+
+FrameCache::FrameCache(std::unique_ptr<FrameSource> source,
+                       size_t budgetBytes)
+    : m_source(std::move(source)), m_budget(budgetBytes) {
+  int count = m_source->GetFrameCount();
+  m_durations.resize(count);
+  for (int i = 0; i < count; i++)
+    m_durations[i] = m_source->GetFrameDuration(i);
+  m_frames.resize(count);
+  m_failed.resize(count);
+}
+
+FrameCache::~FrameCache() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+void FrameCache::Start(int frame, ImageData &image) {
+  SharePixels(image);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frames[frame] = std::make_shared<const ImageData>(image);
+    m_frameBytes = GetImageBytes(image);
+    m_cachedBytes = m_frameBytes;
+    m_cachedFrames = 1;
+    m_position = frame;
+  }
+  m_thread = std::thread(&FrameCache::PrefetchThread, this);
+}
+
+void FrameCache::SetPosition(int frame, int direction) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (frame == m_position && direction == m_direction)
+      return;
+    m_position = frame;
+    m_direction = direction;
+  }
+  m_wake.notify_one();
+}
+
+std::shared_ptr<const ImageData> FrameCache::GetFrame(int frame) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_frames[frame];
+}
+
+bool FrameCache::HasFailed(int frame) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_failed[frame];
+}
+
+int FrameCache::GetCachedFrameCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cachedFrames;
+}
+
+size_t FrameCache::GetCachedBytes() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cachedBytes;
+}
+
+int FrameCache::GetDistance(int frame) const {
+  int count = GetFrameCount();
+  return ((frame - m_position) * m_direction + count) % count;
+}
+
+int FrameCache::ChooseFrame() const {
+  // Walk in playback order, counting the memory of the frames on the way
+  int count = GetFrameCount();
+  size_t closerBytes = 0;
+  for (int distance = 0; distance < count; distance++) {
+    int frame = (m_position + distance * m_direction + count) % count;
+    if (m_frames[frame]) {
+      closerBytes += GetImageBytes(*m_frames[frame]);
+      continue;
+    }
+    if (m_failed[frame])
+      continue;
+    // The frame at the position is always decoded
+    if (distance > 0 && closerBytes + m_frameBytes > m_budget)
+      return -1;
+    return frame;
+  }
+  return -1;
+}
+
+void FrameCache::PrefetchThread() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stop) {
+    int frame = ChooseFrame();
+    if (frame < 0) {
+      m_wake.wait(lock);
+      continue;
+    }
+
+    lock.unlock();
+    ImageData image;
+    bool decoded;
+    {
+      PROFILE_SCOPE("Prefetch Frame");
+      decoded = m_source->DecodeFrame(frame, image);
+      if (decoded) {
+        SetImageRange(image, ComputeValueRange(image));
+        SharePixels(image);
+      }
+    }
+    lock.lock();
+
+    if (!decoded) {
+      LOG_ERROR("Failed to decode frame %d", frame);
+      m_failed[frame] = true;
+      continue;
+    }
+    m_frameBytes = GetImageBytes(image);
+    m_cachedBytes += m_frameBytes;
+    m_cachedFrames++;
+    m_frames[frame] = std::make_shared<const ImageData>(std::move(image));
+
+    // Evict the frames furthest away in playback order, never the one at
+    // the position
+    while (m_cachedBytes > m_budget) {
+      int victim = -1;
+      for (int i = 0; i < GetFrameCount(); i++) {
+        if (m_frames[i] && i != m_position &&
+            (victim < 0 || GetDistance(i) > GetDistance(victim)))
+          victim = i;
+      }
+      if (victim < 0)
+        break;
+      m_cachedBytes -= GetImageBytes(*m_frames[victim]);
+      m_cachedFrames--;
+      m_frames[victim].reset();
+    }
+  }
+}
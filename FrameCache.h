@@ -0,0 +1,96 @@
+#pragma once
+#include "FrameSource.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Decoded frames of a FrameSource, filled ahead of playback by a
+ * background thread.
+ *
+ * The UI thread only moves the playback position and picks up frames that
+ * are ready; it never decodes. The prefetch thread decodes the frame at the
+ * position first, then the frames after it in playback order (wrapping
+ * around) while they fit in the memory budget. When the budget is used up,
+ * the frames furthest away in playback order are evicted first.
+ */
+class FrameCache {
+public:
+  FrameCache(std::unique_ptr<FrameSource> source, size_t budgetBytes);
+
+  /**
+   * @brief Stops the prefetch thread, waiting for the frame being decoded.
+   */
+  ~FrameCache();
+
+  FrameCache(const FrameCache &) = delete;
+  FrameCache &operator=(const FrameCache &) = delete;
+
+  /**
+   * @brief Keeps a frame decoded by the caller and starts prefetching from
+   * it.
+   * \note Float pixels are moved to shared storage, so the caller's image
+   * and the cached frame use the same memory.
+   */
+  void Start(int frame, ImageData &image);
+
+  int GetFrameCount() const { return (int)m_durations.size(); }
+
+  /**
+   * @brief Gets how long a frame stays on screen (0 = no timing in file).
+   */
+  double GetFrameDuration(int frame) const { return m_durations[frame]; }
+
+  /**
+   * @brief Moves the playback position the prefetch thread works from.
+   * @param direction 1 to prefetch the following frames, -1 the previous.
+   */
+  void SetPosition(int frame, int direction);
+
+  /**
+   * @brief Gets a decoded frame, range analysis included.
+   * @return nullptr if the frame has not been decoded yet.
+   */
+  std::shared_ptr<const ImageData> GetFrame(int frame) const;
+
+  /**
+   * @brief Checks whether decoding a frame failed; it is not retried.
+   */
+  bool HasFailed(int frame) const;
+
+  int GetCachedFrameCount() const;
+  size_t GetCachedBytes() const;
+
+private:
+  void PrefetchThread();
+
+  /**
+   * @brief Picks the next frame to decode, or -1 if the budget is used up by
+   * frames closer to the position. Called with m_mutex held.
+   */
+  int ChooseFrame() const;
+
+  /**
+   * @brief Gets how many frames lie between the position and a frame in
+   * playback order.
+   */
+  int GetDistance(int frame) const;
+
+  std::unique_ptr<FrameSource> m_source;
+  std::vector<double> m_durations;
+  const size_t m_budget;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<std::shared_ptr<const ImageData>> m_frames;
+  std::vector<bool> m_failed;
+  size_t m_cachedBytes = 0;
+  size_t m_frameBytes = 0; // Size of the last decoded frame
+  int m_cachedFrames = 0;
+  int m_position = 0;
+  int m_direction = 1;
+  bool m_stop = false;
+  std::thread m_thread;
+};
@@ -0,0 +1,76 @@
+#include "FrameSource.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+
+// Splits "name0042.ext" into "name", "0042" and ".ext"
+bool SplitFrameNumber(const std::string &filename, std::string &prefix,
+                      std::string &digits, std::string &extension) {
+  size_t dot = filename.find_last_of('.');
+  if (dot == std::string::npos)
+    dot = filename.size();
+  size_t first = dot;
+  while (first > 0 && isdigit((unsigned char)filename[first - 1]))
+    first--;
+  if (first == dot)
+    return false;
+  prefix = filename.substr(0, first);
+  digits = filename.substr(first, dot - first);
+  extension = filename.substr(dot);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 ::tolower);
+  return true;
+}
+
+} // namespace
+
+bool ImageSequence::DecodeFrame(int frame, ImageData &out) {
+  PROFILE_SCOPE("ImageSequence::DecodeFrame");
+  if (frame < 0 || frame >= GetFrameCount())
+    return false;
+  return m_decode(m_paths[frame], out);
+}
+
+bool FindImageSequence(const std::string &filepath,
+                       std::vector<std::string> &paths, int &frame) {
+  PROFILE_SCOPE("FindImageSequence");
+  std::filesystem::path path = std::filesystem::u8path(filepath);
+  std::string prefix, digits, extension;
+  if (!SplitFrameNumber(path.filename().u8string(), prefix, digits,
+                        extension))
+    return false;
+
+  // Numbers are compared as text: all files have the same digit count
+  std::vector<std::pair<std::string, std::string>> frames; // Number, path
+  std::error_code error;
+  std::filesystem::path directory = path.parent_path();
+  if (directory.empty())
+    directory = ".";
+  for (std::filesystem::directory_iterator it(directory, error), end;
+       !error && it != end; it.increment(error)) {
+    std::string otherPrefix, otherDigits, otherExtension;
+    if (!it->is_regular_file(error) ||
+        !SplitFrameNumber(it->path().filename().u8string(), otherPrefix,
+                          otherDigits, otherExtension) ||
+        otherPrefix != prefix || otherDigits.size() != digits.size() ||
+        otherExtension != extension)
+      continue;
+    frames.emplace_back(otherDigits, it->path().u8string());
+  }
+  if (frames.size() < 2)
+    return false;
+
+  std::sort(frames.begin(), frames.end());
+  paths.clear();
+  frame = 0;
+  for (const auto &entry : frames) {
+    if (entry.first == digits)
+      frame = (int)paths.size();
+    paths.push_back(entry.second);
+  }
+  return true;
+}
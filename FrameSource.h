@@ -0,0 +1,71 @@
+#pragma once
+#include "ImageData.h"
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief An image made of frames shown one after another (animated GIF,
+ * numbered image files).
+ *
+ * Frames are decoded on demand by FrameCache, from its prefetch thread; a
+ * source is only ever used by one thread at a time.
+ */
+class FrameSource {
+public:
+  virtual ~FrameSource() = default;
+
+  virtual int GetFrameCount() const = 0;
+
+  /**
+   * @brief Gets how long a frame stays on screen, in seconds.
+   * @return 0 if the source has no timing; the viewer's frame rate applies.
+   */
+  virtual double GetFrameDuration(int frame) const = 0;
+
+  /**
+   * @brief Decodes one frame.
+   * @param out Receives pixels, size and format fields. Range analysis is
+   * left to the caller.
+   * @return False if the index is out of range or decoding failed.
+   */
+  virtual bool DecodeFrame(int frame, ImageData &out) = 0;
+};
+
+/**
+ * @brief Numbered image files ("shot.0001.exr", "shot.0002.exr", ...) viewed
+ * as the frames of one image.
+ */
+class ImageSequence : public FrameSource {
+public:
+  /// Decodes one file of the sequence
+  using DecodeFunction =
+      std::function<bool(const std::string &filepath, ImageData &out)>;
+
+  ImageSequence(std::vector<std::string> paths, DecodeFunction decode)
+      : m_paths(std::move(paths)), m_decode(std::move(decode)) {}
+
+  int GetFrameCount() const override { return (int)m_paths.size(); }
+  double GetFrameDuration(int) const override { return 0.0; }
+  bool DecodeFrame(int frame, ImageData &out) override;
+
+  const std::string &GetPath(int frame) const { return m_paths[frame]; }
+
+private:
+  std::vector<std::string> m_paths;
+  DecodeFunction m_decode;
+};
+
+/**
+ * @brief Finds the files numbered like the given one in its directory.
+ *
+ * A file is part of a sequence when its name ends with digits before the
+ * extension; the other files of the sequence have the same prefix, digit
+ * count and extension.
+ * @param paths Receives the files sorted by number, including filepath.
+ * @param frame Receives the position of filepath in paths.
+ * @return False if the file has no number or no other file matches.
+ */
+bool FindImageSequence(const std::string &filepath,
+                       std::vector<std::string> &paths, int &frame);
@@ -0,0 +1,338 @@
+#include "GIFImage.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Browsers show frames with a delay under 20 ms for 100 ms
+const int g_MinDelay = 2;            // Hundredths of a second
+const double g_DefaultDuration = 0.1; // Seconds
+
+// Larger canvases and frames are rejected rather than allocated
+const size_t g_MaxPixels = 1 << 27;
+
+// Saved canvases are kept under this size
+const size_t g_MaxCheckpointBytes = 64ull * 1024 * 1024;
+
+const int g_MaxCodeSize = 12;
+const int g_MaxCodes = 1 << g_MaxCodeSize;
+
+inline int ReadU16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+// Moves pos past a chain of sub-blocks; false if the chain is truncated
+bool SkipSubBlocks(const uint8_t *data, size_t size, size_t &pos) {
+  while (pos < size) {
+    size_t length = data[pos++];
+    if (length == 0)
+      return true;
+    if (size - pos < length)
+      return false;
+    pos += length;
+  }
+  return false;
+}
+
+/**
+ * Decodes LZW data from the sub-blocks starting at pos into count palette
+ * indices. Corrupt or truncated data stops the decode; indices not reached
+ * are left as they are, as browsers do.
+ */
+void DecodeLZW(const uint8_t *data, size_t size, size_t pos, int minCodeSize,
+               uint8_t *out, size_t count) {
+  static thread_local uint16_t s_Prefix[g_MaxCodes];
+  static thread_local uint8_t s_Suffix[g_MaxCodes];
+  static thread_local uint8_t s_First[g_MaxCodes];
+  static thread_local uint16_t s_Length[g_MaxCodes];
+
+  const int clearCode = 1 << minCodeSize;
+  const int endCode = clearCode + 1;
+  for (int code = 0; code < clearCode; code++) {
+    s_Suffix[code] = (uint8_t)code;
+    s_First[code] = (uint8_t)code;
+    s_Length[code] = 1;
+  }
+
+  int codeSize = minCodeSize + 1;
+  int nextCode = clearCode + 2;
+  int prevCode = -1;
+  uint32_t bits = 0;
+  int bitCount = 0;
+  size_t blockLeft = 0;
+  size_t written = 0;
+
+  while (written < count) {
+    while (bitCount < codeSize) {
+      if (blockLeft == 0) {
+        if (pos >= size || data[pos] == 0)
+          return;
+        blockLeft = data[pos++];
+      }
+      if (pos >= size)
+        return;
+      bits |= (uint32_t)data[pos++] << bitCount;
+      bitCount += 8;
+      blockLeft--;
+    }
+    int code = bits & ((1 << codeSize) - 1);
+    bits >>= codeSize;
+    bitCount -= codeSize;
+
+    if (code == clearCode) {
+      codeSize = minCodeSize + 1;
+      nextCode = clearCode + 2;
+      prevCode = -1;
+      continue;
+    }
+    if (code == endCode)
+      return;
+
+    if (prevCode < 0) {
+      if (code >= clearCode)
+        return;
+    } else {
+      if (code > nextCode || (code == nextCode && nextCode >= g_MaxCodes))
+        return;
+      // Code nextCode is the previous string plus its own first index
+      if (nextCode < g_MaxCodes) {
+        s_Prefix[nextCode] = (uint16_t)prevCode;
+        s_Suffix[nextCode] = s_First[code == nextCode ? prevCode : code];
+        s_First[nextCode] = s_First[prevCode];
+        s_Length[nextCode] = s_Length[prevCode] + 1;
+        nextCode++;
+        if (nextCode == (1 << codeSize) && codeSize < g_MaxCodeSize)
+          codeSize++;
+      }
+    }
+
+    // Strings are linked from their last index, so write them backwards
+    size_t length = s_Length[code];
+    int walk = code;
+    for (size_t i = length; i-- > 0;) {
+      if (written + i < count)
+        out[written + i] = s_Suffix[walk];
+      walk = s_Prefix[walk];
+    }
+    written += length;
+    prevCode = code;
+  }
+}
+
+} // namespace
+
+GIFImage::GIFImage() {}
+
+GIFImage::~GIFImage() {}
+
+bool GIFImage::Open(const std::string &filepath) {
+  PROFILE_SCOPE("GIFImage::Open");
+  if (!m_file.Open(filepath))
+    return false;
+
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+  if (size < 13 || (memcmp(data, "GIF87a", 6) != 0 &&
+                    memcmp(data, "GIF89a", 6) != 0))
+    return false;
+
+  m_width = ReadU16(data + 6);
+  m_height = ReadU16(data + 8);
+  if (m_width == 0 || m_height == 0 ||
+      (size_t)m_width * m_height > g_MaxPixels)
+    return false;
+
+  size_t pos = 13;
+  size_t globalPalette = 0;
+  int globalPaletteSize = 0;
+  if (data[10] & 0x80) {
+    globalPalette = pos;
+    globalPaletteSize = 2 << (data[10] & 7);
+    pos += (size_t)globalPaletteSize * 3;
+  }
+
+  // Graphic control extension of the next frame
+  int transparent = -1;
+  int disposal = 0;
+  int delay = 0;
+
+  bool truncated = false;
+  while (pos < size && !truncated) {
+    uint8_t block = data[pos++];
+    if (block == 0x3B) // Trailer
+      break;
+
+    if (block == 0x21) { // Extension
+      if (pos >= size)
+        break;
+      uint8_t label = data[pos++];
+      if (label == 0xF9 && size - pos >= 6 && data[pos] >= 4) {
+        uint8_t flags = data[pos + 1];
+        disposal = (flags >> 2) & 7;
+        delay = ReadU16(data + pos + 2);
+        transparent = (flags & 1) ? data[pos + 4] : -1;
+      }
+      truncated = !SkipSubBlocks(data, size, pos);
+    } else if (block == 0x2C) { // Image
+      if (size - pos < 10)
+        break;
+      Frame frame;
+      frame.left = ReadU16(data + pos);
+      frame.top = ReadU16(data + pos + 2);
+      frame.width = ReadU16(data + pos + 4);
+      frame.height = ReadU16(data + pos + 6);
+      uint8_t flags = data[pos + 8];
+      frame.interlaced = (flags & 0x40) != 0;
+      pos += 9;
+
+      frame.paletteOffset = globalPalette;
+      frame.paletteSize = globalPaletteSize;
+      if (flags & 0x80) {
+        frame.paletteOffset = pos;
+        frame.paletteSize = 2 << (flags & 7);
+        pos += (size_t)frame.paletteSize * 3;
+      }
+      if (pos >= size)
+        break;
+
+      frame.transparent = transparent;
+      frame.disposal = disposal;
+      frame.duration = delay < g_MinDelay ? g_DefaultDuration : delay / 100.0;
+      frame.dataOffset = pos++;
+      truncated = !SkipSubBlocks(data, size, pos);
+      if (!truncated)
+        m_frames.push_back(frame);
+
+      transparent = -1;
+      disposal = 0;
+      delay = 0;
+    } else {
+      LOG_ERROR("Unknown GIF block 0x%02X at offset %zu", block, pos - 1);
+      break;
+    }
+  }
+
+  if (m_frames.empty())
+    return false;
+
+  size_t canvasBytes = (size_t)m_width * m_height * 4;
+  size_t savedCanvases =
+      std::max<size_t>(1, g_MaxCheckpointBytes / canvasBytes);
+  m_checkpointInterval =
+      std::max<int>(16, (int)((m_frames.size() + savedCanvases - 1) /
+                              savedCanvases));
+  return true;
+}
+
+void GIFImage::ComposeFrame(int frameIndex, uint8_t *result) {
+  const Frame &frame = m_frames[frameIndex];
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+
+  // A frame restoring the previous canvas leaves it unchanged
+  if (frame.disposal == 3) {
+    if (!result)
+      return;
+    memcpy(result, m_canvas.data(), m_canvas.size());
+  }
+  uint8_t *target = frame.disposal == 3 ? result : m_canvas.data();
+
+  // Parts of the frame outside the canvas are decoded but not drawn
+  int x0 = std::min(frame.left, m_width);
+  int y0 = std::min(frame.top, m_height);
+  int x1 = std::min(frame.left + frame.width, m_width);
+  int y1 = std::min(frame.top + frame.height, m_height);
+
+  int minCodeSize = data[frame.dataOffset];
+  size_t pixelCount = (size_t)frame.width * frame.height;
+  if (pixelCount > 0 && pixelCount <= g_MaxPixels && minCodeSize >= 1 &&
+      minCodeSize < g_MaxCodeSize) {
+    // Pixels not covered by the LZW data stay transparent
+    m_indices.resize(pixelCount);
+    uint8_t fill = frame.transparent >= 0 ? (uint8_t)frame.transparent : 0;
+    memset(m_indices.data(), fill, pixelCount);
+    DecodeLZW(data, size, frame.dataOffset + 1, minCodeSize,
+              m_indices.data(), pixelCount);
+
+    const uint8_t *palette = frame.paletteOffset ? data + frame.paletteOffset
+                                                 : nullptr;
+    int row = 0;
+    int pass = 0;
+    static const int s_PassStart[] = {0, 4, 2, 1};
+    static const int s_PassStep[] = {8, 8, 4, 2};
+    for (int i = 0; i < frame.height; i++) {
+      // Interlaced frames store rows 0, 8, ..., then 4, 12, ..., and so on
+      int y = i;
+      if (frame.interlaced) {
+        while (row >= frame.height && pass < 3) {
+          pass++;
+          row = s_PassStart[pass];
+        }
+        y = row;
+        row += s_PassStep[pass];
+      }
+      y += frame.top;
+      if (y < y0 || y >= y1)
+        continue;
+
+      const uint8_t *indices = m_indices.data() + (size_t)i * frame.width;
+      uint8_t *dst = target + ((size_t)y * m_width + x0) * 4;
+      for (int x = x0; x < x1; x++, dst += 4) {
+        int index = indices[x - frame.left];
+        if (index == frame.transparent)
+          continue;
+        if (palette && index < frame.paletteSize) {
+          dst[0] = palette[index * 3];
+          dst[1] = palette[index * 3 + 1];
+          dst[2] = palette[index * 3 + 2];
+        } else {
+          dst[0] = dst[1] = dst[2] = 0;
+        }
+        dst[3] = 255;
+      }
+    }
+  }
+
+  if (frame.disposal == 3)
+    return;
+  if (result)
+    memcpy(result, m_canvas.data(), m_canvas.size());
+  if (frame.disposal == 2) {
+    for (int y = y0; y < y1; y++)
+      memset(m_canvas.data() + ((size_t)y * m_width + x0) * 4, 0,
+             (size_t)(x1 - x0) * 4);
+  }
+}
+
+bool GIFImage::DecodeFrame(int frame, ImageData &out) {
+  PROFILE_SCOPE("GIFImage::DecodeFrame");
+  if (frame < 0 || frame >= GetFrameCount())
+    return false;
+
+  // Restart from the latest canvas at or before the frame
+  if (m_canvas.empty() || frame < m_nextFrame) {
+    m_canvas.assign((size_t)m_width * m_height * 4, 0);
+    m_nextFrame = 0;
+  }
+  auto checkpoint = m_checkpoints.upper_bound(frame);
+  if (checkpoint != m_checkpoints.begin() &&
+      (--checkpoint)->first > m_nextFrame) {
+    m_canvas = checkpoint->second;
+    m_nextFrame = checkpoint->first;
+  }
+
+  uint8_t *dst;
+  out.stored = AllocatePixelBuffer(PixelFormat::RGBA8, m_width, m_height, dst);
+  for (; m_nextFrame <= frame; m_nextFrame++) {
+    if (m_nextFrame % m_checkpointInterval == 0 && m_nextFrame > 0)
+      m_checkpoints.emplace(m_nextFrame, m_canvas);
+    ComposeFrame(m_nextFrame, m_nextFrame == frame ? dst : nullptr);
+  }
+
+  out.width = m_width;
+  out.height = m_height;
+  out.channels = 4;
+  out.format = "GIF";
+  out.pixelFormat = "RGBA8";
+  return true;
+}
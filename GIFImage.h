@@ -0,0 +1,72 @@
+#pragma once
+#include "FrameSource.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Animated GIF read through a memory mapping.
+ *
+ * Open() walks the blocks of the file once and records where each frame
+ * lives. DecodeFrame() composes frames onto the canvas in order, applying
+ * the disposal method of each; frames decoded one after the other cost a
+ * single LZW decode each. The canvas is saved every few frames, so seeking
+ * backwards restarts from the nearest saved canvas instead of the first
+ * frame.
+ */
+class GIFImage : public FrameSource {
+public:
+  GIFImage();
+  ~GIFImage() override;
+
+  /**
+   * @brief Maps the file and indexes its frames.
+   * @return False if the file is not a GIF or has no frame. A truncated
+   * file keeps the frames before the damage.
+   */
+  bool Open(const std::string &filepath);
+
+  int GetFrameCount() const override { return (int)m_frames.size(); }
+  double GetFrameDuration(int frame) const override {
+    return m_frames[frame].duration;
+  }
+  bool DecodeFrame(int frame, ImageData &out) override;
+
+  int GetWidth() const { return m_width; }
+  int GetHeight() const { return m_height; }
+
+private:
+  struct Frame {
+    int left, top, width, height;
+    bool interlaced;
+    size_t paletteOffset; ///< Color table in the file; 0 = none
+    int paletteSize;      ///< Entries in the color table
+    int transparent;      ///< Transparent palette index; -1 = none
+    int disposal;         ///< 2 = clear to transparent, 3 = restore previous
+    double duration;      ///< Seconds
+    size_t dataOffset;    ///< LZW minimum code size, then the sub-blocks
+  };
+
+  /**
+   * @brief Draws one frame over m_canvas and moves m_canvas on to what the
+   * next frame is drawn over.
+   * @param result Receives the composed frame; nullptr when it is skipped.
+   */
+  void ComposeFrame(int frame, uint8_t *result);
+
+  MappedFile m_file;
+  int m_width = 0;
+  int m_height = 0;
+  std::vector<Frame> m_frames;
+
+  // Canvas before frame m_nextFrame is drawn, disposal already applied
+  std::vector<uint8_t> m_canvas;
+  int m_nextFrame = 0;
+  std::vector<uint8_t> m_indices; // Palette indices of one frame
+
+  // Canvases before every m_checkpointInterval-th frame, by frame
+  std::map<int, std::vector<uint8_t>> m_checkpoints;
+  int m_checkpointInterval = 16;
+};
@@ -0,0 +1,55 @@
+#include "HalfFloat.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HALF_FLOAT_F16C 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef HALF_FLOAT_F16C
+// F16C instructions are VEX encoded, so the OS must save AVX state as well
+static bool HasF16C() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  bool f16c = (info[2] & (1 << 29)) != 0;
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  return f16c && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return false;
+  return (ecx & bit_F16C) != 0 && __builtin_cpu_supports("avx");
+#endif
+}
+
+#if defined(__GNUC__) && !defined(__F16C__)
+__attribute__((target("avx,f16c")))
+#endif
+static void HalfToFloatF16C(const uint16_t *src, float *dst, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i halves = _mm_loadu_si128((const __m128i *)(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(halves));
+  }
+  for (; i < count; i++)
+    dst[i] = HalfToFloat(src[i]);
+}
+#endif
+
+void HalfToFloatArray(const uint16_t *src, float *dst, size_t count) {
+#ifdef HALF_FLOAT_F16C
+  static const bool s_hasF16C = HasF16C();
+  if (s_hasF16C) {
+    HalfToFloatF16C(src, dst, count);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; i++)
+    dst[i] = HalfToFloat(src[i]);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief Converts an IEEE 754 half (binary16) to float, exactly.
+ * \note Handles subnormals, infinities and NaN payloads.
+ */
+inline float HalfToFloat(uint16_t half) {
+  uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    bits = sign | 0x7f800000 | (mantissa << 13); // Inf / NaN
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign; // +-0
+  } else {
+    // Subnormal half: normalize into a float exponent
+    exponent = 113;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief Converts a float to the nearest half (ties to even).
+ * \note Values beyond the half range become infinity; NaNs stay NaN.
+ */
+inline uint16_t FloatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+  uint32_t magnitude = bits & 0x7fffffff;
+
+  if (magnitude > 0x7f800000) // NaN: keep it quiet and keep the payload top
+    return sign | 0x7e00 | ((magnitude >> 13) & 0x3ff);
+  if (magnitude >= 0x47800000) // >= 65536, including infinity
+    return sign | 0x7c00;
+
+  uint32_t half, remainder, halfway;
+  if (magnitude >= 0x38800000) {
+    // Normal half: rebias the exponent from 127 to 15
+    half = (magnitude - 0x38000000) >> 13;
+    remainder = magnitude & 0x1fff;
+    halfway = 0x1000;
+  } else if (magnitude >= 0x33000000) {
+    // Subnormal half: shift the mantissa with its implicit bit into place
+    uint32_t shift = 126 - (magnitude >> 23);
+    uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+    half = mantissa >> shift;
+    remainder = mantissa & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+  } else {
+    return sign; // Rounds to zero
+  }
+
+  // Round to nearest even; a carry may move into the exponent or to infinity
+  if (remainder > halfway || (remainder == halfway && (half & 1)))
+    half++;
+  return sign | (uint16_t)half;
+}
+
+/**
+ * @brief Converts an array of halves to floats.
+ *
+ * Uses F16C (8 values per instruction) when the CPU supports it, HalfToFloat
+ * otherwise. Results are identical apart from signaling NaNs, which F16C
+ * returns quieted.
+ */
+void HalfToFloatArray(const uint16_t *src, float *dst, size_t count);
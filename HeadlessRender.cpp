@@ -0,0 +1,106 @@
+#include "HeadlessRender.h"
+#include "ImgViewer.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "RawImage.h"
+#include "SoftwareRenderer.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+int RunHeadlessRender(const HeadlessRenderOptions &options) {
+  if (options.inputFile.empty()) {
+    std::cerr << "--render requires an input file\n";
+    return 1;
+  }
+  // Checked before loading, so a typo does not cost a decode
+  if (!(options.zoom > 0.0f) || !std::isfinite(options.zoom)) {
+    std::cerr << "Invalid --zoom, expected a number greater than 0\n";
+    return 1;
+  }
+
+  SoftwareViewParams params;
+  params.zoom = options.zoom;
+  if (!options.pan.empty() &&
+      sscanf(options.pan.c_str(), "%f,%f", &params.panX, &params.panY) != 2) {
+    std::cerr << "Invalid --pan, expected x,y\n";
+    return 1;
+  }
+  bool autoRange = options.range.empty();
+  if (!autoRange && sscanf(options.range.c_str(), "%f,%f", &params.rangeMin,
+                           &params.rangeMax) != 2) {
+    std::cerr << "Invalid --range, expected min,max\n";
+    return 1;
+  }
+  int width = 0;
+  int height = 0;
+  if (!options.size.empty() &&
+      sscanf(options.size.c_str(), "%dx%d", &width, &height) != 2) {
+    std::cerr << "Invalid --size, expected WxH\n";
+    return 1;
+  }
+
+  ImgViewer viewer;
+  if (!options.raw.empty()) {
+    RawImageLayout layout;
+    if (!ParseRawImageLayout(options.raw, layout)) {
+      std::cerr << "Invalid --raw, expected "
+                   "width,height,format[,rowPitch[,offset[,flip]]]\n";
+      return 1;
+    }
+    viewer.SetRawLayout(options.inputFile, layout);
+  }
+  if (!viewer.LoadImage(options.inputFile)) {
+    std::cerr << "Failed to load image: " << options.inputFile << "\n";
+    return 1;
+  }
+  const ImageData &imgData = viewer.GetImageData();
+  if (autoRange) {
+    params.rangeMin = viewer.GetRangeMin();
+    params.rangeMax = viewer.GetRangeMax();
+  }
+
+  // The zoomed size is computed in double so that a large zoom is reported
+  // instead of overflowing the int
+  if (options.size.empty()) {
+    double zoomedWidth = std::ceil(imgData.width * (double)params.zoom);
+    double zoomedHeight = std::ceil(imgData.height * (double)params.zoom);
+    if (zoomedWidth > SoftwareRenderer::MaxOutputSize ||
+        zoomedHeight > SoftwareRenderer::MaxOutputSize) {
+      std::cerr << "--zoom " << params.zoom << " makes the output larger "
+                << "than " << SoftwareRenderer::MaxOutputSize
+                << " pixels; pass --size or a smaller --zoom\n";
+      return 1;
+    }
+    width = (int)zoomedWidth;
+    height = (int)zoomedHeight;
+  }
+  if (width < 1 || height < 1 || width > SoftwareRenderer::MaxOutputSize ||
+      height > SoftwareRenderer::MaxOutputSize) {
+    std::cerr << "Invalid output size " << width << "x" << height
+              << ", expected 1 to " << SoftwareRenderer::MaxOutputSize
+              << " pixels on a side\n";
+    return 1;
+  }
+
+  LOG("Headless render: %s -> %s (%dx%d, zoom=%.3f, pan=(%.1f, %.1f), "
+      "range=[%.4f, %.4f])",
+      options.inputFile.c_str(), options.outputFile.c_str(), width, height,
+      params.zoom, params.panX, params.panY, params.rangeMin, params.rangeMax);
+
+  SoftwareRenderer renderer;
+  std::vector<unsigned char> rgba;
+  PROFILE_SCOPE("Headless Render");
+  if (!renderer.Render(imgData, params, width, height, rgba)) {
+    std::cerr << "Failed to render view\n";
+    return 1;
+  }
+
+  if (!SoftwareRenderer::WritePNG(options.outputFile, rgba, width, height)) {
+    std::cerr << "Failed to write " << options.outputFile << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+/**
+ * @brief Options for rendering the image view without a window or GPU.
+ */
+struct HeadlessRenderOptions {
+  std::string inputFile;
+  std::string outputFile;
+  float zoom = 1.0f;
+  std::string pan;   ///< "x,y" in screen pixels
+  std::string range; ///< "min,max" (empty = auto-detected range)
+  std::string size;  ///< "WxH" (empty = zoomed image size)
+  std::string raw;   ///< Layout of a headerless input file
+};
+
+/**
+ * @brief Loads the input file and renders its view to a PNG on the CPU.
+ *
+ * Shared by imgViewer --render and imgViewerRender. Errors are printed to
+ * stderr; zoom must be positive and the output at most
+ * SoftwareRenderer::MaxOutputSize pixels on a side.
+ * @return Process exit code.
+ */
+int RunHeadlessRender(const HeadlessRenderOptions &options);
@@ -0,0 +1,123 @@
+#pragma once
+#include "ImgViewer.h"
+#include <cstdint>
+
+// D3D-free stand-ins for DX12Renderer and ImageRenderer, used when the UI is
+// built with IMGVIEWER_HEADLESS (the UI replay benchmark). They keep the same
+// interface so ImgViewerUI compiles unchanged, record the sizes the UI asks
+// for, and never touch a GPU.
+
+typedef unsigned int UINT;
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE { D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0 };
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE {
+  uint64_t ptr;
+};
+
+struct ID3D12GraphicsCommandList;
+struct ID3D12DescriptorHeap;
+
+struct ID3D12Device {
+  UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) {
+    return 32;
+  }
+};
+
+/**
+ * @brief Stand-in for the DX12 device, swap chain and command queue.
+ */
+class DX12Renderer {
+public:
+  ID3D12Device *GetDevice() { return &m_device; }
+  ID3D12DescriptorHeap *GetSrvHeap() const { return nullptr; }
+  ID3D12GraphicsCommandList *GetCommandList() const { return nullptr; }
+
+  void BeginRender() {}
+  void EndRender() {}
+  void WaitForGpu() {}
+  void OnResize(UINT width, UINT height) {
+    m_width = width;
+    m_height = height;
+  }
+
+  UINT GetWidth() const { return m_width; }
+  UINT GetHeight() const { return m_height; }
+  UINT GetFrameIndex() const { return 0; }
+
+  static const UINT FrameCount = 2;
+
+private:
+  ID3D12Device m_device;
+  UINT m_width = 0;
+  UINT m_height = 0;
+};
+
+/**
+ * @brief Stand-in for the image texture and view render target.
+ */
+class ImageRenderer {
+public:
+  bool Initialize(ID3D12Device *, ID3D12DescriptorHeap *, UINT) {
+    return true;
+  }
+
+  void ClearTexture() {
+    m_hasTexture = false;
+    m_imageWidth = 0;
+    m_imageHeight = 0;
+  }
+
+  bool UploadImage(ID3D12Device *, ID3D12GraphicsCommandList *,
+                   const ImageData &imageData) {
+    m_hasTexture = imageData.GetPixelCount() > 0;
+    m_imageWidth = imageData.width;
+    m_imageHeight = imageData.height;
+    m_pixelFormat = imageData.stored.format;
+    return m_hasTexture;
+  }
+
+  bool IsTextureCompatible(const ImageData &imageData) const {
+    return m_hasTexture && imageData.width == m_imageWidth &&
+           imageData.height == m_imageHeight &&
+           imageData.stored.format == m_pixelFormat;
+  }
+
+  bool UpdateTexture(ID3D12Device *, ID3D12GraphicsCommandList *,
+                     const ImageData &imageData, UINT) {
+    return IsTextureCompatible(imageData);
+  }
+
+  void Render(ID3D12GraphicsCommandList *, float, const DirectX::XMFLOAT2 &,
+              float, float, bool, bool, bool, int, int, int, int, int, int) {}
+
+  bool ResizeRenderTarget(ID3D12Device *, int width, int height) {
+    if (width <= 0 || height <= 0)
+      return false;
+    m_renderTargetWidth = width;
+    m_renderTargetHeight = height;
+    return true;
+  }
+
+  void RenderToTexture(ID3D12GraphicsCommandList *, float,
+                       const DirectX::XMFLOAT2 &, float, float, bool, bool,
+                       bool) {}
+
+  bool HasTexture() const { return m_hasTexture; }
+  int GetImageWidth() const { return m_imageWidth; }
+  int GetImageHeight() const { return m_imageHeight; }
+  int GetRenderTargetWidth() const { return m_renderTargetWidth; }
+  int GetRenderTargetHeight() const { return m_renderTargetHeight; }
+
+  // Any non-zero ID; draw data is never submitted
+  D3D12_GPU_DESCRIPTOR_HANDLE GetSrvGpuHandle() const { return {1}; }
+  D3D12_GPU_DESCRIPTOR_HANDLE GetOutputSrvGpuHandle() const { return {1}; }
+
+private:
+  bool m_hasTexture = false;
+  int m_imageWidth = 0;
+  int m_imageHeight = 0;
+  PixelFormat m_pixelFormat = PixelFormat::RGBA32F;
+  int m_renderTargetWidth = 0;
+  int m_renderTargetHeight = 0;
+};
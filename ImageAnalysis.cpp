@@ -0,0 +1,403 @@
+#include "ImageAnalysis.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_ANALYSIS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Pixels per work item handed to ParallelFor
+static const size_t g_BlockPixels = 64 * 1024;
+
+static int GetBlockCount(size_t pixelCount) {
+  return (int)((pixelCount + g_BlockPixels - 1) / g_BlockPixels);
+}
+
+// Gets RGBA32F values for pixels [begin, end). Float data is used in place;
+// stored formats are converted into the caller's buffer.
+static const float *LoadBlock(const float *pixels, size_t begin, size_t,
+                              std::vector<float> &) {
+  return pixels + begin * 4;
+}
+
+static const float *LoadBlock(const PixelBuffer &pixels, size_t begin,
+                              size_t end, std::vector<float> &buffer) {
+  buffer.resize((end - begin) * 4);
+  ConvertPixels(pixels, begin, end, buffer.data());
+  return buffer.data();
+}
+
+namespace {
+// Per-lane (R, G, B, A) accumulators of a range scan
+struct LaneRange {
+  float minValue[4] = {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+  float maxValue[4] = {-FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX};
+  bool hasNaN[4] = {false, false, false, false};
+};
+} // namespace
+
+static void ScanRange(const float *pixels, size_t begin, size_t end,
+                      LaneRange &lanes) {
+#ifdef IMAGE_ANALYSIS_SSE2
+  // One RGBA pixel per register. min/max return the second operand when the
+  // first is NaN, so NaNs never reach the accumulators.
+  __m128 vMin = _mm_loadu_ps(lanes.minValue);
+  __m128 vMax = _mm_loadu_ps(lanes.maxValue);
+  __m128 vNaN = _mm_setzero_ps();
+  for (size_t i = begin; i < end; i++) {
+    __m128 v = _mm_loadu_ps(pixels + i * 4);
+    vMin = _mm_min_ps(v, vMin);
+    vMax = _mm_max_ps(v, vMax);
+    vNaN = _mm_or_ps(vNaN, _mm_cmpunord_ps(v, v));
+  }
+  _mm_storeu_ps(lanes.minValue, vMin);
+  _mm_storeu_ps(lanes.maxValue, vMax);
+  int nanBits = _mm_movemask_ps(vNaN);
+  for (int c = 0; c < 4; c++)
+    lanes.hasNaN[c] = lanes.hasNaN[c] || (nanBits & (1 << c)) != 0;
+#else
+  for (size_t i = begin; i < end; i++) {
+    const float *pixel = pixels + i * 4;
+    for (int c = 0; c < 4; c++) {
+      float value = pixel[c];
+      if (std::isnan(value)) {
+        lanes.hasNaN[c] = true;
+        continue;
+      }
+      lanes.minValue[c] = std::min(lanes.minValue[c], value);
+      lanes.maxValue[c] = std::max(lanes.maxValue[c], value);
+    }
+  }
+#endif
+}
+
+template <typename Pixels>
+static ValueRange ComputeValueRangeImpl(const Pixels &pixels,
+                                        size_t pixelCount,
+                                        unsigned int channelMask,
+                                        int threadCount) {
+  ValueRange result;
+  if (pixelCount == 0 || (channelMask & ChannelRGBA) == 0)
+    return result;
+
+  int blockCount = GetBlockCount(pixelCount);
+  std::vector<LaneRange> partials(
+      GetParallelChunkCount(blockCount, threadCount));
+
+  ParallelForChunks(
+      blockCount, threadCount,
+      [&](int chunkIndex, int blockBegin, int blockEnd) {
+        std::vector<float> buffer;
+        for (int block = blockBegin; block < blockEnd; block++) {
+          size_t begin = (size_t)block * g_BlockPixels;
+          size_t end = std::min(pixelCount, begin + g_BlockPixels);
+          const float *values = LoadBlock(pixels, begin, end, buffer);
+          ScanRange(values, 0, end - begin, partials[chunkIndex]);
+        }
+      });
+
+  float minValue = FLT_MAX;
+  float maxValue = -FLT_MAX;
+  for (const LaneRange &lanes : partials) {
+    for (int c = 0; c < 4; c++) {
+      if (!(channelMask & (1u << c)))
+        continue;
+      minValue = std::min(minValue, lanes.minValue[c]);
+      maxValue = std::max(maxValue, lanes.maxValue[c]);
+      result.hasNaN = result.hasNaN || lanes.hasNaN[c];
+    }
+  }
+
+  result.valid = minValue <= maxValue;
+  if (result.valid) {
+    result.minValue = minValue;
+    result.maxValue = maxValue;
+  }
+  return result;
+}
+
+template <typename Pixels>
+static void ComputeHistogramImpl(const Pixels &pixels, size_t pixelCount,
+                                 float rangeMin, float rangeMax, int binCount,
+                                 int *histR, int *histG, int *histB,
+                                 int threadCount) {
+  if (binCount <= 0)
+    return;
+
+  int *outputs[3] = {histR, histG, histB};
+  for (int ch = 0; ch < 3; ch++)
+    std::fill(outputs[ch], outputs[ch] + binCount, 0);
+
+  if (pixelCount == 0)
+    return;
+
+  int blockCount = GetBlockCount(pixelCount);
+
+  // Each chunk counts into its own bins, merged afterwards
+  std::vector<std::vector<int>> partials(
+      GetParallelChunkCount(blockCount, threadCount));
+
+  float rangeSize = rangeMax - rangeMin;
+  float maxBin = (float)(binCount - 1);
+
+  ParallelForChunks(blockCount, threadCount, [&](int chunkIndex,
+                                                 int blockBegin,
+                                                 int blockEnd) {
+    std::vector<int> &bins = partials[chunkIndex];
+    bins.assign((size_t)binCount * 3, 0);
+    int *binsRGB[3] = {bins.data(), bins.data() + binCount,
+                       bins.data() + binCount * 2};
+
+    std::vector<float> buffer;
+    for (int block = blockBegin; block < blockEnd; block++) {
+      size_t begin = (size_t)block * g_BlockPixels;
+      size_t end = std::min(pixelCount, begin + g_BlockPixels);
+      const float *values = LoadBlock(pixels, begin, end, buffer);
+      for (size_t i = 0; i < end - begin; i++) {
+        const float *pixel = values + i * 4;
+        for (int ch = 0; ch < 3; ch++) {
+          float value = pixel[ch];
+          if (std::isnan(value))
+            continue;
+
+          // Clamp in float so out-of-range and infinite values are safe to
+          // convert to a bin index
+          float t = (value - rangeMin) / rangeSize * maxBin;
+          t = std::max(0.0f, std::min(maxBin, t));
+          binsRGB[ch][(int)t]++;
+        }
+      }
+    }
+  });
+
+  for (const std::vector<int> &bins : partials) {
+    if (bins.empty())
+      continue;
+    for (int ch = 0; ch < 3; ch++) {
+      const int *src = bins.data() + (size_t)binCount * ch;
+      for (int i = 0; i < binCount; i++)
+        outputs[ch][i] += src[i];
+    }
+  }
+}
+
+// Min/max of each stored component of integer rows; T is the component
+template <typename T> struct IntegerLaneRange {
+  T minValue[4];
+  T maxValue[4];
+  IntegerLaneRange() {
+    std::fill(minValue, minValue + 4, std::numeric_limits<T>::max());
+    std::fill(maxValue, maxValue + 4, std::numeric_limits<T>::lowest());
+  }
+};
+
+template <typename T>
+static ValueRange ComputeIntegerRangeImpl(const PixelBuffer &pixels,
+                                          int channels,
+                                          unsigned int channelMask,
+                                          int threadCount) {
+  ValueRange result;
+  result.integer = true;
+  unsigned int componentMask = channelMask & ((1u << channels) - 1);
+  if (componentMask == 0 || pixels.width == 0 || pixels.height == 0)
+    return result;
+
+  std::vector<IntegerLaneRange<T>> partials(
+      GetParallelChunkCount(pixels.height, threadCount));
+  ParallelForChunks(
+      pixels.height, threadCount,
+      [&](int chunkIndex, int rowBegin, int rowEnd) {
+        IntegerLaneRange<T> &lanes = partials[chunkIndex];
+        size_t rowValues = (size_t)pixels.width * channels;
+        for (int y = rowBegin; y < rowEnd; y++) {
+          const uint8_t *row = pixels.GetRow(y);
+          for (size_t i = 0; i < rowValues; i += channels) {
+            for (int c = 0; c < channels; c++) {
+              T value;
+              memcpy(&value, row + (i + c) * sizeof(T), sizeof(T));
+              lanes.minValue[c] = std::min(lanes.minValue[c], value);
+              lanes.maxValue[c] = std::max(lanes.maxValue[c], value);
+            }
+          }
+        }
+      });
+
+  int64_t minValue = std::numeric_limits<int64_t>::max();
+  int64_t maxValue = std::numeric_limits<int64_t>::min();
+  for (const IntegerLaneRange<T> &lanes : partials) {
+    for (int c = 0; c < channels; c++) {
+      if (!(componentMask & (1u << c)))
+        continue;
+      minValue = std::min(minValue, (int64_t)lanes.minValue[c]);
+      maxValue = std::max(maxValue, (int64_t)lanes.maxValue[c]);
+    }
+  }
+
+  result.valid = true;
+  result.minInteger = minValue;
+  result.maxInteger = maxValue;
+  result.minValue = (float)minValue;
+  result.maxValue = (float)maxValue;
+  return result;
+}
+
+static ValueRange ComputeIntegerRange(const PixelBuffer &pixels,
+                                      unsigned int channelMask,
+                                      int threadCount) {
+  const PixelFormatInfo &info = GetPixelFormatInfo(pixels.format);
+  switch (info.type) {
+  case PixelComponentType::UInt8:
+    return ComputeIntegerRangeImpl<uint8_t>(pixels, info.channels,
+                                            channelMask, threadCount);
+  case PixelComponentType::SInt8:
+    return ComputeIntegerRangeImpl<int8_t>(pixels, info.channels,
+                                           channelMask, threadCount);
+  case PixelComponentType::UInt16:
+    return ComputeIntegerRangeImpl<uint16_t>(pixels, info.channels,
+                                             channelMask, threadCount);
+  case PixelComponentType::SInt16:
+    return ComputeIntegerRangeImpl<int16_t>(pixels, info.channels,
+                                            channelMask, threadCount);
+  case PixelComponentType::UInt32:
+    return ComputeIntegerRangeImpl<uint32_t>(pixels, info.channels,
+                                             channelMask, threadCount);
+  case PixelComponentType::SInt32:
+    return ComputeIntegerRangeImpl<int32_t>(pixels, info.channels,
+                                            channelMask, threadCount);
+  default:
+    return ValueRange();
+  }
+}
+
+template <typename T>
+static void ComputeIntegerHistogramImpl(const PixelBuffer &pixels,
+                                        int channels, int64_t rangeMin,
+                                        int64_t rangeMax, int binCount,
+                                        int *const outputs[3],
+                                        int threadCount) {
+  int histChannels = std::min(channels, 3);
+  int64_t rangeSize = std::max<int64_t>(1, rangeMax - rangeMin);
+  int64_t maxBin = binCount - 1;
+
+  // Each chunk counts into its own bins, merged afterwards
+  std::vector<std::vector<int>> partials(
+      GetParallelChunkCount(pixels.height, threadCount));
+  ParallelForChunks(
+      pixels.height, threadCount,
+      [&](int chunkIndex, int rowBegin, int rowEnd) {
+        std::vector<int> &bins = partials[chunkIndex];
+        bins.assign((size_t)binCount * 3, 0);
+        for (int y = rowBegin; y < rowEnd; y++) {
+          const uint8_t *row = pixels.GetRow(y);
+          for (int x = 0; x < pixels.width; x++) {
+            for (int c = 0; c < histChannels; c++) {
+              T value;
+              memcpy(&value, row + ((size_t)x * channels + c) * sizeof(T),
+                     sizeof(T));
+              // Differences of 32-bit values times the bin count fit
+              int64_t offset = std::min(
+                  std::max<int64_t>(0, (int64_t)value - rangeMin), rangeSize);
+              bins[(size_t)binCount * c + offset * maxBin / rangeSize]++;
+            }
+          }
+        }
+      });
+
+  for (const std::vector<int> &bins : partials) {
+    if (bins.empty())
+      continue;
+    for (int ch = 0; ch < 3; ch++) {
+      const int *src = bins.data() + (size_t)binCount * ch;
+      for (int i = 0; i < binCount; i++)
+        outputs[ch][i] += src[i];
+    }
+  }
+}
+
+void ComputeIntegerHistogram(const PixelBuffer &pixels, int64_t rangeMin,
+                             int64_t rangeMax, int binCount, int *histR,
+                             int *histG, int *histB, int threadCount) {
+  if (binCount <= 0)
+    return;
+  int *const outputs[3] = {histR, histG, histB};
+  for (int ch = 0; ch < 3; ch++)
+    std::fill(outputs[ch], outputs[ch] + binCount, 0);
+  if (!pixels.data || pixels.width == 0 || pixels.height == 0)
+    return;
+
+  const PixelFormatInfo &info = GetPixelFormatInfo(pixels.format);
+  switch (info.type) {
+  case PixelComponentType::UInt8:
+    ComputeIntegerHistogramImpl<uint8_t>(pixels, info.channels, rangeMin,
+                                         rangeMax, binCount, outputs,
+                                         threadCount);
+    break;
+  case PixelComponentType::SInt8:
+    ComputeIntegerHistogramImpl<int8_t>(pixels, info.channels, rangeMin,
+                                        rangeMax, binCount, outputs,
+                                        threadCount);
+    break;
+  case PixelComponentType::UInt16:
+    ComputeIntegerHistogramImpl<uint16_t>(pixels, info.channels, rangeMin,
+                                          rangeMax, binCount, outputs,
+                                          threadCount);
+    break;
+  case PixelComponentType::SInt16:
+    ComputeIntegerHistogramImpl<int16_t>(pixels, info.channels, rangeMin,
+                                         rangeMax, binCount, outputs,
+                                         threadCount);
+    break;
+  case PixelComponentType::UInt32:
+    ComputeIntegerHistogramImpl<uint32_t>(pixels, info.channels, rangeMin,
+                                          rangeMax, binCount, outputs,
+                                          threadCount);
+    break;
+  case PixelComponentType::SInt32:
+    ComputeIntegerHistogramImpl<int32_t>(pixels, info.channels, rangeMin,
+                                         rangeMax, binCount, outputs,
+                                         threadCount);
+    break;
+  default:
+    break;
+  }
+}
+
+ValueRange ComputeValueRange(const float *pixels, size_t pixelCount,
+                             unsigned int channelMask, int threadCount) {
+  if (!pixels)
+    return ValueRange();
+  return ComputeValueRangeImpl(pixels, pixelCount, channelMask, threadCount);
+}
+
+ValueRange ComputeValueRange(const PixelBuffer &pixels,
+                             unsigned int channelMask, int threadCount) {
+  if (!pixels.data)
+    return ValueRange();
+  if (IsIntegerType(GetPixelFormatInfo(pixels.format).type))
+    return ComputeIntegerRange(pixels, channelMask, threadCount);
+  return ComputeValueRangeImpl(pixels, (size_t)pixels.width * pixels.height,
+                               channelMask, threadCount);
+}
+
+void ComputeHistogram(const float *pixels, size_t pixelCount, float rangeMin,
+                      float rangeMax, int binCount, int *histR, int *histG,
+                      int *histB, int threadCount) {
+  ComputeHistogramImpl(pixels, pixels ? pixelCount : 0, rangeMin, rangeMax,
+                       binCount, histR, histG, histB, threadCount);
+}
+
+void ComputeHistogram(const PixelBuffer &pixels, float rangeMin,
+                      float rangeMax, int binCount, int *histR, int *histG,
+                      int *histB, int threadCount) {
+  size_t pixelCount =
+      pixels.data ? (size_t)pixels.width * pixels.height : 0;
+  ComputeHistogramImpl(pixels, pixelCount, rangeMin, rangeMax, binCount,
+                       histR, histG, histB, threadCount);
+}
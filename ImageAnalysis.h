@@ -0,0 +1,124 @@
+#pragma once
+#include "ImageData.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Result of a min/max scan over pixel values.
+ */
+struct ValueRange {
+  float minValue = 0.0f; ///< Smallest non-NaN value (0 if none)
+  float maxValue = 1.0f; ///< Largest non-NaN value (1 if none)
+  bool hasNaN = false;   ///< True if any scanned value was NaN
+  bool valid = false;    ///< True if at least one non-NaN value was found
+
+  /// Integer formats: the range of the stored integers, exactly
+  bool integer = false;
+  int64_t minInteger = 0;
+  int64_t maxInteger = 0;
+};
+
+/// Channel selection bits for ComputeValueRange
+enum ChannelMask : unsigned int {
+  ChannelR = 1u << 0,
+  ChannelG = 1u << 1,
+  ChannelB = 1u << 2,
+  ChannelA = 1u << 3,
+  ChannelRGB = ChannelR | ChannelG | ChannelB,
+  ChannelRGBA = ChannelRGB | ChannelA,
+};
+
+/**
+ * @brief Finds the min/max of the selected channels of RGBA32F pixels,
+ * skipping NaNs.
+ * @param pixels RGBA32F pixel data.
+ * @param pixelCount Number of pixels (not floats).
+ * @param channelMask Channels to include (ChannelMask bits).
+ * @param threadCount Worker threads (0 = hardware threads).
+ */
+ValueRange ComputeValueRange(const float *pixels, size_t pixelCount,
+                             unsigned int channelMask = ChannelRGBA,
+                             int threadCount = 0);
+
+/**
+ * @brief Builds R, G and B histograms of RGBA32F pixels.
+ *
+ * Values are mapped linearly from [rangeMin, rangeMax] to [0, binCount - 1]
+ * and clamped; NaNs are skipped.
+ * @param histR Receives binCount red counts (overwritten).
+ * @param histG Receives binCount green counts (overwritten).
+ * @param histB Receives binCount blue counts (overwritten).
+ * @param threadCount Worker threads (0 = hardware threads).
+ */
+void ComputeHistogram(const float *pixels, size_t pixelCount, float rangeMin,
+                      float rangeMax, int binCount, int *histR, int *histG,
+                      int *histB, int threadCount = 0);
+
+/**
+ * @brief ComputeValueRange for pixels in a stored format. Blocks of pixels
+ * are widened to RGBA32F just before they are scanned.
+ *
+ * Integer formats are scanned as integers instead, and only the channels
+ * the format stores are included; the float range is the integer range
+ * rounded.
+ */
+ValueRange ComputeValueRange(const PixelBuffer &pixels,
+                             unsigned int channelMask = ChannelRGBA,
+                             int threadCount = 0);
+
+/**
+ * @brief ComputeHistogram for pixels in a stored format.
+ */
+void ComputeHistogram(const PixelBuffer &pixels, float rangeMin,
+                      float rangeMax, int binCount, int *histR, int *histG,
+                      int *histB, int threadCount = 0);
+
+/**
+ * @brief ComputeHistogram for integer formats, binned as integers.
+ *
+ * Values are mapped from [rangeMin, rangeMax] to [0, binCount - 1] with
+ * integer arithmetic and clamped, so when binCount is rangeMax - rangeMin + 1
+ * every value has a bin of its own. Channels the format does not store are
+ * left empty.
+ */
+void ComputeIntegerHistogram(const PixelBuffer &pixels, int64_t rangeMin,
+                             int64_t rangeMax, int binCount, int *histR,
+                             int *histG, int *histB, int threadCount = 0);
+
+/**
+ * @brief ComputeValueRange over an image's RGBA32F or stored pixels.
+ */
+inline ValueRange ComputeValueRange(const ImageData &image,
+                                    unsigned int channelMask = ChannelRGBA,
+                                    int threadCount = 0) {
+  if (image.HasStoredPixels())
+    return ComputeValueRange(image.stored, channelMask, threadCount);
+  return ComputeValueRange(image.pixels.data(), image.GetPixelCount(),
+                           channelMask, threadCount);
+}
+
+/**
+ * @brief Records a range of all channels in the image's range fields.
+ */
+inline void SetImageRange(ImageData &image, const ValueRange &range) {
+  image.hasNaN = range.hasNaN;
+  image.minValue = range.minValue;
+  image.maxValue = range.maxValue;
+  image.hasIntegerRange = range.integer && range.valid;
+  image.minInteger = range.minInteger;
+  image.maxInteger = range.maxInteger;
+}
+
+/**
+ * @brief ComputeHistogram over an image's RGBA32F or stored pixels.
+ */
+inline void ComputeHistogram(const ImageData &image, float rangeMin,
+                             float rangeMax, int binCount, int *histR,
+                             int *histG, int *histB, int threadCount = 0) {
+  if (image.HasStoredPixels())
+    ComputeHistogram(image.stored, rangeMin, rangeMax, binCount, histR, histG,
+                     histB, threadCount);
+  else
+    ComputeHistogram(image.pixels.data(), image.GetPixelCount(), rangeMin,
+                     rangeMax, binCount, histR, histG, histB, threadCount);
+}
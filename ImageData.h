@@ -0,0 +1,54 @@
+#pragma once
+#include "PixelFormat.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Structure representing loaded image data.
+ */
+struct ImageData {
+  std::vector<float> pixels; ///< RGBA float pixel data (0.0 - 1.0 range)
+  /// Pixels kept in their stored format; when set, pixels is empty
+  PixelBuffer stored;
+  int width = 0;             ///< Image width in pixels
+  int height = 0;            ///< Image height in pixels
+  int channels = 0;          ///< Number of color channels
+  std::string filename;      ///< Source filename
+  std::string format;        ///< File format (e.g., PNG, HDR, DDS)
+  std::string pixelFormat;   ///< Internal pixel format description
+  bool depth = false;        ///< Depth plane of a depth buffer
+  bool vectors = false;      ///< R and G are 2D vectors (motion, velocity)
+  float minValue = 0.0f;     ///< Minimum pixel value found
+  float maxValue = 1.0f;     ///< Maximum pixel value found
+  bool hasNaN = false;       ///< Flag indicating presence of NaN values
+
+  bool hasIntegerRange = false; ///< Integer format; exact range below
+  int64_t minInteger = 0;       ///< Minimum stored integer
+  int64_t maxInteger = 0;       ///< Maximum stored integer
+
+  /**
+   * @brief Checks if the pixels are kept in their stored format.
+   */
+  bool HasStoredPixels() const { return stored.data != nullptr; }
+
+  /**
+   * @brief Gets the number of pixels.
+   */
+  size_t GetPixelCount() const {
+    return HasStoredPixels() ? (size_t)stored.width * stored.height
+                             : pixels.size() / 4;
+  }
+
+  /**
+   * @brief Reads one pixel as floats, whatever the storage.
+   */
+  void GetPixel(size_t index, float rgba[4]) const {
+    if (HasStoredPixels()) {
+      ConvertPixels(stored, index, index + 1, rgba);
+      return;
+    }
+    for (int c = 0; c < 4; c++)
+      rgba[c] = pixels[index * 4 + c];
+  }
+};
@@ -0,0 +1,716 @@
+#include "ImageProbe.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+namespace {
+
+uint16_t ReadLE16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+uint32_t ReadLE32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+uint16_t ReadBE16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+uint32_t ReadBE32(const uint8_t *p) {
+  return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+bool StartsWith(const uint8_t *data, size_t size, const char *signature,
+                size_t length) {
+  return size >= length && memcmp(data, signature, length) == 0;
+}
+
+// Sizes above this are taken as a damaged header
+const uint32_t g_MaxDimension = 1u << 24;
+
+bool IsValidSize(uint32_t width, uint32_t height) {
+  return width > 0 && height > 0 && width <= g_MaxDimension &&
+         height <= g_MaxDimension;
+}
+
+// ---- DDS ----
+
+const size_t g_DDSHeaderSize = 4 + 124;
+const uint32_t g_DDSDepthFlag = 0x800000;
+const uint32_t g_DDSMipCountFlag = 0x20000;
+const uint32_t g_DDSCubemapCaps = 0x200;
+const uint32_t g_DDSVolumeCaps = 0x200000;
+const uint32_t g_DDPFAlphaPixels = 0x1;
+const uint32_t g_DDPFFourCC = 0x4;
+const uint32_t g_DDPFLuminance = 0x20000;
+const uint32_t g_DDSMiscTextureCube = 0x4;
+
+// Names of common DXGI formats, matching what DDSImage shows
+const char *GetDXGIFormatName(uint32_t format) {
+  switch (format) {
+  case 2:
+    return "RGBA32F";
+  case 10:
+    return "RGBA16F";
+  case 28:
+  case 29:
+    return "RGBA8";
+  case 71:
+  case 72:
+    return "BC1";
+  case 74:
+  case 75:
+    return "BC2";
+  case 77:
+  case 78:
+    return "BC3";
+  case 80:
+    return "BC4U";
+  case 81:
+    return "BC4S";
+  case 83:
+    return "BC5U";
+  case 84:
+    return "BC5S";
+  case 87:
+    return "BGRA8";
+  case 95:
+    return "BC6HU";
+  case 96:
+    return "BC6HS";
+  case 98:
+  case 99:
+    return "BC7";
+  default:
+    return nullptr;
+  }
+}
+
+bool MatchDDS(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "DDS ", 4);
+}
+
+bool ParseDDS(const uint8_t *data, size_t size, ImageProbe &probe) {
+  if (size < g_DDSHeaderSize)
+    return false;
+  uint32_t flags = ReadLE32(data + 8);
+  uint32_t height = ReadLE32(data + 12);
+  uint32_t width = ReadLE32(data + 16);
+  if (!IsValidSize(width, height))
+    return false;
+  probe.width = (int)width;
+  probe.height = (int)height;
+  if (flags & g_DDSDepthFlag)
+    probe.depth = (int)std::max<uint32_t>(1, ReadLE32(data + 24));
+  if (flags & g_DDSMipCountFlag)
+    probe.mipLevels = (int)std::min<uint32_t>(
+        32, std::max<uint32_t>(1, ReadLE32(data + 28)));
+
+  uint32_t pixelFlags = ReadLE32(data + 80);
+  const uint8_t *fourCC = data + 84;
+  uint32_t caps2 = ReadLE32(data + 112);
+  if (!(caps2 & g_DDSVolumeCaps))
+    probe.depth = 1;
+  if (caps2 & g_DDSCubemapCaps)
+    probe.faceCount = 6;
+
+  char name[32];
+  if ((pixelFlags & g_DDPFFourCC) && memcmp(fourCC, "DX10", 4) == 0) {
+    if (size < g_DDSHeaderSize + 20)
+      return false;
+    uint32_t format = ReadLE32(data + g_DDSHeaderSize);
+    uint32_t miscFlag = ReadLE32(data + g_DDSHeaderSize + 8);
+    uint32_t arraySize = ReadLE32(data + g_DDSHeaderSize + 12);
+    probe.faceCount = (miscFlag & g_DDSMiscTextureCube) ? 6 : 1;
+    probe.arraySize = (int)std::max<uint32_t>(1, arraySize);
+    const char *known = GetDXGIFormatName(format);
+    if (known)
+      probe.pixelFormat = known;
+    else {
+      snprintf(name, sizeof(name), "DXGI %u", format);
+      probe.pixelFormat = name;
+    }
+  } else if (pixelFlags & g_DDPFFourCC) {
+    probe.pixelFormat.assign((const char *)fourCC, 4);
+  } else {
+    uint32_t bitCount = ReadLE32(data + 88);
+    snprintf(name, sizeof(name), "%u-bit", bitCount);
+    probe.pixelFormat = name;
+    probe.channels = (pixelFlags & g_DDPFLuminance) ? 1 : 3;
+    if (pixelFlags & g_DDPFAlphaPixels)
+      probe.channels++;
+  }
+  return true;
+}
+
+// ---- KTX2 ----
+
+const uint8_t g_KTX2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                      0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+bool MatchKTX2(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, (const char *)g_KTX2Identifier, 12);
+}
+
+bool ParseKTX2(const uint8_t *data, size_t size, ImageProbe &probe) {
+  if (size < 48)
+    return false;
+  uint32_t vkFormat = ReadLE32(data + 12);
+  uint32_t width = ReadLE32(data + 20);
+  uint32_t height = std::max<uint32_t>(1, ReadLE32(data + 24));
+  if (!IsValidSize(width, height))
+    return false;
+  probe.width = (int)width;
+  probe.height = (int)height;
+  probe.depth = (int)std::max<uint32_t>(1, ReadLE32(data + 28));
+  probe.arraySize = (int)std::max<uint32_t>(1, ReadLE32(data + 32));
+  probe.faceCount = (int)std::max<uint32_t>(1, ReadLE32(data + 36));
+  probe.mipLevels =
+      (int)std::min<uint32_t>(32, std::max<uint32_t>(1, ReadLE32(data + 40)));
+  char name[32];
+  snprintf(name, sizeof(name), "VkFormat %u", vkFormat);
+  probe.pixelFormat = name;
+  return true;
+}
+
+// ---- PNG ----
+
+bool MatchPNG(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "\x89PNG\r\n\x1a\n", 8);
+}
+
+bool ParsePNG(const uint8_t *data, size_t size, ImageProbe &probe) {
+  // IHDR is always the first chunk
+  if (size < 29 || memcmp(data + 12, "IHDR", 4) != 0)
+    return false;
+  uint32_t width = ReadBE32(data + 16);
+  uint32_t height = ReadBE32(data + 20);
+  if (!IsValidSize(width, height))
+    return false;
+  int bitDepth = data[24];
+  const char *layout;
+  switch (data[25]) {
+  case 0:
+    layout = "L";
+    probe.channels = 1;
+    break;
+  case 2:
+    layout = "RGB";
+    probe.channels = 3;
+    break;
+  case 3:
+    layout = "P"; // Palette; alpha may come from a tRNS chunk
+    probe.channels = 3;
+    break;
+  case 4:
+    layout = "LA";
+    probe.channels = 2;
+    break;
+  case 6:
+    layout = "RGBA";
+    probe.channels = 4;
+    break;
+  default:
+    return false;
+  }
+  probe.width = (int)width;
+  probe.height = (int)height;
+  probe.pixelFormat = layout + std::to_string(bitDepth);
+  return true;
+}
+
+// ---- JPEG ----
+
+bool MatchJPEG(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "\xFF\xD8\xFF", 3);
+}
+
+bool ParseJPEG(const uint8_t *data, size_t size, ImageProbe &probe) {
+  // Walk the marker segments up to the frame header
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF)
+      return false;
+    uint8_t marker = data[pos + 1];
+    if (marker == 0xFF) {
+      pos++; // Fill byte
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      pos += 2; // No length
+      continue;
+    }
+    if (marker == 0xD9 || marker == 0xDA)
+      return false; // End of image or scan data before any frame header
+    size_t length = ReadBE16(data + pos + 2);
+    bool frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+                 marker != 0xC8 && marker != 0xCC;
+    if (frame) {
+      if (length < 8 || pos + 10 > size)
+        return false;
+      uint32_t height = ReadBE16(data + pos + 5);
+      uint32_t width = ReadBE16(data + pos + 7);
+      int components = data[pos + 9];
+      // A height of 0 is given later by a DNL marker; not supported here
+      if (!IsValidSize(width, height))
+        return false;
+      probe.width = (int)width;
+      probe.height = (int)height;
+      probe.channels = components;
+      probe.pixelFormat = components == 1   ? "L8"
+                          : components == 4 ? "CMYK"
+                                            : "YCbCr";
+      return true;
+    }
+    pos += 2 + length;
+  }
+  return false;
+}
+
+// ---- GIF ----
+
+bool MatchGIF(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "GIF87a", 6) ||
+         StartsWith(data, size, "GIF89a", 6);
+}
+
+bool ParseGIF(const uint8_t *data, size_t size, ImageProbe &probe) {
+  // Frames are only counted by GIFImage, which walks the whole file
+  if (size < 13)
+    return false;
+  uint32_t width = ReadLE16(data + 6);
+  uint32_t height = ReadLE16(data + 8);
+  if (!IsValidSize(width, height))
+    return false;
+  probe.width = (int)width;
+  probe.height = (int)height;
+  probe.channels = 4;
+  probe.pixelFormat = "P8";
+  return true;
+}
+
+// ---- BMP ----
+
+bool MatchBMP(const uint8_t *data, size_t size) {
+  // The DIB header size narrows down the two-byte signature
+  if (!StartsWith(data, size, "BM", 2) || size < 18)
+    return false;
+  uint32_t headerSize = ReadLE32(data + 14);
+  return headerSize == 12 || headerSize == 40 || headerSize == 52 ||
+         headerSize == 56 || headerSize == 64 || headerSize == 108 ||
+         headerSize == 124;
+}
+
+bool ParseBMP(const uint8_t *data, size_t size, ImageProbe &probe) {
+  uint32_t headerSize = ReadLE32(data + 14);
+  int32_t width, height;
+  int bitCount;
+  if (headerSize == 12) {
+    if (size < 26)
+      return false;
+    width = (int16_t)ReadLE16(data + 18);
+    height = (int16_t)ReadLE16(data + 20);
+    bitCount = ReadLE16(data + 24);
+  } else {
+    if (size < 30)
+      return false;
+    width = (int32_t)ReadLE32(data + 18);
+    height = (int32_t)ReadLE32(data + 22); // Negative for top-down rows
+    bitCount = ReadLE16(data + 28);
+  }
+  if (height < 0)
+    height = -height;
+  if (width <= 0 || !IsValidSize((uint32_t)width, (uint32_t)height))
+    return false;
+  probe.width = width;
+  probe.height = height;
+  probe.channels = bitCount == 32 ? 4 : 3;
+  probe.pixelFormat = std::to_string(bitCount) + "-bit";
+  return true;
+}
+
+// ---- Radiance HDR ----
+
+bool MatchHDR(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "#?RADIANCE", 10) ||
+         StartsWith(data, size, "#?RGBE", 6);
+}
+
+bool ParseHDR(const uint8_t *data, size_t size, ImageProbe &probe) {
+  // Header lines end with an empty line; the resolution line follows
+  const size_t maxHeader = std::min<size_t>(size, 64 * 1024);
+  const char *text = (const char *)data;
+  size_t pos = 0;
+  while (pos + 1 < maxHeader && !(text[pos] == '\n' && text[pos + 1] == '\n'))
+    pos++;
+  pos += 2;
+  if (pos >= maxHeader)
+    return false;
+
+  std::string line(text + pos,
+                   std::find(text + pos, text + maxHeader, '\n'));
+  char axis1[3], axis2[3];
+  int size1, size2;
+  if (sscanf(line.c_str(), "%2s %d %2s %d", axis1, &size1, axis2, &size2) !=
+      4)
+    return false;
+  bool yFirst = axis1[1] == 'Y';
+  int width = yFirst ? size2 : size1;
+  int height = yFirst ? size1 : size2;
+  if (width <= 0 || height <= 0 ||
+      !IsValidSize((uint32_t)width, (uint32_t)height))
+    return false;
+  probe.width = width;
+  probe.height = height;
+  probe.channels = 3;
+  probe.pixelFormat = "RGBE";
+  return true;
+}
+
+// ---- OpenEXR ----
+
+const char *g_EXRCompressionNames[] = {"NONE", "RLE",   "ZIPS", "ZIP",
+                                       "PIZ",  "PXR24", "B44",  "B44A",
+                                       "DWAA", "DWAB"};
+
+bool MatchEXR(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "\x76\x2f\x31\x01", 4);
+}
+
+bool ParseEXR(const uint8_t *data, size_t size, ImageProbe &probe) {
+  // Attributes of the first part: name, type, size, value
+  const uint8_t *end = data + size;
+  const uint8_t *p = data + 8;
+  bool hasWindow = false;
+  int levelMode = 0, roundingMode = 0;
+  std::set<std::string> groups;
+  probe.channels = 0;
+  while (p < end && *p) {
+    const uint8_t *nameEnd = (const uint8_t *)memchr(p, 0, end - p);
+    if (!nameEnd)
+      return false;
+    std::string name((const char *)p, (const char *)nameEnd);
+    const uint8_t *typeEnd =
+        (const uint8_t *)memchr(nameEnd + 1, 0, end - nameEnd - 1);
+    if (!typeEnd || end - typeEnd < 5)
+      return false;
+    uint32_t valueSize = ReadLE32(typeEnd + 1);
+    const uint8_t *value = typeEnd + 5;
+    if (valueSize > (size_t)(end - value))
+      return false;
+
+    if (name == "dataWindow" && valueSize >= 16) {
+      int32_t xMin = (int32_t)ReadLE32(value);
+      int32_t yMin = (int32_t)ReadLE32(value + 4);
+      int32_t xMax = (int32_t)ReadLE32(value + 8);
+      int32_t yMax = (int32_t)ReadLE32(value + 12);
+      int64_t width = (int64_t)xMax - xMin + 1;
+      int64_t height = (int64_t)yMax - yMin + 1;
+      if (width <= 0 || height <= 0 || width > g_MaxDimension ||
+          height > g_MaxDimension)
+        return false;
+      probe.width = (int)width;
+      probe.height = (int)height;
+      hasWindow = true;
+    } else if (name == "channels") {
+      // Channel names, each followed by 16 bytes of pixel type and sampling
+      const uint8_t *c = value;
+      const uint8_t *listEnd = value + valueSize;
+      int pixelType = -1;
+      while (c < listEnd && *c) {
+        const uint8_t *channelEnd =
+            (const uint8_t *)memchr(c, 0, listEnd - c);
+        if (!channelEnd || listEnd - channelEnd < 17)
+          return false;
+        std::string channel((const char *)c, (const char *)channelEnd);
+        size_t dot = channel.find_last_of('.');
+        groups.insert(dot == std::string::npos ? std::string()
+                                               : channel.substr(0, dot));
+        int type = (int)ReadLE32(channelEnd + 1);
+        pixelType = pixelType < 0 || pixelType == type ? type : 3;
+        probe.channels++;
+        c = channelEnd + 17;
+      }
+      static const char *s_TypeNames[] = {"uint", "half", "float", "mixed"};
+      if (pixelType >= 0 && pixelType <= 3)
+        probe.pixelFormat = s_TypeNames[pixelType];
+    } else if (name == "compression" && valueSize >= 1 && *value < 10) {
+      if (!probe.pixelFormat.empty())
+        probe.pixelFormat += ", ";
+      probe.pixelFormat += g_EXRCompressionNames[*value];
+    } else if (name == "tiles" && valueSize >= 9) {
+      levelMode = value[8] & 0xf;
+      roundingMode = value[8] >> 4;
+    }
+    p = value + valueSize;
+  }
+  if (!hasWindow)
+    return false;
+
+  probe.arraySize = std::max<int>(1, (int)groups.size());
+  if (levelMode == 1) {
+    // Mip levels down to 1x1, rounding down or up
+    int maxSize = std::max(probe.width, probe.height);
+    int levels = 1;
+    while ((1 << (levels - 1)) < maxSize &&
+           (roundingMode == 1 || (2 << (levels - 1)) <= maxSize))
+      levels++;
+    probe.mipLevels = levels;
+  }
+  return true;
+}
+
+// ---- Y4M ----
+
+bool MatchY4M(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "YUV4MPEG2 ", 10);
+}
+
+bool ParseY4M(const uint8_t *data, size_t size, ImageProbe &probe) {
+  const char *text = (const char *)data;
+  const char *end = text + std::min<size_t>(size, 4096);
+  const char *lineEnd = std::find(text, end, '\n');
+  if (lineEnd == end)
+    return false;
+
+  std::string colorSpace = "420jpeg";
+  long width = 0, height = 0;
+  for (const char *p = text + 10; p < lineEnd;) {
+    const char *tokenEnd = std::find(p, lineEnd, ' ');
+    std::string token(p, tokenEnd);
+    if (token.size() > 1 && token[0] == 'W')
+      width = strtol(token.c_str() + 1, nullptr, 10);
+    else if (token.size() > 1 && token[0] == 'H')
+      height = strtol(token.c_str() + 1, nullptr, 10);
+    else if (token.size() > 1 && token[0] == 'C')
+      colorSpace = token.substr(1);
+    p = tokenEnd + 1;
+  }
+  if (width <= 0 || height <= 0 ||
+      !IsValidSize((uint32_t)width, (uint32_t)height))
+    return false;
+  probe.width = (int)width;
+  probe.height = (int)height;
+  probe.channels = 3;
+  probe.pixelFormat = colorSpace == "420p10" ? "I420P10"
+                      : colorSpace.compare(0, 3, "420") == 0
+                          ? "I420"
+                          : "C" + colorSpace;
+  return true;
+}
+
+// ---- PFM, PGM and PPM ----
+
+bool MatchPFM(const uint8_t *data, size_t size) {
+  return size >= 3 && data[0] == 'P' && (data[1] == 'f' || data[1] == 'F') &&
+         isspace(data[2]);
+}
+
+// ASCII (P2, P3) and binary (P5, P6) gray and color maps
+bool MatchPNM(const uint8_t *data, size_t size) {
+  return size >= 3 && data[0] == 'P' && data[1] != 0 &&
+         strchr("2356", data[1]) && isspace(data[2]);
+}
+
+// Reads a decimal number, skipping whitespace and # comments before it
+bool ReadHeaderNumber(const char *&p, const char *end, double &value) {
+  while (p < end) {
+    if (*p == '#') {
+      while (p < end && *p != '\n')
+        p++;
+    } else if (isspace((unsigned char)*p)) {
+      p++;
+    } else {
+      break;
+    }
+  }
+  if (p == end)
+    return false;
+  std::string token;
+  while (p < end && !isspace((unsigned char)*p) && token.size() < 32)
+    token += *p++;
+  char *stop;
+  value = strtod(token.c_str(), &stop);
+  return !token.empty() && *stop == 0;
+}
+
+bool ParsePortableMap(const uint8_t *data, size_t size, ImageProbe &probe) {
+  const char *p = (const char *)data + 2;
+  const char *end = (const char *)data + std::min<size_t>(size, 4096);
+  double width, height, maxValue;
+  if (!ReadHeaderNumber(p, end, width) || !ReadHeaderNumber(p, end, height) ||
+      !ReadHeaderNumber(p, end, maxValue) || width < 1 || height < 1 ||
+      !IsValidSize((uint32_t)width, (uint32_t)height))
+    return false;
+  probe.width = (int)width;
+  probe.height = (int)height;
+
+  char kind = (char)data[1];
+  bool gray = kind == 'f' || kind == '2' || kind == '5';
+  probe.channels = gray ? 1 : 3;
+  if (kind == 'f' || kind == 'F')
+    probe.pixelFormat = gray ? "L32F" : "RGB32F";
+  else if (maxValue > 255)
+    probe.pixelFormat = gray ? "L16BE" : "RGB16BE";
+  else
+    probe.pixelFormat = gray ? "L8" : "RGB8";
+  return true;
+}
+
+// ---- PSD ----
+
+bool MatchPSD(const uint8_t *data, size_t size) {
+  return StartsWith(data, size, "8BPS", 4);
+}
+
+bool ParsePSD(const uint8_t *data, size_t size, ImageProbe &probe) {
+  if (size < 26)
+    return false;
+  uint32_t height = ReadBE32(data + 14);
+  uint32_t width = ReadBE32(data + 18);
+  if (!IsValidSize(width, height))
+    return false;
+  probe.width = (int)width;
+  probe.height = (int)height;
+  probe.channels = ReadBE16(data + 12);
+  probe.pixelFormat = std::to_string(ReadBE16(data + 22)) + "-bit";
+  return true;
+}
+
+// ---- TIFF ----
+
+bool MatchTIFF(const uint8_t *data, size_t size) {
+  // Classic (42) and BigTIFF (43), in either byte order
+  return StartsWith(data, size, "II*\0", 4) ||
+         StartsWith(data, size, "MM\0*", 4) ||
+         StartsWith(data, size, "II+\0", 4) ||
+         StartsWith(data, size, "MM\0+", 4);
+}
+
+bool ParseTIFF(const uint8_t *data, size_t size, ImageProbe &probe) {
+  const bool bigEndian = data[0] == 'M';
+  const bool bigTIFF = data[bigEndian ? 3 : 2] == '+';
+  auto read16 = [&](uint64_t pos) {
+    return bigEndian ? ReadBE16(data + pos) : ReadLE16(data + pos);
+  };
+  auto read32 = [&](uint64_t pos) {
+    return bigEndian ? ReadBE32(data + pos) : ReadLE32(data + pos);
+  };
+  auto read64 = [&](uint64_t pos) {
+    uint64_t first = read32(pos), second = read32(pos + 4);
+    return bigEndian ? first << 32 | second : second << 32 | first;
+  };
+
+  // Only the first directory is read
+  const size_t entrySize = bigTIFF ? 20 : 12;
+  if (size < (bigTIFF ? 16u : 8u))
+    return false;
+  uint64_t offset = bigTIFF ? read64(8) : read32(4);
+  if (offset > size || size - offset < (bigTIFF ? 8u : 2u))
+    return false;
+  uint64_t count = bigTIFF ? read64(offset) : read16(offset);
+  uint64_t entries = offset + (bigTIFF ? 8 : 2);
+  if (count > (size - entries) / entrySize)
+    return false;
+
+  uint32_t width = 0, height = 0;
+  int samples = 1, bits = 1, sampleFormat = 1;
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t entry = entries + i * entrySize;
+    uint16_t tag = read16(entry);
+    uint16_t type = read16(entry + 2);
+    if (type != 3 && type != 4)
+      continue;
+    // Only the first value is read; per-sample values are all the same in
+    // files this viewer reads. Values that do not fit are stored elsewhere.
+    uint64_t valueCount = bigTIFF ? read64(entry + 4) : read32(entry + 4);
+    uint64_t field = entry + (bigTIFF ? 12 : 8);
+    if (valueCount * (type == 3 ? 2 : 4) > (bigTIFF ? 8u : 4u)) {
+      field = bigTIFF ? read64(field) : read32(field);
+      if (field > size - 4)
+        continue;
+    }
+    uint32_t value = type == 3 ? read16(field) : read32(field);
+    if (tag == 256)
+      width = value;
+    else if (tag == 257)
+      height = value;
+    else if (tag == 277)
+      samples = (int)value;
+    else if (tag == 258)
+      bits = (int)value;
+    else if (tag == 339)
+      sampleFormat = (int)value;
+  }
+  if (!IsValidSize(width, height))
+    return false;
+  probe.width = (int)width;
+  probe.height = (int)height;
+  probe.channels = samples;
+  const char *type = sampleFormat == 3   ? "float"
+                     : sampleFormat == 2 ? "int"
+                                         : "uint";
+  probe.pixelFormat = type + std::to_string(bits);
+  return true;
+}
+
+struct FormatEntry {
+  ImageFileFormat format;
+  bool (*match)(const uint8_t *data, size_t size);
+  bool (*parse)(const uint8_t *data, size_t size, ImageProbe &probe);
+};
+
+// Detection order; the signatures do not overlap
+const FormatEntry g_Formats[] = {
+    {{"DDS", "dds"}, MatchDDS, ParseDDS},
+    {{"KTX2", "ktx2"}, MatchKTX2, ParseKTX2},
+    {{"EXR", "exr"}, MatchEXR, ParseEXR},
+    {{"PNG", "png"}, MatchPNG, ParsePNG},
+    {{"JPEG", "jpg"}, MatchJPEG, ParseJPEG},
+    {{"GIF", "gif"}, MatchGIF, ParseGIF},
+    {{"HDR", "hdr"}, MatchHDR, ParseHDR},
+    {{"Y4M", "y4m"}, MatchY4M, ParseY4M},
+    {{"PSD", "psd"}, MatchPSD, ParsePSD},
+    {{"TIFF", "tif"}, MatchTIFF, ParseTIFF},
+    {{"BMP", "bmp"}, MatchBMP, ParseBMP},
+    {{"PFM", "pfm"}, MatchPFM, ParsePortableMap},
+    {{"PNM", "pnm"}, MatchPNM, ParsePortableMap},
+};
+
+const FormatEntry *FindFormat(const uint8_t *data, size_t size) {
+  for (const FormatEntry &entry : g_Formats) {
+    if (entry.match(data, size))
+      return &entry;
+  }
+  return nullptr;
+}
+
+} // namespace
+
+const ImageFileFormat *DetectImageFormat(const uint8_t *data, size_t size) {
+  const FormatEntry *entry = FindFormat(data, size);
+  return entry ? &entry->format : nullptr;
+}
+
+bool ProbeImage(const uint8_t *data, size_t size, ImageProbe &probe) {
+  probe = ImageProbe();
+  const FormatEntry *entry = FindFormat(data, size);
+  if (!entry || !entry->parse(data, size, probe))
+    return false;
+  probe.format = &entry->format;
+  return true;
+}
+
+bool ProbeImageFile(const std::string &filepath, ImageProbe &probe) {
+  PROFILE_SCOPE("ProbeImageFile");
+  MappedFile file;
+  if (!file.Open(filepath))
+    return false;
+  return ProbeImage(file.GetData(), file.GetSize(), probe);
+}
+
+const ImageFileFormat *DetectImageFileFormat(const std::string &filepath) {
+  MappedFile file;
+  if (!file.Open(filepath))
+    return nullptr;
+  return DetectImageFormat(file.GetData(), file.GetSize());
+}
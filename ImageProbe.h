@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A file format the viewer recognizes by its signature.
+ */
+struct ImageFileFormat {
+  const char *name;      ///< Display name, as in ImageData::format
+  const char *extension; ///< Usual extension, lower case, without the dot
+};
+
+/**
+ * @brief What the header of an image file says, read without decoding.
+ */
+struct ImageProbe {
+  const ImageFileFormat *format = nullptr;
+  std::string pixelFormat; ///< Stored pixel format, as far as the header says
+  int width = 0;
+  int height = 0;
+  int depth = 1;     ///< Slices of volume textures
+  int mipLevels = 1;
+  int arraySize = 1; ///< Array layers; channel groups for EXR
+  int faceCount = 1; ///< 6 for cubemaps
+  int channels = 0;  ///< Channels stored in the file; 0 if not given
+};
+
+/**
+ * @brief Identifies a file by its first bytes.
+ *
+ * Formats are tried in a fixed order; each checks only a signature of a
+ * few bytes. TGA, raw dumps and other files without one are not detected.
+ * @return nullptr if no format matches.
+ */
+const ImageFileFormat *DetectImageFormat(const uint8_t *data, size_t size);
+
+/**
+ * @brief Detects the format of a file in memory and parses its header.
+ * @return False if the format is unknown or the header is truncated or
+ * inconsistent.
+ */
+bool ProbeImage(const uint8_t *data, size_t size, ImageProbe &probe);
+
+/**
+ * @brief ProbeImage for a file at a UTF-8 path.
+ *
+ * The file is mapped, so only the pages holding the header are read.
+ */
+bool ProbeImageFile(const std::string &filepath, ImageProbe &probe);
+
+/**
+ * @brief DetectImageFormat for a file at a UTF-8 path.
+ * @return nullptr if the file cannot be read or has no known signature.
+ */
+const ImageFileFormat *DetectImageFileFormat(const std::string &filepath);
@@ -0,0 +1,105 @@
+#pragma once
+#include "ImageData.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Axis a volume is sliced across. Z slices are the stored XY planes;
+ * Y slices are XZ planes (z down) and X slices are ZY planes (z across).
+ */
+enum class SliceAxis { Z, Y, X };
+
+/**
+ * @brief Identifies one 2D subresource: mip level, array layer, cube face and
+ * depth slice.
+ */
+struct SubresourceIndex {
+  int mip = 0;
+  int layer = 0;
+  int face = 0;
+  int slice = 0;
+  SliceAxis axis = SliceAxis::Z; ///< Volumes only
+
+  bool operator==(const SubresourceIndex &other) const {
+    return mip == other.mip && layer == other.layer && face == other.face &&
+           slice == other.slice && axis == other.axis;
+  }
+  bool operator!=(const SubresourceIndex &other) const {
+    return !(*this == other);
+  }
+};
+
+/**
+ * @brief Shape of an image made of several 2D subresources.
+ */
+struct SubresourceLayout {
+  int width = 0;      ///< Width of mip 0
+  int height = 0;     ///< Height of mip 0
+  int depth = 1;      ///< Depth of mip 0 (volume textures)
+  int mipLevels = 1;  ///< Number of mip levels
+  int arraySize = 1;  ///< Number of array layers
+  int faceCount = 1;  ///< 6 for cubemaps, 1 otherwise
+  std::string format;      ///< File format (e.g., KTX2)
+  std::string pixelFormat; ///< Stored pixel format
+  int channels = 4;        ///< Channels present in the file
+  /// Names of the array layers, for files with named layers (EXR)
+  std::vector<std::string> layerNames;
+
+  /**
+   * @brief Gets the depth (number of slices) of a mip level.
+   */
+  int GetMipDepth(int mip) const {
+    int d = depth >> mip;
+    return d > 0 ? d : 1;
+  }
+
+  /**
+   * @brief Gets the number of slices of a mip level across an axis.
+   */
+  int GetSliceCount(int mip, SliceAxis axis) const {
+    int size = axis == SliceAxis::X   ? width
+               : axis == SliceAxis::Y ? height
+                                      : depth;
+    size >>= mip;
+    return size > 0 ? size : 1;
+  }
+
+  /**
+   * @brief Checks whether there is anything besides a single 2D image.
+   */
+  bool HasSubresources() const {
+    return mipLevels > 1 || arraySize > 1 || faceCount > 1 || depth > 1;
+  }
+
+  /**
+   * @brief Checks whether an index names a subresource of this layout.
+   */
+  bool Contains(const SubresourceIndex &index) const {
+    return index.mip >= 0 && index.mip < mipLevels && index.layer >= 0 &&
+           index.layer < arraySize && index.face >= 0 &&
+           index.face < faceCount && index.slice >= 0 &&
+           (index.axis == SliceAxis::Z || depth > 1) &&
+           index.slice < GetSliceCount(index.mip, index.axis);
+  }
+};
+
+/**
+ * @brief An image file whose subresources are decoded on demand.
+ *
+ * Opening a source only parses its headers; pixel data is read and decoded
+ * by Decode() for the subresource being viewed.
+ */
+class ImageSource {
+public:
+  virtual ~ImageSource() = default;
+
+  virtual const SubresourceLayout &GetLayout() const = 0;
+
+  /**
+   * @brief Decodes one subresource into RGBA32F.
+   * @param out Receives pixels, size and format fields. Range analysis is
+   * left to the caller.
+   * @return False if the index is out of range or decoding failed.
+   */
+  virtual bool Decode(const SubresourceIndex &index, ImageData &out) = 0;
+};
@@ -1,445 +1,1064 @@
-#include "ImgViewer.h"
-#include "pch.h"
-#include <algorithm>
-#include <cmath>
-
-#define STBI_WINDOWS_UTF8
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#include "Logger.h"
-#include <DirectXTex.h>
-#include <Windows.h> // Required for MultiByteToWideChar
-#include <filesystem>
-#include <jpeglib.h>
-#include <setjmp.h>
-#include <stdio.h>
-
-
-// Helper to convert UTF-8 std::string to std::wstring
-static std::wstring Utf8ToWide(const std::string &str) {
-  if (str.empty())
-    return std::wstring();
-  int size_needed =
-      MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-  std::wstring wstrTo(size_needed, 0);
-  MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0],
-                      size_needed);
-  return wstrTo;
-}
-
-ImgViewer::ImgViewer() {}
-
-ImgViewer::~ImgViewer() {}
-
-bool ImgViewer::LoadImage(const std::string &filepath) {
-  Clear();
-
-  // Determine file type by extension
-  std::string ext = filepath.substr(filepath.find_last_of('.') + 1);
-  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-
-  bool success = false;
-  if (ext == "dds") {
-    success = LoadDDS(filepath);
-  } else if (ext == "jpg" || ext == "jpeg") {
-    success = LoadJpeg(filepath);
-  } else {
-    success = LoadSTB(filepath);
-  }
-
-  if (success) {
-    m_imageData.filename = filepath.substr(filepath.find_last_of("/\\") + 1);
-    AnalyzeImageRange();
-
-    // Set initial range to detected range
-    m_rangeMin = m_imageData.minValue;
-    m_rangeMax = m_imageData.maxValue;
-  }
-
-  return success;
-}
-
-bool ImgViewer::LoadSTB(const std::string &filepath) {
-  int width, height, channels;
-
-  // First try to load as HDR
-  // stbi_is_hdr handles UTF-8 on Windows if STBI_WINDOWS_UTF8 is defined
-  if (stbi_is_hdr(filepath.c_str())) {
-    float *data = stbi_loadf(filepath.c_str(), &width, &height, &channels, 4);
-    if (!data)
-      return false;
-
-    m_imageData.width = width;
-    m_imageData.height = height;
-    m_imageData.channels = channels;
-    m_imageData.format = "HDR";
-    m_imageData.pixelFormat = "RGBA32F";
-
-    size_t pixelCount = width * height * 4;
-    m_imageData.pixels.resize(pixelCount);
-    memcpy(m_imageData.pixels.data(), data, pixelCount * sizeof(float));
-
-    stbi_image_free(data);
-    return true;
-  } else {
-    // Load as LDR
-    unsigned char *data =
-        stbi_load(filepath.c_str(), &width, &height, &channels, 4);
-    if (!data)
-      return false;
-
-    m_imageData.width = width;
-    m_imageData.height = height;
-    m_imageData.channels = channels;
-
-    // Determine format from extension
-    std::string ext = filepath.substr(filepath.find_last_of('.') + 1);
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
-    m_imageData.format = ext;
-    m_imageData.pixelFormat = "RGBA8";
-
-    size_t pixelCount = width * height * 4;
-    m_imageData.pixels.resize(pixelCount);
-
-    // Convert from byte to float [0, 1]
-    for (size_t i = 0; i < pixelCount; i++) {
-      m_imageData.pixels[i] = data[i] / 255.0f;
-    }
-
-    stbi_image_free(data);
-    return true;
-  }
-}
-
-bool ImgViewer::LoadDDS(const std::string &filepath) {
-  using namespace DirectX;
-
-  std::wstring wfilepath = Utf8ToWide(filepath);
-
-  TexMetadata metadata;
-  ScratchImage image;
-
-  HRESULT hr =
-      LoadFromDDSFile(wfilepath.c_str(), DDS_FLAGS_NONE, &metadata, image);
-  if (FAILED(hr))
-    return false;
-
-  m_imageData.width = static_cast<int>(metadata.width);
-  m_imageData.height = static_cast<int>(metadata.height);
-  m_imageData.format = "DDS";
-
-  // Convert format name
-  switch (metadata.format) {
-  case DXGI_FORMAT_R8G8B8A8_UNORM:
-    m_imageData.pixelFormat = "RGBA8";
-    m_imageData.channels = 4;
-    break;
-  case DXGI_FORMAT_R32G32B32A32_FLOAT:
-    m_imageData.pixelFormat = "RGBA32F";
-    m_imageData.channels = 4;
-    break;
-  case DXGI_FORMAT_R16G16B16A16_FLOAT:
-    m_imageData.pixelFormat = "RGBA16F";
-    m_imageData.channels = 4;
-    break;
-  case DXGI_FORMAT_BC1_UNORM:
-    m_imageData.pixelFormat = "BC1";
-    m_imageData.channels = 4;
-    break;
-  case DXGI_FORMAT_BC3_UNORM:
-    m_imageData.pixelFormat = "BC3";
-    m_imageData.channels = 4;
-    break;
-  case DXGI_FORMAT_BC7_UNORM:
-    m_imageData.pixelFormat = "BC7";
-    m_imageData.channels = 4;
-    break;
-  default:
-    m_imageData.pixelFormat = "Unknown";
-    m_imageData.channels = 4;
-    break;
-  }
-
-  // Decompress if needed
-  ScratchImage decompressed;
-  if (IsCompressed(metadata.format)) {
-    hr = Decompress(image.GetImages(), image.GetImageCount(), metadata,
-                    DXGI_FORMAT_R32G32B32A32_FLOAT, decompressed);
-    if (FAILED(hr))
-      return false;
-
-    image = std::move(decompressed);
-    metadata = image.GetMetadata();
-  }
-
-  // Convert to RGBA32F if not already
-  if (metadata.format != DXGI_FORMAT_R32G32B32A32_FLOAT) {
-    ScratchImage converted;
-    hr = Convert(image.GetImages(), image.GetImageCount(), metadata,
-                 DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT,
-                 TEX_THRESHOLD_DEFAULT, converted);
-    if (FAILED(hr))
-      return false;
-
-    image = std::move(converted);
-    metadata = image.GetMetadata();
-  }
-
-  // Copy pixel data
-  const Image *img = image.GetImage(0, 0, 0);
-  if (!img)
-    return false;
-
-  size_t pixelCount = m_imageData.width * m_imageData.height * 4;
-  m_imageData.pixels.resize(pixelCount);
-  memcpy(m_imageData.pixels.data(), img->pixels, pixelCount * sizeof(float));
-
-  return true;
-}
-
-void ImgViewer::AnalyzeImageRange() {
-  if (m_imageData.pixels.empty())
-    return;
-
-  float minVal = FLT_MAX;
-  float maxVal = -FLT_MAX;
-  bool foundNaN = false;
-
-  // Analyze all channels
-  for (float value : m_imageData.pixels) {
-    if (std::isnan(value)) {
-      foundNaN = true;
-      continue;
-    }
-
-    minVal = std::min(minVal, value);
-    maxVal = std::max(maxVal, value);
-  }
-
-  m_imageData.hasNaN = foundNaN;
-  m_imageData.minValue = (minVal == FLT_MAX) ? 0.0f : minVal;
-  m_imageData.maxValue = (maxVal == -FLT_MAX) ? 1.0f : maxVal;
-}
-
-bool ImgViewer::LoadImageFromClipboard() {
-  Clear();
-
-  if (!OpenClipboard(nullptr))
-    return false;
-
-  bool success = false;
-
-  // Try to get DIB format
-  HANDLE hDIB = GetClipboardData(CF_DIB);
-  if (hDIB) {
-    BITMAPINFO *pBitmapInfo = (BITMAPINFO *)GlobalLock(hDIB);
-    if (pBitmapInfo) {
-      BITMAPINFOHEADER &bmih = pBitmapInfo->bmiHeader;
-
-      if (bmih.biBitCount == 24 || bmih.biBitCount == 32) {
-        m_imageData.width = bmih.biWidth;
-        m_imageData.height = abs(bmih.biHeight);
-        m_imageData.channels = bmih.biBitCount / 8;
-        m_imageData.format = "Clipboard";
-        m_imageData.pixelFormat = "RGBA8";
-        m_imageData.filename = "Clipboard Image";
-
-        BYTE *pPixels = (BYTE *)pBitmapInfo + bmih.biSize +
-                        bmih.biClrUsed * sizeof(RGBQUAD);
-
-        size_t pixelCount = m_imageData.width * m_imageData.height * 4;
-        m_imageData.pixels.resize(pixelCount);
-
-        // Convert BGR(A) to RGBA float
-        int srcStride = ((m_imageData.width * bmih.biBitCount + 31) / 32) * 4;
-        bool topDown = bmih.biHeight < 0;
-
-        for (int y = 0; y < m_imageData.height; y++) {
-          int srcY = topDown ? y : (m_imageData.height - 1 - y);
-          BYTE *srcRow = pPixels + srcY * srcStride;
-
-          for (int x = 0; x < m_imageData.width; x++) {
-            int dstIdx = (y * m_imageData.width + x) * 4;
-            int srcIdx = x * (bmih.biBitCount / 8);
-
-            m_imageData.pixels[dstIdx + 2] = srcRow[srcIdx + 0] / 255.0f; // B
-            m_imageData.pixels[dstIdx + 1] = srcRow[srcIdx + 1] / 255.0f; // G
-            m_imageData.pixels[dstIdx + 0] = srcRow[srcIdx + 2] / 255.0f; // R
-            m_imageData.pixels[dstIdx + 3] = (bmih.biBitCount == 32)
-                                                 ? (srcRow[srcIdx + 3] / 255.0f)
-                                                 : 1.0f; // A
-          }
-        }
-
-        AnalyzeImageRange();
-        m_rangeMin = m_imageData.minValue;
-        m_rangeMax = m_imageData.maxValue;
-
-        success = true;
-      }
-
-      GlobalUnlock(hDIB);
-    }
-  } else {
-    // Try CF_BITMAP (Device Dependent Bitmap) - common for screenshots
-    HBITMAP hBitmap = (HBITMAP)GetClipboardData(CF_BITMAP);
-    if (hBitmap) {
-      BITMAP bm;
-      if (GetObject(hBitmap, sizeof(bm), &bm)) {
-        m_imageData.width = bm.bmWidth;
-        m_imageData.height = bm.bmHeight;
-        m_imageData.channels = 4; // We force RGBA
-        m_imageData.format = "Clipboard (Bitmap)";
-        m_imageData.pixelFormat = "RGBA8";
-        m_imageData.filename = "Clipboard Screenshot";
-
-        size_t pixelCount = m_imageData.width * m_imageData.height * 4;
-        m_imageData.pixels.resize(pixelCount);
-
-        // Get the bitmap bits
-        HDC hDC = GetDC(NULL);
-
-        BITMAPINFO bmi = {};
-        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-        bmi.bmiHeader.biWidth = bm.bmWidth;
-        bmi.bmiHeader.biHeight = -bm.bmHeight; // Top-down
-        bmi.bmiHeader.biPlanes = 1;
-        bmi.bmiHeader.biBitCount = 32;
-        bmi.bmiHeader.biCompression = BI_RGB;
-
-        // Temp buffer for GetDIBits
-        std::vector<BYTE> tempBuffer(m_imageData.width * m_imageData.height *
-                                     4);
-
-        if (GetDIBits(hDC, hBitmap, 0, m_imageData.height, tempBuffer.data(),
-                      &bmi, DIB_RGB_COLORS)) {
-          // Convert BGR(A) to RGBA float
-          for (int i = 0; i < m_imageData.width * m_imageData.height; i++) {
-            int idx = i * 4;
-            m_imageData.pixels[idx + 0] = tempBuffer[idx + 2] / 255.0f; // R
-            m_imageData.pixels[idx + 1] = tempBuffer[idx + 1] / 255.0f; // G
-            m_imageData.pixels[idx + 2] = tempBuffer[idx + 0] / 255.0f; // B
-            m_imageData.pixels[idx + 3] =
-                1.0f; // Alpha - screenshots usually opaque
-          }
-
-          AnalyzeImageRange();
-          m_rangeMin = m_imageData.minValue;
-          m_rangeMax = m_imageData.maxValue;
-
-          success = true;
-        }
-
-        ReleaseDC(NULL, hDC);
-      }
-    }
-  }
-
-  CloseClipboard();
-  return success;
-}
-
-void ImgViewer::Clear() {
-  m_imageData = ImageData();
-  m_zoom = 1.0f;
-  m_pan = {0.0f, 0.0f};
-}
-struct my_error_mgr {
-  struct jpeg_error_mgr pub;
-  jmp_buf setjmp_buffer;
-};
-
-typedef struct my_error_mgr *my_error_ptr;
-
-static void my_error_exit(j_common_ptr cinfo) {
-  my_error_ptr myerr = (my_error_ptr)cinfo->err;
-  // Let the memory manager delete any temp files before we die
-  (*cinfo->err->output_message)(cinfo);
-  longjmp(myerr->setjmp_buffer, 1);
-}
-
-bool ImgViewer::LoadJpeg(const std::string &filepath) {
-  LOG("Loading JPEG: %s", filepath.c_str());
-  FILE *infile;
-
-  // Use _wfopen handles Unicode paths correctly on Windows
-  std::wstring wpath = Utf8ToWide(filepath);
-  if ((infile = _wfopen(wpath.c_str(), L"rb")) == NULL) {
-    LOG_ERROR("Failed to open JPEG file: %s", filepath.c_str());
-    return false;
-  }
-
-  struct jpeg_decompress_struct cinfo;
-  struct my_error_mgr jerr;
-
-  // We set up the normal JPEG error routines, then override error_exit.
-  cinfo.err = jpeg_std_error(&jerr.pub);
-  jerr.pub.error_exit = my_error_exit;
-
-  // Establish the setjmp return context for my_error_exit to use.
-  if (setjmp(jerr.setjmp_buffer)) {
-    // If we get here, the JPEG code has signaled an error.
-    // We need to clean up the JPEG object, close the input file, and return.
-    LOG_ERROR("JPEG error occurred while loading: %s", filepath.c_str());
-    jpeg_destroy_decompress(&cinfo);
-    fclose(infile);
-    return false;
-  }
-
-  jpeg_create_decompress(&cinfo);
-  jpeg_stdio_src(&cinfo, infile);
-
-  if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
-    LOG_ERROR("JPEG header invalid or not found: %s", filepath.c_str());
-    jpeg_destroy_decompress(&cinfo);
-    fclose(infile);
-    return false;
-  }
-
-  jpeg_start_decompress(&cinfo);
-
-  m_imageData.width = cinfo.output_width;
-  m_imageData.height = cinfo.output_height;
-  m_imageData.channels = 4; // We convert to RGBA
-  m_imageData.format = "JPEG";
-  m_imageData.pixelFormat = "RGBA8";
-
-  size_t pixelCount = m_imageData.width * m_imageData.height * 4;
-  m_imageData.pixels.resize(pixelCount);
-
-  int row_stride = cinfo.output_width * cinfo.output_components;
-  JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo,
-                                                 JPOOL_IMAGE, row_stride, 1);
-
-  while (cinfo.output_scanline < cinfo.output_height) {
-    jpeg_read_scanlines(&cinfo, buffer, 1);
-
-    // Convert to float RGBA
-    int y = cinfo.output_scanline - 1;
-    for (int x = 0; x < m_imageData.width; x++) {
-      int dstIdx = (y * m_imageData.width + x) * 4;
-      int srcIdx = x * cinfo.output_components;
-
-      if (cinfo.output_components == 3) {
-        m_imageData.pixels[dstIdx + 0] = buffer[0][srcIdx + 0] / 255.0f; // R
-        m_imageData.pixels[dstIdx + 1] = buffer[0][srcIdx + 1] / 255.0f; // G
-        m_imageData.pixels[dstIdx + 2] = buffer[0][srcIdx + 2] / 255.0f; // B
-        m_imageData.pixels[dstIdx + 3] = 1.0f;                           // A
-      } else if (cinfo.output_components == 1) {
-        float val = buffer[0][srcIdx] / 255.0f;
-        m_imageData.pixels[dstIdx + 0] = val;  // R
-        m_imageData.pixels[dstIdx + 1] = val;  // G
-        m_imageData.pixels[dstIdx + 2] = val;  // B
-        m_imageData.pixels[dstIdx + 3] = 1.0f; // A
-      }
-    }
-  }
-
-  jpeg_finish_decompress(&cinfo);
-  jpeg_destroy_decompress(&cinfo);
-  fclose(infile);
-
-  LOG("JPEG loaded successfully: %dx%d", m_imageData.width, m_imageData.height);
-  return true;
-}
+#include "ImgViewer.h"
+#include "BMPDecoder.h"
+#include "DDSImage.h"
+#include "EXRImage.h"
+#include "FrameCache.h"
+#include "GIFImage.h"
+#include "ImageAnalysis.h"
+#include "ImageProbe.h"
+#include "KTX2Image.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "RGBEDecoder.h"
+#include "RawImage.h"
+#include "TIFFImage.h"
+#include "YUVImage.h"
+#include "pch.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+#define STBI_WINDOWS_UTF8
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "Logger.h"
+#include "Profiler.h"
+#ifdef _WIN32
+#include <Windows.h> // Required for MultiByteToWideChar
+#endif
+#include <filesystem>
+#include <jpeglib.h>
+#include <setjmp.h>
+#include <stdio.h>
+
+// Decoded pixels kept for subresources that are not on screen
+static const size_t g_SubresourceCacheBytes = 1024ull * 1024 * 1024;
+
+// Decoded frames of animations and image sequences
+static const size_t g_FrameCacheBytes = 1024ull * 1024 * 1024;
+
+// Motion fields kept per image, one per cell size
+static const size_t g_MaxMotionFields = 4;
+
+#ifdef _WIN32
+// Helper to convert UTF-8 std::string to std::wstring
+static std::wstring Utf8ToWide(const std::string &str) {
+  if (str.empty())
+    return std::wstring();
+  int size_needed =
+      MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
+  std::wstring wstrTo(size_needed, 0);
+  MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0],
+                      size_needed);
+  return wstrTo;
+}
+#endif
+
+ImgViewer::ImgViewer() {}
+
+ImgViewer::~ImgViewer() {}
+
+bool ImgViewer::LoadImage(const std::string &filepath) {
+  PROFILE_SCOPE("LoadImage");
+  Clear();
+
+  bool success = LoadFile(filepath);
+  if (success) {
+    AnalyzeImageRange();
+    ShowDepth();
+    StartFrames(filepath);
+    ShowReprojection();
+
+    // Set initial range to detected range
+    m_rangeMin = m_imageData.minValue;
+    m_rangeMax = m_imageData.maxValue;
+  }
+
+  return success;
+}
+
+bool ImgViewer::LoadFile(const std::string &filepath) {
+  // The signature picks the decoder, so misnamed files open too; files
+  // without one (TGA, headerless dumps) go by their extension
+  std::string ext;
+  const ImageFileFormat *detected =
+      IsRawImagePath(filepath) ? nullptr : DetectImageFileFormat(filepath);
+  if (detected) {
+    ext = detected->extension;
+  } else {
+    ext = filepath.substr(filepath.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  }
+
+  bool success = false;
+  if (ext == "dds") {
+    success = LoadDDS(filepath);
+  } else if (ext == "jpg" || ext == "jpeg") {
+    success = LoadJpeg(filepath);
+  } else if (ext == "ktx2") {
+    success = LoadKTX2(filepath);
+  } else if (ext == "exr") {
+    success = LoadEXR(filepath);
+  } else if (ext == "tif" || ext == "tiff") {
+    success = LoadTIFF(filepath);
+  } else if (ext == "y4m") {
+    success = LoadY4M(filepath);
+  } else if (ext == "gif") {
+    success = LoadGIF(filepath) || LoadSTB(filepath);
+  } else if (ext == "hdr") {
+    // stb_image is more forgiving with truncated files
+    success = LoadHDR(filepath) || LoadSTB(filepath);
+  } else if (IsRawImagePath(filepath)) {
+    RawImageLayout layout;
+    if (GetRawLayout(filepath, layout))
+      success = LoadRaw(filepath, layout);
+    else
+      LOG_ERROR("No layout given for raw file: %s", filepath.c_str());
+  } else if (ext == "bmp") {
+    // RLE bitmaps are left to stb_image
+    success = LoadBMP(filepath) || LoadSTB(filepath);
+  } else if (ext == "pfm") {
+    success = LoadPortableMap(filepath);
+  } else if (ext == "pgm" || ext == "ppm" || ext == "pnm") {
+    // ASCII files and unusual maximums are left to stb_image
+    success = LoadPortableMap(filepath) || LoadSTB(filepath);
+  } else {
+    success = LoadSTB(filepath);
+  }
+
+  if (success)
+    m_imageData.filename = filepath.substr(filepath.find_last_of("/\\") + 1);
+  return success;
+}
+
+bool ImgViewer::LoadSTB(const std::string &filepath) {
+  PROFILE_SCOPE("LoadSTB");
+  int width, height, channels;
+
+  // First try to load as HDR
+  // stbi_is_hdr handles UTF-8 on Windows if STBI_WINDOWS_UTF8 is defined
+  if (stbi_is_hdr(filepath.c_str())) {
+    float *data = nullptr;
+    {
+      PROFILE_SCOPE("stbi_loadf");
+      data = stbi_loadf(filepath.c_str(), &width, &height, &channels, 4);
+    }
+    if (!data)
+      return false;
+
+    m_imageData.width = width;
+    m_imageData.height = height;
+    m_imageData.channels = channels;
+    m_imageData.format = "HDR";
+    m_imageData.pixelFormat = "RGBA32F";
+
+    size_t pixelCount = (size_t)width * height * 4;
+    m_imageData.pixels.resize(pixelCount);
+    memcpy(m_imageData.pixels.data(), data, pixelCount * sizeof(float));
+
+    stbi_image_free(data);
+    return true;
+  } else if (stbi_is_16_bit(filepath.c_str())) {
+    // 16-bit PNG/PNM: samples stay 16-bit in the file's channel count and are
+    // viewed straight from stb's buffer
+    stbi_us *data = nullptr;
+    {
+      PROFILE_SCOPE("stbi_load_16");
+      data = stbi_load_16(filepath.c_str(), &width, &height, &channels, 0);
+    }
+    if (!data)
+      return false;
+
+    static const PixelFormat s_Formats[] = {PixelFormat::L16, PixelFormat::LA16,
+                                            PixelFormat::RGB16,
+                                            PixelFormat::RGBA16};
+    PixelBuffer &stored = m_imageData.stored;
+    stored.format = s_Formats[channels - 1];
+    stored.width = width;
+    stored.height = height;
+    stored.data = reinterpret_cast<const uint8_t *>(data);
+    stored.rowPitch = (ptrdiff_t)width * channels * sizeof(stbi_us);
+    stored.owner = std::shared_ptr<const void>(data, stbi_image_free);
+
+    m_imageData.width = width;
+    m_imageData.height = height;
+    m_imageData.channels = channels;
+
+    std::string ext = filepath.substr(filepath.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
+    m_imageData.format = ext;
+    m_imageData.pixelFormat = GetPixelFormatInfo(stored.format).name;
+    return true;
+  } else {
+    // Load as LDR
+    unsigned char *data = nullptr;
+    {
+      PROFILE_SCOPE("stbi_load");
+      data = stbi_load(filepath.c_str(), &width, &height, &channels, 4);
+    }
+    if (!data)
+      return false;
+
+    m_imageData.width = width;
+    m_imageData.height = height;
+    m_imageData.channels = channels;
+
+    // Determine format from extension
+    std::string ext = filepath.substr(filepath.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
+    m_imageData.format = ext;
+    m_imageData.pixelFormat = "RGBA8";
+
+    size_t pixelCount = (size_t)width * height * 4;
+    m_imageData.pixels.resize(pixelCount);
+
+    // Convert from byte to float [0, 1]
+    PROFILE_SCOPE("ConvertToFloat");
+    for (size_t i = 0; i < pixelCount; i++) {
+      m_imageData.pixels[i] = data[i] / 255.0f;
+    }
+
+    stbi_image_free(data);
+    return true;
+  }
+}
+
+bool ImgViewer::LoadHDR(const std::string &filepath) {
+  PROFILE_SCOPE("LoadHDR");
+  MappedFile file;
+  RGBEHeader header;
+  if (!file.Open(filepath) ||
+      !ReadRGBEHeader(file.GetData(), file.GetSize(), header)) {
+    LOG_ERROR("Failed to open Radiance HDR file: %s", filepath.c_str());
+    return false;
+  }
+
+  {
+    PROFILE_SCOPE("Allocate");
+    m_imageData.pixels.resize((size_t)header.width * header.height * 4);
+  }
+  if (!DecodeRGBEImage(file.GetData(), file.GetSize(), header,
+                       m_imageData.pixels.data())) {
+    LOG_ERROR("Radiance HDR file is truncated or corrupt: %s",
+              filepath.c_str());
+    m_imageData.pixels = std::vector<float>();
+    return false;
+  }
+
+  m_imageData.width = header.width;
+  m_imageData.height = header.height;
+  m_imageData.channels = 3;
+  m_imageData.format = "HDR";
+  m_imageData.pixelFormat = "RGBA32F";
+  return true;
+}
+
+// Decodes the pixels of a DIB to RGBA8, for files and the clipboard
+static void SetDIBImage(ImageData &imageData, const uint8_t *data,
+                        const DIBHeader &header, const char *format) {
+  uint8_t *pixels;
+  PixelBuffer &stored = imageData.stored;
+  {
+    PROFILE_SCOPE("Allocate");
+    stored = AllocatePixelBuffer(PixelFormat::RGBA8, header.width,
+                                 header.height, pixels);
+  }
+  DecodeDIBImage(data, header, pixels);
+
+  imageData.width = header.width;
+  imageData.height = header.height;
+  imageData.channels = header.bitCount >= 16 && header.masks[3] ? 4 : 3;
+  imageData.format = format;
+  imageData.pixelFormat = GetDIBFormatName(header);
+}
+
+bool ImgViewer::LoadBMP(const std::string &filepath) {
+  PROFILE_SCOPE("LoadBMP");
+  MappedFile file;
+  DIBHeader header;
+  if (!file.Open(filepath) ||
+      !ReadBMPHeader(file.GetData(), file.GetSize(), header)) {
+    LOG("Not an uncompressed BMP file: %s", filepath.c_str());
+    return false;
+  }
+  SetDIBImage(m_imageData, file.GetData(), header, "BMP");
+  return true;
+}
+
+// Shows a buffer viewed in place by one of the mapping loaders
+static void SetMappedImage(ImageData &imageData, PixelBuffer &&buffer,
+                           const char *format) {
+  const PixelFormatInfo &info = GetPixelFormatInfo(buffer.format);
+  imageData.width = buffer.width;
+  imageData.height = buffer.height;
+  imageData.channels = info.channels;
+  imageData.format = format;
+  imageData.pixelFormat = info.name;
+  imageData.vectors = buffer.format == PixelFormat::RG32F;
+  imageData.stored = std::move(buffer);
+}
+
+bool ImgViewer::LoadRaw(const std::string &filepath,
+                        const RawImageLayout &layout) {
+  PROFILE_SCOPE("LoadRaw");
+  if (layout.yuvFormat != YUVFormat::None)
+    return LoadYUV(filepath, layout);
+
+  PixelBuffer buffer;
+  if (!OpenRawImage(filepath, layout, buffer))
+    return false;
+  SetMappedImage(m_imageData, std::move(buffer), "RAW");
+  return true;
+}
+
+bool ImgViewer::LoadPortableMap(const std::string &filepath) {
+  PROFILE_SCOPE("LoadPortableMap");
+  PixelBuffer buffer;
+  if (!OpenPortableMap(filepath, buffer))
+    return false;
+
+  const PixelFormatInfo &info = GetPixelFormatInfo(buffer.format);
+  const char *format = info.type == PixelComponentType::Float32 ? "PFM"
+                       : info.gray                              ? "PGM"
+                                                                : "PPM";
+  SetMappedImage(m_imageData, std::move(buffer), format);
+  return true;
+}
+
+bool ImgViewer::SetTextureSource(std::shared_ptr<ImageSource> source) {
+  // Volumes are bricked when their first slice is decoded, so they can be
+  // sliced across any axis
+  std::shared_ptr<BrickedVolume> volume;
+  if (source->GetLayout().depth > 1) {
+    volume = std::make_shared<BrickedVolume>(std::move(source));
+    source = volume;
+  }
+
+  // Only the first subresource is decoded; others on SelectSubresource()
+  SubresourceIndex index;
+  if (!source->Decode(index, m_imageData))
+    return false;
+
+  m_source = std::move(source);
+  m_volume = std::move(volume);
+  m_subresource = index;
+  return true;
+}
+
+bool ImgViewer::LoadDDS(const std::string &filepath) {
+  PROFILE_SCOPE("LoadDDS");
+  auto source = std::make_shared<DDSImage>();
+  if (!source->Open(filepath))
+    return false;
+  return SetTextureSource(std::move(source));
+}
+
+bool ImgViewer::LoadKTX2(const std::string &filepath) {
+  PROFILE_SCOPE("LoadKTX2");
+  auto source = std::make_shared<KTX2Image>();
+  if (!source->Open(filepath))
+    return false;
+  return SetTextureSource(std::move(source));
+}
+
+bool ImgViewer::LoadEXR(const std::string &filepath) {
+  PROFILE_SCOPE("LoadEXR");
+  auto source = std::make_shared<EXRImage>();
+  if (!source->Open(filepath))
+    return false;
+
+  // Only the first layer is decoded; others on SelectSubresource()
+  SubresourceIndex index;
+  if (!source->Decode(index, m_imageData))
+    return false;
+
+  m_source = std::move(source);
+  m_subresource = index;
+  return true;
+}
+
+bool ImgViewer::LoadTIFF(const std::string &filepath) {
+  PROFILE_SCOPE("LoadTIFF");
+  auto source = std::make_shared<TIFFImage>();
+  if (!source->Open(filepath))
+    return false;
+
+  // Only the first page is decoded; others on SelectSubresource()
+  SubresourceIndex index;
+  if (!source->Decode(index, m_imageData))
+    return false;
+
+  m_source = std::move(source);
+  m_subresource = index;
+  return true;
+}
+
+bool ImgViewer::LoadGIF(const std::string &filepath) {
+  PROFILE_SCOPE("LoadGIF");
+  auto source = std::make_unique<GIFImage>();
+  if (!source->Open(filepath) || !source->DecodeFrame(0, m_imageData))
+    return false;
+
+  // Later frames are decoded in the background once playback starts
+  if (source->GetFrameCount() > 1)
+    m_frames = std::make_unique<FrameCache>(std::move(source),
+                                            g_FrameCacheBytes);
+  m_frame = 0;
+  m_framePosition = 0;
+  return true;
+}
+
+bool ImgViewer::LoadY4M(const std::string &filepath) {
+  PROFILE_SCOPE("LoadY4M");
+  return OpenYUV(filepath, RawImageLayout(), nullptr, 0);
+}
+
+bool ImgViewer::LoadYUV(const std::string &filepath,
+                        const RawImageLayout &layout) {
+  PROFILE_SCOPE("LoadYUV");
+  return OpenYUV(filepath, layout, nullptr, 0);
+}
+
+bool ImgViewer::OpenYUV(const std::string &filepath,
+                        const RawImageLayout &layout,
+                        const YUVSettings *settings, int frame) {
+  auto source = std::make_unique<YUVImage>();
+  bool opened =
+      layout.yuvFormat == YUVFormat::None
+          ? source->OpenY4M(filepath)
+          : source->OpenRaw(filepath, layout.yuvFormat, layout.width,
+                            layout.height, layout.rowPitch, layout.offset);
+  if (!opened)
+    return false;
+  if (settings)
+    source->SetSettings(*settings);
+  frame = std::min(frame, source->GetFrameCount() - 1);
+  if (!source->DecodeFrame(frame, m_imageData))
+    return false;
+
+  m_yuvPath = filepath;
+  m_yuvLayout = layout;
+  m_yuvSettings = source->GetSettings();
+
+  // The mapping stays open; other frames are converted in the background
+  if (source->GetFrameCount() > 1)
+    m_frames = std::make_unique<FrameCache>(std::move(source),
+                                            g_FrameCacheBytes);
+  m_frame = frame;
+  m_framePosition = frame;
+  return true;
+}
+
+bool ImgViewer::SetYUVSettings(const YUVSettings &settings) {
+  PROFILE_SCOPE("SetYUVSettings");
+  if (!IsYUV())
+    return false;
+
+  // Waits for the frame being converted with the old settings
+  std::string filepath = m_yuvPath;
+  std::string filename = m_imageData.filename;
+  bool playing = m_playing;
+  m_frames.reset();
+  m_playing = false;
+  m_frameTime = 0.0;
+  if (!OpenYUV(filepath, m_yuvLayout, &settings, m_framePosition))
+    return false;
+
+  m_imageData.filename = filename;
+  AnalyzeImageRange();
+  if (m_frames) {
+    m_frames->Start(m_frame, m_imageData);
+    SetPlaying(playing);
+  }
+  return true;
+}
+
+void ImgViewer::StartFrames(const std::string &filepath) {
+  // Files with subresources or a layout of their own are not sequenced
+  if (!m_frames && !HasSubresources() && !IsRawImagePath(filepath) &&
+      !IsYUV()) {
+    std::vector<std::string> paths;
+    int frame;
+    if (!FindImageSequence(filepath, paths, frame))
+      return;
+
+    // Each file is loaded by a viewer of its own on the prefetch thread
+    auto decode = [](const std::string &path, ImageData &out) {
+      ImgViewer loader;
+      if (!loader.LoadFile(path))
+        return false;
+      out = std::move(loader.m_imageData);
+      return true;
+    };
+    m_frames = std::make_unique<FrameCache>(
+        std::make_unique<ImageSequence>(std::move(paths), decode),
+        g_FrameCacheBytes);
+    m_frame = frame;
+    m_framePosition = frame;
+    LOG("Image sequence of %d frames", m_frames->GetFrameCount());
+  }
+
+  if (m_frames)
+    m_frames->Start(m_frame, m_imageData);
+}
+
+int ImgViewer::GetFrameCount() const {
+  return m_frames ? m_frames->GetFrameCount() : 0;
+}
+
+double ImgViewer::GetFrameDuration(int frame) const {
+  double duration = m_frames->GetFrameDuration(frame);
+  return duration > 0.0 ? duration : 1.0 / m_frameRate;
+}
+
+void ImgViewer::SeekFrame(int frame) {
+  if (!m_frames || frame < 0 || frame >= GetFrameCount())
+    return;
+
+  // Stepping back prefetches the frames before, unless playing
+  int direction = m_playing || frame >= m_framePosition ? 1 : -1;
+  m_framePosition = frame;
+  m_frameTime = 0.0;
+  m_frames->SetPosition(frame, direction);
+}
+
+void ImgViewer::StepFrame(int delta) {
+  int count = GetFrameCount();
+  if (count == 0)
+    return;
+  int frame = ((m_framePosition + delta) % count + count) % count;
+  SetPlaying(false);
+  m_frameTime = 0.0;
+  m_framePosition = frame;
+  m_frames->SetPosition(frame, delta < 0 ? -1 : 1);
+}
+
+void ImgViewer::SetPlaying(bool playing) {
+  if (!m_frames || playing == m_playing)
+    return;
+  m_playing = playing;
+  m_frameTime = 0.0;
+  m_frames->SetPosition(m_framePosition, 1);
+}
+
+bool ImgViewer::UpdateFrames(double elapsedSeconds) {
+  if (!m_frames)
+    return false;
+
+  int count = GetFrameCount();
+  int shownDistance = 0;
+  if (m_playing) {
+    // The clock runs whatever the decode speed; frames that are not ready
+    // when their time comes are skipped
+    m_frameTime += elapsedSeconds;
+    for (int i = 0; i < count; i++) {
+      double duration = GetFrameDuration(m_framePosition);
+      if (m_frameTime < duration)
+        break;
+      m_frameTime -= duration;
+      m_framePosition = (m_framePosition + 1) % count;
+    }
+    // A stall longer than the whole animation restarts the frame's time
+    if (m_frameTime >= GetFrameDuration(m_framePosition))
+      m_frameTime = 0.0;
+    m_frames->SetPosition(m_framePosition, 1);
+
+    // Any frame decoded between the one shown and the position will do
+    shownDistance = (m_framePosition - m_frame + count) % count;
+  } else if (m_framePosition != m_frame) {
+    shownDistance = 1;
+  }
+
+  for (int back = 0; back < shownDistance; back++) {
+    int frame = (m_framePosition - back + count) % count;
+    std::shared_ptr<const ImageData> image = m_frames->GetFrame(frame);
+    if (!image)
+      continue;
+
+    // Frames of one file keep its name
+    std::string filename = m_imageData.filename;
+    m_imageData = *image;
+    if (m_imageData.filename.empty())
+      m_imageData.filename = filename;
+    m_frame = frame;
+    m_motionFields.clear();
+    return true;
+  }
+  return false;
+}
+
+bool ImgViewer::SelectSubresource(const SubresourceIndex &index) {
+  PROFILE_SCOPE("SelectSubresource");
+  if (!m_source)
+    return false;
+  if (index == m_subresource)
+    return true;
+
+  // Subresources viewed before are taken from the cache, already analyzed
+  auto cached = std::find_if(
+      m_subresourceCache.begin(), m_subresourceCache.end(),
+      [&](const CachedSubresource &entry) { return entry.index == index; });
+
+  ImageData data;
+  bool fromCache = cached != m_subresourceCache.end();
+  if (fromCache) {
+    data = std::move(cached->data);
+    m_subresourceCache.erase(cached);
+  } else {
+    if (!m_source->Decode(index, data))
+      return false;
+    data.filename = m_imageData.filename;
+  }
+
+  // The image being replaced goes to the front of the cache; depth planes
+  // and environment maps are cached as stored
+  ImageData &replaced = IsDepth()         ? m_depthPlane
+                        : IsReprojected() ? m_environment
+                                          : m_imageData;
+  m_subresourceCache.push_front({m_subresource, std::move(replaced)});
+  m_depthPlane = ImageData();
+  m_linearDepth = ImageData();
+  m_environment = ImageData();
+  m_imageData = std::move(data);
+  m_subresource = index;
+  m_motionFields.clear();
+  if (!fromCache)
+    AnalyzeImageRange();
+  ShowDepth();
+  ShowReprojection();
+
+  // Drop the least recently viewed subresources beyond the budget
+  size_t cachedBytes = 0;
+  for (auto it = m_subresourceCache.begin(); it != m_subresourceCache.end();
+       ++it) {
+    cachedBytes += it->data.pixels.size() * sizeof(float) +
+                   it->data.stored.GetByteSize();
+    if (cachedBytes > g_SubresourceCacheBytes) {
+      m_subresourceCache.erase(it, m_subresourceCache.end());
+      break;
+    }
+  }
+  return true;
+}
+
+void ImgViewer::SetVolumeRange(bool volumeRange) {
+  PROFILE_SCOPE("SetVolumeRange");
+  if (volumeRange == m_volumeRange)
+    return;
+  m_volumeRange = volumeRange;
+  if (!m_volume)
+    return;
+
+  // Cached slices were analyzed with the other setting
+  m_subresourceCache.clear();
+  AnalyzeImageRange();
+  m_rangeMin = m_imageData.minValue;
+  m_rangeMax = m_imageData.maxValue;
+}
+
+void ImgViewer::SetDepthSettings(const DepthSettings &settings) {
+  PROFILE_SCOPE("SetDepthSettings");
+  m_depthSettings = settings;
+  if (!IsDepth())
+    return;
+  ShowDepth();
+
+  // Distances and depth have nothing in common; start from the new range
+  m_rangeMin = m_imageData.minValue;
+  m_rangeMax = m_imageData.maxValue;
+}
+
+void ImgViewer::ShowDepth() {
+  if (!IsDepth()) {
+    if (!m_imageData.depth)
+      return;
+    m_depthPlane = m_imageData;
+  }
+  if (!m_depthSettings.linearize) {
+    m_imageData = m_depthPlane;
+    return;
+  }
+
+  if (!m_linearDepth.HasStoredPixels() ||
+      !IsSameProjection(m_linearSettings, m_depthSettings)) {
+    m_linearDepth = m_depthPlane;
+    m_linearDepth.stored = LinearizeDepth(m_depthPlane.stored, m_depthSettings);
+    m_linearDepth.pixelFormat += " (linear)";
+    SetImageRange(m_linearDepth, ComputeDistanceRange(m_linearDepth.stored));
+    m_linearSettings = m_depthSettings;
+  }
+  m_imageData = m_linearDepth;
+}
+
+bool ImgViewer::IsEnvironmentMap() const {
+  const ImageData &image = IsReprojected() ? m_environment : m_imageData;
+  if (image.GetPixelCount() == 0 || IsDepth() || HasFrames() || IsYUV())
+    return false;
+  return IsCubemap() || image.width == 2 * image.height;
+}
+
+void ImgViewer::SetReproject(bool reproject) {
+  PROFILE_SCOPE("SetReproject");
+  m_reproject = reproject;
+  m_motionFields.clear();
+  if (reproject) {
+    ShowReprojection();
+  } else if (IsReprojected()) {
+    m_imageData = std::move(m_environment);
+    m_environment = ImageData();
+  }
+}
+
+// Converts the pixels of an image to RGBA32F, rows in parallel
+static void CopyFloatPixels(const ImageData &image, float *rgba) {
+  if (!image.HasStoredPixels()) {
+    std::copy(image.pixels.begin(), image.pixels.end(), rgba);
+    return;
+  }
+  size_t width = image.stored.width;
+  ParallelFor(image.stored.height, 0, [&](int begin, int end) {
+    ConvertPixels(image.stored, begin * width, end * width,
+                  rgba + begin * width * 4);
+  });
+}
+
+bool ImgViewer::DecodeCubeFaces() {
+  if (!m_cubeFaces.empty() && m_cubeFacesIndex.mip == m_subresource.mip &&
+      m_cubeFacesIndex.layer == m_subresource.layer)
+    return true;
+  PROFILE_SCOPE("DecodeCubeFaces");
+
+  // The face on screen is already decoded
+  const ImageData &onScreen = IsReprojected() ? m_environment : m_imageData;
+  int faceSize = onScreen.width;
+  size_t faceFloats = (size_t)faceSize * faceSize * 4;
+  m_cubeFaces.resize(faceFloats * 6);
+  for (int face = 0; face < 6; face++) {
+    SubresourceIndex index = m_subresource;
+    index.face = face;
+    ImageData decoded;
+    if (face != m_subresource.face &&
+        (!m_source->Decode(index, decoded) || decoded.width != faceSize ||
+         decoded.height != faceSize)) {
+      m_cubeFaces = std::vector<float>();
+      return false;
+    }
+    CopyFloatPixels(face == m_subresource.face ? onScreen : decoded,
+                    m_cubeFaces.data() + faceFloats * face);
+  }
+  m_cubeFacesIndex = m_subresource;
+  return true;
+}
+
+void ImgViewer::ShowReprojection() {
+  if (!m_reproject || IsReprojected() || !IsEnvironmentMap())
+    return;
+  PROFILE_SCOPE("ShowReprojection");
+
+  // Cubemaps are reprojected from all faces, lat-long images as they are
+  bool cube = IsCubemap();
+  Reprojection reprojection =
+      cube ? Reprojection::CubeToLatLong : Reprojection::LatLongToCube;
+  if (cube && m_imageData.width != m_imageData.height)
+    return;
+  if (!BuildReprojectionTable(reprojection, m_imageData.width,
+                              m_imageData.height, m_reprojectionTable))
+    return;
+
+  std::vector<float> converted;
+  const float *source = m_imageData.pixels.data();
+  if (cube) {
+    if (!DecodeCubeFaces()) {
+      LOG_ERROR("Failed to decode the faces of mip %d layer %d",
+                m_subresource.mip, m_subresource.layer);
+      return;
+    }
+    source = m_cubeFaces.data();
+  } else if (m_imageData.HasStoredPixels()) {
+    converted.resize(m_imageData.GetPixelCount() * 4);
+    CopyFloatPixels(m_imageData, converted.data());
+    source = converted.data();
+  }
+
+  ImageData reprojected;
+  reprojected.width = m_reprojectionTable.width;
+  reprojected.height = m_reprojectionTable.height;
+  reprojected.channels = m_imageData.channels;
+  reprojected.filename = m_imageData.filename;
+  reprojected.format = m_imageData.format;
+  reprojected.pixelFormat =
+      m_imageData.pixelFormat + (cube ? " (lat-long)" : " (cube cross)");
+  reprojected.pixels.resize((size_t)reprojected.width * reprojected.height *
+                            4);
+  Reproject(m_reprojectionTable, source, reprojected.pixels.data());
+  SetImageRange(reprojected, ComputeValueRange(reprojected));
+
+  m_environment = std::move(m_imageData);
+  m_imageData = std::move(reprojected);
+}
+
+const EnvironmentLighting *ImgViewer::AnalyzeLighting() {
+  if (GetLighting())
+    return &m_lighting;
+  if (!IsEnvironmentMap())
+    return nullptr;
+  PROFILE_SCOPE("AnalyzeLighting");
+
+  const ImageData &image = IsReprojected() ? m_environment : m_imageData;
+  if (IsCubemap()) {
+    if (!DecodeCubeFaces() ||
+        !ComputeCubeLighting(m_cubeFaces.data(), image.width, m_lighting))
+      return nullptr;
+  } else if (!ComputeLatLongLighting(image, m_lighting)) {
+    return nullptr;
+  }
+  m_hasLighting = true;
+  m_lightingIndex = m_subresource;
+  return &m_lighting;
+}
+
+const EnvironmentLighting *ImgViewer::GetLighting() const {
+  // Every face of a cubemap has the lighting of the whole cube
+  if (!m_hasLighting || m_lightingIndex.mip != m_subresource.mip ||
+      m_lightingIndex.layer != m_subresource.layer)
+    return nullptr;
+  return &m_lighting;
+}
+
+bool ImgViewer::HasMotionVectors() const {
+  return m_imageData.vectors && m_imageData.GetPixelCount() > 0;
+}
+
+const MotionField *ImgViewer::GetMotionField(int cellSize) {
+  if (!HasMotionVectors())
+    return nullptr;
+  if (!m_motionFields.empty() && m_motionFields.front().cellSize == cellSize)
+    return &m_motionFields.front();
+
+  // Fields of other zoom levels move to the front when they are used again
+  auto cached = std::find_if(
+      m_motionFields.begin(), m_motionFields.end(),
+      [&](const MotionField &field) { return field.cellSize == cellSize; });
+  MotionField field;
+  if (cached != m_motionFields.end()) {
+    field = std::move(*cached);
+    m_motionFields.erase(cached);
+  } else if (!ReduceMotionField(m_imageData, cellSize, field)) {
+    return nullptr;
+  }
+  m_motionFields.insert(m_motionFields.begin(), std::move(field));
+  if (m_motionFields.size() > g_MaxMotionFields)
+    m_motionFields.pop_back();
+  return &m_motionFields.front();
+}
+
+void ImgViewer::SetRawLayoutFile(const std::string &filepath) {
+  m_rawLayoutFile = filepath;
+  ReadRawImageLayouts(filepath, m_rawLayouts);
+}
+
+bool ImgViewer::GetRawLayout(const std::string &filepath,
+                             RawImageLayout &layout) const {
+  auto it = m_rawLayouts.find(filepath);
+  if (it == m_rawLayouts.end())
+    return false;
+  layout = it->second;
+  return true;
+}
+
+void ImgViewer::SetRawLayout(const std::string &filepath,
+                             const RawImageLayout &layout) {
+  m_rawLayouts[filepath] = layout;
+  if (!m_rawLayoutFile.empty() &&
+      !WriteRawImageLayouts(m_rawLayoutFile, m_rawLayouts))
+    LOG_ERROR("Failed to save raw layouts to %s", m_rawLayoutFile.c_str());
+}
+
+void ImgViewer::AnalyzeImageRange() {
+  PROFILE_SCOPE("AnalyzeImageRange");
+  if (m_imageData.GetPixelCount() == 0)
+    return;
+
+  // Slices of a volume share the range of the whole volume
+  ValueRange range;
+  if (UsesVolumeRange() && m_volume->GetRange(m_subresource, range)) {
+    SetImageRange(m_imageData, range);
+    return;
+  }
+
+  // Analyze all channels
+  SetImageRange(m_imageData, ComputeValueRange(m_imageData));
+}
+
+bool ImgViewer::LoadImageFromClipboard() {
+  PROFILE_SCOPE("LoadImageFromClipboard");
+  Clear();
+
+#ifndef _WIN32
+  // The clipboard is only available through the Win32 API
+  return false;
+#else
+
+  if (!OpenClipboard(nullptr))
+    return false;
+
+  bool success = false;
+
+  // Windows converts between the DIB formats, so CF_DIB is only asked for
+  // when CF_DIBV5 is not there
+  for (UINT format : {(UINT)CF_DIBV5, (UINT)CF_DIB}) {
+    HANDLE hDIB = GetClipboardData(format);
+    if (!hDIB)
+      continue;
+    const uint8_t *data = (const uint8_t *)GlobalLock(hDIB);
+    if (data) {
+      DIBHeader header;
+      if (ReadDIBHeader(data, GlobalSize(hDIB), header)) {
+        SetDIBImage(m_imageData, data, header, "Clipboard");
+        m_imageData.filename = "Clipboard Image";
+        success = true;
+      }
+      GlobalUnlock(hDIB);
+    }
+    break;
+  }
+
+  if (success) {
+    AnalyzeImageRange();
+    m_rangeMin = m_imageData.minValue;
+    m_rangeMax = m_imageData.maxValue;
+  }
+
+  CloseClipboard();
+  return success;
+#endif
+}
+
+void ImgViewer::Clear() {
+  m_imageData = ImageData();
+  m_source.reset();
+  m_subresource = SubresourceIndex();
+  m_subresourceCache.clear();
+  m_volume.reset();
+  m_frames.reset();
+  m_frame = 0;
+  m_framePosition = 0;
+  m_playing = false;
+  m_frameTime = 0.0;
+  m_yuvPath.clear();
+  m_yuvLayout = RawImageLayout();
+  m_depthPlane = ImageData();
+  m_linearDepth = ImageData();
+  m_environment = ImageData();
+  m_cubeFaces = std::vector<float>();
+  m_hasLighting = false;
+  m_motionFields.clear();
+  m_zoom = 1.0f;
+  m_pan = {0.0f, 0.0f};
+}
+struct my_error_mgr {
+  struct jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+};
+
+typedef struct my_error_mgr *my_error_ptr;
+
+static void my_error_exit(j_common_ptr cinfo) {
+  my_error_ptr myerr = (my_error_ptr)cinfo->err;
+  // Let the memory manager delete any temp files before we die
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(myerr->setjmp_buffer, 1);
+}
+
+bool ImgViewer::LoadJpeg(const std::string &filepath) {
+  PROFILE_SCOPE("LoadJpeg");
+  LOG("Loading JPEG: %s", filepath.c_str());
+  FILE *infile;
+
+  // Use _wfopen handles Unicode paths correctly on Windows
+#ifdef _WIN32
+  std::wstring wpath = Utf8ToWide(filepath);
+  infile = _wfopen(wpath.c_str(), L"rb");
+#else
+  infile = fopen(filepath.c_str(), "rb");
+#endif
+  if (infile == NULL) {
+    LOG_ERROR("Failed to open JPEG file: %s", filepath.c_str());
+    return false;
+  }
+
+  struct jpeg_decompress_struct cinfo;
+  struct my_error_mgr jerr;
+
+  // We set up the normal JPEG error routines, then override error_exit.
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = my_error_exit;
+
+  // Establish the setjmp return context for my_error_exit to use.
+  if (setjmp(jerr.setjmp_buffer)) {
+    // If we get here, the JPEG code has signaled an error.
+    // We need to clean up the JPEG object, close the input file, and return.
+    LOG_ERROR("JPEG error occurred while loading: %s", filepath.c_str());
+    jpeg_destroy_decompress(&cinfo);
+    fclose(infile);
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, infile);
+
+  if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+    LOG_ERROR("JPEG header invalid or not found: %s", filepath.c_str());
+    jpeg_destroy_decompress(&cinfo);
+    fclose(infile);
+    return false;
+  }
+
+  jpeg_start_decompress(&cinfo);
+
+  m_imageData.width = cinfo.output_width;
+  m_imageData.height = cinfo.output_height;
+  m_imageData.channels = 4; // We convert to RGBA
+  m_imageData.format = "JPEG";
+  m_imageData.pixelFormat = "RGBA8";
+
+  size_t pixelCount = (size_t)m_imageData.width * m_imageData.height * 4;
+  m_imageData.pixels.resize(pixelCount);
+
+  int row_stride = cinfo.output_width * cinfo.output_components;
+  JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo,
+                                                 JPOOL_IMAGE, row_stride, 1);
+
+  while (cinfo.output_scanline < cinfo.output_height) {
+    jpeg_read_scanlines(&cinfo, buffer, 1);
+
+    // Convert to float RGBA
+    int y = cinfo.output_scanline - 1;
+    for (int x = 0; x < m_imageData.width; x++) {
+      int dstIdx = (y * m_imageData.width + x) * 4;
+      int srcIdx = x * cinfo.output_components;
+
+      if (cinfo.output_components == 3) {
+        m_imageData.pixels[dstIdx + 0] = buffer[0][srcIdx + 0] / 255.0f; // R
+        m_imageData.pixels[dstIdx + 1] = buffer[0][srcIdx + 1] / 255.0f; // G
+        m_imageData.pixels[dstIdx + 2] = buffer[0][srcIdx + 2] / 255.0f; // B
+        m_imageData.pixels[dstIdx + 3] = 1.0f;                           // A
+      } else if (cinfo.output_components == 1) {
+        float val = buffer[0][srcIdx] / 255.0f;
+        m_imageData.pixels[dstIdx + 0] = val;  // R
+        m_imageData.pixels[dstIdx + 1] = val;  // G
+        m_imageData.pixels[dstIdx + 2] = val;  // B
+        m_imageData.pixels[dstIdx + 3] = 1.0f; // A
+      }
+    }
+  }
+
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  fclose(infile);
+
+  LOG("JPEG loaded successfully: %dx%d", m_imageData.width, m_imageData.height);
+  return true;
+}
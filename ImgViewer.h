@@ -1,114 +1,492 @@
-#pragma once
-#include "pch.h"
-#include <string>
-#include <vector>
-
-/**
- * @brief Structure representing loaded image data.
- */
-struct ImageData {
-  std::vector<float> pixels; ///< RGBA float pixel data (0.0 - 1.0 range)
-  int width = 0;             ///< Image width in pixels
-  int height = 0;            ///< Image height in pixels
-  int channels = 0;          ///< Number of color channels
-  std::string filename;      ///< Source filename
-  std::string format;        ///< File format (e.g., PNG, HDR, DDS)
-  std::string pixelFormat;   ///< Internal pixel format description
-  float minValue = 0.0f;     ///< Minimum pixel value found
-  float maxValue = 1.0f;     ///< Maximum pixel value found
-  bool hasNaN = false;       ///< Flag indicating presence of NaN values
-};
-
-/**
- * @brief Main class for handling image loading and state.
- */
-class ImgViewer {
-public:
-  /**
-   * @brief Constructor.
-   */
-  ImgViewer();
-
-  /**
-   * @brief Destructor.
-   */
-  ~ImgViewer();
-
-  /**
-   * @brief Loads an image from the specified file path.
-   * @param filepath Path to the image file.
-   * @return True if loading succeeded, false otherwise.
-   */
-  bool LoadImage(const std::string &filepath);
-
-  /**
-   * @brief Loads an image from the system clipboard.
-   * @return True if a valid image was found and loaded, false otherwise.
-   */
-  bool LoadImageFromClipboard();
-
-  /**
-   * @brief Clears the current image data.
-   */
-  void Clear();
-
-  /**
-   * @brief Gets the current image data.
-   * @return Reference to ImageData structure.
-   */
-  const ImageData &GetImageData() const { return m_imageData; }
-
-  /**
-   * @brief Checks if an image is currently loaded.
-   * @return True if image dimensions are valid.
-   */
-  bool HasImage() const {
-    return m_imageData.width > 0 && m_imageData.height > 0;
-  }
-
-  // UI state getters and setters
-
-  float GetZoom() const { return m_zoom; }
-  void SetZoom(float zoom) { m_zoom = zoom; }
-
-  const DirectX::XMFLOAT2 &GetPan() const { return m_pan; }
-  void SetPan(const DirectX::XMFLOAT2 &pan) { m_pan = pan; }
-
-  float GetRangeMin() const { return m_rangeMin; }
-  float GetRangeMax() const { return m_rangeMax; }
-  void SetRange(float min, float max) {
-    m_rangeMin = min;
-    m_rangeMax = max;
-  }
-
-private:
-  ImageData m_imageData;
-
-  // View state
-  float m_zoom = 1.0f;
-  DirectX::XMFLOAT2 m_pan = {0.0f, 0.0f};
-
-  // Color mapping range
-  float m_rangeMin = 0.0f;
-  float m_rangeMax = 1.0f;
-
-  /**
-   * @brief Loads image using stb_image library (LDR and HDR).
-   */
-  bool LoadSTB(const std::string &filepath);
-
-  /**
-   * @brief Loads image using DirectXTex library (DDS).
-   */
-  bool LoadDDS(const std::string &filepath);
-
-  /**
-   * @brief Loads image using libjpeg-turbo (JPG/JPEG).
-   */
-  bool LoadJpeg(const std::string &filepath);
-
-  /**
-   * @brief Analyzes image pixels to find min/max values and NaNs.
-   */
-  void AnalyzeImageRange();
-};
+#pragma once
+#include "BrickedVolume.h"
+#include "DepthBuffer.h"
+#include "EnvironmentLighting.h"
+#include "FrameCache.h"
+#include "ImageData.h"
+#include "ImageSource.h"
+#include "MotionField.h"
+#include "RawImage.h"
+#include "Reprojection.h"
+#include "pch.h"
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Main class for handling image loading and state.
+ */
+class ImgViewer {
+public:
+  /**
+   * @brief Constructor.
+   */
+  ImgViewer();
+
+  /**
+   * @brief Destructor.
+   */
+  ~ImgViewer();
+
+  /**
+   * @brief Loads an image from the specified file path.
+   * @param filepath Path to the image file.
+   * @return True if loading succeeded, false otherwise.
+   */
+  bool LoadImage(const std::string &filepath);
+
+  // Individual decoders used by LoadImage. They only fill the pixel data and
+  // format fields; call Clear() first and AnalyzeImageRange() afterwards.
+  // Public so the benchmarks can time them in isolation.
+
+  /**
+   * @brief Loads image using stb_image library (LDR and HDR).
+   */
+  bool LoadSTB(const std::string &filepath);
+
+  /**
+   * @brief Loads a Radiance RGBE (.hdr) image with the parallel decoder.
+   */
+  bool LoadHDR(const std::string &filepath);
+
+  /**
+   * @brief Loads an uncompressed BMP with the parallel DIB decoder.
+   */
+  bool LoadBMP(const std::string &filepath);
+
+  /**
+   * @brief Opens a DDS texture and decodes its first subresource.
+   */
+  bool LoadDDS(const std::string &filepath);
+
+  /**
+   * @brief Loads image using libjpeg-turbo (JPG/JPEG).
+   */
+  bool LoadJpeg(const std::string &filepath);
+
+  /**
+   * @brief Opens a KTX2 texture and decodes its first subresource.
+   */
+  bool LoadKTX2(const std::string &filepath);
+
+  /**
+   * @brief Opens an OpenEXR image and decodes its first layer.
+   */
+  bool LoadEXR(const std::string &filepath);
+
+  /**
+   * @brief Loads the first page of a TIFF file; other pages are layers.
+   */
+  bool LoadTIFF(const std::string &filepath);
+
+  /**
+   * @brief Opens a GIF and decodes its first frame; animated GIFs get a
+   * frame cache, started by LoadImage().
+   */
+  bool LoadGIF(const std::string &filepath);
+
+  /**
+   * @brief Maps a headerless dump and views it with the given layout.
+   */
+  bool LoadRaw(const std::string &filepath, const RawImageLayout &layout);
+
+  /**
+   * @brief Maps a YUV4MPEG2 file and decodes its first frame; files of
+   * several frames get a frame cache, started by LoadImage().
+   */
+  bool LoadY4M(const std::string &filepath);
+
+  /**
+   * @brief Maps a dump of YUV frames (layout.yuvFormat) and decodes its
+   * first frame, like LoadY4M().
+   */
+  bool LoadYUV(const std::string &filepath, const RawImageLayout &layout);
+
+  /**
+   * @brief Maps a PFM or binary PGM/PPM and views its pixels in place.
+   */
+  bool LoadPortableMap(const std::string &filepath);
+
+  /**
+   * @brief Analyzes image pixels to find min/max values and NaNs.
+   */
+  void AnalyzeImageRange();
+
+  /**
+   * @brief Loads an image from the system clipboard.
+   *
+   * CF_DIBV5 is preferred, since it can carry alpha; Windows synthesizes it
+   * and CF_DIB from CF_BITMAP, so screenshots arrive the same way.
+   * @return True if a valid image was found and loaded, false otherwise.
+   */
+  bool LoadImageFromClipboard();
+
+  /**
+   * @brief Clears the current image data.
+   */
+  void Clear();
+
+  /**
+   * @brief Gets the current image data.
+   * @return Reference to ImageData structure.
+   */
+  const ImageData &GetImageData() const { return m_imageData; }
+
+  /**
+   * @brief Checks if an image is currently loaded.
+   * @return True if image dimensions are valid.
+   */
+  bool HasImage() const {
+    return m_imageData.width > 0 && m_imageData.height > 0;
+  }
+
+  // Mip levels, array layers, cube faces and volume slices
+
+  /**
+   * @brief Checks if the loaded file has more than one 2D subresource.
+   */
+  bool HasSubresources() const {
+    return m_source && m_source->GetLayout().HasSubresources();
+  }
+
+  /**
+   * @brief Gets the layout of the loaded file, or nullptr for plain images.
+   */
+  const SubresourceLayout *GetSubresourceLayout() const {
+    return m_source ? &m_source->GetLayout() : nullptr;
+  }
+
+  const SubresourceIndex &GetSubresourceIndex() const { return m_subresource; }
+
+  /**
+   * @brief Decodes another subresource of the loaded file into the image.
+   * \note Keeps the view and color mapping range; the detected value range
+   * is updated. Recently viewed subresources are cached, so switching back
+   * does not decode again.
+   * @return False if there is no such subresource or decoding failed.
+   */
+  bool SelectSubresource(const SubresourceIndex &index);
+
+  // Volume textures, sliced across any axis
+
+  /**
+   * @brief Gets the bricked volume of a volume texture, or nullptr.
+   */
+  BrickedVolume *GetVolume() const { return m_volume.get(); }
+
+  /**
+   * @brief Checks if the detected range of a volume slice is the range of
+   * the whole volume.
+   */
+  bool UsesVolumeRange() const { return m_volume && m_volumeRange; }
+
+  /**
+   * @brief Takes the detected range of volume slices from the whole volume
+   * (the default), so every slice has the same color mapping, or from the
+   * slice shown.
+   * \note The slice shown is analyzed again and the color mapping range set
+   * to its new range. The setting stays for later volumes.
+   */
+  void SetVolumeRange(bool volumeRange);
+
+  // Frames of animated GIFs and numbered image sequences. Frames are decoded
+  // by a background thread; none of these calls wait for a decode.
+
+  /**
+   * @brief Checks if the loaded image has frames to play.
+   */
+  bool HasFrames() const { return m_frames != nullptr; }
+
+  int GetFrameCount() const;
+
+  /**
+   * @brief Gets the frame on screen.
+   */
+  int GetFrameIndex() const { return m_frame; }
+
+  /**
+   * @brief Gets the frame playback is at; it is shown once decoded.
+   */
+  int GetFramePosition() const { return m_framePosition; }
+
+  /**
+   * @brief Gets how long a frame is shown, in seconds; frames without
+   * timing use the frame rate.
+   */
+  double GetFrameDuration(int frame) const;
+
+  /**
+   * @brief Moves playback to a frame.
+   */
+  void SeekFrame(int frame);
+
+  /**
+   * @brief Pauses and moves by delta frames, wrapping around.
+   */
+  void StepFrame(int delta);
+
+  bool IsPlaying() const { return m_playing; }
+  void SetPlaying(bool playing);
+
+  float GetFrameRate() const { return m_frameRate; }
+  void SetFrameRate(float frameRate) { m_frameRate = frameRate; }
+
+  /**
+   * @brief Gets the decoded frames, or nullptr for single images.
+   */
+  const FrameCache *GetFrameCache() const { return m_frames.get(); }
+
+  /**
+   * @brief Advances playback and shows the frame at the position if it has
+   * been decoded.
+   * \note Keeps the view and color mapping range, like SelectSubresource().
+   * While playing, frames that are not decoded in time are skipped.
+   * @param elapsedSeconds Time since the last call.
+   * @return True if the image changed.
+   */
+  bool UpdateFrames(double elapsedSeconds);
+
+  // Conversion of YUV video frames
+
+  /**
+   * @brief Checks if the loaded image is a Y4M file or YUV dump.
+   */
+  bool IsYUV() const { return !m_yuvPath.empty(); }
+
+  const YUVSettings &GetYUVSettings() const { return m_yuvSettings; }
+
+  /**
+   * @brief Converts the frames again with other settings, staying on the
+   * frame playback is at.
+   * \note Keeps the view and color mapping range; the detected value range
+   * is updated. Frames decoded with the old settings are dropped.
+   * @return False if the file cannot be decoded any more.
+   */
+  bool SetYUVSettings(const YUVSettings &settings);
+
+  // Linearization of depth buffers
+
+  /**
+   * @brief Checks if the image on screen is the depth plane of a depth
+   * buffer.
+   */
+  bool IsDepth() const { return m_depthPlane.HasStoredPixels(); }
+
+  const DepthSettings &GetDepthSettings() const { return m_depthSettings; }
+
+  /**
+   * @brief Shows depth planes as view-space distance or as stored. Settings
+   * stay for later depth buffers.
+   * \note The detected value range is updated and the color mapping range
+   * set to it. Linearized planes are kept until the plane or projection
+   * changes, so switching back and forth does not convert again.
+   */
+  void SetDepthSettings(const DepthSettings &settings);
+
+  // Reprojection of environment maps between cubemaps and lat-long images
+
+  /**
+   * @brief Checks if the image is an environment map that can be
+   * reprojected: a face of a cubemap, or a 2:1 lat-long image.
+   */
+  bool IsEnvironmentMap() const;
+
+  /**
+   * @brief Checks if the image on screen is the reprojection of an
+   * environment map.
+   */
+  bool IsReprojected() const { return m_environment.GetPixelCount() > 0; }
+
+  bool GetReproject() const { return m_reproject; }
+
+  /**
+   * @brief Shows cubemaps as lat-long images and lat-long images as cube
+   * crosses, or both as stored. The setting stays for later images.
+   * \note Keeps the view and color mapping range; the detected value range
+   * is that of the reprojection. The lookup table is kept until the output
+   * size changes and the cube faces until another mip or layer is shown, so
+   * reprojecting again only filters.
+   */
+  void SetReproject(bool reproject);
+
+  /**
+   * @brief Analyzes the lighting of the environment map: spherical
+   * harmonics, total irradiance, dominant direction and luminance CDF.
+   * \note Cubemaps are analyzed from all faces of the mip and layer on
+   * screen. The result is kept until another file, mip or layer is shown.
+   * @return nullptr if the image is not an environment map or its faces
+   * cannot be decoded.
+   */
+  const EnvironmentLighting *AnalyzeLighting();
+
+  /**
+   * @brief Gets the lighting analyzed for the image on screen, or nullptr.
+   */
+  const EnvironmentLighting *GetLighting() const;
+
+  // Motion vectors
+
+  /**
+   * @brief Checks if the image holds 2D vectors, such as motion vectors or
+   * velocities: two float channels with no alpha.
+   */
+  bool HasMotionVectors() const;
+
+  /**
+   * @brief Gets the motion vectors of the image on screen reduced to cells
+   * of cellSize pixels.
+   * \note Fields are kept for the last few cell sizes until the image
+   * changes, so panning and zooming back do not reduce them again.
+   * @return nullptr if the image has no motion vectors.
+   */
+  const MotionField *GetMotionField(int cellSize);
+
+  // Layouts of headerless dumps, remembered per path
+
+  /**
+   * @brief Reads remembered layouts from a file; SetRawLayout() updates it.
+   */
+  void SetRawLayoutFile(const std::string &filepath);
+
+  /**
+   * @brief Gets the layout last used for a dump.
+   * @return False if the path has no remembered layout.
+   */
+  bool GetRawLayout(const std::string &filepath, RawImageLayout &layout) const;
+
+  /**
+   * @brief Remembers the layout of a dump; LoadImage() then opens it with
+   * this layout.
+   */
+  void SetRawLayout(const std::string &filepath, const RawImageLayout &layout);
+
+  // UI state getters and setters
+
+  float GetZoom() const { return m_zoom; }
+  void SetZoom(float zoom) { m_zoom = zoom; }
+
+  const DirectX::XMFLOAT2 &GetPan() const { return m_pan; }
+  void SetPan(const DirectX::XMFLOAT2 &pan) { m_pan = pan; }
+
+  float GetRangeMin() const { return m_rangeMin; }
+  float GetRangeMax() const { return m_rangeMax; }
+  void SetRange(float min, float max) {
+    m_rangeMin = min;
+    m_rangeMax = max;
+  }
+
+private:
+  /**
+   * @brief Decodes a file by its extension and sets the filename.
+   */
+  bool LoadFile(const std::string &filepath);
+
+  /**
+   * @brief Decodes the first subresource of a texture and keeps its source
+   * for the others. Volumes are wrapped in a BrickedVolume.
+   */
+  bool SetTextureSource(std::shared_ptr<ImageSource> source);
+
+  /**
+   * @brief Starts prefetching the frames of the loaded file, or of the
+   * sequence it is numbered in.
+   */
+  void StartFrames(const std::string &filepath);
+
+  /**
+   * @brief Maps a Y4M file (layout.yuvFormat is None) or YUV dump and
+   * decodes one of its frames.
+   * @param settings Conversion settings; nullptr keeps the guess.
+   */
+  bool OpenYUV(const std::string &filepath, const RawImageLayout &layout,
+               const YUVSettings *settings, int frame);
+
+  /**
+   * @brief Shows a just decoded (and analyzed) depth plane in m_imageData
+   * as the depth settings say; other images are left alone.
+   */
+  void ShowDepth();
+
+  /**
+   * @brief Replaces a just decoded environment map in m_imageData by its
+   * reprojection if the setting asks for it; other images are left alone.
+   */
+  void ShowReprojection();
+
+  /**
+   * @brief Checks if the loaded file is a cubemap.
+   */
+  bool IsCubemap() const {
+    return m_source && m_source->GetLayout().faceCount == 6;
+  }
+
+  /**
+   * @brief Decodes all faces of the cubemap mip and layer on screen into
+   * m_cubeFaces, unless they are there already.
+   */
+  bool DecodeCubeFaces();
+
+  ImageData m_imageData;
+
+  // File the image was decoded from, for formats with subresources
+  std::shared_ptr<ImageSource> m_source;
+  SubresourceIndex m_subresource;
+
+  // m_source of volume textures
+  std::shared_ptr<BrickedVolume> m_volume;
+  bool m_volumeRange = true;
+
+  // Previously viewed subresources, most recent first
+  struct CachedSubresource {
+    SubresourceIndex index;
+    ImageData data;
+  };
+  std::list<CachedSubresource> m_subresourceCache;
+
+  // Playback of animations and image sequences
+  std::unique_ptr<FrameCache> m_frames;
+  int m_frame = 0;         // Frame on screen
+  int m_framePosition = 0; // Frame playback is at
+  bool m_playing = false;
+  double m_frameTime = 0.0; // Time spent at the position
+  float m_frameRate = 24.0f;
+
+  // Y4M file or YUV dump the frames are converted from
+  std::string m_yuvPath;
+  RawImageLayout m_yuvLayout;
+  YUVSettings m_yuvSettings;
+
+  // Depth plane on screen as stored, and linearized with m_linearSettings
+  ImageData m_depthPlane;
+  ImageData m_linearDepth;
+  DepthSettings m_linearSettings;
+  DepthSettings m_depthSettings;
+
+  // Environment map as decoded while its reprojection is on screen, and
+  // what it is reprojected with
+  ImageData m_environment;
+  ReprojectionTable m_reprojectionTable;
+  std::vector<float> m_cubeFaces; // RGBA32F faces of m_cubeFacesIndex
+  SubresourceIndex m_cubeFacesIndex;
+  bool m_reproject = false;
+
+  // Lighting of the environment map, for the mip and layer below
+  EnvironmentLighting m_lighting;
+  SubresourceIndex m_lightingIndex;
+  bool m_hasLighting = false;
+
+  // Motion fields of the image on screen, most recently used first
+  std::vector<MotionField> m_motionFields;
+
+  RawImageLayouts m_rawLayouts;
+  std::string m_rawLayoutFile;
+
+  // View state
+  float m_zoom = 1.0f;
+  DirectX::XMFLOAT2 m_pan = {0.0f, 0.0f};
+
+  // Color mapping range
+  float m_rangeMin = 0.0f;
+  float m_rangeMax = 1.0f;
+};
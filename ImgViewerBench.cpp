@@ -0,0 +1,4357 @@
+// Microbenchmarks for the image loaders and analysis kernels.
+//
+// Generates synthetic images, encodes them to the formats the viewer loads,
+// times each decoder and the range/histogram kernels, and writes the results
+// as JSON. Results can be compared against a stored baseline:
+//
+//   imgViewerBench --sizes 1,16 --threads 1,4 --out results.json
+//   imgViewerBench --baseline results.json --tolerance 0.1
+//
+// Exit code is 1 if any stage is slower than the baseline by more than the
+// tolerance, or if a stage that checks its output finds it wrong.
+//
+// --validate-bc decodes random BCn blocks with BCDecoder and with DirectXTex
+// and exits with 1 unless every pixel is bitwise identical. --validate-hdr
+// does the same for the RGBE decoder against stb_image, and --validate-bmp
+// for the DIB decoder against the pixels each bitmap layout was written from.
+// --validate-exr writes EXR files in every compression and layout and checks
+// that the EXR decoder reads back the samples they were written from.
+// --validate-tiff does the same for the TIFF decoder.
+// --validate-render <dir> compares the software renderer with its scalar
+// reference and with the golden PNGs in dir (--update-golden rewrites them).
+#include "BCDecoder.h"
+#include "BMPDecoder.h"
+#include "BenchCommon.h"
+#include "BrickedVolume.h"
+#include "DDSImage.h"
+#include "DepthBuffer.h"
+#include "EXRImage.h"
+#include "EnvironmentLighting.h"
+#include "GIFImage.h"
+#include "HalfFloat.h"
+#include "ImageAnalysis.h"
+#include "ImageProbe.h"
+#include "ImgViewer.h"
+#include "MotionField.h"
+#include "Parallel.h"
+#include "RGBEDecoder.h"
+#include "Reprojection.h"
+#include "SoftwareRenderer.h"
+#include "TIFFImage.h"
+#include "YUVImage.h"
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include <DirectXTex.h>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+namespace po = boost::program_options;
+namespace fs = std::filesystem;
+
+/**
+ * @brief Kind of synthetic content.
+ */
+enum class Content { LDR, HDR, HDRWithNaN, Random };
+
+static const char *GetContentName(Content content) {
+  switch (content) {
+  case Content::LDR:
+    return "ldr";
+  case Content::HDR:
+    return "hdr";
+  case Content::HDRWithNaN:
+    return "nan";
+  case Content::Random:
+    return "random";
+  }
+  return "";
+}
+
+/**
+ * @brief One timed measurement.
+ */
+struct BenchResult {
+  std::string name;  ///< Unique key used for baseline comparison
+  std::string stage; ///< decode, range or histogram
+  std::string format;
+  std::string content;
+  int megapixels = 0;
+  int threads = 0; ///< 0 = stage is not threaded by the benchmark
+  double seconds = 0.0;
+  double mpixPerSec = 0.0;
+};
+
+/**
+ * @brief Synthetic RGBA32F image.
+ */
+struct SyntheticImage {
+  int width = 0;
+  int height = 0;
+  std::vector<float> pixels;
+};
+
+// Cheap deterministic per-pixel noise
+static inline uint32_t Hash(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352d;
+  x ^= x >> 15;
+  x *= 0x846ca68b;
+  x ^= x >> 16;
+  return x;
+}
+
+static SyntheticImage GenerateImage(int megapixels, Content content,
+                                    int threadCount) {
+  // Square-ish, with dimensions a multiple of 4 so BC formats fit exactly
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0);
+  side = std::max(4, side & ~3);
+
+  SyntheticImage image;
+  image.width = side;
+  image.height = side;
+  image.pixels.resize((size_t)side * side * 4);
+
+  ParallelFor(side, threadCount, [&](int rowBegin, int rowEnd) {
+    for (int y = rowBegin; y < rowEnd; y++) {
+      float *row = image.pixels.data() + (size_t)y * side * 4;
+      for (int x = 0; x < side; x++) {
+        uint32_t h = Hash((uint32_t)(y * side + x));
+        float noise = (float)(h & 0xff) / 255.0f * 0.1f;
+        float u = (float)x / side;
+        float v = (float)y / side;
+
+        float r = u * 0.9f + noise;
+        float g = v * 0.9f + noise;
+        float b = (1.0f - u) * 0.5f + v * 0.4f;
+        if (content != Content::LDR) {
+          // Spread over several stops, with a few bright highlights
+          float exposure = std::exp2(u * 8.0f - 4.0f);
+          r *= exposure;
+          g *= exposure;
+          b *= exposure;
+          if ((h >> 8) % 4096 == 0)
+            r = g = b = 1000.0f;
+        }
+        if (content == Content::HDRWithNaN && (h >> 20) % 997 == 0)
+          g = std::numeric_limits<float>::quiet_NaN();
+
+        float *pixel = row + (size_t)x * 4;
+        pixel[0] = r;
+        pixel[1] = g;
+        pixel[2] = b;
+        pixel[3] = 1.0f;
+      }
+    }
+  });
+  return image;
+}
+
+static std::vector<unsigned char> ToRGBA8(const SyntheticImage &image) {
+  std::vector<unsigned char> rgba(image.pixels.size());
+  for (size_t i = 0; i < rgba.size(); i++) {
+    float value = std::min(1.0f, std::max(0.0f, image.pixels[i]));
+    rgba[i] = (unsigned char)(value * 255.0f + 0.5f);
+  }
+  return rgba;
+}
+
+static std::vector<uint16_t> ToHalf(const SyntheticImage &image) {
+  std::vector<uint16_t> half(image.pixels.size());
+  for (size_t i = 0; i < half.size(); i++)
+    half[i] = FloatToHalf(image.pixels[i]);
+  return half;
+}
+
+// ---- Radiance HDR writing ----
+
+// RGBE bytes of each pixel, rounded like stb_image_write
+static std::vector<uint8_t> ToRGBE(const SyntheticImage &image) {
+  size_t pixelCount = image.pixels.size() / 4;
+  std::vector<uint8_t> rgbe(pixelCount * 4);
+  for (size_t i = 0; i < pixelCount; i++) {
+    float rgb[3];
+    for (int c = 0; c < 3; c++)
+      rgb[c] = std::max(0.0f, image.pixels[i * 4 + c]);
+    float maxComponent = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+    uint8_t *out = &rgbe[i * 4];
+    if (maxComponent < 1e-32f) {
+      out[0] = out[1] = out[2] = out[3] = 0;
+      continue;
+    }
+    int exponent;
+    float normalize = (float)frexp(maxComponent, &exponent) * 256.0f /
+                      maxComponent;
+    for (int c = 0; c < 3; c++)
+      out[c] = (uint8_t)(rgb[c] * normalize);
+    out[3] = (uint8_t)(exponent + 128);
+  }
+  return rgbe;
+}
+
+// Appends one channel of a scanline with runs of 3+ equal bytes
+static void EncodeRGBERuns(const uint8_t *rgbe, int width, int channel,
+                           std::vector<uint8_t> &out) {
+  auto at = [&](int x) { return rgbe[(size_t)x * 4 + channel]; };
+  auto runLength = [&](int x) {
+    int length = 1;
+    while (x + length < width && length < 127 && at(x + length) == at(x))
+      length++;
+    return length;
+  };
+  for (int x = 0; x < width;) {
+    int run = runLength(x);
+    if (run >= 3) {
+      out.push_back((uint8_t)(128 + run));
+      out.push_back(at(x));
+      x += run;
+      continue;
+    }
+    int count = 0;
+    while (x + count < width && count < 128 && runLength(x + count) < 3)
+      count++;
+    out.push_back((uint8_t)count);
+    for (int i = 0; i < count; i++)
+      out.push_back(at(x + i));
+    x += count;
+  }
+}
+
+/**
+ * @brief Encodes RGBE pixels as a Radiance picture with RLE scanlines, or
+ * flat pixels if rle is false.
+ */
+static std::vector<uint8_t> EncodeRGBE(const std::vector<uint8_t> &rgbe,
+                                       int width, int height, bool rle) {
+  std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " +
+                       std::to_string(height) + " +X " +
+                       std::to_string(width) + "\n";
+  std::vector<uint8_t> out(header.begin(), header.end());
+  if (!rle) {
+    out.insert(out.end(), rgbe.begin(), rgbe.end());
+    return out;
+  }
+  for (int y = 0; y < height; y++) {
+    const uint8_t *row = &rgbe[(size_t)y * width * 4];
+    out.insert(out.end(), {2, 2, (uint8_t)(width >> 8), (uint8_t)width});
+    for (int channel = 0; channel < 4; channel++)
+      EncodeRGBERuns(row, width, channel, out);
+  }
+  return out;
+}
+
+// ---- DDS writing ----
+
+namespace {
+#pragma pack(push, 1)
+struct DDSPixelFormat {
+  uint32_t size;
+  uint32_t flags;
+  uint32_t fourCC;
+  uint32_t rgbBitCount;
+  uint32_t rBitMask, gBitMask, bBitMask, aBitMask;
+};
+
+struct DDSHeader {
+  uint32_t size;
+  uint32_t flags;
+  uint32_t height;
+  uint32_t width;
+  uint32_t pitchOrLinearSize;
+  uint32_t depth;
+  uint32_t mipMapCount;
+  uint32_t reserved1[11];
+  DDSPixelFormat pixelFormat;
+  uint32_t caps, caps2, caps3, caps4;
+  uint32_t reserved2;
+};
+
+struct DDSHeaderDX10 {
+  uint32_t dxgiFormat;
+  uint32_t resourceDimension;
+  uint32_t miscFlag;
+  uint32_t arraySize;
+  uint32_t miscFlags2;
+};
+#pragma pack(pop)
+} // namespace
+
+// DXGI_FORMAT values, spelled out so the writer does not need DirectX headers
+static const uint32_t g_DxgiRGBA32F = 2;
+static const uint32_t g_DxgiRGBA16F = 10;
+static const uint32_t g_DxgiD32FS8 = 20;
+static const uint32_t g_DxgiRGBA8 = 28;
+static const uint32_t g_DxgiD24S8 = 45;
+static const uint32_t g_DxgiBC1 = 71;
+
+static bool WriteDDS(const fs::path &path, uint32_t dxgiFormat, int width,
+                     int height, bool blockCompressed, const void *data,
+                     size_t size) {
+  DDSHeader header = {};
+  header.size = sizeof(DDSHeader);
+  header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | (blockCompressed ? 0x80000 : 0x8);
+  header.height = (uint32_t)height;
+  header.width = (uint32_t)width;
+  header.pitchOrLinearSize =
+      blockCompressed ? (uint32_t)size : (uint32_t)(size / height);
+  header.mipMapCount = 1;
+  header.pixelFormat.size = sizeof(DDSPixelFormat);
+  header.pixelFormat.flags = 0x4; // DDPF_FOURCC
+  header.pixelFormat.fourCC = 0x30315844; // "DX10"
+  header.caps = 0x1000; // DDSCAPS_TEXTURE
+
+  DDSHeaderDX10 dx10 = {};
+  dx10.dxgiFormat = dxgiFormat;
+  dx10.resourceDimension = 3; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+  dx10.arraySize = 1;
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+    return false;
+  file.write("DDS ", 4);
+  file.write((const char *)&header, sizeof(header));
+  file.write((const char *)&dx10, sizeof(dx10));
+  file.write((const char *)data, (std::streamsize)size);
+  return (bool)file;
+}
+
+// Little-endian PFM: RGB floats, rows bottom-up
+static bool WritePFM(const fs::path &path, const SyntheticImage &image) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+    return false;
+  file << "PF\n" << image.width << " " << image.height << "\n-1.0\n";
+  std::vector<float> row((size_t)image.width * 3);
+  for (int y = image.height - 1; y >= 0; y--) {
+    const float *src = image.pixels.data() + (size_t)y * image.width * 4;
+    for (int x = 0; x < image.width; x++)
+      memcpy(&row[(size_t)x * 3], src + (size_t)x * 4, 3 * sizeof(float));
+    file.write((const char *)row.data(),
+               (std::streamsize)(row.size() * sizeof(float)));
+  }
+  return (bool)file;
+}
+
+// ---- OpenEXR writing ----
+
+static void AppendEXRAttribute(std::string &out, const char *name,
+                               const char *type, const void *value,
+                               int32_t size) {
+  out.append(name, strlen(name) + 1);
+  out.append(type, strlen(type) + 1);
+  out.append((const char *)&size, 4);
+  out.append((const char *)value, size);
+}
+
+// Splits even and odd bytes, then delta encodes: the filter ZIP and RLE
+// chunks are packed after
+static void ApplyZipFilter(const std::vector<uint8_t> &raw,
+                           std::vector<uint8_t> &filtered) {
+  filtered.resize(raw.size());
+  size_t half = (raw.size() + 1) / 2;
+  for (size_t i = 0; i < raw.size(); i++)
+    filtered[(i & 1) ? half + i / 2 : i / 2] = raw[i];
+  for (size_t i = filtered.size(); i > 1; i--)
+    filtered[i - 1] = (uint8_t)(filtered[i - 1] - filtered[i - 2] + 128);
+}
+
+static void Deflate(const std::vector<uint8_t> &src,
+                    std::vector<uint8_t> &dst) {
+  uLongf size = compressBound((uLong)src.size());
+  dst.resize(size);
+  compress2(dst.data(), &size, src.data(), (uLong)src.size(),
+            Z_DEFAULT_COMPRESSION);
+  dst.resize(size);
+}
+
+/**
+ * @brief Writes a ZIP compressed scanline EXR with half RGBA plus "albedo"
+ * and "normal" layers (the RGB channels in another order), so layer
+ * selection has channels to skip.
+ */
+static bool WriteEXR(const fs::path &path, const std::vector<uint16_t> &rgba,
+                     int width, int height) {
+  // Channels sorted by name, as the file stores them: component of rgba
+  const struct {
+    const char *name;
+    int component;
+  } channels[] = {{"A", 3},        {"B", 2},        {"G", 1},
+                  {"R", 0},        {"albedo.B", 1}, {"albedo.G", 0},
+                  {"albedo.R", 2}, {"normal.X", 2}, {"normal.Y", 1},
+                  {"normal.Z", 0}};
+  const int linesPerChunk = 16;
+
+  std::string header;
+  const int32_t magic = 20000630, version = 2;
+  header.append((const char *)&magic, 4);
+  header.append((const char *)&version, 4);
+  std::string channelList;
+  for (const auto &channel : channels) {
+    const int32_t fields[4] = {1, 0, 1, 1}; // HALF, not linear, sampling
+    channelList.append(channel.name, strlen(channel.name) + 1);
+    channelList.append((const char *)fields, sizeof(fields));
+  }
+  channelList += '\0';
+  AppendEXRAttribute(header, "channels", "chlist", channelList.data(),
+                     (int32_t)channelList.size());
+  const uint8_t compression = 3; // ZIP
+  AppendEXRAttribute(header, "compression", "compression", &compression, 1);
+  const int32_t window[4] = {0, 0, width - 1, height - 1};
+  AppendEXRAttribute(header, "dataWindow", "box2i", window, 16);
+  AppendEXRAttribute(header, "displayWindow", "box2i", window, 16);
+  const uint8_t lineOrder = 0;
+  AppendEXRAttribute(header, "lineOrder", "lineOrder", &lineOrder, 1);
+  const float aspect = 1.0f, center[2] = {0.0f, 0.0f};
+  AppendEXRAttribute(header, "pixelAspectRatio", "float", &aspect, 4);
+  AppendEXRAttribute(header, "screenWindowCenter", "v2f", center, 8);
+  AppendEXRAttribute(header, "screenWindowWidth", "float", &aspect, 4);
+  header += '\0';
+
+  int chunkCount = (height + linesPerChunk - 1) / linesPerChunk;
+  std::vector<std::string> chunks(chunkCount);
+  ParallelFor(chunkCount, 0, [&](int begin, int end) {
+    std::vector<uint8_t> raw, filtered, packed;
+    for (int chunk = begin; chunk < end; chunk++) {
+      int y0 = chunk * linesPerChunk;
+      int y1 = std::min(y0 + linesPerChunk, height);
+      raw.clear();
+      for (int y = y0; y < y1; y++) {
+        for (const auto &channel : channels) {
+          for (int x = 0; x < width; x++) {
+            uint16_t value =
+                rgba[((size_t)y * width + x) * 4 + channel.component];
+            raw.push_back((uint8_t)value);
+            raw.push_back((uint8_t)(value >> 8));
+          }
+        }
+      }
+
+      ApplyZipFilter(raw, filtered);
+      Deflate(filtered, packed);
+      const std::vector<uint8_t> &data =
+          packed.size() < raw.size() ? packed : raw;
+      int32_t dataSize = (int32_t)data.size();
+      std::string &out = chunks[chunk];
+      out.append((const char *)&y0, 4);
+      out.append((const char *)&dataSize, 4);
+      out.append((const char *)data.data(), dataSize);
+    }
+  });
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+    return false;
+  file.write(header.data(), (std::streamsize)header.size());
+  uint64_t offset = header.size() + (uint64_t)chunkCount * 8;
+  for (const std::string &chunk : chunks) {
+    file.write((const char *)&offset, 8);
+    offset += chunk.size();
+  }
+  for (const std::string &chunk : chunks)
+    file.write(chunk.data(), (std::streamsize)chunk.size());
+  return (bool)file;
+}
+
+// Compression methods and channel types, as the file stores them
+enum EXRCompression { EXRNone, EXRRLE, EXRZIPS, EXRZIP, EXRPIZ, EXRPXR24 };
+enum EXRChannelType { EXRUInt, EXRHalf, EXRFloat };
+
+struct EXRTestChannel {
+  const char *name;
+  int type;
+  int xSampling;
+  int ySampling;
+};
+
+/**
+ * @brief One part of a test EXR file: scanlines, or tiles when tileWidth is
+ * not 0, of channels sorted by name.
+ */
+struct EXRTestPart {
+  const char *name; ///< Multi-part files only
+  int compression;
+  std::vector<EXRTestChannel> channels;
+  int minX, minY, width, height;
+  int tileWidth, tileHeight;
+  int levelMode;    ///< 0 = one level, 1 = mipmaps, 2 = ripmaps
+  int roundingMode; ///< 0 = level sizes round down, 1 = up
+  bool wide;        ///< Halves spread over more than 2^14 values
+};
+
+// Pixels of one chunk, in data window coordinates scaled to its level
+struct EXRTestChunk {
+  int minX, minY, maxX, maxY;
+  int tileX, tileY, levelX, levelY;
+};
+
+static int FloorDiv(int x, int y) {
+  return x >= 0 ? x / y : -((-x + y - 1) / y);
+}
+
+// Samples of a channel with the given sampling in [min, max]
+static int NumSamples(int sampling, int min, int max) {
+  return FloorDiv(max, sampling) - FloorDiv(min - 1, sampling);
+}
+
+static int GetEXRLevelSize(int size, int level, int roundingMode) {
+  int levelSize = size >> level;
+  if (roundingMode == 1 && (levelSize << level) < size)
+    levelSize++;
+  return std::max(levelSize, 1);
+}
+
+static int GetEXRLevelCount(int size, int roundingMode) {
+  int levels = 1;
+  while (GetEXRLevelSize(size, levels - 1, roundingMode) > 1)
+    levels++;
+  return levels;
+}
+
+// Chunks in file order: by level, then by tile row
+static std::vector<EXRTestChunk> GetEXRTestChunks(const EXRTestPart &part) {
+  std::vector<EXRTestChunk> chunks;
+  if (part.tileWidth == 0) {
+    const int linesPerChunk[] = {1, 1, 1, 16, 32, 16};
+    int lines = linesPerChunk[part.compression];
+    int maxY = part.minY + part.height - 1;
+    for (int y = part.minY; y <= maxY; y += lines)
+      chunks.push_back({part.minX, y, part.minX + part.width - 1,
+                        std::min(y + lines - 1, maxY), 0, 0, 0, 0});
+    return chunks;
+  }
+
+  int xLevels = 1, yLevels = 1;
+  if (part.levelMode == 1) {
+    xLevels = yLevels = GetEXRLevelCount(std::max(part.width, part.height),
+                                         part.roundingMode);
+  } else if (part.levelMode == 2) {
+    xLevels = GetEXRLevelCount(part.width, part.roundingMode);
+    yLevels = GetEXRLevelCount(part.height, part.roundingMode);
+  }
+  for (int ly = 0; ly < yLevels; ly++) {
+    for (int lx = 0; lx < xLevels; lx++) {
+      if (part.levelMode == 1 && lx != ly)
+        continue;
+      int width = GetEXRLevelSize(part.width, lx, part.roundingMode);
+      int height = GetEXRLevelSize(part.height, ly, part.roundingMode);
+      for (int ty = 0; ty * part.tileHeight < height; ty++) {
+        for (int tx = 0; tx * part.tileWidth < width; tx++) {
+          int x = part.minX + tx * part.tileWidth;
+          int y = part.minY + ty * part.tileHeight;
+          chunks.push_back(
+              {x, y, std::min(x + part.tileWidth, part.minX + width) - 1,
+               std::min(y + part.tileHeight, part.minY + height) - 1, tx, ty,
+               lx, ly});
+        }
+      }
+    }
+  }
+  return chunks;
+}
+
+// Decodable mips of a part: the levels reduced equally in x and y
+static int GetEXRTestMipCount(const EXRTestPart &part) {
+  int mips = 1;
+  for (const EXRTestChunk &chunk : GetEXRTestChunks(part)) {
+    if (chunk.levelX == chunk.levelY)
+      mips = std::max(mips, chunk.levelX + 1);
+  }
+  return mips;
+}
+
+static int GetEXRSampleSize(const EXRTestChannel &channel) {
+  return channel.type == EXRHalf ? 2 : 4;
+}
+
+// Sample bits of channel c at data window coordinates (x, y) of a level:
+// ramps with a little noise, so every compression has something to pack.
+// Floats only use their top 24 bits, which PXR24 keeps.
+static uint32_t GetEXRTestSample(const EXRTestPart &part, int c, int x, int y,
+                                 int levelX, int levelY) {
+  uint32_t noise =
+      Hash((uint32_t)(x * 7919 + y * 104729 + c * 31 + levelX * 17 +
+                      levelY * 257)) &
+      3;
+  uint32_t ramp = (uint32_t)(x * 3 + y * 5 + c * 7 + levelX * 11 +
+                             levelY * 13);
+  switch (part.channels[c].type) {
+  case EXRHalf:
+    if (part.wide)
+      return (uint32_t)(x * 131 + y * 257 + c * 1009 + noise) & 0xffff;
+    return 0x3000 + (ramp & 0x7ff) + noise;
+  case EXRFloat:
+    return 0x3f800000u + (((ramp & 0xffff) + noise) << 8);
+  default:
+    return ramp + noise;
+  }
+}
+
+// Uncompressed chunk: lines, then channels, then samples
+static void GetEXRTestChunkData(const EXRTestPart &part,
+                                const EXRTestChunk &chunk,
+                                std::vector<uint8_t> &raw) {
+  raw.clear();
+  for (int y = chunk.minY; y <= chunk.maxY; y++) {
+    for (int c = 0; c < (int)part.channels.size(); c++) {
+      const EXRTestChannel &channel = part.channels[c];
+      if (FloorDiv(y, channel.ySampling) * channel.ySampling != y)
+        continue;
+      int first = FloorDiv(chunk.minX - 1, channel.xSampling) + 1;
+      int count = NumSamples(channel.xSampling, chunk.minX, chunk.maxX);
+      for (int i = 0; i < count; i++) {
+        uint32_t sample =
+            GetEXRTestSample(part, c, (first + i) * channel.xSampling, y,
+                             chunk.levelX, chunk.levelY);
+        raw.insert(raw.end(), (const uint8_t *)&sample,
+                   (const uint8_t *)&sample + GetEXRSampleSize(channel));
+      }
+    }
+  }
+}
+
+// OpenEXR RLE: a count c >= 0 repeats the next byte c + 1 times, a count
+// -n copies the next n bytes
+static void PackRLE(const std::vector<uint8_t> &src,
+                    std::vector<uint8_t> &dst) {
+  dst.clear();
+  size_t i = 0;
+  while (i < src.size()) {
+    size_t run = 1;
+    while (i + run < src.size() && src[i + run] == src[i] && run < 128)
+      run++;
+    if (run >= 3) {
+      dst.push_back((uint8_t)(run - 1));
+      dst.push_back(src[i]);
+      i += run;
+      continue;
+    }
+    // Literals up to the next run of three
+    size_t end = i;
+    while (end < src.size() && end - i < 127 &&
+           !(end + 2 < src.size() && src[end] == src[end + 1] &&
+             src[end] == src[end + 2]))
+      end++;
+    dst.push_back((uint8_t)-(int)(end - i));
+    dst.insert(dst.end(), src.begin() + i, src.begin() + end);
+    i = end;
+  }
+}
+
+// PXR24: byte planes of the differences of each line of each channel, most
+// significant first; floats keep their top 24 bits
+static void PackPXR24(const EXRTestPart &part, const EXRTestChunk &chunk,
+                      const std::vector<uint8_t> &raw,
+                      std::vector<uint8_t> &dst) {
+  std::vector<uint8_t> planes;
+  const uint8_t *src = raw.data();
+  for (int y = chunk.minY; y <= chunk.maxY; y++) {
+    for (const EXRTestChannel &channel : part.channels) {
+      if (FloorDiv(y, channel.ySampling) * channel.ySampling != y)
+        continue;
+      int count = NumSamples(channel.xSampling, chunk.minX, chunk.maxX);
+      int planeCount = channel.type == EXRHalf    ? 2
+                       : channel.type == EXRFloat ? 3
+                                                  : 4;
+      int topShift = channel.type == EXRHalf ? 8 : 24;
+      size_t base = planes.size();
+      planes.resize(base + (size_t)count * planeCount);
+      uint32_t previous = 0;
+      for (int i = 0; i < count; i++) {
+        uint32_t value = 0;
+        memcpy(&value, src, GetEXRSampleSize(channel));
+        src += GetEXRSampleSize(channel);
+        uint32_t difference = value - previous;
+        previous = value;
+        for (int p = 0; p < planeCount; p++)
+          planes[base + (size_t)p * count + i] =
+              (uint8_t)(difference >> (topShift - 8 * p));
+      }
+    }
+  }
+  Deflate(planes, dst);
+}
+
+// Forward 2D Haar wavelet of an nx * ny plane with strides ox and oy, the
+// inverse of the decoder's
+static void EncodeWavelet(uint16_t *in, int nx, int ox, int ny, int oy,
+                          uint16_t maxValue) {
+  auto encode14 = [](uint16_t a, uint16_t b, uint16_t &l, uint16_t &h) {
+    int as = (int16_t)a, bs = (int16_t)b;
+    l = (uint16_t)((as + bs) >> 1);
+    h = (uint16_t)(as - bs);
+  };
+  auto encode16 = [](uint16_t a, uint16_t b, uint16_t &l, uint16_t &h) {
+    int ao = (a + 0x8000) & 0xffff;
+    int m = (ao + b) >> 1;
+    int d = ao - b;
+    if (d < 0)
+      m = (m + 0x8000) & 0xffff;
+    l = (uint16_t)m;
+    h = (uint16_t)(d & 0xffff);
+  };
+  auto encode = [&](uint16_t a, uint16_t b, uint16_t &l, uint16_t &h) {
+    if (maxValue < (1 << 14))
+      encode14(a, b, l, h);
+    else
+      encode16(a, b, l, h);
+  };
+
+  int n = std::min(nx, ny);
+  for (int p = 1, p2 = 2; p2 <= n; p = p2, p2 <<= 1) {
+    size_t ox1 = (size_t)ox * p, ox2 = (size_t)ox * p2;
+    size_t oy1 = (size_t)oy * p, oy2 = (size_t)oy * p2;
+    size_t lastY = (size_t)oy * (ny - p2);
+    size_t lastX = (size_t)ox * (nx - p2);
+    uint16_t i00, i01, i10, i11;
+    size_t py = 0;
+    for (; py <= lastY; py += oy2) {
+      size_t px = py;
+      for (; px <= py + lastX; px += ox2) {
+        size_t p01 = px + ox1, p10 = px + oy1, p11 = p10 + ox1;
+        encode(in[px], in[p01], i00, i01);
+        encode(in[p10], in[p11], i10, i11);
+        encode(i00, i10, in[px], in[p10]);
+        encode(i01, i11, in[p01], in[p11]);
+      }
+      if (nx & p) {
+        size_t p10 = px + oy1;
+        encode(in[px], in[p10], i00, in[p10]);
+        in[px] = i00;
+      }
+    }
+    if (ny & p) {
+      for (size_t px = py; px <= py + lastX; px += ox2) {
+        size_t p01 = px + ox1;
+        encode(in[px], in[p01], i00, in[p01]);
+        in[px] = i00;
+      }
+    }
+  }
+}
+
+// Most significant bit first, as PIZ Huffman data is read
+struct BitWriter {
+  std::vector<uint8_t> &out;
+  uint32_t bits = 0;
+  int count = 0;
+  int64_t total = 0;
+
+  void Write(int n, uint64_t value) {
+    for (int i = n - 1; i >= 0; i--) {
+      bits = (bits << 1) | ((value >> i) & 1);
+      total++;
+      if (++count == 8) {
+        out.push_back((uint8_t)bits);
+        bits = 0;
+        count = 0;
+      }
+    }
+  }
+
+  void Flush() {
+    if (count > 0)
+      out.push_back((uint8_t)(bits << (8 - count)));
+    bits = 0;
+    count = 0;
+  }
+};
+
+// Huffman codes from symbol counts: length in the low 6 bits, canonical code
+// above, longer codes first as OpenEXR assigns them
+static void BuildHufCodes(const std::vector<uint64_t> &counts,
+                          std::vector<uint64_t> &codes) {
+  // Leaves, then the nodes joining the two least frequent ones
+  std::vector<int> parents;
+  std::vector<int> leaves(counts.size(), -1);
+  typedef std::pair<uint64_t, int> Node;
+  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> heap;
+  for (size_t s = 0; s < counts.size(); s++) {
+    if (counts[s] > 0) {
+      leaves[s] = (int)parents.size();
+      heap.push({counts[s], (int)parents.size()});
+      parents.push_back(-1);
+    }
+  }
+  while (heap.size() > 1) {
+    Node a = heap.top();
+    heap.pop();
+    Node b = heap.top();
+    heap.pop();
+    int node = (int)parents.size();
+    parents.push_back(-1);
+    parents[a.second] = parents[b.second] = node;
+    heap.push({a.first + b.first, node});
+  }
+
+  codes.assign(counts.size(), 0);
+  for (size_t s = 0; s < counts.size(); s++) {
+    for (int node = leaves[s]; node >= 0 && parents[node] >= 0;
+         node = parents[node])
+      codes[s]++;
+  }
+
+  uint64_t lengthCounts[59] = {};
+  for (uint64_t length : codes)
+    lengthCounts[length]++;
+  uint64_t code = 0;
+  for (int length = 58; length > 0; length--) {
+    uint64_t next = (code + lengthCounts[length]) >> 1;
+    lengthCounts[length] = code;
+    code = next;
+  }
+  for (uint64_t &entry : codes) {
+    if (entry > 0)
+      entry |= lengthCounts[entry]++ << 6;
+  }
+}
+
+// PIZ Huffman data: min and max symbol, the code lengths with zero runs
+// packed, then the codes; the symbol after the largest value repeats the
+// previous value up to 255 times
+static void PackHuffman(const std::vector<uint16_t> &values,
+                        std::vector<uint8_t> &out) {
+  std::vector<uint64_t> counts((1 << 16) + 1, 0);
+  for (uint16_t value : values)
+    counts[value]++;
+  int min = 0;
+  while (counts[min] == 0)
+    min++;
+  int max = 1 << 16;
+  while (counts[max - 1] == 0)
+    max--;
+  counts[max] = 1; // The run symbol
+  std::vector<uint64_t> codes;
+  BuildHufCodes(counts, codes);
+
+  out.assign(20, 0);
+  BitWriter table{out};
+  for (int symbol = min; symbol <= max; symbol++) {
+    int length = (int)(codes[symbol] & 63);
+    if (length == 0) {
+      int run = 1;
+      while (symbol + run <= max && (codes[symbol + run] & 63) == 0 &&
+             run < 255 + 6)
+        run++;
+      if (run >= 6) {
+        table.Write(6, 63);
+        table.Write(8, run - 6);
+        symbol += run - 1;
+        continue;
+      }
+      if (run >= 2) {
+        table.Write(6, 59 + run - 2);
+        symbol += run - 1;
+        continue;
+      }
+    }
+    table.Write(6, length);
+  }
+  table.Flush();
+  int32_t tableLength = (int32_t)(out.size() - 20);
+
+  BitWriter data{out};
+  auto send = [&](int symbol, int repeats) {
+    uint64_t code = codes[symbol], run = codes[max];
+    int length = (int)(code & 63), runLength = (int)(run & 63);
+    if (length + runLength + 8 < length * repeats) {
+      data.Write(length, code >> 6);
+      data.Write(runLength, run >> 6);
+      data.Write(8, repeats);
+      return;
+    }
+    for (int i = 0; i <= repeats; i++)
+      data.Write(length, code >> 6);
+  };
+  int symbol = values[0], repeats = 0;
+  for (size_t i = 1; i < values.size(); i++) {
+    if (values[i] == symbol && repeats < 255) {
+      repeats++;
+      continue;
+    }
+    send(symbol, repeats);
+    symbol = values[i];
+    repeats = 0;
+  }
+  send(symbol, repeats);
+  data.Flush();
+
+  int32_t header[5] = {min, max, tableLength, (int32_t)data.total, 0};
+  memcpy(out.data(), header, sizeof(header));
+}
+
+// PIZ: a bitmap of the 16-bit values present, then each channel's plane of
+// value indices, wavelet transformed and Huffman coded together
+static void PackPIZ(const EXRTestPart &part, const EXRTestChunk &chunk,
+                    const std::vector<uint8_t> &raw,
+                    std::vector<uint8_t> &dst) {
+  std::vector<uint16_t> planes(raw.size() / 2);
+  std::vector<size_t> starts, ends;
+  size_t start = 0;
+  for (const EXRTestChannel &channel : part.channels) {
+    starts.push_back(start);
+    start += (size_t)NumSamples(channel.xSampling, chunk.minX, chunk.maxX) *
+             NumSamples(channel.ySampling, chunk.minY, chunk.maxY) *
+             GetEXRSampleSize(channel) / 2;
+  }
+  ends = starts;
+  const uint8_t *src = raw.data();
+  for (int y = chunk.minY; y <= chunk.maxY; y++) {
+    for (size_t c = 0; c < part.channels.size(); c++) {
+      const EXRTestChannel &channel = part.channels[c];
+      if (FloorDiv(y, channel.ySampling) * channel.ySampling != y)
+        continue;
+      size_t bytes =
+          (size_t)NumSamples(channel.xSampling, chunk.minX, chunk.maxX) *
+          GetEXRSampleSize(channel);
+      memcpy(&planes[ends[c]], src, bytes);
+      src += bytes;
+      ends[c] += bytes / 2;
+    }
+  }
+
+  const int bitmapSize = 8192;
+  uint8_t bitmap[bitmapSize] = {};
+  for (uint16_t value : planes)
+    bitmap[value >> 3] |= (uint8_t)(1 << (value & 7));
+  bitmap[0] &= ~1; // Zero is always present
+  int minNonZero = bitmapSize - 1, maxNonZero = 0;
+  for (int i = 0; i < bitmapSize; i++) {
+    if (bitmap[i]) {
+      minNonZero = std::min(minNonZero, i);
+      maxNonZero = std::max(maxNonZero, i);
+    }
+  }
+  std::vector<uint16_t> indices(1 << 16, 0);
+  int lutSize = 0;
+  for (int i = 0; i < (1 << 16); i++) {
+    if (i == 0 || (bitmap[i >> 3] & (1 << (i & 7))))
+      indices[i] = (uint16_t)lutSize++;
+  }
+  for (uint16_t &value : planes)
+    value = indices[value];
+
+  for (size_t c = 0; c < part.channels.size(); c++) {
+    const EXRTestChannel &channel = part.channels[c];
+    int nx = NumSamples(channel.xSampling, chunk.minX, chunk.maxX);
+    int ny = NumSamples(channel.ySampling, chunk.minY, chunk.maxY);
+    int words = GetEXRSampleSize(channel) / 2;
+    for (int j = 0; j < words; j++)
+      EncodeWavelet(&planes[starts[c] + j], nx, words, ny, nx * words,
+                    (uint16_t)(lutSize - 1));
+  }
+
+  std::vector<uint8_t> huffman;
+  PackHuffman(planes, huffman);
+  dst.clear();
+  const uint8_t range[4] = {(uint8_t)minNonZero, (uint8_t)(minNonZero >> 8),
+                            (uint8_t)maxNonZero, (uint8_t)(maxNonZero >> 8)};
+  dst.insert(dst.end(), range, range + 4);
+  if (minNonZero <= maxNonZero)
+    dst.insert(dst.end(), bitmap + minNonZero, bitmap + maxNonZero + 1);
+  int32_t length = (int32_t)huffman.size();
+  dst.insert(dst.end(), (const uint8_t *)&length,
+             (const uint8_t *)&length + 4);
+  dst.insert(dst.end(), huffman.begin(), huffman.end());
+}
+
+/**
+ * @brief Writes a test EXR file: a single part, or a multi-part file for
+ * several, with each chunk packed in its part's compression unless that
+ * does not make it smaller.
+ * @param packedChunks Receives the number of chunks stored packed.
+ */
+static bool WriteTestEXR(const fs::path &path,
+                         const std::vector<EXRTestPart> &parts,
+                         int &packedChunks) {
+  bool multiPart = parts.size() > 1;
+  std::string header;
+  const int32_t magic = 20000630;
+  const int32_t version =
+      2 | (multiPart ? 0x1000 : parts[0].tileWidth ? 0x200 : 0);
+  header.append((const char *)&magic, 4);
+  header.append((const char *)&version, 4);
+
+  std::vector<std::vector<std::string>> chunks(parts.size());
+  packedChunks = 0;
+  for (size_t p = 0; p < parts.size(); p++) {
+    const EXRTestPart &part = parts[p];
+    std::vector<EXRTestChunk> rects = GetEXRTestChunks(part);
+    std::string channelList;
+    for (const EXRTestChannel &channel : part.channels) {
+      const int32_t fields[4] = {channel.type, 0, channel.xSampling,
+                                 channel.ySampling};
+      channelList.append(channel.name, strlen(channel.name) + 1);
+      channelList.append((const char *)fields, sizeof(fields));
+    }
+    channelList += '\0';
+    AppendEXRAttribute(header, "channels", "chlist", channelList.data(),
+                       (int32_t)channelList.size());
+    const uint8_t compression = (uint8_t)part.compression;
+    AppendEXRAttribute(header, "compression", "compression", &compression, 1);
+    const int32_t window[4] = {part.minX, part.minY,
+                               part.minX + part.width - 1,
+                               part.minY + part.height - 1};
+    AppendEXRAttribute(header, "dataWindow", "box2i", window, 16);
+    AppendEXRAttribute(header, "displayWindow", "box2i", window, 16);
+    const uint8_t lineOrder = 0;
+    AppendEXRAttribute(header, "lineOrder", "lineOrder", &lineOrder, 1);
+    const float aspect = 1.0f, center[2] = {0.0f, 0.0f};
+    AppendEXRAttribute(header, "pixelAspectRatio", "float", &aspect, 4);
+    AppendEXRAttribute(header, "screenWindowCenter", "v2f", center, 8);
+    AppendEXRAttribute(header, "screenWindowWidth", "float", &aspect, 4);
+    if (part.tileWidth) {
+      uint8_t tiles[9];
+      memcpy(tiles, &part.tileWidth, 4);
+      memcpy(tiles + 4, &part.tileHeight, 4);
+      tiles[8] = (uint8_t)(part.levelMode | part.roundingMode << 4);
+      AppendEXRAttribute(header, "tiles", "tiledesc", tiles, 9);
+    }
+    if (multiPart) {
+      const char *type = part.tileWidth ? "tiledimage" : "scanlineimage";
+      AppendEXRAttribute(header, "name", "string", part.name,
+                         (int32_t)strlen(part.name));
+      AppendEXRAttribute(header, "type", "string", type,
+                         (int32_t)strlen(type));
+      const int32_t chunkCount = (int32_t)rects.size();
+      AppendEXRAttribute(header, "chunkCount", "int", &chunkCount, 4);
+    }
+    header += '\0';
+
+    std::vector<uint8_t> raw, filtered, packed;
+    for (const EXRTestChunk &rect : rects) {
+      GetEXRTestChunkData(part, rect, raw);
+      switch (part.compression) {
+      case EXRRLE:
+        ApplyZipFilter(raw, filtered);
+        PackRLE(filtered, packed);
+        break;
+      case EXRZIPS:
+      case EXRZIP:
+        ApplyZipFilter(raw, filtered);
+        Deflate(filtered, packed);
+        break;
+      case EXRPIZ:
+        PackPIZ(part, rect, raw, packed);
+        break;
+      case EXRPXR24:
+        PackPXR24(part, rect, raw, packed);
+        break;
+      default:
+        packed = raw;
+        break;
+      }
+      bool usePacked = part.compression != EXRNone &&
+                       packed.size() < raw.size();
+      const std::vector<uint8_t> &data = usePacked ? packed : raw;
+      packedChunks += usePacked ? 1 : 0;
+
+      std::string chunk;
+      const int32_t partIndex = (int32_t)p;
+      if (multiPart)
+        chunk.append((const char *)&partIndex, 4);
+      if (part.tileWidth) {
+        const int32_t coordinates[4] = {rect.tileX, rect.tileY, rect.levelX,
+                                        rect.levelY};
+        chunk.append((const char *)coordinates, sizeof(coordinates));
+      } else {
+        chunk.append((const char *)&rect.minY, 4);
+      }
+      const int32_t dataSize = (int32_t)data.size();
+      chunk.append((const char *)&dataSize, 4);
+      chunk.append((const char *)data.data(), data.size());
+      chunks[p].push_back(std::move(chunk));
+    }
+  }
+  if (multiPart)
+    header += '\0';
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+    return false;
+  file.write(header.data(), (std::streamsize)header.size());
+  uint64_t offset = header.size();
+  for (const std::vector<std::string> &partChunks : chunks)
+    offset += partChunks.size() * 8;
+  for (const std::vector<std::string> &partChunks : chunks) {
+    for (const std::string &chunk : partChunks) {
+      file.write((const char *)&offset, 8);
+      offset += chunk.size();
+    }
+  }
+  for (const std::vector<std::string> &partChunks : chunks) {
+    for (const std::string &chunk : partChunks)
+      file.write(chunk.data(), (std::streamsize)chunk.size());
+  }
+  return (bool)file;
+}
+
+/**
+ * @brief Writes RGBA32F pixels as a little-endian TIFF in Deflate strips
+ * with the floating-point predictor, as image editors save HDR TIFFs.
+ */
+static bool WriteTIFF(const fs::path &path, const SyntheticImage &image) {
+  const int width = image.width, height = image.height;
+  const int rowsPerStrip = 16;
+  const size_t rowSamples = (size_t)width * 4;
+  const size_t rowBytes = rowSamples * sizeof(float);
+
+  int stripCount = (height + rowsPerStrip - 1) / rowsPerStrip;
+  std::vector<std::string> strips(stripCount);
+  ParallelFor(stripCount, 0, [&](int begin, int end) {
+    std::vector<uint8_t> raw;
+    for (int strip = begin; strip < end; strip++) {
+      int y0 = strip * rowsPerStrip;
+      int y1 = std::min(y0 + rowsPerStrip, height);
+      raw.resize(rowBytes * (y1 - y0));
+      for (int y = y0; y < y1; y++) {
+        // Byte planes, most significant first, then byte differences
+        // between neighboring pixels
+        const uint8_t *src =
+            (const uint8_t *)&image.pixels[(size_t)y * rowSamples];
+        uint8_t *row = raw.data() + rowBytes * (y - y0);
+        for (size_t i = 0; i < rowSamples; i++) {
+          for (int b = 0; b < 4; b++)
+            row[(3 - b) * rowSamples + i] = src[i * 4 + b];
+        }
+        for (size_t i = rowBytes - 1; i >= 4; i--)
+          row[i] = (uint8_t)(row[i] - row[i - 4]);
+      }
+      uLongf size = compressBound((uLong)raw.size());
+      strips[strip].resize(size);
+      compress2((Bytef *)&strips[strip][0], &size, raw.data(),
+                (uLong)raw.size(), Z_DEFAULT_COMPRESSION);
+      strips[strip].resize(size);
+    }
+  });
+
+  // Header, strips, then the offset and size arrays and the directory
+  std::string out(8, '\0');
+  auto put16 = [&out](uint16_t v) { out.append((const char *)&v, 2); };
+  auto put32 = [&out](uint32_t v) { out.append((const char *)&v, 4); };
+  std::vector<uint32_t> offsets, sizes;
+  for (const std::string &strip : strips) {
+    offsets.push_back((uint32_t)out.size());
+    sizes.push_back((uint32_t)strip.size());
+    out += strip;
+  }
+  // A single strip's offset and size are stored in their entries
+  uint32_t offsetsAt = offsets[0];
+  uint32_t sizesAt = sizes[0];
+  if (stripCount > 1) {
+    offsetsAt = (uint32_t)out.size();
+    for (uint32_t v : offsets)
+      put32(v);
+    sizesAt = (uint32_t)out.size();
+    for (uint32_t v : sizes)
+      put32(v);
+  }
+  uint32_t bitsAt = (uint32_t)out.size();
+  for (int i = 0; i < 4; i++)
+    put16(32);
+  uint32_t formatsAt = (uint32_t)out.size();
+  for (int i = 0; i < 4; i++)
+    put16(3); // IEEE float
+
+  uint32_t directory = (uint32_t)out.size();
+  const uint16_t typeShort = 3, typeLong = 4;
+  const uint32_t strips32 = (uint32_t)stripCount;
+  const struct {
+    uint16_t tag, type;
+    uint32_t count, value;
+  } entries[] = {
+      {256, typeLong, 1, (uint32_t)width},  // ImageWidth
+      {257, typeLong, 1, (uint32_t)height}, // ImageLength
+      {258, typeShort, 4, bitsAt},          // BitsPerSample
+      {259, typeShort, 1, 8},               // Compression: Deflate
+      {262, typeShort, 1, 2},               // Photometric: RGB
+      {273, typeLong, strips32, offsetsAt}, // StripOffsets
+      {277, typeShort, 1, 4},               // SamplesPerPixel
+      {278, typeLong, 1, rowsPerStrip},     // RowsPerStrip
+      {279, typeLong, strips32, sizesAt},   // StripByteCounts
+      {284, typeShort, 1, 1},               // PlanarConfig: chunky
+      {317, typeShort, 1, 3},               // Predictor: floating point
+      {338, typeShort, 1, 2},               // ExtraSamples: unassociated alpha
+      {339, typeShort, 4, formatsAt},       // SampleFormat
+  };
+  put16((uint16_t)(sizeof(entries) / sizeof(entries[0])));
+  for (const auto &entry : entries) {
+    put16(entry.tag);
+    put16(entry.type);
+    put32(entry.count);
+    // One SHORT or LONG fits in the entry; arrays are stored above
+    if (entry.type == typeShort && entry.count == 1) {
+      put16((uint16_t)entry.value);
+      put16(0);
+    } else {
+      put32(entry.value);
+    }
+  }
+  put32(0); // No next directory
+  memcpy(&out[0], "II*\0", 4);
+  memcpy(&out[4], &directory, 4);
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(out.data(), (std::streamsize)out.size());
+  return (bool)file;
+}
+
+// ---- TIFF round trip ----
+
+/**
+ * @brief Layout of a TIFF file written by WriteTestTIFF.
+ */
+struct TIFFTestCase {
+  const char *name;
+  int width;
+  int height;
+  int bits;            ///< Bits per sample: 8, 16, 32 or 64
+  int sampleFormat;    ///< 1 = unsigned, 2 = signed, 3 = float
+  int samplesPerPixel;
+  int photometric;     ///< 0 = MinIsWhite, 1 = MinIsBlack, 2 = RGB, 3 = palette
+  int compression;     ///< 1 = none, 5 = LZW, 8 = Deflate, 32773 = PackBits
+  int predictor;       ///< 1 = none, 2 = horizontal, 3 = floating point
+  bool planar;
+  int tileSize;        ///< 0 = strips
+  int rowsPerStrip;
+  bool bigEndian;
+  bool bigTIFF;
+};
+
+// Samples of a test image in native byte order, chunky. Values repeat over
+// four pixels so that PackBits and LZW find runs.
+static std::vector<uint8_t> GetTIFFTestSamples(const TIFFTestCase &c) {
+  const int bytes = c.bits / 8;
+  const size_t count = (size_t)c.width * c.height * c.samplesPerPixel;
+  std::vector<uint8_t> samples(count * bytes);
+  for (size_t i = 0; i < count; i++) {
+    size_t pixel = i / c.samplesPerPixel;
+    size_t x = pixel % c.width, y = pixel / c.width;
+    uint32_t h = Hash((uint32_t)(((y * c.width + x / 4) * c.samplesPerPixel +
+                                  i % c.samplesPerPixel) *
+                                 2654435761u));
+    uint8_t *dst = &samples[i * bytes];
+    if (c.sampleFormat != 3) {
+      uint64_t value = (uint64_t)h << 32 | Hash(h);
+      memcpy(dst, &value, bytes);
+      continue;
+    }
+    // Signed values over 16 stops
+    float value = ((float)(h & 0xffff) / 65535.0f * 2.0f - 1.0f) *
+                  std::ldexp(1.0f, (int)(h >> 16) % 16 - 8);
+    if (c.bits == 16) {
+      uint16_t half = FloatToHalf(value);
+      memcpy(dst, &half, 2);
+    } else if (c.bits == 32) {
+      memcpy(dst, &value, 4);
+    } else {
+      double wide = value + (double)Hash(h) * 1e-12;
+      memcpy(dst, &wide, 8);
+    }
+  }
+  return samples;
+}
+
+// Colors of the test palette, R then G then B
+static std::vector<uint16_t> GetTIFFTestPalette(int bits) {
+  std::vector<uint16_t> colorMap((size_t)3 << bits);
+  for (size_t i = 0; i < colorMap.size(); i++)
+    colorMap[i] = (uint16_t)Hash((uint32_t)i + 77);
+  return colorMap;
+}
+
+// TIFF PackBits: a count n >= 0 copies the next n + 1 bytes, -n repeats the
+// next byte 1 + n times and -128 is skipped
+static void PackBits(const std::vector<uint8_t> &src,
+                     std::vector<uint8_t> &dst) {
+  // Writers may pad with the no-op code
+  dst.assign(1, 0x80);
+  size_t i = 0;
+  while (i < src.size()) {
+    size_t run = 1;
+    while (i + run < src.size() && src[i + run] == src[i] && run < 128)
+      run++;
+    if (run >= 3) {
+      dst.push_back((uint8_t)(1 - (int)run));
+      dst.push_back(src[i]);
+      i += run;
+      continue;
+    }
+    size_t end = i;
+    while (end < src.size() && end - i < 128 &&
+           !(end + 2 < src.size() && src[end] == src[end + 1] &&
+             src[end] == src[end + 2]))
+      end++;
+    dst.push_back((uint8_t)(end - i - 1));
+    dst.insert(dst.end(), src.begin() + i, src.begin() + end);
+    i = end;
+  }
+}
+
+// TIFF LZW: MSB-first codes that widen one code earlier than GIF's. The
+// table is cleared before it fills up.
+static void PackTIFFLZW(const std::vector<uint8_t> &src,
+                        std::vector<uint8_t> &dst) {
+  const int clearCode = 256, endCode = 257;
+  std::unordered_map<uint32_t, uint16_t> table; // Prefix << 8 | byte
+  uint32_t bits = 0;
+  int bitCount = 0;
+  int codeSize = 9;
+  int nextCode = endCode + 1;
+  dst.clear();
+  auto put = [&](int code) {
+    bits = bits << codeSize | (uint32_t)code;
+    bitCount += codeSize;
+    for (; bitCount >= 8; bitCount -= 8)
+      dst.push_back((uint8_t)(bits >> (bitCount - 8)));
+  };
+
+  put(clearCode);
+  int prefix = src[0];
+  for (size_t i = 1; i < src.size(); i++) {
+    uint32_t key = (uint32_t)prefix << 8 | src[i];
+    auto it = table.find(key);
+    if (it != table.end()) {
+      prefix = it->second;
+      continue;
+    }
+    put(prefix);
+    if (nextCode < 4093) {
+      table.emplace(key, (uint16_t)nextCode++);
+      if (nextCode >= (1 << codeSize) && codeSize < 12)
+        codeSize++;
+    } else {
+      put(clearCode);
+      table.clear();
+      codeSize = 9;
+      nextCode = endCode + 1;
+    }
+    prefix = src[i];
+  }
+  put(prefix);
+  put(endCode);
+  if (bitCount > 0)
+    dst.push_back((uint8_t)(bits << (8 - bitCount)));
+}
+
+template <typename T> static void ApplyHorizontal(uint8_t *row, size_t count,
+                                                  int stride) {
+  T *samples = (T *)row;
+  for (size_t i = count; i-- > (size_t)stride;)
+    samples[i] = (T)(samples[i] - samples[i - stride]);
+}
+
+// Appends values of 2, 4 or 8 bytes in the byte order of the file
+static void PutTIFF(std::vector<uint8_t> &out, uint64_t value, int size,
+                    bool bigEndian) {
+  for (int i = 0; i < size; i++) {
+    int shift = 8 * (bigEndian ? size - 1 - i : i);
+    out.push_back((uint8_t)(value >> shift));
+  }
+}
+
+/**
+ * @brief Writes samples from GetTIFFTestSamples in the layout of a test
+ * case: strips or tiles, chunky or planar, with its predictor, compression
+ * and byte order, as a classic or BigTIFF file.
+ */
+static bool WriteTestTIFF(const fs::path &path, const TIFFTestCase &c,
+                          const std::vector<uint8_t> &samples) {
+  const int bytes = c.bits / 8;
+  const int spp = c.samplesPerPixel;
+  const int planes = c.planar ? spp : 1;
+  const int chunkSamples = c.planar ? 1 : spp;
+  const int chunkWidth = c.tileSize ? c.tileSize : c.width;
+  const int chunkHeight = c.tileSize ? c.tileSize : c.rowsPerStrip;
+  const int across = (c.width + chunkWidth - 1) / chunkWidth;
+  const int down = (c.height + chunkHeight - 1) / chunkHeight;
+  const size_t rowSamples = (size_t)chunkWidth * chunkSamples;
+  const size_t rowBytes = rowSamples * bytes;
+
+  std::vector<uint8_t> out(c.bigTIFF ? 16 : 8);
+  std::vector<uint64_t> offsets, byteCounts;
+  std::vector<uint8_t> raw, temp, packed;
+  for (int plane = 0; plane < planes; plane++) {
+    for (int chunk = 0; chunk < across * down; chunk++) {
+      int x0 = chunk % across * chunkWidth;
+      int y0 = chunk / across * chunkHeight;
+      // Tiles are whole, padded with zeros; the last strip is cut short
+      int rows = c.tileSize ? chunkHeight
+                            : std::min(chunkHeight, c.height - y0);
+      raw.assign(rowBytes * rows, 0);
+      for (int y = 0; y < rows && y0 + y < c.height; y++) {
+        uint8_t *row = &raw[rowBytes * y];
+        for (int x = 0; x < chunkWidth && x0 + x < c.width; x++) {
+          size_t pixel = (size_t)(y0 + y) * c.width + x0 + x;
+          for (int s = 0; s < chunkSamples; s++) {
+            size_t sample = pixel * spp + (c.planar ? plane : s);
+            memcpy(row + ((size_t)x * chunkSamples + s) * bytes,
+                   &samples[sample * bytes], bytes);
+          }
+        }
+        if (c.predictor == 2) {
+          if (bytes == 1)
+            ApplyHorizontal<uint8_t>(row, rowSamples, chunkSamples);
+          else if (bytes == 2)
+            ApplyHorizontal<uint16_t>(row, rowSamples, chunkSamples);
+          else if (bytes == 4)
+            ApplyHorizontal<uint32_t>(row, rowSamples, chunkSamples);
+          else
+            ApplyHorizontal<uint64_t>(row, rowSamples, chunkSamples);
+        } else if (c.predictor == 3) {
+          // Byte planes, most significant first, whatever the byte order
+          temp.assign(row, row + rowBytes);
+          for (size_t i = 0; i < rowSamples; i++) {
+            for (int b = 0; b < bytes; b++)
+              row[(bytes - 1 - b) * rowSamples + i] = temp[i * bytes + b];
+          }
+          for (size_t i = rowBytes; i-- > (size_t)chunkSamples;)
+            row[i] = (uint8_t)(row[i] - row[i - chunkSamples]);
+        }
+      }
+      if (c.bigEndian && c.predictor != 3) {
+        for (size_t i = 0; i + bytes <= raw.size(); i += bytes)
+          std::reverse(raw.begin() + i, raw.begin() + i + bytes);
+      }
+
+      if (c.compression == 5)
+        PackTIFFLZW(raw, packed);
+      else if (c.compression == 8)
+        Deflate(raw, packed);
+      else if (c.compression == 32773)
+        PackBits(raw, packed);
+      else
+        packed = raw;
+      offsets.push_back(out.size());
+      byteCounts.push_back(packed.size());
+      out.insert(out.end(), packed.begin(), packed.end());
+      if (out.size() & 1)
+        out.push_back(0); // Word alignment
+    }
+  }
+
+  // Directory entries in tag order; arrays that do not fit in an entry
+  // are stored before the directory
+  const uint16_t typeShort = 3, typeLong = 4, typeLong8 = 16;
+  const uint16_t typeOffset = c.bigTIFF ? typeLong8 : typeLong;
+  struct Entry {
+    uint16_t tag;
+    uint16_t type;
+    std::vector<uint64_t> values;
+  };
+  std::vector<Entry> entries = {
+      {256, typeLong, {(uint64_t)c.width}},
+      {257, typeLong, {(uint64_t)c.height}},
+      {258, typeShort, std::vector<uint64_t>(spp, c.bits)},
+      {259, typeShort, {(uint64_t)c.compression}},
+      {262, typeShort, {(uint64_t)c.photometric}},
+  };
+  if (!c.tileSize)
+    entries.push_back({273, typeOffset, offsets});
+  entries.push_back({277, typeShort, {(uint64_t)spp}});
+  if (!c.tileSize) {
+    entries.push_back({278, typeLong, {(uint64_t)c.rowsPerStrip}});
+    entries.push_back({279, typeOffset, byteCounts});
+  }
+  entries.push_back({284, typeShort, {c.planar ? 2u : 1u}});
+  if (c.predictor != 1)
+    entries.push_back({317, typeShort, {(uint64_t)c.predictor}});
+  if (c.photometric == 3) {
+    std::vector<uint16_t> colorMap = GetTIFFTestPalette(c.bits);
+    entries.push_back(
+        {320, typeShort, std::vector<uint64_t>(colorMap.begin(),
+                                               colorMap.end())});
+  }
+  if (c.tileSize) {
+    entries.push_back({322, typeShort, {(uint64_t)c.tileSize}});
+    entries.push_back({323, typeShort, {(uint64_t)c.tileSize}});
+    entries.push_back({324, typeOffset, offsets});
+    entries.push_back({325, typeOffset, byteCounts});
+  }
+  int colors = c.photometric == 2 ? 3 : 1;
+  if (spp > colors) {
+    // Unassociated alpha, then unspecified samples
+    std::vector<uint64_t> extra(spp - colors, 0);
+    extra[0] = 2;
+    entries.push_back({338, typeShort, extra});
+  }
+  entries.push_back(
+      {339, typeShort, std::vector<uint64_t>(spp, c.sampleFormat)});
+
+  const size_t inlineSize = c.bigTIFF ? 8 : 4;
+  std::vector<std::vector<uint8_t>> fields;
+  for (const Entry &entry : entries) {
+    int size = entry.type == typeShort ? 2 : entry.type == typeLong ? 4 : 8;
+    std::vector<uint8_t> field;
+    for (uint64_t value : entry.values)
+      PutTIFF(field, value, size, c.bigEndian);
+    if (field.size() > inlineSize) {
+      uint64_t at = out.size();
+      out.insert(out.end(), field.begin(), field.end());
+      field.clear();
+      PutTIFF(field, at, (int)inlineSize, c.bigEndian);
+    }
+    field.resize(inlineSize, 0);
+    fields.push_back(field);
+  }
+
+  uint64_t directory = out.size();
+  PutTIFF(out, entries.size(), c.bigTIFF ? 8 : 2, c.bigEndian);
+  for (size_t i = 0; i < entries.size(); i++) {
+    PutTIFF(out, entries[i].tag, 2, c.bigEndian);
+    PutTIFF(out, entries[i].type, 2, c.bigEndian);
+    PutTIFF(out, entries[i].values.size(), c.bigTIFF ? 8 : 4, c.bigEndian);
+    out.insert(out.end(), fields[i].begin(), fields[i].end());
+  }
+  PutTIFF(out, 0, (int)inlineSize, c.bigEndian); // No next directory
+
+  std::vector<uint8_t> header;
+  header.push_back(c.bigEndian ? 'M' : 'I');
+  header.push_back(c.bigEndian ? 'M' : 'I');
+  PutTIFF(header, c.bigTIFF ? 43 : 42, 2, c.bigEndian);
+  if (c.bigTIFF) {
+    PutTIFF(header, 8, 2, c.bigEndian); // Offset size
+    PutTIFF(header, 0, 2, c.bigEndian);
+  }
+  PutTIFF(header, directory, (int)inlineSize, c.bigEndian);
+  std::copy(header.begin(), header.end(), out.begin());
+
+  std::ofstream file(path, std::ios::binary);
+  file.write((const char *)out.data(), (std::streamsize)out.size());
+  return (bool)file;
+}
+
+// Appends palette indices as GIF LZW data with 8-bit roots, in sub-blocks.
+// The code table is cleared whenever it fills up.
+static void AppendGIFLZW(std::string &out,
+                         const std::vector<uint8_t> &indices) {
+  const int clearCode = 256, endCode = 257;
+  std::unordered_map<uint32_t, uint16_t> table; // Prefix << 8 | index
+  std::string packed;
+  uint32_t bits = 0;
+  int bitCount = 0;
+  int codeSize = 9;
+  int nextCode = endCode + 1;
+  auto put = [&](int code) {
+    bits |= (uint32_t)code << bitCount;
+    bitCount += codeSize;
+    for (; bitCount >= 8; bitCount -= 8, bits >>= 8)
+      packed += (char)(bits & 0xFF);
+  };
+
+  put(clearCode);
+  int prefix = indices[0];
+  for (size_t i = 1; i < indices.size(); i++) {
+    uint32_t key = (uint32_t)prefix << 8 | indices[i];
+    auto it = table.find(key);
+    if (it != table.end()) {
+      prefix = it->second;
+      continue;
+    }
+    put(prefix);
+    if (nextCode < 4096) {
+      // The decoder adds this code one code later, hence the ">"
+      table.emplace(key, (uint16_t)nextCode++);
+      if (nextCode > (1 << codeSize) && codeSize < 12)
+        codeSize++;
+    } else {
+      put(clearCode);
+      table.clear();
+      codeSize = 9;
+      nextCode = endCode + 1;
+    }
+    prefix = indices[i];
+  }
+  put(prefix);
+  put(endCode);
+  if (bitCount > 0)
+    packed += (char)bits;
+
+  out += (char)8;
+  for (size_t pos = 0; pos < packed.size(); pos += 255) {
+    size_t length = std::min<size_t>(255, packed.size() - pos);
+    out += (char)length;
+    out.append(packed, pos, length);
+  }
+  out += '\0';
+}
+
+// Frames of the animated GIF, enough for reverse decoding to restart from
+// saved canvases
+static const int g_GIFFrames = 40;
+
+/**
+ * @brief Writes an animated GIF: the image in a 6x7x6 color cube, then
+ * frames that each redraw a sixteenth of the canvas, as screen captures do.
+ */
+static bool WriteGIF(const fs::path &path,
+                     const std::vector<unsigned char> &rgba, int width,
+                     int height, int frameCount) {
+  auto index = [&](int x, int y) {
+    const unsigned char *p = &rgba[((size_t)y * width + x) * 4];
+    return (uint8_t)((p[0] * 6 / 256) * 42 + (p[1] * 7 / 256) * 6 +
+                     p[2] * 6 / 256);
+  };
+
+  std::string out = "GIF89a";
+  const uint16_t size[2] = {(uint16_t)width, (uint16_t)height};
+  out.append((const char *)size, 4);
+  out += (char)0xF7; // 256 color global table
+  out.append(2, '\0');
+  for (int i = 0; i < 256; i++) {
+    int r = i / 42 % 6, g = i / 6 % 7, b = i % 6;
+    out += (char)(r * 51);
+    out += (char)(g * 42);
+    out += (char)(b * 51);
+  }
+
+  std::vector<uint8_t> indices;
+  for (int frame = 0; frame < frameCount; frame++) {
+    int w = frame == 0 ? width : width / 4;
+    int h = frame == 0 ? height : height / 4;
+    int left = frame == 0 ? 0 : frame * width / 8 % (width - w);
+    int top = frame == 0 ? 0 : frame * height / 8 % (height - h);
+
+    // Disposal 1 (keep), 40 ms
+    const char control[] = {0x21, (char)0xF9, 4, 1 << 2, 4, 0, 0, 0};
+    out.append(control, sizeof(control));
+    out += (char)0x2C;
+    const uint16_t rect[4] = {(uint16_t)left, (uint16_t)top, (uint16_t)w,
+                              (uint16_t)h};
+    out.append((const char *)rect, 8);
+    out += '\0';
+
+    // Each frame shows the image shifted a little further
+    indices.resize((size_t)w * h);
+    for (int y = 0; y < h; y++)
+      for (int x = 0; x < w; x++)
+        indices[(size_t)y * w + x] =
+            index((left + x + frame) % width, (top + y) % height);
+    AppendGIFLZW(out, indices);
+  }
+  out += (char)0x3B;
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(out.data(), (std::streamsize)out.size());
+  return (bool)file;
+}
+
+// One frame of a GIF compositing test
+struct GIFTestFrame {
+  int left, top, width, height;
+  int disposal;    ///< 1 = keep, 2 = clear to transparent, 3 = restore
+  int transparent; ///< Transparent palette index; -1 = none
+  bool interlaced;
+  bool localPalette; ///< Reversed color cube as a local color table
+  std::vector<uint8_t> indices; ///< Rows top to bottom
+};
+
+// Color of a palette index in the color cube of the test GIFs, or in the
+// reversed cube of their local color tables
+static void GetGIFTestColor(int index, bool reversed, uint8_t rgb[3]) {
+  if (reversed)
+    index = 255 - index;
+  rgb[0] = (uint8_t)(index / 42 % 6 * 51);
+  rgb[1] = (uint8_t)(index / 6 % 7 * 42);
+  rgb[2] = (uint8_t)(index % 6 * 51);
+}
+
+// Writes frames over a canvas with the color cube as the global table.
+// Interlaced frames are stored in pass order.
+static bool WriteTestGIF(const fs::path &path, int width, int height,
+                         const std::vector<GIFTestFrame> &frames) {
+  auto appendPalette = [](std::string &out, bool reversed) {
+    for (int i = 0; i < 256; i++) {
+      uint8_t rgb[3];
+      GetGIFTestColor(i, reversed, rgb);
+      out.append((const char *)rgb, 3);
+    }
+  };
+
+  std::string out = "GIF89a";
+  const uint16_t size[2] = {(uint16_t)width, (uint16_t)height};
+  out.append((const char *)size, 4);
+  out += (char)0xF7; // 256 color global table
+  out.append(2, '\0');
+  appendPalette(out, false);
+
+  std::vector<uint8_t> indices;
+  for (const GIFTestFrame &frame : frames) {
+    const char control[] = {0x21,
+                            (char)0xF9,
+                            4,
+                            (char)(frame.disposal << 2 |
+                                   (frame.transparent >= 0 ? 1 : 0)),
+                            4,
+                            0,
+                            (char)std::max(frame.transparent, 0),
+                            0};
+    out.append(control, sizeof(control));
+    out += (char)0x2C;
+    const uint16_t rect[4] = {(uint16_t)frame.left, (uint16_t)frame.top,
+                              (uint16_t)frame.width, (uint16_t)frame.height};
+    out.append((const char *)rect, 8);
+    out += (char)((frame.interlaced ? 0x40 : 0) |
+                  (frame.localPalette ? 0x87 : 0));
+    if (frame.localPalette)
+      appendPalette(out, true);
+
+    indices.clear();
+    static const int s_PassStart[] = {0, 4, 2, 1};
+    static const int s_PassStep[] = {8, 8, 4, 2};
+    for (int pass = 0; pass < (frame.interlaced ? 4 : 1); pass++) {
+      int start = frame.interlaced ? s_PassStart[pass] : 0;
+      int step = frame.interlaced ? s_PassStep[pass] : 1;
+      for (int y = start; y < frame.height; y += step)
+        indices.insert(indices.end(),
+                       frame.indices.begin() + (size_t)y * frame.width,
+                       frame.indices.begin() + (size_t)(y + 1) * frame.width);
+    }
+    AppendGIFLZW(out, indices);
+  }
+  out += (char)0x3B;
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(out.data(), (std::streamsize)out.size());
+  return (bool)file;
+}
+
+static inline uint16_t ToRGB565(const unsigned char *rgb) {
+  return (uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) |
+                    (rgb[2] >> 3));
+}
+
+// Minimal BC1 encoder: luma-extreme endpoints, nearest palette entry. Quality
+// does not matter here, only that the decoder sees realistic blocks.
+static std::vector<unsigned char> EncodeBC1(const std::vector<unsigned char> &rgba,
+                                            int width, int height,
+                                            int threadCount) {
+  int blocksX = width / 4;
+  int blocksY = height / 4;
+  std::vector<unsigned char> blocks((size_t)blocksX * blocksY * 8);
+
+  ParallelFor(blocksY, threadCount, [&](int byBegin, int byEnd) {
+    for (int by = byBegin; by < byEnd; by++) {
+      for (int bx = 0; bx < blocksX; bx++) {
+        const unsigned char *texels[16];
+        int minLuma = INT32_MAX, maxLuma = -1;
+        int minIndex = 0, maxIndex = 0;
+        for (int i = 0; i < 16; i++) {
+          int x = bx * 4 + (i & 3);
+          int y = by * 4 + (i >> 2);
+          texels[i] = &rgba[((size_t)y * width + x) * 4];
+          int luma = texels[i][0] * 2 + texels[i][1] * 4 + texels[i][2];
+          if (luma < minLuma) {
+            minLuma = luma;
+            minIndex = i;
+          }
+          if (luma > maxLuma) {
+            maxLuma = luma;
+            maxIndex = i;
+          }
+        }
+
+        uint16_t color0 = ToRGB565(texels[maxIndex]);
+        uint16_t color1 = ToRGB565(texels[minIndex]);
+        int luma0 = maxLuma, luma1 = minLuma;
+        if (color0 < color1) {
+          std::swap(color0, color1);
+          std::swap(luma0, luma1);
+        }
+
+        // Four-color mode (color0 > color1); equal endpoints use index 0
+        uint32_t indices = 0;
+        if (color0 != color1 && luma0 != luma1) {
+          // Palette order: color0, color1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+          static const int s_StepToIndex[4] = {1, 3, 2, 0};
+          for (int i = 0; i < 16; i++) {
+            int luma = texels[i][0] * 2 + texels[i][1] * 4 + texels[i][2];
+            float t = (float)(luma - luma1) / (float)(luma0 - luma1);
+            int step = std::min(3, std::max(0, (int)(t * 3.0f + 0.5f)));
+            indices |= (uint32_t)s_StepToIndex[step] << (i * 2);
+          }
+        }
+
+        unsigned char *block =
+            &blocks[((size_t)by * blocksX + bx) * 8];
+        memcpy(block, &color0, 2);
+        memcpy(block + 2, &color1, 2);
+        memcpy(block + 4, &indices, 4);
+      }
+    }
+  });
+  return blocks;
+}
+
+// ---- Timing ----
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Runs fn iterations times and returns the median duration in seconds.
+ * @return A negative value if any run failed.
+ */
+static double TimeMedian(int iterations, const std::function<bool()> &fn) {
+  std::vector<double> times;
+  for (int i = 0; i < iterations; i++) {
+    auto start = Clock::now();
+    bool ok = fn();
+    auto end = Clock::now();
+    if (!ok)
+      return -1.0;
+    times.push_back(std::chrono::duration<double>(end - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+// ---- JSON ----
+
+static void WriteResults(std::ostream &out,
+                         const std::vector<BenchResult> &results) {
+  // One result per line, so the baseline reader can stay line based
+  out << "{\n  \"hardwareThreads\": " << GetDefaultThreadCount()
+      << ",\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    char line[512];
+    snprintf(line, sizeof(line),
+             "    {\"name\": \"%s\", \"stage\": \"%s\", \"format\": \"%s\", "
+             "\"content\": \"%s\", \"megapixels\": %d, \"threads\": %d, "
+             "\"seconds\": %.6f, \"mpixPerSec\": %.3f}%s\n",
+             r.name.c_str(), r.stage.c_str(), r.format.c_str(),
+             r.content.c_str(), r.megapixels, r.threads, r.seconds,
+             r.mpixPerSec, i + 1 < results.size() ? "," : "");
+    out << line;
+  }
+  out << "  ]\n}\n";
+}
+
+// ---- Benchmarks ----
+
+namespace {
+struct EncodedFile {
+  std::string format; ///< Short name used in result keys
+  Content content;
+  fs::path path;
+  RawImageLayout layout; ///< Pixel layout of .raw files
+};
+} // namespace
+
+static std::vector<EncodedFile> EncodeFiles(const SyntheticImage &ldr,
+                                            const SyntheticImage &hdr,
+                                            const SyntheticImage &nan,
+                                            const fs::path &dir,
+                                            int megapixels, int threadCount) {
+  std::vector<EncodedFile> files;
+  std::string prefix = "bench_" + std::to_string(megapixels) + "mp_";
+  std::vector<unsigned char> rgba8 = ToRGBA8(ldr);
+  int w = ldr.width, h = ldr.height;
+
+  // Writes one file with the given writer and records it on success
+  auto add = [&](const char *format, Content content, const char *ext,
+                 const std::function<bool(const std::string &)> &write) {
+    fs::path path = dir / (prefix + format + "_" + GetContentName(content) +
+                           "." + ext);
+    if (write(path.u8string()))
+      files.push_back({format, content, path, RawImageLayout()});
+    else
+      std::cerr << "Failed to write " << path.string() << "\n";
+  };
+
+  add("png", Content::LDR, "png", [&](const std::string &path) {
+    return stbi_write_png(path.c_str(), w, h, 4, rgba8.data(), w * 4) != 0;
+  });
+  add("jpg", Content::LDR, "jpg", [&](const std::string &path) {
+    return stbi_write_jpg(path.c_str(), w, h, 4, rgba8.data(), 90) != 0;
+  });
+  add("bmp", Content::LDR, "bmp", [&](const std::string &path) {
+    return stbi_write_bmp(path.c_str(), w, h, 4, rgba8.data()) != 0;
+  });
+  add("tga", Content::LDR, "tga", [&](const std::string &path) {
+    return stbi_write_tga(path.c_str(), w, h, 4, rgba8.data()) != 0;
+  });
+  add("hdr", Content::HDR, "hdr", [&](const std::string &path) {
+    return stbi_write_hdr(path.c_str(), hdr.width, hdr.height, 4,
+                          hdr.pixels.data()) != 0;
+  });
+
+  add("dds-rgba8", Content::LDR, "dds", [&](const std::string &path) {
+    return WriteDDS(fs::u8path(path), g_DxgiRGBA8, w, h, false, rgba8.data(),
+                    rgba8.size());
+  });
+  std::vector<unsigned char> bc1 = EncodeBC1(rgba8, w, h, threadCount);
+  add("dds-bc1", Content::LDR, "dds", [&](const std::string &path) {
+    return WriteDDS(fs::u8path(path), g_DxgiBC1, w, h, true, bc1.data(),
+                    bc1.size());
+  });
+  add("dds-rgba32f", Content::HDR, "dds", [&](const std::string &path) {
+    return WriteDDS(fs::u8path(path), g_DxgiRGBA32F, hdr.width, hdr.height,
+                    false, hdr.pixels.data(),
+                    hdr.pixels.size() * sizeof(float));
+  });
+  std::vector<uint16_t> hdrHalf = ToHalf(hdr);
+  add("dds-rgba16f", Content::HDR, "dds", [&](const std::string &path) {
+    return WriteDDS(fs::u8path(path), g_DxgiRGBA16F, hdr.width, hdr.height,
+                    false, hdrHalf.data(), hdrHalf.size() * sizeof(uint16_t));
+  });
+  add("exr-zip", Content::HDR, "exr", [&](const std::string &path) {
+    return WriteEXR(fs::u8path(path), hdrHalf, hdr.width, hdr.height);
+  });
+  add("tiff-float", Content::HDR, "tif", [&](const std::string &path) {
+    return WriteTIFF(fs::u8path(path), hdr);
+  });
+  add("gif-anim", Content::LDR, "gif", [&](const std::string &path) {
+    return WriteGIF(fs::u8path(path), rgba8, w, h, g_GIFFrames);
+  });
+  add("dds-rgba32f", Content::HDRWithNaN, "dds", [&](const std::string &path) {
+    return WriteDDS(fs::u8path(path), g_DxgiRGBA32F, nan.width, nan.height,
+                    false, nan.pixels.data(),
+                    nan.pixels.size() * sizeof(float));
+  });
+
+  // Mapped in place: these measure header parsing and mapping only
+  add("pfm", Content::HDR, "pfm", [&](const std::string &path) {
+    return WritePFM(fs::u8path(path), hdr);
+  });
+  add("raw-rgba32f", Content::HDR, "raw", [&](const std::string &path) {
+    std::ofstream file(fs::u8path(path), std::ios::binary);
+    file.write((const char *)hdr.pixels.data(),
+               (std::streamsize)(hdr.pixels.size() * sizeof(float)));
+    return (bool)file;
+  });
+  if (!files.empty() && files.back().path.extension() == ".raw") {
+    RawImageLayout &layout = files.back().layout;
+    layout.width = hdr.width;
+    layout.height = hdr.height;
+    layout.format = PixelFormat::RGBA32F;
+  }
+  return files;
+}
+
+static void AddResult(std::vector<BenchResult> &results, const char *stage,
+                      const std::string &format, Content content,
+                      int megapixels, int threads, double seconds,
+                      size_t pixelCount) {
+  BenchResult r;
+  r.stage = stage;
+  r.format = format;
+  r.content = GetContentName(content);
+  r.megapixels = megapixels;
+  r.threads = threads;
+  r.seconds = seconds;
+  r.mpixPerSec = seconds > 0.0 ? (double)pixelCount / seconds / 1e6 : 0.0;
+  r.name = r.stage + "/" + r.format + "/" + r.content + "/" +
+           std::to_string(megapixels) + "MP";
+  if (threads > 0)
+    r.name += "/t" + std::to_string(threads);
+
+  printf("%-40s %10.2f ms %10.1f MPix/s\n", r.name.c_str(), seconds * 1000.0,
+         r.mpixPerSec);
+  results.push_back(r);
+}
+
+static void BenchDecoders(const std::vector<EncodedFile> &files,
+                          int megapixels, int iterations,
+                          std::vector<BenchResult> &results) {
+  for (const EncodedFile &file : files) {
+    ImgViewer viewer;
+    std::string path = file.path.u8string();
+    size_t pixelCount = 0;
+
+    double seconds = TimeMedian(iterations, [&]() {
+      viewer.Clear();
+      bool ok;
+      if (file.path.extension() == ".dds")
+        ok = viewer.LoadDDS(path);
+      else if (file.path.extension() == ".jpg")
+        ok = viewer.LoadJpeg(path);
+      else if (file.path.extension() == ".exr")
+        ok = viewer.LoadEXR(path);
+      else if (file.path.extension() == ".gif")
+        ok = viewer.LoadGIF(path);
+      else if (file.path.extension() == ".tif")
+        ok = viewer.LoadTIFF(path);
+      else if (file.path.extension() == ".hdr")
+        ok = viewer.LoadHDR(path);
+      else if (file.path.extension() == ".bmp")
+        ok = viewer.LoadBMP(path);
+      else if (file.path.extension() == ".pfm")
+        ok = viewer.LoadPortableMap(path);
+      else if (file.path.extension() == ".raw")
+        ok = viewer.LoadRaw(path, file.layout);
+      else
+        ok = viewer.LoadSTB(path);
+      const ImageData &data = viewer.GetImageData();
+      pixelCount = (size_t)data.width * data.height;
+      return ok;
+    });
+
+    if (seconds < 0.0) {
+      std::cerr << "Decoding " << path << " failed\n";
+      continue;
+    }
+    AddResult(results, "decode", file.format, file.content, megapixels, 0,
+              seconds, pixelCount);
+
+    // Header-only probes are too short to time one at a time
+    const int probeRuns = 100;
+    seconds = TimeMedian(iterations, [&]() {
+      ImageProbe probe;
+      bool ok = true;
+      for (int i = 0; i < probeRuns && ok; i++)
+        ok = ProbeImageFile(path, probe);
+      return ok;
+    });
+    if (seconds >= 0.0)
+      AddResult(results, "probe", file.format, file.content, megapixels, 0,
+                seconds / probeRuns, pixelCount);
+  }
+}
+
+static void BenchKernels(const SyntheticImage &image, Content content,
+                         int megapixels, const std::vector<int> &threadCounts,
+                         int iterations, std::vector<BenchResult> &results) {
+  size_t pixelCount = (size_t)image.width * image.height;
+  std::vector<int> histR(256), histG(256), histB(256);
+  std::vector<uint16_t> half = ToHalf(image);
+  PixelBuffer halfBuffer;
+  halfBuffer.format = PixelFormat::RGBA16F;
+  halfBuffer.width = image.width;
+  halfBuffer.height = image.height;
+  halfBuffer.data = reinterpret_cast<const uint8_t *>(half.data());
+  halfBuffer.rowPitch = (ptrdiff_t)image.width * 4 * sizeof(uint16_t);
+
+  for (int threads : threadCounts) {
+    ValueRange range;
+    double seconds = TimeMedian(iterations, [&]() {
+      range = ComputeValueRange(image.pixels.data(), pixelCount, ChannelRGBA,
+                                threads);
+      return range.valid;
+    });
+    AddResult(results, "range", "rgba32f", content, megapixels, threads,
+              seconds, pixelCount);
+
+    // Same parameters as ImgViewerUI::UpdateHistogram
+    seconds = TimeMedian(iterations, [&]() {
+      ComputeHistogram(image.pixels.data(), pixelCount, range.minValue,
+                       range.maxValue, 256, histR.data(), histG.data(),
+                       histB.data(), threads);
+      return true;
+    });
+    AddResult(results, "histogram", "rgba32f", content, megapixels, threads,
+              seconds, pixelCount);
+
+    // RGBA16F images are widened block by block inside the kernels
+    seconds = TimeMedian(iterations, [&]() {
+      range = ComputeValueRange(halfBuffer, ChannelRGBA, threads);
+      return range.valid;
+    });
+    AddResult(results, "range", "rgba16f", content, megapixels, threads,
+              seconds, pixelCount);
+
+    seconds = TimeMedian(iterations, [&]() {
+      ComputeHistogram(halfBuffer, range.minValue, range.maxValue, 256,
+                       histR.data(), histG.data(), histB.data(), threads);
+      return true;
+    });
+    AddResult(results, "histogram", "rgba16f", content, megapixels, threads,
+              seconds, pixelCount);
+  }
+}
+
+// Range analysis of the packed render target formats, which unpacks every
+// pixel from its stored word, and of integer formats, scanned as integers
+static void BenchPackedRange(int megapixels,
+                             const std::vector<int> &threadCounts,
+                             int iterations, std::vector<BenchResult> &results) {
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0);
+  size_t pixelCount = (size_t)side * side;
+  for (PixelFormat format :
+       {PixelFormat::R11G11B10F, PixelFormat::RGB10A2, PixelFormat::RGB9E5,
+        PixelFormat::B5G6R5, PixelFormat::R32UI, PixelFormat::RGBA8UI,
+        PixelFormat::RG16I}) {
+    uint8_t *dst;
+    PixelBuffer buffer = AllocatePixelBuffer(format, side, side, dst);
+    for (size_t i = 0; i < buffer.GetByteSize(); i++)
+      dst[i] = (uint8_t)Hash((uint32_t)i * 0x9e3779b9u + (uint32_t)format);
+    std::string name = GetPixelFormatInfo(format).name;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    for (int threads : threadCounts) {
+      double seconds = TimeMedian(iterations, [&]() {
+        return ComputeValueRange(buffer, ChannelRGBA, threads).valid;
+      });
+      AddResult(results, "range", name, Content::Random, megapixels, threads,
+                seconds, pixelCount);
+    }
+  }
+}
+
+// Distance a projection with these settings writes a depth for, in the
+// textbook form of each projection
+static double GetDepthDistance(double depth, const DepthSettings &settings) {
+  double n = settings.nearPlane;
+  double f = settings.farPlane;
+  if (settings.infiniteFar)
+    return settings.reverseZ ? n / depth : n / (1.0 - depth);
+  return settings.reverseZ ? n * f / (n + depth * (f - n))
+                           : n * f / (f - depth * (f - n));
+}
+
+// Linearizes depth from 0 to 1 for standard and reverse-Z projections, with
+// and without a far plane, and compares it with the closed form. Rows of 37
+// pixels go through the SSE2 blocks and the scalar tail. A distance may be
+// off by what one float step of depth moves it. Returns the number of
+// projections that are off.
+static int CheckDepthLinearize() {
+  const int width = 37;
+  const int height = 3;
+  const int count = width * height;
+  int failures = 0;
+  for (PixelFormat format : {PixelFormat::L32F, PixelFormat::L16}) {
+    for (int projection = 0; projection < 4; projection++) {
+      DepthSettings settings;
+      settings.linearize = true;
+      settings.nearPlane = 0.5f;
+      settings.farPlane = 200.0f;
+      settings.reverseZ = (projection & 1) != 0;
+      settings.infiniteFar = (projection & 2) != 0;
+
+      uint8_t *dst;
+      PixelBuffer depth = AllocatePixelBuffer(format, width, height, dst);
+      std::vector<float> values(count);
+      for (int i = 0; i < count; i++) {
+        if (format == PixelFormat::L16) {
+          uint16_t code = (uint16_t)std::lround(i * 65535.0 / (count - 1));
+          memcpy(dst + i * 2, &code, sizeof(code));
+          values[i] = code / 65535.0f;
+        } else {
+          values[i] = i / (float)(count - 1);
+          memcpy(dst + i * 4, &values[i], sizeof(float));
+        }
+      }
+      PixelBuffer distances = LinearizeDepth(depth, settings, 1);
+
+      int bad = 0;
+      int firstBad = -1;
+      for (int i = 0; i < count && distances.data; i++) {
+        float actual;
+        memcpy(&actual, distances.data + i * 4, sizeof(actual));
+        double expected = GetDepthDistance(values[i], settings);
+        bool ok;
+        if (std::isinf(expected)) {
+          ok = actual == INFINITY;
+        } else {
+          double below = GetDepthDistance(
+              std::max(std::nextafter(values[i], -1.0f), 0.0f), settings);
+          double above = GetDepthDistance(
+              std::min(std::nextafter(values[i], 2.0f), 1.0f), settings);
+          double low = std::min(below, above) * (1.0 - 1e-5);
+          double high = std::max(below, above) * (1.0 + 1e-5);
+          ok = actual >= low && actual <= high;
+        }
+        if (!ok && bad++ == 0)
+          firstBad = i;
+      }
+      if (!distances.data || bad > 0) {
+        std::cerr << "Linear depth of " << GetPixelFormatInfo(format).name
+                  << (settings.reverseZ ? " reverse-Z" : " standard")
+                  << (settings.infiniteFar ? " infinite" : " finite") << ": "
+                  << bad << " of " << count << " pixels are off";
+        if (firstBad >= 0) {
+          float actual;
+          memcpy(&actual, distances.data + firstBad * 4, sizeof(actual));
+          std::cerr << ", depth " << values[firstBad] << " gave " << actual
+                    << " instead of "
+                    << GetDepthDistance(values[firstBad], settings);
+        }
+        std::cerr << "\n";
+        failures++;
+      }
+    }
+  }
+  return failures;
+}
+
+// Writes D24S8 and D32FS8 surfaces with known depth and stencil, and checks
+// the depth and stencil layers DDSImage splits them into. The unused bits of
+// D32FS8 are set so that reading them shows. Returns the number of formats
+// that are off.
+static int CheckDepthStencilSplit(const fs::path &dir) {
+  const int width = 5;
+  const int height = 3;
+  const int count = width * height;
+  int failures = 0;
+  for (uint32_t dxgiFormat : {g_DxgiD24S8, g_DxgiD32FS8}) {
+    bool d24 = dxgiFormat == g_DxgiD24S8;
+    size_t pixelSize = d24 ? 4 : 8;
+    std::vector<uint8_t> surface((size_t)count * pixelSize);
+    std::vector<float> depths(count);
+    std::vector<uint8_t> stencils(count);
+    for (int i = 0; i < count; i++) {
+      uint32_t h = Hash((uint32_t)i + 1);
+      uint8_t *pixel = &surface[i * pixelSize];
+      stencils[i] = (uint8_t)(h >> 24);
+      if (d24) {
+        uint32_t word = (h & 0xFFFFFF) | ((uint32_t)stencils[i] << 24);
+        memcpy(pixel, &word, sizeof(word));
+        depths[i] = (h & 0xFFFFFF) / 16777215.0f;
+      } else {
+        depths[i] = (h & 0xFFFF) / 65535.0f;
+        memcpy(pixel, &depths[i], sizeof(float));
+        pixel[4] = stencils[i];
+        pixel[5] = pixel[6] = pixel[7] = 0xA5;
+      }
+    }
+
+    std::string name = d24 ? "D24S8" : "D32FS8";
+    fs::path path = dir / ("depth-" + name + ".dds");
+    bool ok = WriteDDS(path, dxgiFormat, width, height, false, surface.data(),
+                       surface.size());
+    int bad = 0;
+    {
+      DDSImage dds;
+      ImageData depth, stencil;
+      SubresourceIndex stencilIndex;
+      stencilIndex.layer = 1;
+      ok = ok && dds.Open(path.u8string()) &&
+           dds.GetLayout().arraySize == 2 &&
+           dds.Decode(SubresourceIndex(), depth) &&
+           dds.Decode(stencilIndex, stencil) && depth.depth &&
+           !stencil.depth && depth.stored.format == PixelFormat::L32F &&
+           stencil.stored.format == PixelFormat::R8UI &&
+           depth.width == width && depth.height == height &&
+           stencil.width == width && stencil.height == height;
+      for (int i = 0; i < count && ok; i++) {
+        int x = i % width;
+        int y = i / width;
+        float value;
+        memcpy(&value, depth.stored.GetRow(y) + x * 4, sizeof(value));
+        if (std::fabs(value - depths[i]) > 1e-6f ||
+            stencil.stored.GetRow(y)[x] != stencils[i])
+          bad++;
+      }
+    }
+    std::error_code ec;
+    fs::remove(path, ec);
+    if (!ok) {
+      std::cerr << "Depth/stencil split of " << name
+                << ": layers missing or wrong\n";
+      failures++;
+    } else if (bad > 0) {
+      std::cerr << "Depth/stencil split of " << name << ": " << bad << " of "
+                << count << " pixels differ\n";
+      failures++;
+    }
+  }
+  return failures;
+}
+
+// Linearization of depth planes, reverse-Z with an infinite far plane. The
+// projections and the depth/stencil split are checked first; returns the
+// number of checks that fail.
+static int BenchDepthLinearize(const fs::path &dir, int megapixels,
+                               const std::vector<int> &threadCounts,
+                               int iterations,
+                               std::vector<BenchResult> &results) {
+  int failures = CheckDepthLinearize() + CheckDepthStencilSplit(dir);
+
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0);
+  size_t pixelCount = (size_t)side * side;
+  DepthSettings settings;
+  settings.linearize = true;
+  settings.reverseZ = true;
+  settings.infiniteFar = true;
+  for (PixelFormat format : {PixelFormat::L32F, PixelFormat::L16}) {
+    uint8_t *dst;
+    PixelBuffer depth = AllocatePixelBuffer(format, side, side, dst);
+    for (size_t i = 0; i < pixelCount; i++) {
+      float value = (Hash((uint32_t)i) & 0xFFFF) / 65535.0f;
+      if (format == PixelFormat::L16) {
+        uint16_t code = (uint16_t)(value * 65535.0f);
+        memcpy(dst + i * 2, &code, sizeof(code));
+      } else {
+        memcpy(dst + i * 4, &value, sizeof(value));
+      }
+    }
+    std::string name = GetPixelFormatInfo(format).name;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    for (int threads : threadCounts) {
+      double seconds = TimeMedian(iterations, [&]() {
+        return LinearizeDepth(depth, settings, threads).data != nullptr;
+      });
+      AddResult(results, "depthlinear", name, Content::Random, megapixels,
+                threads, seconds, pixelCount);
+    }
+  }
+  return failures;
+}
+
+// ---- Motion vectors ----
+
+// Motion vectors that grow linearly across the image, so the mean of a cell
+// is the vector at its center and the longest is at one of its corners
+static void GetMotionVector(int x, int y, int side, float vector[2]) {
+  vector[0] = (x - 0.3f * side) * 0.01f;
+  vector[1] = (0.6f * side - y) * 0.02f;
+}
+
+// Reduction of motion vectors to the cells of two zoom levels, from float
+// pixels (RG16F and RG32F textures are decoded to them) and from a mapped
+// RG32F dump. Returns the number of fields that are off.
+static int BenchMotionField(int megapixels,
+                            const std::vector<int> &threadCounts,
+                            int iterations,
+                            std::vector<BenchResult> &results) {
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0);
+  size_t pixelCount = (size_t)side * side;
+  ImageData pixels;
+  pixels.width = pixels.height = side;
+  pixels.pixels.resize(pixelCount * 4);
+  uint8_t *dst;
+  ImageData stored = pixels;
+  stored.pixels = std::vector<float>();
+  stored.stored = AllocatePixelBuffer(PixelFormat::RG32F, side, side, dst);
+  for (int y = 0; y < side; y++) {
+    for (int x = 0; x < side; x++) {
+      size_t i = (size_t)y * side + x;
+      float *rgba = &pixels.pixels[i * 4];
+      GetMotionVector(x, y, side, rgba);
+      rgba[2] = 0.0f;
+      rgba[3] = 1.0f;
+      memcpy(dst + i * 8, rgba, 8);
+    }
+  }
+
+  int failures = 0;
+  for (const ImageData *image : {&pixels, &stored}) {
+    for (int cellSize : {8, 64}) {
+      std::string format = image->HasStoredPixels() ? "rg32f" : "rgba32f";
+      format += "-" + std::to_string(cellSize);
+      for (int threads : threadCounts) {
+        MotionField field;
+        double seconds = TimeMedian(iterations, [&]() {
+          return ReduceMotionField(*image, cellSize, field, threads);
+        });
+        AddResult(results, "motionfield", format, Content::Random, megapixels,
+                  threads, seconds, pixelCount);
+
+        // The center of a cell is where its vector is the mean
+        float maxError = 0.0f;
+        for (int cellY = 0; cellY < field.rows; cellY++) {
+          for (int cellX = 0; cellX < field.columns; cellX++) {
+            int x0 = cellX * cellSize;
+            int y0 = cellY * cellSize;
+            int x1 = std::min(x0 + cellSize, side) - 1;
+            int y1 = std::min(y0 + cellSize, side) - 1;
+            float first[2], last[2];
+            GetMotionVector(x0, y0, side, first);
+            GetMotionVector(x1, y1, side, last);
+            const float *mean =
+                &field.mean[((size_t)cellY * field.columns + cellX) * 2];
+            for (int c = 0; c < 2; c++)
+              maxError = std::max(
+                  maxError, std::fabs(mean[c] - (first[c] + last[c]) * 0.5f));
+          }
+        }
+        float corner[2];
+        GetMotionVector(side - 1, 0, side, corner);
+        float maxLength = std::hypot(corner[0], corner[1]);
+        if (maxError > 1e-3f ||
+            std::fabs(field.maxLength - maxLength) > 1e-3f * maxLength) {
+          std::cerr << "Motion field of " << format << " is off by "
+                    << maxError << ", longest vector " << field.maxLength
+                    << " instead of " << maxLength << "\n";
+          failures++;
+        }
+      }
+    }
+  }
+  return failures;
+}
+
+// ---- Volumes ----
+
+namespace {
+/**
+ * @brief Volume in memory in the slab layout of DDS and KTX2 files: XY
+ * slices one after another. Slices across Y and X are gathered from it in
+ * parallel, rows at a time, as a viewer without bricks would.
+ */
+class SlabVolume : public ImageSource {
+public:
+  SlabVolume(int side, PixelFormat format, int threadCount)
+      : m_format(format), m_threadCount(threadCount) {
+    m_layout.width = m_layout.height = m_layout.depth = side;
+    m_layout.format = "Slab";
+    m_pixelSize = GetPixelSize(format);
+    m_voxels.resize((size_t)side * side * side * m_pixelSize);
+    for (size_t i = 0; i < m_voxels.size(); i++)
+      m_voxels[i] = (uint8_t)Hash((uint32_t)i * 0x9e3779b9u);
+  }
+
+  const SubresourceLayout &GetLayout() const override { return m_layout; }
+
+  bool Decode(const SubresourceIndex &index, ImageData &out) override {
+    if (!m_layout.Contains(index))
+      return false;
+    const int side = m_layout.width;
+    const size_t rowBytes = (size_t)side * m_pixelSize;
+    const size_t sliceBytes = rowBytes * side;
+    uint8_t *dst;
+    out.width = out.height = side;
+    out.stored = AllocatePixelBuffer(m_format, side, side, dst);
+    ParallelFor(side, m_threadCount, [&](int begin, int end) {
+      for (int row = begin; row < end; row++) {
+        uint8_t *line = dst + rowBytes * row;
+        if (index.axis == SliceAxis::Z) {
+          memcpy(line, &m_voxels[sliceBytes * index.slice + rowBytes * row],
+                 rowBytes);
+        } else if (index.axis == SliceAxis::Y) {
+          memcpy(line, &m_voxels[sliceBytes * row + rowBytes * index.slice],
+                 rowBytes);
+        } else {
+          // Row y of an X slice: one voxel of each Z slice
+          const uint8_t *src =
+              &m_voxels[rowBytes * row + m_pixelSize * index.slice];
+          for (int z = 0; z < side; z++)
+            memcpy(line + m_pixelSize * z, src + sliceBytes * z, m_pixelSize);
+        }
+      }
+    });
+    return true;
+  }
+
+private:
+  SubresourceLayout m_layout;
+  PixelFormat m_format;
+  int m_threadCount;
+  size_t m_pixelSize = 0;
+  std::vector<uint8_t> m_voxels;
+};
+} // namespace
+
+// Steps through every slice of an RGBA16F volume across each axis, from the
+// slab layout and from bricks, and times bricking it. The bricked slices are
+// checked against the slab ones; returns the number of axes that differ.
+static int BenchVolumeSlice(int megapixels,
+                            const std::vector<int> &threadCounts,
+                            int iterations,
+                            std::vector<BenchResult> &results) {
+  int side = (int)std::cbrt((double)megapixels * 1024.0 * 1024.0);
+  size_t voxelCount = (size_t)side * side * side;
+  int failures = 0;
+  for (int threads : threadCounts) {
+    auto slab = std::make_shared<SlabVolume>(side, PixelFormat::RGBA16F,
+                                             threads);
+    BrickedVolume bricked(slab);
+    bricked.SetThreadCount(threads);
+
+    // A volume is bricked once per mip, when its first slice is decoded
+    double seconds = TimeMedian(iterations, [&]() {
+      BrickedVolume volume(slab);
+      volume.SetThreadCount(threads);
+      ImageData data;
+      return volume.Decode(SubresourceIndex(), data);
+    });
+    AddResult(results, "volumeslice", "rgba16f-brick", Content::Random,
+              megapixels, threads, seconds, voxelCount);
+
+    static const char *s_AxisNames[] = {"z", "y", "x"};
+    for (SliceAxis axis : {SliceAxis::Z, SliceAxis::Y, SliceAxis::X}) {
+      SubresourceIndex index;
+      index.axis = axis;
+      ImageData expected, data;
+      size_t mismatches = 0;
+      for (index.slice = 0; index.slice < side; index.slice += 7) {
+        if (!slab->Decode(index, expected) || !bricked.Decode(index, data) ||
+            memcmp(expected.stored.data, data.stored.data,
+                   expected.stored.GetByteSize()) != 0)
+          mismatches++;
+      }
+      if (mismatches > 0) {
+        std::cerr << "Bricked " << s_AxisNames[(int)axis]
+                  << " slices differ from the slab layout\n";
+        failures++;
+      }
+
+      for (int source = 0; source < 2; source++) {
+        ImageSource &volume =
+            source == 0 ? (ImageSource &)*slab : (ImageSource &)bricked;
+        seconds = TimeMedian(iterations, [&]() {
+          for (index.slice = 0; index.slice < side; index.slice++) {
+            if (!volume.Decode(index, data))
+              return false;
+          }
+          return true;
+        });
+        std::string name = std::string("rgba16f-") + s_AxisNames[(int)axis] +
+                           (source == 0 ? "-slab" : "-bricked");
+        AddResult(results, "volumeslice", name, Content::Random, megapixels,
+                  threads, seconds, voxelCount);
+      }
+    }
+  }
+  return failures;
+}
+
+// ---- Environment maps ----
+
+// Forward, right and down axes of the D3D cube faces
+static const float g_FaceAxes[6][3][3] = {
+    {{1, 0, 0}, {0, 0, -1}, {0, -1, 0}},  // +X
+    {{-1, 0, 0}, {0, 0, 1}, {0, -1, 0}},  // -X
+    {{0, 1, 0}, {1, 0, 0}, {0, 0, 1}},    // +Y
+    {{0, -1, 0}, {1, 0, 0}, {0, 0, -1}},  // -Y
+    {{0, 0, 1}, {1, 0, 0}, {0, -1, 0}},   // +Z
+    {{0, 0, -1}, {-1, 0, 0}, {0, -1, 0}}, // -Z
+};
+
+// Face in each cell of a horizontal cross, -1 for none
+static const int g_CrossFaces[3][4] = {
+    {-1, 2, -1, -1}, {1, 4, 0, 5}, {-1, 3, -1, -1}};
+
+// Color of a direction in the synthetic environment: the direction itself,
+// mapped to [0, 1], which bilinear filtering reproduces closely
+static void GetEnvironmentColor(const float dir[3], float *rgba) {
+  float scale =
+      0.5f / std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+  for (int c = 0; c < 3; c++)
+    rgba[c] = dir[c] * scale + 0.5f;
+  rgba[3] = 1.0f;
+}
+
+static void GetFaceColor(int face, int size, int x, int y, float *rgba) {
+  float s = 2.0f * (x + 0.5f) / size - 1.0f;
+  float t = 2.0f * (y + 0.5f) / size - 1.0f;
+  const float(*axes)[3] = g_FaceAxes[face];
+  float dir[3];
+  for (int c = 0; c < 3; c++)
+    dir[c] = axes[0][c] + s * axes[1][c] + t * axes[2][c];
+  GetEnvironmentColor(dir, rgba);
+}
+
+static void GetLatLongColor(int width, int height, int x, int y,
+                            float *rgba) {
+  const float pi = 3.14159265358979f;
+  float longitude = ((x + 0.5f) / width - 0.5f) * 2.0f * pi;
+  float latitude = (0.5f - (y + 0.5f) / height) * pi;
+  float dir[3] = {std::cos(latitude) * std::sin(longitude),
+                  std::sin(latitude),
+                  std::cos(latitude) * std::cos(longitude)};
+  GetEnvironmentColor(dir, rgba);
+}
+
+/**
+ * @brief The synthetic environment as a cubemap of about the given size and
+ * as the lat-long image it reprojects to.
+ */
+struct SyntheticEnvironment {
+  int faceSize = 0;
+  std::vector<float> faces; ///< RGBA32F, one face after another
+  ImageData latLong;
+};
+
+static SyntheticEnvironment GenerateEnvironment(int megapixels) {
+  SyntheticEnvironment env;
+  int faceSize = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0 / 6.0);
+  size_t faceFloats = (size_t)faceSize * faceSize * 4;
+  env.faceSize = faceSize;
+  env.faces.resize(faceFloats * 6);
+  for (int face = 0; face < 6; face++) {
+    float *texel = &env.faces[faceFloats * face];
+    for (int y = 0; y < faceSize; y++) {
+      for (int x = 0; x < faceSize; x++, texel += 4)
+        GetFaceColor(face, faceSize, x, y, texel);
+    }
+  }
+
+  int width, height;
+  GetReprojectedSize(Reprojection::CubeToLatLong, faceSize, width, height);
+  env.latLong.width = width;
+  env.latLong.height = height;
+  env.latLong.pixels.resize((size_t)width * height * 4);
+  float *pixel = env.latLong.pixels.data();
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++, pixel += 4)
+      GetLatLongColor(width, height, x, y, pixel);
+  }
+  return env;
+}
+
+// Reprojects a cubemap to a lat-long image and a lat-long image to a cube
+// cross, through lookup tables built once; building them is timed on its
+// own. Both hold the color of each texel's direction, so every output pixel
+// is checked against the color of its own direction; returns the number of
+// reprojections that are off.
+static int BenchReproject(int megapixels, const std::vector<int> &threadCounts,
+                          int iterations, std::vector<BenchResult> &results) {
+  SyntheticEnvironment env = GenerateEnvironment(megapixels);
+  int faceSize = env.faceSize;
+  int width = env.latLong.width;
+  int height = env.latLong.height;
+  int failures = 0;
+
+  for (int threads : threadCounts) {
+    for (Reprojection reprojection :
+         {Reprojection::CubeToLatLong, Reprojection::LatLongToCube}) {
+      bool toCube = reprojection == Reprojection::LatLongToCube;
+      int sourceWidth = toCube ? width : faceSize;
+      int sourceHeight = toCube ? height : faceSize;
+      const float *source =
+          toCube ? env.latLong.pixels.data() : env.faces.data();
+      std::string name = toCube ? "latlong-cube" : "cube-latlong";
+
+      ReprojectionTable table;
+      BuildReprojectionTable(reprojection, sourceWidth, sourceHeight, table,
+                             threads);
+      size_t pixelCount = table.taps.size();
+      double seconds = TimeMedian(iterations, [&]() {
+        ReprojectionTable built;
+        return BuildReprojectionTable(reprojection, sourceWidth, sourceHeight,
+                                      built, threads);
+      });
+      AddResult(results, "reproject", name + "-table", Content::LDR,
+                megapixels, threads, seconds, pixelCount);
+
+      std::vector<float> out(pixelCount * 4);
+      seconds = TimeMedian(iterations, [&]() {
+        Reproject(table, source, out.data(), threads);
+        return true;
+      });
+      AddResult(results, "reproject", name, Content::LDR, megapixels, threads,
+                seconds, pixelCount);
+
+      float maxError = 0.0f;
+      int crossFace = table.width / 4;
+      for (int y = 0; y < table.height; y++) {
+        for (int x = 0; x < table.width; x++) {
+          float expected[4];
+          if (!toCube) {
+            GetLatLongColor(table.width, table.height, x, y, expected);
+          } else {
+            int face = g_CrossFaces[y / crossFace][x / crossFace];
+            if (face < 0)
+              continue;
+            GetFaceColor(face, crossFace, x % crossFace, y % crossFace,
+                         expected);
+          }
+          const float *pixel = &out[((size_t)y * table.width + x) * 4];
+          for (int c = 0; c < 4; c++)
+            maxError = std::max(maxError, std::fabs(pixel[c] - expected[c]));
+        }
+      }
+      if (maxError > 1e-3f) {
+        std::cerr << "Reprojected " << name << " is off by " << maxError
+                  << "\n";
+        failures++;
+      }
+    }
+  }
+  return failures;
+}
+
+// Analyzes the lighting of the synthetic environment as a cubemap and as a
+// lat-long image. Its color is the direction mapped to [0, 1], so both must
+// find an irradiance of 2 pi in every channel; returns the number of
+// channels that do not.
+static int BenchLighting(int megapixels, const std::vector<int> &threadCounts,
+                         int iterations, std::vector<BenchResult> &results) {
+  SyntheticEnvironment env = GenerateEnvironment(megapixels);
+  size_t cubeTexels = env.faces.size() / 4;
+  int failures = 0;
+  for (int threads : threadCounts) {
+    EnvironmentLighting cube, latLong;
+    double seconds = TimeMedian(iterations, [&]() {
+      return ComputeCubeLighting(env.faces.data(), env.faceSize, cube,
+                                 threads);
+    });
+    AddResult(results, "lighting", "cube", Content::LDR, megapixels, threads,
+              seconds, cubeTexels);
+    seconds = TimeMedian(iterations, [&]() {
+      return ComputeLatLongLighting(env.latLong, latLong, threads);
+    });
+    AddResult(results, "lighting", "latlong", Content::LDR, megapixels,
+              threads, seconds, env.latLong.GetPixelCount());
+
+    const float expected = 2.0f * 3.14159265358979f;
+    for (int c = 0; c < 3; c++) {
+      if (std::fabs(cube.irradiance[c] - expected) > 1e-3f * expected ||
+          std::fabs(latLong.irradiance[c] - expected) > 1e-3f * expected) {
+        std::cerr << "Irradiance is " << cube.irradiance[c] << " (cube) and "
+                  << latLong.irradiance[c] << " (lat-long) instead of "
+                  << expected << "\n";
+        failures++;
+      }
+    }
+  }
+  return failures;
+}
+
+// ---- DIB ----
+
+/**
+ * @brief A bitmap layout written by EncodeDIB: 1 to 8-bit color indices,
+ * 24-bit BGR, or 16/32-bit pixels with the given R, G, B, A masks.
+ */
+struct DIBLayout {
+  const char *name;
+  int bitCount;
+  uint32_t compression; ///< BI_RGB (0), BI_BITFIELDS (3), BI_ALPHABITFIELDS (6)
+  uint32_t masks[4];    ///< Fields written; alpha 0 writes zero padding
+  uint32_t headerSize;  ///< 12 (core), 40 (info) or 124 (V5)
+};
+
+static const DIBLayout g_DIBLayouts[] = {
+    {"p1", 1, 0, {}, 40},
+    {"p4", 4, 0, {}, 40},
+    {"p8", 8, 0, {}, 40},
+    {"p8-core", 8, 0, {}, 12},
+    {"r8g8b8", 24, 0, {}, 40},
+    {"r8g8b8-core", 24, 0, {}, 12},
+    {"x1r5g5b5", 16, 0, {0x7c00, 0x3e0, 0x1f, 0}, 40},
+    {"r5g6b5", 16, 3, {0xf800, 0x7e0, 0x1f, 0}, 40},
+    {"a1r5g5b5", 16, 6, {0x7c00, 0x3e0, 0x1f, 0x8000}, 40},
+    {"x8r8g8b8", 32, 0, {0xff0000, 0xff00, 0xff, 0}, 40},
+    {"a8r8g8b8", 32, 3, {0xff0000, 0xff00, 0xff, 0xff000000}, 124},
+    {"a8b8g8r8", 32, 3, {0xff, 0xff00, 0xff0000, 0xff000000}, 124},
+    {"a2r10g10b10", 32, 3, {0x3ff00000, 0xffc00, 0x3ff, 0xc0000000}, 124},
+};
+
+static void PutLE16(std::vector<uint8_t> &out, size_t pos, uint32_t value) {
+  out[pos] = (uint8_t)value;
+  out[pos + 1] = (uint8_t)(value >> 8);
+}
+
+static void PutLE32(std::vector<uint8_t> &out, size_t pos, uint32_t value) {
+  PutLE16(out, pos, value & 0xffff);
+  PutLE16(out, pos + 2, value >> 16);
+}
+
+/**
+ * @brief Writes random pixels as a DIB (the layout of CF_DIB clipboard
+ * data), or as a .bmp file with file set.
+ * @param expected Receives the RGBA8 pixels the DIB holds, top row first:
+ * bit fields widened with rounding (top 8 bits of wider ones), alpha 255
+ * where the layout has none.
+ */
+static std::vector<uint8_t> EncodeDIB(const DIBLayout &layout, int width,
+                                      int height, bool topDown, bool file,
+                                      std::vector<uint8_t> &expected) {
+  const bool core = layout.headerSize == 12;
+  const size_t headerOffset = file ? 14 : 0;
+  const size_t paletteSize =
+      layout.bitCount <= 8 ? (size_t)1 << layout.bitCount : 0;
+  const size_t entrySize = core ? 3 : 4;
+  size_t maskBytes = 0;
+  if (layout.headerSize == 40 && layout.compression == 3)
+    maskBytes = 12;
+  else if (layout.headerSize == 40 && layout.compression == 6)
+    maskBytes = 16;
+  const size_t rowPitch = ((size_t)width * layout.bitCount + 31) / 32 * 4;
+  const size_t dataOffset =
+      headerOffset + layout.headerSize + maskBytes + paletteSize * entrySize;
+
+  std::vector<uint8_t> out(dataOffset + rowPitch * height);
+  if (file) {
+    out[0] = 'B';
+    out[1] = 'M';
+    PutLE32(out, 2, (uint32_t)out.size());
+    PutLE32(out, 10, (uint32_t)dataOffset);
+  }
+  const size_t h = headerOffset;
+  PutLE32(out, h, layout.headerSize);
+  if (core) {
+    PutLE16(out, h + 4, width);
+    PutLE16(out, h + 6, height);
+    PutLE16(out, h + 8, 1);
+    PutLE16(out, h + 10, layout.bitCount);
+  } else {
+    PutLE32(out, h + 4, width);
+    PutLE32(out, h + 8, topDown ? (uint32_t)-height : (uint32_t)height);
+    PutLE16(out, h + 12, 1);
+    PutLE16(out, h + 14, layout.bitCount);
+    PutLE32(out, h + 16, layout.compression);
+    PutLE32(out, h + 20, (uint32_t)(rowPitch * height));
+    if (layout.compression != 0) {
+      int maskCount = layout.headerSize == 40 && layout.compression == 3 ? 3
+                                                                         : 4;
+      for (int c = 0; c < maskCount; c++)
+        PutLE32(out, h + 40 + c * 4, layout.masks[c]);
+    }
+  }
+
+  std::vector<uint32_t> palette(paletteSize);
+  size_t paletteOffset = h + layout.headerSize + maskBytes;
+  for (size_t i = 0; i < paletteSize; i++) {
+    palette[i] = Hash((uint32_t)i * 977 + 1) & 0xffffff;
+    for (int c = 0; c < 3; c++)
+      out[paletteOffset + i * entrySize + c] = (uint8_t)(palette[i] >> 8 * c);
+  }
+
+  expected.assign((size_t)width * height * 4, 0);
+  for (int y = 0; y < height; y++) {
+    uint8_t *row =
+        out.data() + dataOffset + rowPitch * (topDown ? y : height - 1 - y);
+    for (int x = 0; x < width; x++) {
+      uint32_t random = Hash((uint32_t)(y * width + x) * 31 + 7);
+      uint8_t *e = &expected[((size_t)y * width + x) * 4];
+      if (layout.bitCount <= 8) {
+        uint32_t index = random & (uint32_t)(paletteSize - 1);
+        int bit = x * layout.bitCount;
+        row[bit / 8] |=
+            (uint8_t)(index << (8 - layout.bitCount - bit % 8));
+        // Entries are stored B, G, R
+        e[0] = (uint8_t)(palette[index] >> 16);
+        e[1] = (uint8_t)(palette[index] >> 8);
+        e[2] = (uint8_t)palette[index];
+        e[3] = 255;
+      } else if (layout.bitCount == 24) {
+        for (int c = 0; c < 3; c++) {
+          e[c] = (uint8_t)(random >> 8 * c);
+          row[x * 3 + 2 - c] = e[c];
+        }
+        e[3] = 255;
+      } else {
+        uint32_t word = 0;
+        for (int c = 0; c < 4; c++) {
+          uint32_t mask = layout.masks[c];
+          if (!mask) {
+            e[c] = c == 3 ? 255 : 0;
+            continue;
+          }
+          int shift = 0;
+          while (!(mask >> shift & 1))
+            shift++;
+          int bits = 0;
+          while (bits + shift < 32 && (mask >> (shift + bits) & 1))
+            bits++;
+          uint32_t max = (uint32_t)((1ull << bits) - 1);
+          uint32_t value = ((random >> 8 * c & 0xff) * max + 127) / 255;
+          word |= value << shift;
+          e[c] = bits > 8 ? (uint8_t)(value >> (bits - 8))
+                          : (uint8_t)((value * 510 + max) / (2 * max));
+        }
+        for (int i = 0; i < layout.bitCount / 8; i++)
+          row[x * (layout.bitCount / 8) + i] = (uint8_t)(word >> 8 * i);
+      }
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief Decodes every DIB layout, bottom-up and top-down, as clipboard data
+ * and as a file, and compares the pixels with the ones written.
+ * @return Number of layouts with mismatching pixels.
+ */
+static int ValidateBMP() {
+  const int sizes[][2] = {{37, 5}, {3, 2}, {64, 3}};
+  int failures = 0;
+  for (const DIBLayout &layout : g_DIBLayouts) {
+    size_t mismatches = 0;
+    size_t pixelCount = 0;
+    bool ok = true;
+    for (const auto &size : sizes) {
+      for (bool topDown : {false, true}) {
+        // Core headers have no top-down rows
+        if (topDown && layout.headerSize == 12)
+          continue;
+        for (bool file : {false, true}) {
+          std::vector<uint8_t> expected;
+          std::vector<uint8_t> data = EncodeDIB(layout, size[0], size[1],
+                                                topDown, file, expected);
+          DIBHeader header;
+          if (!(file ? ReadBMPHeader(data.data(), data.size(), header)
+                     : ReadDIBHeader(data.data(), data.size(), header)) ||
+              header.width != size[0] || header.height != size[1]) {
+            ok = false;
+            continue;
+          }
+          // Three threads split even the smallest images
+          std::vector<uint8_t> decoded(expected.size());
+          DecodeDIBImage(data.data(), header, decoded.data(), 3);
+          for (size_t i = 0; i < decoded.size(); i += 4) {
+            if (memcmp(&decoded[i], &expected[i], 4) != 0 &&
+                mismatches++ == 0) {
+              printf("%-12s first mismatch at pixel %zu of %dx%d: "
+                     "(%d %d %d %d), written (%d %d %d %d)\n",
+                     layout.name, i / 4, size[0], size[1], decoded[i],
+                     decoded[i + 1], decoded[i + 2], decoded[i + 3],
+                     expected[i], expected[i + 1], expected[i + 2],
+                     expected[i + 3]);
+            }
+          }
+          pixelCount += decoded.size() / 4;
+        }
+      }
+    }
+    if (!ok)
+      printf("%-12s failed to parse\n", layout.name);
+    else
+      printf("%-12s %zu of %zu pixels differ\n", layout.name, mismatches,
+             pixelCount);
+    if (!ok || mismatches > 0)
+      failures++;
+  }
+  return failures;
+}
+
+// Decodes bottom-up bitmaps of the common layouts per thread count, as the
+// file and clipboard loaders do
+static void BenchDIBDecode(int megapixels,
+                           const std::vector<int> &threadCounts,
+                           int iterations, std::vector<BenchResult> &results) {
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0);
+  size_t pixelCount = (size_t)side * side;
+  std::vector<uint8_t> pixels(pixelCount * 4);
+  for (const DIBLayout &layout : g_DIBLayouts) {
+    std::string name = layout.name;
+    if (name != "p8" && name != "r8g8b8" && name != "r5g6b5" &&
+        name != "x8r8g8b8" && name != "a8b8g8r8")
+      continue;
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> data =
+        EncodeDIB(layout, side, side, false, false, expected);
+    DIBHeader header;
+    if (!ReadDIBHeader(data.data(), data.size(), header))
+      continue;
+    for (int threads : threadCounts) {
+      double seconds = TimeMedian(iterations, [&]() {
+        DecodeDIBImage(data.data(), header, pixels.data(), threads);
+        return true;
+      });
+      AddResult(results, "dibdecode", name, Content::Random, megapixels,
+                threads, seconds, pixelCount);
+    }
+  }
+}
+
+// ---- BCn ----
+
+static const BCFormat g_BCFormats[] = {
+    BCFormat::BC1,   BCFormat::BC2,   BCFormat::BC3, BCFormat::BC4U,
+    BCFormat::BC4S,  BCFormat::BC5U,  BCFormat::BC5S, BCFormat::BC6HU,
+    BCFormat::BC6HS, BCFormat::BC7,
+};
+
+static DXGI_FORMAT GetDXGIFormat(BCFormat format) {
+  switch (format) {
+  case BCFormat::BC1:
+    return DXGI_FORMAT_BC1_UNORM;
+  case BCFormat::BC2:
+    return DXGI_FORMAT_BC2_UNORM;
+  case BCFormat::BC3:
+    return DXGI_FORMAT_BC3_UNORM;
+  case BCFormat::BC4U:
+    return DXGI_FORMAT_BC4_UNORM;
+  case BCFormat::BC4S:
+    return DXGI_FORMAT_BC4_SNORM;
+  case BCFormat::BC5U:
+    return DXGI_FORMAT_BC5_UNORM;
+  case BCFormat::BC5S:
+    return DXGI_FORMAT_BC5_SNORM;
+  case BCFormat::BC6HU:
+    return DXGI_FORMAT_BC6H_UF16;
+  case BCFormat::BC6HS:
+    return DXGI_FORMAT_BC6H_SF16;
+  case BCFormat::BC7:
+    return DXGI_FORMAT_BC7_UNORM;
+  }
+  return DXGI_FORMAT_UNKNOWN;
+}
+
+/**
+ * @brief Fills a surface with random blocks. Every bit pattern is a valid
+ * block, so this reaches all modes, partitions and reserved encodings.
+ */
+static std::vector<uint8_t> GenerateBlocks(BCFormat format, int width,
+                                           int height, uint32_t seed) {
+  size_t size = (size_t)((width + 3) / 4) * ((height + 3) / 4) *
+                GetBCBlockSize(format);
+  std::vector<uint8_t> blocks(size);
+  for (size_t i = 0; i < size; i++)
+    blocks[i] = (uint8_t)Hash((uint32_t)i * 0x9e3779b9u + seed);
+  return blocks;
+}
+
+/**
+ * @brief Compares BCDecoder with DirectXTex on random blocks.
+ * @return Number of formats with mismatching pixels.
+ */
+static int ValidateBC() {
+  const int width = 256;
+  const int height = 256;
+  int failures = 0;
+
+  for (BCFormat format : g_BCFormats) {
+    std::vector<uint8_t> blocks =
+        GenerateBlocks(format, width, height, (uint32_t)format + 1);
+    std::vector<float> decoded((size_t)width * height * 4);
+    DecodeBCImage(format, blocks.data(), 0, width, height, decoded.data());
+
+    DirectX::Image image = {};
+    image.width = width;
+    image.height = height;
+    image.format = GetDXGIFormat(format);
+    image.rowPitch = (size_t)(width / 4) * GetBCBlockSize(format);
+    image.slicePitch = blocks.size();
+    image.pixels = blocks.data();
+
+    DirectX::ScratchImage reference;
+    if (FAILED(DirectX::Decompress(image, DXGI_FORMAT_R32G32B32A32_FLOAT,
+                                   reference))) {
+      printf("%-10s DirectXTex failed to decompress\n",
+             GetBCFormatName(format));
+      failures++;
+      continue;
+    }
+
+    const DirectX::Image *ref = reference.GetImage(0, 0, 0);
+    size_t mismatches = 0;
+    for (int y = 0; y < height; y++) {
+      const float *refRow =
+          reinterpret_cast<const float *>(ref->pixels + y * ref->rowPitch);
+      const float *row = decoded.data() + (size_t)y * width * 4;
+      for (int x = 0; x < width; x++) {
+        if (memcmp(refRow + x * 4, row + x * 4, 4 * sizeof(float)) == 0)
+          continue;
+        if (mismatches++ == 0) {
+          const float *a = row + x * 4;
+          const float *b = refRow + x * 4;
+          printf("%-10s first mismatch at (%d, %d): (%g %g %g %g) vs "
+                 "DirectXTex (%g %g %g %g)\n",
+                 GetBCFormatName(format), x, y, a[0], a[1], a[2], a[3], b[0],
+                 b[1], b[2], b[3]);
+        }
+      }
+    }
+
+    printf("%-10s %zu of %d pixels differ\n", GetBCFormatName(format),
+           mismatches, width * height);
+    if (mismatches > 0)
+      failures++;
+  }
+  return failures;
+}
+
+/**
+ * @brief Compares the RGBE decoder with stb_image on random pixels, in RLE
+ * and flat files. Exponents cover the whole byte range, including 0.
+ * @return Number of files with mismatching pixels.
+ */
+static int ValidateHDR() {
+  struct Case {
+    const char *name;
+    int width;
+    int height;
+    bool rle;
+  };
+  const Case cases[] = {
+      {"rle", 301, 67, true},
+      {"rle-narrow", 8, 16, true},
+      {"flat", 300, 20, false},
+      {"flat-narrow", 5, 9, false},
+  };
+
+  int failures = 0;
+  for (const Case &c : cases) {
+    // Values repeat in short stretches so the RLE files mix runs and literals
+    std::vector<uint8_t> rgbe((size_t)c.width * c.height * 4);
+    for (size_t i = 0; i < rgbe.size(); i++)
+      rgbe[i] = (uint8_t)Hash((uint32_t)(i / 4 / 3) * 4 + (uint32_t)(i % 4));
+    // A flat file must not start like an RLE scanline
+    rgbe[0] = 0xff;
+    std::vector<uint8_t> file = EncodeRGBE(rgbe, c.width, c.height, c.rle);
+
+    RGBEHeader header;
+    std::vector<float> decoded((size_t)c.width * c.height * 4);
+    bool ok = ReadRGBEHeader(file.data(), file.size(), header) &&
+              DecodeRGBEImage(file.data(), file.size(), header,
+                              decoded.data());
+
+    int width, height, channels;
+    float *reference = stbi_loadf_from_memory(
+        file.data(), (int)file.size(), &width, &height, &channels, 4);
+    if (!ok || !reference || width != c.width || height != c.height) {
+      printf("%-12s failed to decode\n", c.name);
+      stbi_image_free(reference);
+      failures++;
+      continue;
+    }
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < decoded.size(); i += 4) {
+      if (memcmp(&decoded[i], &reference[i], 4 * sizeof(float)) != 0 &&
+          mismatches++ == 0) {
+        printf("%-12s first mismatch at pixel %zu: (%g %g %g) vs stb_image "
+               "(%g %g %g)\n",
+               c.name, i / 4, decoded[i], decoded[i + 1], decoded[i + 2],
+               reference[i], reference[i + 1], reference[i + 2]);
+      }
+    }
+    stbi_image_free(reference);
+
+    printf("%-12s %zu of %d pixels differ\n", c.name, mismatches,
+           c.width * c.height);
+    if (mismatches > 0)
+      failures++;
+  }
+  return failures;
+}
+
+// Channels of a layer in RGBA order, as EXRImage sorts them into layers
+struct EXRTestLayer {
+  int part;
+  const char *slots[4]; ///< Channel names; nullptr for missing ones
+};
+
+struct EXRTestCase {
+  const char *name;
+  std::vector<EXRTestPart> parts; ///< Several make a multi-part file
+  std::vector<EXRTestLayer> layers;
+};
+
+// Compares a decoded mip of a layer with the samples it was written from.
+// Halves are expected as RGBA16F, anything else as float; missing color is
+// 0 and missing alpha 1. Returns false if the size or format is wrong.
+static bool CompareEXRTestLayer(const EXRTestPart &part,
+                                const EXRTestLayer &layer, int mip,
+                                const ImageData &data, const char *name,
+                                size_t &mismatches) {
+  int channels[4];
+  bool allHalf = true;
+  for (int slot = 0; slot < 4; slot++) {
+    channels[slot] = -1;
+    for (int c = 0; c < (int)part.channels.size() && layer.slots[slot];
+         c++) {
+      if (strcmp(part.channels[c].name, layer.slots[slot]) == 0)
+        channels[slot] = c;
+    }
+    if (channels[slot] >= 0 && part.channels[channels[slot]].type != EXRHalf)
+      allHalf = false;
+  }
+
+  int width = GetEXRLevelSize(part.width, mip, part.roundingMode);
+  int height = GetEXRLevelSize(part.height, mip, part.roundingMode);
+  if (data.width != width || data.height != height ||
+      (allHalf ? data.stored.format != PixelFormat::RGBA16F
+               : data.pixels.size() != (size_t)width * height * 4))
+    return false;
+
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint32_t decoded[4], expected[4];
+      for (int slot = 0; slot < 4; slot++) {
+        int c = channels[slot];
+        uint32_t sample = 0;
+        if (c >= 0) {
+          // Subsampled channels cover the pixels up to the next sample
+          const EXRTestChannel &channel = part.channels[c];
+          int sx = FloorDiv(part.minX + x, channel.xSampling) *
+                   channel.xSampling;
+          int sy = FloorDiv(part.minY + y, channel.ySampling) *
+                   channel.ySampling;
+          sample = GetEXRTestSample(part, c, sx, sy, mip, mip);
+        }
+        if (allHalf) {
+          uint16_t half;
+          memcpy(&half, data.stored.GetRow(y) + ((size_t)x * 4 + slot) * 2,
+                 2);
+          decoded[slot] = half;
+          expected[slot] = c >= 0 ? sample : slot == 3 ? 0x3c00 : 0;
+          continue;
+        }
+        float value = slot == 3 ? 1.0f : 0.0f;
+        if (c >= 0 && part.channels[c].type == EXRHalf)
+          value = HalfToFloat((uint16_t)sample);
+        else if (c >= 0 && part.channels[c].type == EXRFloat)
+          memcpy(&value, &sample, 4);
+        else if (c >= 0)
+          value = (float)sample;
+        memcpy(&expected[slot], &value, 4);
+        memcpy(&decoded[slot], &data.pixels[((size_t)y * width + x) * 4 + slot],
+               4);
+      }
+      if (memcmp(decoded, expected, sizeof(decoded)) != 0 &&
+          mismatches++ == 0) {
+        printf("%-16s first mismatch in mip %d at (%d, %d): %08x %08x %08x "
+               "%08x, written %08x %08x %08x %08x\n",
+               name, mip, x, y, decoded[0], decoded[1], decoded[2],
+               decoded[3], expected[0], expected[1], expected[2],
+               expected[3]);
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Writes EXR files in every compression and layout the decoder
+ * reads and compares each mip of each layer it decodes with the samples
+ * they were written from, bit for bit.
+ * @return Number of files with mismatching pixels.
+ */
+static int ValidateEXR(const fs::path &dir) {
+  const std::vector<EXRTestChannel> rgba = {{"A", EXRHalf, 1, 1},
+                                            {"B", EXRHalf, 1, 1},
+                                            {"G", EXRHalf, 1, 1},
+                                            {"R", EXRHalf, 1, 1}};
+  const std::vector<EXRTestChannel> mixed = {{"A", EXRHalf, 1, 1},
+                                             {"B", EXRFloat, 1, 1},
+                                             {"G", EXRUInt, 1, 1},
+                                             {"R", EXRFloat, 1, 1}};
+  const std::vector<EXRTestChannel> subsampled = {{"A", EXRHalf, 1, 1},
+                                                  {"B", EXRHalf, 2, 2},
+                                                  {"G", EXRHalf, 1, 1},
+                                                  {"R", EXRHalf, 2, 1}};
+  const std::vector<EXRTestChannel> layered = {{"B", EXRHalf, 1, 1},
+                                               {"G", EXRHalf, 1, 1},
+                                               {"R", EXRHalf, 1, 1},
+                                               {"normal.X", EXRFloat, 1, 1},
+                                               {"normal.Y", EXRFloat, 1, 1},
+                                               {"normal.Z", EXRFloat, 1, 1}};
+  const std::vector<EXRTestChannel> depth = {{"Z", EXRFloat, 1, 1}};
+  const EXRTestLayer rgbaLayer = {0, {"R", "G", "B", "A"}};
+
+  // Parts: name, compression, channels, data window, tiles, levels, wide
+  const EXRTestCase cases[] = {
+      {"none", {{"", EXRNone, rgba, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"rle", {{"", EXRRLE, rgba, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"zips", {{"", EXRZIPS, rgba, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"zip", {{"", EXRZIP, rgba, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"piz", {{"", EXRPIZ, rgba, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"piz-wide", {{"", EXRPIZ, rgba, 0, 0, 256, 96, 0, 0, 0, 0, true}},
+       {rgbaLayer}},
+      {"piz-mixed", {{"", EXRPIZ, mixed, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"pxr24", {{"", EXRPXR24, rgba, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"pxr24-mixed",
+       {{"", EXRPXR24, mixed, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"tiled-pxr24",
+       {{"", EXRPXR24, mixed, 2, -1, 75, 45, 20, 20, 0, 0, false}},
+       {rgbaLayer}},
+      {"tiled-mipmap",
+       {{"", EXRZIP, rgba, 2, -1, 75, 45, 16, 8, 1, 0, false}},
+       {rgbaLayer}},
+      {"tiled-ripmap",
+       {{"", EXRPIZ, rgba, 2, -1, 75, 45, 32, 16, 2, 1, false}},
+       {rgbaLayer}},
+      {"multi-part",
+       {{"beauty", EXRZIPS, rgba, 0, 0, 50, 30, 0, 0, 0, 0, false},
+        {"depth", EXRRLE, depth, 0, 0, 50, 30, 16, 16, 0, 0, false}},
+       {rgbaLayer, {1, {"Z", "Z", "Z", nullptr}}}},
+      {"subsampled-zip",
+       {{"", EXRZIP, subsampled, 0, 0, 97, 61, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"subsampled-piz",
+       {{"", EXRPIZ, subsampled, 0, 0, 97, 61, 0, 0, 0, 0, false}},
+       {rgbaLayer}},
+      {"layers", {{"", EXRZIP, layered, -3, 5, 61, 37, 0, 0, 0, 0, false}},
+       {{0, {"R", "G", "B", nullptr}},
+        {0, {"normal.X", "normal.Y", "normal.Z", nullptr}}}},
+  };
+
+  int failures = 0;
+  for (const EXRTestCase &c : cases) {
+    fs::path path = dir / (std::string("validate_") + c.name + ".exr");
+    int packedChunks = 0;
+    EXRImage image;
+    bool ok = WriteTestEXR(path, c.parts, packedChunks) &&
+              image.Open(path.u8string()) &&
+              image.GetLayout().arraySize == (int)c.layers.size();
+    size_t mismatches = 0, pixelCount = 0;
+    for (int l = 0; ok && l < (int)c.layers.size(); l++) {
+      const EXRTestPart &part = c.parts[c.layers[l].part];
+      int mips = std::min(GetEXRTestMipCount(part),
+                          image.GetLayout().mipLevels);
+      for (int mip = 0; ok && mip < mips; mip++) {
+        SubresourceIndex index;
+        index.layer = l;
+        index.mip = mip;
+        ImageData data;
+        ok = image.Decode(index, data) &&
+             CompareEXRTestLayer(part, c.layers[l], mip, data, c.name,
+                                 mismatches);
+        pixelCount += (size_t)data.width * data.height;
+      }
+    }
+    std::error_code ec;
+    fs::remove(path, ec);
+
+    // Chunks that do not shrink are stored as they are
+    bool packed = packedChunks > 0 || c.parts[0].compression == EXRNone;
+    if (!ok)
+      printf("%-16s failed to decode\n", c.name);
+    else if (!packed)
+      printf("%-16s has no packed chunks\n", c.name);
+    else
+      printf("%-16s %zu of %zu pixels differ\n", c.name, mismatches,
+             pixelCount);
+    if (!ok || !packed || mismatches > 0)
+      failures++;
+  }
+  return failures;
+}
+
+// Image for the renderer checks: values under, inside and over the view
+// range, with NaN, infinities, denormals and -0 in every channel
+static std::vector<float> GetRenderTestPixels(int width, int height) {
+  std::vector<float> pixels((size_t)width * height * 4);
+  for (size_t i = 0; i < pixels.size(); i++) {
+    uint32_t h = Hash((uint32_t)i);
+    switch (h % 16) {
+    case 0:
+      pixels[i] = std::numeric_limits<float>::quiet_NaN();
+      break;
+    case 1:
+      pixels[i] = std::numeric_limits<float>::infinity();
+      break;
+    case 2:
+      pixels[i] = -std::numeric_limits<float>::infinity();
+      break;
+    case 3:
+      pixels[i] = 1e-40f;
+      break;
+    case 4:
+      pixels[i] = -0.0f;
+      break;
+    default:
+      pixels[i] = (float)(h >> 16) / 65535.0f * 3.0f - 1.0f;
+      break;
+    }
+  }
+  return pixels;
+}
+
+static SoftwareViewParams GetRenderTestParams(float zoom, float panX,
+                                              float panY, float rangeMin,
+                                              float rangeMax) {
+  SoftwareViewParams params;
+  params.zoom = zoom;
+  params.panX = panX;
+  params.panY = panY;
+  params.rangeMin = rangeMin;
+  params.rangeMax = rangeMax;
+  return params;
+}
+
+/**
+ * @brief Renders a test image with SoftwareRenderer and compares it with
+ * the scalar ShadeTexel reference (SSE2 against scalar where the renderer
+ * uses SSE2) and with golden PNGs, bit for bit.
+ * @param goldenDir Directory holding render-<case>.png.
+ * @param updateGolden Write the golden PNGs instead of reading them.
+ * @return Number of mismatching cases.
+ */
+static int ValidateRender(const fs::path &goldenDir, bool updateGolden) {
+  const int width = 61;
+  const int height = 37;
+  ImageData image;
+  image.width = width;
+  image.height = height;
+  image.pixels = GetRenderTestPixels(width, height);
+
+  // The same values stored as halves, sampled through ConvertPixelRow
+  ImageData halfImage;
+  halfImage.width = width;
+  halfImage.height = height;
+  uint8_t *halfPixels = nullptr;
+  halfImage.stored =
+      AllocatePixelBuffer(PixelFormat::RGBA16F, width, height, halfPixels);
+  for (size_t i = 0; i < image.pixels.size(); i++) {
+    uint16_t half = FloatToHalf(image.pixels[i]);
+    memcpy(halfPixels + i * 2, &half, 2);
+  }
+
+  SoftwareRenderer renderer;
+  int failures = 0;
+
+  // At zoom 1 without pan, output pixel (x, y) shows texel (x, y)
+  SoftwareViewParams masked = GetRenderTestParams(1, 0, 0, 0.25f, 0.75f);
+  masked.showG = false;
+  const SoftwareViewParams shadeCases[] = {
+      GetRenderTestParams(1, 0, 0, 0, 1),
+      GetRenderTestParams(1, 0, 0, -1, 2),
+      masked,
+      GetRenderTestParams(1, 0, 0, 0.5f, 0.5f),
+      GetRenderTestParams(1, 0, 0, 1, 0),
+  };
+  for (const ImageData *source : {&image, &halfImage}) {
+    for (const SoftwareViewParams &params : shadeCases) {
+      const char *name = source == &image ? "shade" : "shade-half";
+      std::vector<unsigned char> rgba;
+      if (!renderer.Render(*source, params, width, height, rgba)) {
+        printf("%-14s failed to render\n", name);
+        failures++;
+        continue;
+      }
+      size_t mismatches = 0;
+      for (size_t i = 0; i < (size_t)width * height; i++) {
+        float texel[4];
+        source->GetPixel(i, texel);
+        unsigned char expected[4];
+        SoftwareRenderer::ShadeTexel(texel, params, expected);
+        if (memcmp(&rgba[i * 4], expected, 4) != 0 && mismatches++ == 0) {
+          printf("%-14s first mismatch at pixel %zu, range [%g, %g]: "
+                 "(%g %g %g %g) -> %d %d %d %d vs scalar %d %d %d %d\n",
+                 name, i, params.rangeMin, params.rangeMax, texel[0],
+                 texel[1], texel[2], texel[3], rgba[i * 4], rgba[i * 4 + 1],
+                 rgba[i * 4 + 2], rgba[i * 4 + 3], expected[0], expected[1],
+                 expected[2], expected[3]);
+        }
+      }
+      printf("%-14s range [%g, %g]: %zu of %d pixels differ\n", name,
+             params.rangeMin, params.rangeMax, mismatches, width * height);
+      if (mismatches > 0)
+        failures++;
+    }
+  }
+
+  // Full view transforms against the golden images
+  struct Case {
+    const char *name;
+    const ImageData *image;
+    int width;
+    int height;
+    SoftwareViewParams params;
+  };
+  SoftwareViewParams noGreen = GetRenderTestParams(2, 0, 0, 0.25f, 0.75f);
+  noGreen.showG = false;
+  const Case cases[] = {
+      {"identity", &image, width, height, GetRenderTestParams(1, 0, 0, 0, 1)},
+      {"magnify", &image, 160, 96,
+       GetRenderTestParams(3.5f, 7.25f, -4.5f, -1, 2)},
+      {"minify", &image, 40, 30, GetRenderTestParams(0.37f, 0, 0, 0, 1)},
+      {"mask", &image, 128, 80, noGreen},
+      {"offscreen", &image, 32, 32, GetRenderTestParams(1, 500, 0, 0, 1)},
+      {"half", &halfImage, 92, 56, GetRenderTestParams(1.5f, 0, 0, -1, 2)},
+  };
+  for (const Case &c : cases) {
+    std::vector<unsigned char> rgba;
+    if (!renderer.Render(*c.image, c.params, c.width, c.height, rgba)) {
+      printf("%-14s failed to render\n", c.name);
+      failures++;
+      continue;
+    }
+
+    fs::path path = goldenDir / (std::string("render-") + c.name + ".png");
+    if (updateGolden) {
+      if (!SoftwareRenderer::WritePNG(path.string(), rgba, c.width,
+                                      c.height)) {
+        printf("%-14s cannot write %s\n", c.name, path.string().c_str());
+        failures++;
+      } else {
+        printf("%-14s wrote %s\n", c.name, path.string().c_str());
+      }
+      continue;
+    }
+
+    int goldenWidth, goldenHeight, channels;
+    unsigned char *golden = stbi_load(path.string().c_str(), &goldenWidth,
+                                      &goldenHeight, &channels, 4);
+    if (!golden || goldenWidth != c.width || goldenHeight != c.height) {
+      printf("%-14s cannot read a %dx%d golden image %s\n", c.name, c.width,
+             c.height, path.string().c_str());
+      stbi_image_free(golden);
+      failures++;
+      continue;
+    }
+    size_t mismatches = 0;
+    for (size_t i = 0; i < (size_t)c.width * c.height; i++) {
+      if (memcmp(&rgba[i * 4], &golden[i * 4], 4) != 0 && mismatches++ == 0) {
+        printf("%-14s first mismatch at (%zu, %zu): %d %d %d %d vs golden "
+               "%d %d %d %d\n",
+               c.name, i % c.width, i / c.width, rgba[i * 4], rgba[i * 4 + 1],
+               rgba[i * 4 + 2], rgba[i * 4 + 3], golden[i * 4],
+               golden[i * 4 + 1], golden[i * 4 + 2], golden[i * 4 + 3]);
+      }
+    }
+    stbi_image_free(golden);
+
+    printf("%-14s %zu of %d pixels differ\n", c.name, mismatches,
+           c.width * c.height);
+    if (mismatches > 0)
+      failures++;
+  }
+  return failures;
+}
+
+// Value of one sample as TIFFImage shows it when it converts to float:
+// UNORM for unsigned integers, as they are for signed integers and floats
+static float GetTIFFTestValue(const TIFFTestCase &c, const uint8_t *sample) {
+  if (c.sampleFormat == 3) {
+    if (c.bits == 16) {
+      uint16_t half;
+      memcpy(&half, sample, 2);
+      return HalfToFloat(half);
+    }
+    if (c.bits == 32) {
+      float value;
+      memcpy(&value, sample, 4);
+      return value;
+    }
+    double value;
+    memcpy(&value, sample, 8);
+    return (float)value;
+  }
+  uint32_t value = 0;
+  memcpy(&value, sample, c.bits / 8);
+  if (c.sampleFormat == 2) {
+    return c.bits == 8    ? (float)(int8_t)value
+           : c.bits == 16 ? (float)(int16_t)value
+                          : (float)(int32_t)value;
+  }
+  if (c.bits == 8)
+    return value / 255.0f;
+  if (c.bits == 16)
+    return value / 65535.0f;
+  return (float)(value / 4294967295.0);
+}
+
+/**
+ * @brief Writes TIFF files in every compression, predictor, layout and byte
+ * order the decoder reads and compares each pixel it decodes with the
+ * samples they were written from, bit for bit.
+ * @return Number of files with mismatching pixels.
+ */
+static int ValidateTIFF(const fs::path &dir) {
+  // Odd sizes leave partial strips and tiles
+  const int w = 37, h = 23;
+  // Name, size, bits, sample format, samples, photometric, compression,
+  // predictor, planar, tile size, rows per strip, big-endian, BigTIFF
+  const TIFFTestCase cases[] = {
+      {"none-rgb8", w, h, 8, 1, 3, 2, 1, 1, false, 0, 5, false, false},
+      {"lzw-rgba8", w, h, 8, 1, 4, 2, 5, 2, false, 0, 4, false, false},
+      {"lzw-gray16-be", w, h, 16, 1, 1, 1, 5, 2, false, 0, 7, true, false},
+      {"lzw-big", 301, 211, 8, 1, 3, 2, 5, 1, false, 0, 211, false, false},
+      {"deflate-rgba16", w, h, 16, 1, 4, 2, 8, 2, false, 16, 0, false,
+       false},
+      {"packbits-gray8", w, h, 8, 1, 1, 1, 32773, 1, false, 0, 3, false,
+       false},
+      {"packbits-rgb16-be", w, h, 16, 1, 3, 2, 32773, 1, false, 0, 6, true,
+       false},
+      {"float-rgba32", w, h, 32, 3, 4, 2, 8, 3, false, 0, 16, false, false},
+      {"float-gray32-be", w, h, 32, 3, 1, 1, 5, 3, false, 0, 5, true, false},
+      {"half-rgba-tiled", w, h, 16, 3, 4, 2, 8, 3, false, 16, 0, false,
+       false},
+      {"double-rgb", w, h, 64, 3, 3, 2, 8, 3, false, 0, 9, true, false},
+      {"planar-rgb8", w, h, 8, 1, 3, 2, 5, 2, true, 0, 8, false, false},
+      {"planar-rgba32f-be", w, h, 32, 3, 4, 2, 8, 3, true, 16, 0, true,
+       false},
+      {"planar-gray-alpha", w, h, 32, 3, 2, 1, 8, 1, true, 0, 10, false,
+       false},
+      {"miniswhite-la8", w, h, 8, 1, 2, 0, 32773, 2, false, 0, 4, false,
+       false},
+      {"palette8", w, h, 8, 1, 1, 3, 5, 1, false, 0, 6, true, false},
+      {"int16-be", w, h, 16, 2, 1, 1, 5, 2, false, 0, 5, true, false},
+      {"uint32", w, h, 32, 1, 1, 1, 8, 2, false, 16, 0, false, false},
+      {"rgb16-extra", w, h, 16, 1, 5, 2, 8, 2, false, 0, 8, false, false},
+      {"bigtiff-rgb8-be", w, h, 8, 1, 3, 2, 8, 2, false, 16, 0, true, true},
+  };
+
+  int failures = 0;
+  std::error_code ec;
+  for (const TIFFTestCase &c : cases) {
+    std::vector<uint8_t> samples = GetTIFFTestSamples(c);
+    fs::path path = dir / (std::string("validate-") + c.name + ".tif");
+    TIFFImage image;
+    ImageData data;
+    bool ok = WriteTestTIFF(path, c, samples) && image.Open(path.string()) &&
+              image.Decode(SubresourceIndex(), data) &&
+              data.width == c.width && data.height == c.height;
+    if (!ok) {
+      printf("%-18s failed to decode\n", c.name);
+      failures++;
+      fs::remove(path, ec);
+      continue;
+    }
+
+    // Stored layouts keep the shown samples as they are; the others are
+    // converted to float
+    const int bytes = c.bits / 8;
+    const int spp = c.samplesPerPixel;
+    const bool rgb = c.photometric == 2;
+    int shown = rgb ? std::min(spp, 4) : std::min(spp, 2);
+    if (c.photometric == 3)
+      shown = 1;
+    std::vector<uint16_t> colorMap;
+    if (c.photometric == 3)
+      colorMap = GetTIFFTestPalette(c.bits);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < (size_t)c.width * c.height; i++) {
+      const uint8_t *pixel = &samples[i * spp * bytes];
+      bool same;
+      float decoded[4], expected[4];
+      data.GetPixel(i, decoded);
+      if (data.HasStoredPixels()) {
+        size_t pixelSize = GetPixelSize(data.stored.format);
+        const uint8_t *stored =
+            data.stored.GetRow((int)(i / c.width)) + i % c.width * pixelSize;
+        same = pixelSize == (size_t)shown * bytes &&
+               memcmp(stored, pixel, pixelSize) == 0;
+        ConvertPixelRow(data.stored.format, pixel, 1, expected);
+      } else if (c.photometric == 3) {
+        size_t index = pixel[0];
+        for (int ch = 0; ch < 3; ch++)
+          expected[ch] = colorMap[(ch << c.bits) + index] / 65535.0f;
+        expected[3] = 1.0f;
+        same = memcmp(decoded, expected, sizeof(expected)) == 0;
+      } else {
+        float values[4] = {0, 0, 0, 1};
+        for (int s = 0; s < shown; s++)
+          values[s] = GetTIFFTestValue(c, pixel + (size_t)s * bytes);
+        if (c.photometric == 0)
+          values[0] = 1.0f - values[0];
+        if (rgb) {
+          memcpy(expected, values, sizeof(expected));
+        } else {
+          expected[0] = expected[1] = expected[2] = values[0];
+          expected[3] = shown == 2 ? values[1] : 1.0f;
+        }
+        same = memcmp(decoded, expected, sizeof(expected)) == 0;
+      }
+      if (!same && mismatches++ == 0) {
+        printf("%-18s first mismatch at (%zu, %zu): (%g %g %g %g), "
+               "expected (%g %g %g %g)\n",
+               c.name, i % c.width, i / c.width, decoded[0], decoded[1],
+               decoded[2], decoded[3], expected[0], expected[1], expected[2],
+               expected[3]);
+      }
+    }
+    printf("%-18s %zu of %d pixels differ (%s)\n", c.name, mismatches,
+           c.width * c.height, data.pixelFormat.c_str());
+    if (mismatches > 0)
+      failures++;
+    fs::remove(path, ec);
+  }
+  return failures;
+}
+
+// Decodes each layer of the EXR file per thread count: chunks are inflated
+// in parallel, and only the layer's channels are converted
+static void BenchEXRDecode(const std::vector<EncodedFile> &files,
+                           int megapixels, const std::vector<int> &threadCounts,
+                           int iterations, std::vector<BenchResult> &results) {
+  for (const EncodedFile &file : files) {
+    EXRImage image;
+    if (file.path.extension() != ".exr" || !image.Open(file.path.u8string()))
+      continue;
+    const SubresourceLayout &layout = image.GetLayout();
+    size_t pixelCount = (size_t)layout.width * layout.height;
+    for (int layer = 0; layer < layout.arraySize; layer++) {
+      std::string name = "zip-" + layout.layerNames[layer];
+      for (int threads : threadCounts) {
+        image.SetThreadCount(threads);
+        SubresourceIndex index;
+        index.layer = layer;
+        ImageData data;
+        double seconds = TimeMedian(
+            iterations, [&]() { return image.Decode(index, data); });
+        AddResult(results, "exrdecode", name, file.content, megapixels,
+                  threads, seconds, pixelCount);
+      }
+    }
+  }
+}
+
+// Decodes the TIFF file per thread count: strips are inflated and their
+// predictor undone in parallel, straight into the result
+static void BenchTIFFDecode(const std::vector<EncodedFile> &files,
+                            int megapixels,
+                            const std::vector<int> &threadCounts,
+                            int iterations, std::vector<BenchResult> &results) {
+  for (const EncodedFile &file : files) {
+    TIFFImage image;
+    if (file.path.extension() != ".tif" || !image.Open(file.path.u8string()))
+      continue;
+    const SubresourceLayout &layout = image.GetLayout();
+    size_t pixelCount = (size_t)layout.width * layout.height;
+    for (int threads : threadCounts) {
+      image.SetThreadCount(threads);
+      ImageData data;
+      double seconds = TimeMedian(iterations, [&]() {
+        return image.Decode(SubresourceIndex(), data);
+      });
+      AddResult(results, "tiffdecode", file.format, file.content, megapixels,
+                threads, seconds, pixelCount);
+    }
+  }
+}
+
+// Decodes every frame of the animated GIF in order, as playback does, and in
+// reverse, which restarts from saved canvases
+// Frames that cycle through keep, clear and restore disposal, transparency,
+// interlacing, local color tables and a rectangle past the canvas edge.
+// There are more than 16, so decoding backwards restarts from a saved
+// canvas.
+static std::vector<GIFTestFrame> GetGIFTestFrames(int width, int height) {
+  std::vector<GIFTestFrame> frames;
+  for (int i = 0; i < 24; i++) {
+    GIFTestFrame frame;
+    int kind = i == 0 ? -1 : i % 4;
+    frame.width = i == 0 ? width : 5 + i % 7;
+    frame.height = i == 0 ? height : 3 + i % 11;
+    frame.left = i == 0 ? 0 : i * 5 % (width - 4);
+    frame.top = i == 0 ? 0 : i * 3 % (height - 2);
+    frame.disposal = kind == 1 ? 2 : kind == 2 ? 3 : 1;
+    frame.transparent = kind == 0 || kind == 2 || kind == 3 ? 7 * i % 256 : -1;
+    frame.interlaced = kind == 1 || kind == 3;
+    frame.localPalette = kind == 3;
+    frame.indices.resize((size_t)frame.width * frame.height);
+    for (size_t p = 0; p < frame.indices.size(); p++) {
+      frame.indices[p] = (uint8_t)(Hash((uint32_t)(i * 4096 + p)) >> 24);
+      if (frame.transparent >= 0 && p % 3 == 0)
+        frame.indices[p] = (uint8_t)frame.transparent;
+    }
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+// Composes the test frames as GIF89a describes: pixels that are not
+// transparent are drawn over the canvas, and the disposal method then
+// clears the frame's rectangle or restores the canvas from before it.
+static std::vector<std::vector<uint8_t>>
+ComposeTestGIF(int width, int height, const std::vector<GIFTestFrame> &frames) {
+  std::vector<std::vector<uint8_t>> composed;
+  std::vector<uint8_t> canvas((size_t)width * height * 4, 0);
+  for (const GIFTestFrame &frame : frames) {
+    std::vector<uint8_t> previous = canvas;
+    for (int y = 0; y < frame.height; y++) {
+      for (int x = 0; x < frame.width; x++) {
+        int canvasX = frame.left + x;
+        int canvasY = frame.top + y;
+        int index = frame.indices[(size_t)y * frame.width + x];
+        if (canvasX >= width || canvasY >= height ||
+            index == frame.transparent)
+          continue;
+        uint8_t *dst = &canvas[((size_t)canvasY * width + canvasX) * 4];
+        GetGIFTestColor(index, frame.localPalette, dst);
+        dst[3] = 255;
+      }
+    }
+    composed.push_back(canvas);
+    if (frame.disposal == 2) {
+      for (int y = frame.top; y < std::min(frame.top + frame.height, height);
+           y++)
+        for (int x = frame.left; x < std::min(frame.left + frame.width, width);
+             x++)
+          memset(&canvas[((size_t)y * width + x) * 4], 0, 4);
+    } else if (frame.disposal == 3) {
+      canvas = previous;
+    }
+  }
+  return composed;
+}
+
+// Decodes the compositing test GIF in order and backwards and compares every
+// frame with the reference. Returns the number of passes that differ.
+static int CheckGIFCompositing(const fs::path &dir) {
+  const int width = 23;
+  const int height = 17;
+  std::vector<GIFTestFrame> frames = GetGIFTestFrames(width, height);
+  std::vector<std::vector<uint8_t>> expected =
+      ComposeTestGIF(width, height, frames);
+  fs::path path = dir / "compose.gif";
+  if (!WriteTestGIF(path, width, height, frames)) {
+    std::cerr << "Cannot write " << path.string() << "\n";
+    return 1;
+  }
+
+  int failures = 0;
+  for (bool reverse : {false, true}) {
+    GIFImage image;
+    int count = (int)frames.size();
+    bool ok = image.Open(path.u8string()) && image.GetFrameCount() == count;
+    int badFrames = 0;
+    int firstBad = -1;
+    for (int i = 0; i < count && ok; i++) {
+      int frame = reverse ? count - 1 - i : i;
+      ImageData data;
+      ok = image.DecodeFrame(frame, data) &&
+           data.stored.format == PixelFormat::RGBA8 &&
+           data.width == width && data.height == height;
+      bool same = ok;
+      for (int y = 0; y < height && same; y++)
+        same = memcmp(data.stored.GetRow(y),
+                      &expected[frame][(size_t)y * width * 4],
+                      (size_t)width * 4) == 0;
+      if (ok && !same && badFrames++ == 0)
+        firstBad = frame;
+    }
+    if (!ok || badFrames > 0) {
+      std::cerr << "GIF compositing " << (reverse ? "backwards" : "in order")
+                << ": ";
+      if (!ok)
+        std::cerr << "decoding failed\n";
+      else
+        std::cerr << badFrames << " of " << count
+                  << " frames differ, first frame " << firstBad << "\n";
+      failures++;
+    }
+  }
+  std::error_code ec;
+  fs::remove(path, ec);
+  return failures;
+}
+
+// Decodes every frame of the animated GIF in order and backwards, after
+// checking compositing; returns the number of checks that fail
+static int BenchGIFDecode(const fs::path &dir,
+                          const std::vector<EncodedFile> &files,
+                          int megapixels, int iterations,
+                          std::vector<BenchResult> &results) {
+  int failures = CheckGIFCompositing(dir);
+  for (const EncodedFile &file : files) {
+    if (file.path.extension() != ".gif")
+      continue;
+    for (bool reverse : {false, true}) {
+      size_t pixelCount = 0;
+      double seconds = TimeMedian(iterations, [&]() {
+        GIFImage image;
+        if (!image.Open(file.path.u8string()))
+          return false;
+        int count = image.GetFrameCount();
+        ImageData data;
+        for (int i = 0; i < count; i++) {
+          if (!image.DecodeFrame(reverse ? count - 1 - i : i, data))
+            return false;
+        }
+        pixelCount = (size_t)image.GetWidth() * image.GetHeight() * count;
+        return true;
+      });
+      AddResult(results, "gifdecode", reverse ? "reverse" : "sequential",
+                file.content, megapixels, 0, seconds, pixelCount);
+    }
+  }
+  return failures;
+}
+
+// Codes of one YUV frame, chroma at half width and, unless packed, half
+// height
+struct YUVTestFrame {
+  int width, height, chromaWidth, chromaHeight;
+  std::vector<uint16_t> luma, cb, cr;
+};
+
+// Fills a frame with random codes of the given bits, including codes outside
+// the limited range
+static YUVTestFrame MakeYUVTestFrame(int width, int height, int bits,
+                                     bool halfHeight, uint32_t seed) {
+  YUVTestFrame frame;
+  frame.width = width;
+  frame.height = height;
+  frame.chromaWidth = (width + 1) / 2;
+  frame.chromaHeight = halfHeight ? (height + 1) / 2 : height;
+  uint32_t mask = (1u << bits) - 1;
+  auto fill = [&](std::vector<uint16_t> &codes, size_t count, uint32_t salt) {
+    codes.resize(count);
+    for (size_t i = 0; i < count; i++)
+      codes[i] = (uint16_t)(Hash(seed ^ salt ^ (uint32_t)i * 0x9e3779b9u) &
+                            mask);
+  };
+  fill(frame.luma, (size_t)width * height, 0x1000000);
+  fill(frame.cb, (size_t)frame.chromaWidth * frame.chromaHeight, 0x2000000);
+  fill(frame.cr, (size_t)frame.chromaWidth * frame.chromaHeight, 0x3000000);
+  return frame;
+}
+
+// Lays the codes out as a tightly packed dump of the format
+static std::vector<uint8_t> EncodeYUVTestFrame(const YUVTestFrame &frame,
+                                               YUVFormat format) {
+  std::vector<uint8_t> bytes;
+  auto put = [&](uint16_t code) {
+    switch (format) {
+    case YUVFormat::I420P10:
+      bytes.push_back((uint8_t)code);
+      bytes.push_back((uint8_t)(code >> 8));
+      break;
+    case YUVFormat::P010:
+      bytes.push_back((uint8_t)(code << 6));
+      bytes.push_back((uint8_t)(code >> 2));
+      break;
+    default:
+      bytes.push_back((uint8_t)code);
+      break;
+    }
+  };
+  size_t chromaCount = frame.cb.size();
+  if (format == YUVFormat::YUY2) {
+    for (int y = 0; y < frame.height; y++) {
+      const uint16_t *luma = &frame.luma[(size_t)y * frame.width];
+      for (int x = 0; x < frame.chromaWidth; x++) {
+        size_t c = (size_t)y * frame.chromaWidth + x;
+        put(luma[x * 2]);
+        put(frame.cb[c]);
+        put(x * 2 + 1 < frame.width ? luma[x * 2 + 1] : 0);
+        put(frame.cr[c]);
+      }
+    }
+    return bytes;
+  }
+  for (uint16_t code : frame.luma)
+    put(code);
+  if (format == YUVFormat::NV12 || format == YUVFormat::P010) {
+    for (size_t c = 0; c < chromaCount; c++) {
+      put(frame.cb[c]);
+      put(frame.cr[c]);
+    }
+  } else {
+    for (uint16_t code : frame.cb)
+      put(code);
+    for (uint16_t code : frame.cr)
+      put(code);
+  }
+  return bytes;
+}
+
+// The RGB a YUV code triple stands for, from the definitions: Y' = Kr R +
+// Kg G + Kb B, Pb = (B - Y') / (2 (1 - Kb)), Pr = (R - Y') / (2 (1 - Kr)),
+// with limited range codes at 16-235 (Y) and 16-240 (Cb, Cr) in 8-bit steps
+static void GetYUVReference(uint16_t y, uint16_t cb, uint16_t cr, int bits,
+                            const YUVSettings &settings, double rgb[3]) {
+  static const double s_Kr[] = {0.299, 0.2126, 0.2627};
+  static const double s_Kb[] = {0.114, 0.0722, 0.0593};
+  double kr = s_Kr[(int)settings.matrix];
+  double kb = s_Kb[(int)settings.matrix];
+  double luma, pb, pr;
+  if (settings.fullRange) {
+    double maxCode = (double)((1 << bits) - 1);
+    double zero = (double)(1 << (bits - 1));
+    luma = y / maxCode;
+    pb = (cb - zero) / maxCode;
+    pr = (cr - zero) / maxCode;
+  } else {
+    double step = (double)(1 << (bits - 8));
+    luma = (y / step - 16.0) / 219.0;
+    pb = (cb / step - 128.0) / 224.0;
+    pr = (cr / step - 128.0) / 224.0;
+  }
+  rgb[0] = luma + 2.0 * (1.0 - kr) * pr;
+  rgb[2] = luma + 2.0 * (1.0 - kb) * pb;
+  rgb[1] = (luma - kr * rgb[0] - kb * rgb[2]) / (1.0 - kr - kb);
+}
+
+// Decodes odd-sized dumps of every layout with each matrix and range and
+// compares every pixel with the reference. Rows of 37 pixels go through the
+// SSE2 path in blocks of four and the scalar path for the last one. Returns
+// the number of conversions that are off.
+static int CheckYUVConvert(const fs::path &dir) {
+  const int sizes[][2] = {{37, 5}, {7, 3}, {1, 1}};
+  const char *matrixNames[] = {"BT.601", "BT.709", "BT.2020"};
+  int failures = 0;
+  for (YUVFormat format : {YUVFormat::I420, YUVFormat::I420P10,
+                           YUVFormat::NV12, YUVFormat::P010,
+                           YUVFormat::YUY2}) {
+    int bits = format == YUVFormat::I420P10 || format == YUVFormat::P010 ? 10
+                                                                         : 8;
+    for (const int *size : sizes) {
+      int width = size[0];
+      int height = size[1];
+      YUVTestFrame frame =
+          MakeYUVTestFrame(width, height, bits, format != YUVFormat::YUY2,
+                           (uint32_t)format * 7919u + (uint32_t)width);
+      std::vector<uint8_t> bytes = EncodeYUVTestFrame(frame, format);
+      fs::path path = dir / ("check." + std::string(GetYUVFormatName(format)));
+      {
+        std::ofstream file(path, std::ios::binary);
+        file.write((const char *)bytes.data(), (std::streamsize)bytes.size());
+      }
+
+      YUVImage image;
+      bool opened = bytes.size() == GetYUVFrameSize(format, width, height) &&
+                    image.OpenRaw(path.u8string(), format, width, height, 0, 0);
+      for (int matrix = 0; matrix < 3; matrix++) {
+        for (bool fullRange : {false, true}) {
+          YUVSettings settings;
+          settings.matrix = (YUVMatrix)matrix;
+          settings.fullRange = fullRange;
+          image.SetSettings(settings);
+          image.SetThreadCount(2);
+          ImageData data;
+          bool ok = opened && image.DecodeFrame(0, data) &&
+                    data.stored.format == PixelFormat::RGBA32F &&
+                    data.width == width && data.height == height;
+
+          int bad = 0;
+          int firstBad = -1;
+          float actual[4] = {};
+          double expected[3] = {};
+          for (int i = 0; i < width * height && ok; i++) {
+            int x = i % width;
+            int y = i / width;
+            int cy = format == YUVFormat::YUY2 ? y : y / 2;
+            size_t c = (size_t)cy * frame.chromaWidth + x / 2;
+            double rgb[3];
+            GetYUVReference(frame.luma[i], frame.cb[c], frame.cr[c], bits,
+                            settings, rgb);
+            float rgba[4];
+            memcpy(rgba, data.stored.GetRow(y) + (size_t)x * 16,
+                   sizeof(rgba));
+            bool same = rgba[3] == 1.0f;
+            for (int ch = 0; ch < 3; ch++)
+              same = same &&
+                     std::fabs(rgba[ch] - rgb[ch]) <=
+                         1e-5 * (1.0 + std::fabs(rgb[ch]));
+            if (!same && bad++ == 0) {
+              firstBad = i;
+              memcpy(actual, rgba, sizeof(actual));
+              memcpy(expected, rgb, sizeof(expected));
+            }
+          }
+          if (!ok || bad > 0) {
+            std::cerr << "YUV " << GetYUVFormatName(format) << " " << width
+                      << "x" << height << " " << matrixNames[matrix]
+                      << (fullRange ? " full" : " limited") << ": ";
+            if (!ok)
+              std::cerr << "decoding failed\n";
+            else
+              std::cerr << bad << " of " << width * height
+                        << " pixels are off, pixel " << firstBad << " gave "
+                        << actual[0] << " " << actual[1] << " " << actual[2]
+                        << " instead of " << expected[0] << " "
+                        << expected[1] << " " << expected[2] << "\n";
+            failures++;
+          }
+        }
+      }
+      std::error_code ec;
+      fs::remove(path, ec);
+    }
+  }
+  return failures;
+}
+
+// Converts a frame of each YUV dump layout to RGBA32F per thread count,
+// after checking the conversion; returns the number of checks that fail. The
+// timed codes are random; the conversion does the same work for any codes.
+static int BenchYUVConvert(const fs::path &dir, int megapixels,
+                           const std::vector<int> &threadCounts,
+                           int iterations, std::vector<BenchResult> &results) {
+  int failures = CheckYUVConvert(dir);
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0) & ~1;
+  size_t pixelCount = (size_t)side * side;
+  for (YUVFormat format : {YUVFormat::I420, YUVFormat::I420P10,
+                           YUVFormat::NV12, YUVFormat::P010,
+                           YUVFormat::YUY2}) {
+    std::string name = GetYUVFormatName(format);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    fs::path path = dir / ("bench_" + std::to_string(megapixels) + "mp." +
+                           name);
+    std::vector<uint8_t> frame(GetYUVFrameSize(format, side, side));
+    for (size_t i = 0; i < frame.size(); i++)
+      frame[i] = (uint8_t)Hash((uint32_t)i * 0x9e3779b9u + (uint32_t)format);
+    {
+      std::ofstream file(path, std::ios::binary);
+      file.write((const char *)frame.data(), (std::streamsize)frame.size());
+      if (!file)
+        continue;
+    }
+
+    YUVImage image;
+    if (image.OpenRaw(path.u8string(), format, side, side, 0, 0)) {
+      for (int threads : threadCounts) {
+        image.SetThreadCount(threads);
+        ImageData data;
+        double seconds = TimeMedian(
+            iterations, [&]() { return image.DecodeFrame(0, data); });
+        AddResult(results, "yuvconvert", name, Content::Random, megapixels,
+                  threads, seconds, pixelCount);
+      }
+    }
+    std::error_code ec;
+    fs::remove(path, ec);
+  }
+  return failures;
+}
+
+static void BenchHDRDecode(const SyntheticImage &image, int megapixels,
+                           const std::vector<int> &threadCounts,
+                           int iterations, std::vector<BenchResult> &results) {
+  std::vector<uint8_t> file =
+      EncodeRGBE(ToRGBE(image), image.width, image.height, true);
+  RGBEHeader header;
+  if (!ReadRGBEHeader(file.data(), file.size(), header))
+    return;
+
+  size_t pixelCount = (size_t)image.width * image.height;
+  std::vector<float> pixels(pixelCount * 4);
+  for (int threads : threadCounts) {
+    double seconds = TimeMedian(iterations, [&]() {
+      return DecodeRGBEImage(file.data(), file.size(), header, pixels.data(),
+                             threads);
+    });
+    AddResult(results, "hdrdecode", "rle", Content::HDR, megapixels, threads,
+              seconds, pixelCount);
+  }
+}
+
+static void BenchBCDecode(int megapixels, const std::vector<int> &threadCounts,
+                          int iterations, std::vector<BenchResult> &results) {
+  // Same dimensions as the synthetic images
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0);
+  side = std::max(4, side & ~3);
+  size_t pixelCount = (size_t)side * side;
+  std::vector<float> pixels(pixelCount * 4);
+
+  // A 1024x1024 view into the middle of the surface
+  int regionSize = std::min(side, 1024);
+  int regionX = ((side - regionSize) / 2) & ~3;
+  int regionY = regionX;
+
+  for (BCFormat format : {BCFormat::BC1, BCFormat::BC3, BCFormat::BC5U,
+                          BCFormat::BC6HU, BCFormat::BC7}) {
+    std::vector<uint8_t> blocks = GenerateBlocks(format, side, side, 1);
+    std::string name = GetBCFormatName(format);
+    name = name.substr(0, name.find(' '));
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    for (int threads : threadCounts) {
+      double seconds = TimeMedian(iterations, [&]() {
+        return DecodeBCImage(format, blocks.data(), 0, side, side,
+                             pixels.data(), threads);
+      });
+      AddResult(results, "bcdecode", name, Content::Random, megapixels,
+                threads, seconds, pixelCount);
+
+      seconds = TimeMedian(iterations, [&]() {
+        return DecodeBCRegion(format, blocks.data(), 0, side, side, regionX,
+                              regionY, regionSize, regionSize, pixels.data(),
+                              threads);
+      });
+      AddResult(results, "bcregion", name, Content::Random, megapixels,
+                threads, seconds, (size_t)regionSize * regionSize);
+    }
+  }
+}
+
+/**
+ * @brief Compares results against a baseline.
+ * @return Number of stages that regressed by more than tolerance.
+ */
+static int CompareToBaseline(const std::vector<BenchResult> &results,
+                             const std::map<std::string, double> &baseline,
+                             double tolerance) {
+  int regressions = 0;
+  printf("\n%-40s %12s %12s %8s\n", "Stage", "Baseline", "Current", "Change");
+  for (const BenchResult &r : results) {
+    auto it = baseline.find(r.name);
+    if (it == baseline.end() || it->second <= 0.0)
+      continue;
+
+    double change = r.mpixPerSec / it->second - 1.0;
+    bool regressed = change < -tolerance;
+    if (regressed)
+      regressions++;
+    printf("%-40s %12.1f %12.1f %+7.1f%%%s\n", r.name.c_str(), it->second,
+           r.mpixPerSec, change * 100.0, regressed ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+int main(int argc, char **argv) {
+  std::string sizes = "1,16";
+  std::string threads;
+  int iterations = 5;
+  std::string outputFile;
+  std::string baselineFile;
+  double tolerance = 0.10;
+  std::string tempDir;
+  bool keepFiles = false;
+  bool validateBC = false;
+  bool validateHDR = false;
+  bool validateBMP = false;
+  bool validateEXR = false;
+  bool validateTIFF = false;
+  std::string goldenDir;
+  bool updateGolden = false;
+
+  try {
+    po::options_description desc("Allowed options");
+    desc.add_options()("help,h", "produce help message")(
+        "sizes", po::value<std::string>(&sizes),
+        "comma separated image sizes in megapixels (default 1,16; max 256)")(
+        "threads", po::value<std::string>(&threads),
+        "comma separated thread counts for the kernels (default: 1 and all "
+        "hardware threads)")(
+        "iterations", po::value<int>(&iterations)->default_value(5),
+        "runs per stage; the median is reported")(
+        "out", po::value<std::string>(&outputFile),
+        "write results to a JSON file")(
+        "baseline", po::value<std::string>(&baselineFile),
+        "compare against a JSON file written by --out")(
+        "tolerance", po::value<double>(&tolerance)->default_value(0.10),
+        "allowed slowdown relative to the baseline (0.1 = 10%)")(
+        "temp-dir", po::value<std::string>(&tempDir),
+        "directory for the encoded test files (default: system temp)")(
+        "keep-files", "do not delete the encoded test files")(
+        "validate-bc", "check the BCn decoder against DirectXTex and exit")(
+        "validate-hdr", "check the RGBE decoder against stb_image and exit")(
+        "validate-bmp", "check the DIB decoder on every bitmap layout and "
+                        "exit")(
+        "validate-exr", "check the EXR decoder on every compression and "
+                        "layout and exit")(
+        "validate-tiff", "check the TIFF decoder on every compression, "
+                         "predictor and layout and exit")(
+        "validate-render", po::value<std::string>(&goldenDir),
+        "check the software renderer against its scalar reference and the "
+        "golden PNGs in this directory and exit")(
+        "update-golden", "with --validate-render, write the golden PNGs "
+                         "instead of comparing");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+      std::cout << desc << "\n";
+      return 0;
+    }
+    keepFiles = vm.count("keep-files") > 0;
+    validateBC = vm.count("validate-bc") > 0;
+    validateHDR = vm.count("validate-hdr") > 0;
+    validateBMP = vm.count("validate-bmp") > 0;
+    validateEXR = vm.count("validate-exr") > 0;
+    validateTIFF = vm.count("validate-tiff") > 0;
+    updateGolden = vm.count("update-golden") > 0;
+  } catch (const std::exception &e) {
+    std::cerr << "Error parsing command line arguments: " << e.what() << "\n";
+    return 1;
+  }
+
+  if (validateBC)
+    return ValidateBC() > 0 ? 1 : 0;
+  if (validateHDR)
+    return ValidateHDR() > 0 ? 1 : 0;
+  if (validateBMP)
+    return ValidateBMP() > 0 ? 1 : 0;
+  if (!goldenDir.empty())
+    return ValidateRender(fs::u8path(goldenDir), updateGolden) > 0 ? 1 : 0;
+
+  std::vector<int> megapixelList;
+  std::vector<int> threadCounts;
+  try {
+    megapixelList = ParseIntList(sizes);
+    threadCounts = threads.empty()
+                       ? std::vector<int>{1, GetDefaultThreadCount()}
+                       : ParseIntList(threads);
+  } catch (const std::exception &) {
+    std::cerr << "Invalid --sizes or --threads list\n";
+    return 1;
+  }
+  threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()),
+                     threadCounts.end());
+  iterations = std::max(1, iterations);
+
+  for (int mp : megapixelList) {
+    if (mp < 1 || mp > 256) {
+      std::cerr << "Sizes must be between 1 and 256 megapixels\n";
+      return 1;
+    }
+  }
+
+  fs::path dir = tempDir.empty() ? fs::temp_directory_path() / "imgViewerBench"
+                                 : fs::u8path(tempDir);
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec) {
+    std::cerr << "Cannot create " << dir.string() << ": " << ec.message()
+              << "\n";
+    return 1;
+  }
+  // EXRImage and TIFFImage map files, so their checks go through the temp
+  // directory
+  if (validateEXR)
+    return ValidateEXR(dir) > 0 ? 1 : 0;
+  if (validateTIFF)
+    return ValidateTIFF(dir) > 0 ? 1 : 0;
+
+  std::vector<BenchResult> results;
+  int failures = 0;
+  for (int mp : megapixelList) {
+    printf("== %d MP ==\n", mp);
+    SyntheticImage ldr = GenerateImage(mp, Content::LDR, 0);
+    SyntheticImage hdr = GenerateImage(mp, Content::HDR, 0);
+    SyntheticImage nan = GenerateImage(mp, Content::HDRWithNaN, 0);
+
+    std::vector<EncodedFile> files = EncodeFiles(ldr, hdr, nan, dir, mp, 0);
+    BenchDecoders(files, mp, iterations, results);
+
+    BenchKernels(ldr, Content::LDR, mp, threadCounts, iterations, results);
+    BenchKernels(hdr, Content::HDR, mp, threadCounts, iterations, results);
+    BenchKernels(nan, Content::HDRWithNaN, mp, threadCounts, iterations,
+                 results);
+    BenchHDRDecode(hdr, mp, threadCounts, iterations, results);
+    BenchDIBDecode(mp, threadCounts, iterations, results);
+    BenchEXRDecode(files, mp, threadCounts, iterations, results);
+    BenchTIFFDecode(files, mp, threadCounts, iterations, results);
+    failures += BenchGIFDecode(dir, files, mp, iterations, results);
+    failures += BenchYUVConvert(dir, mp, threadCounts, iterations, results);
+    BenchBCDecode(mp, threadCounts, iterations, results);
+    BenchPackedRange(mp, threadCounts, iterations, results);
+    failures +=
+        BenchDepthLinearize(dir, mp, threadCounts, iterations, results);
+    failures += BenchMotionField(mp, threadCounts, iterations, results);
+    failures += BenchVolumeSlice(mp, threadCounts, iterations, results);
+    failures += BenchReproject(mp, threadCounts, iterations, results);
+    failures += BenchLighting(mp, threadCounts, iterations, results);
+
+    if (!keepFiles) {
+      for (const EncodedFile &file : files)
+        fs::remove(file.path, ec);
+    }
+  }
+
+  if (!outputFile.empty()) {
+    std::ofstream out(outputFile);
+    if (!out) {
+      std::cerr << "Cannot write " << outputFile << "\n";
+      return 1;
+    }
+    WriteResults(out, results);
+  }
+
+  if (!baselineFile.empty()) {
+    std::map<std::string, double> baseline;
+    if (!ReadBaselineValues(baselineFile, "mpixPerSec", baseline)) {
+      std::cerr << "Cannot read baseline " << baselineFile << "\n";
+      return 1;
+    }
+    int regressions = CompareToBaseline(results, baseline, tolerance);
+    if (regressions > 0) {
+      printf("\n%d stage(s) regressed by more than %.0f%%\n", regressions,
+             tolerance * 100.0);
+      return 1;
+    }
+  }
+  if (failures > 0) {
+    printf("\n%d check(s) found wrong output\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,66 @@
+// Command line renderer for the image view, without a window or GPU.
+//
+// Same as imgViewer --render, in a target built from the core sources only,
+// so previews and golden images can be produced on servers and in CI:
+//
+//   imgViewerRender input.hdr --render out.png --zoom 2 --range 0,4
+#include "HeadlessRender.h"
+#include "Profiler.h"
+#include <boost/program_options.hpp>
+#include <exception>
+#include <iostream>
+#include <string>
+
+namespace po = boost::program_options;
+
+int main(int argc, char **argv) {
+  HeadlessRenderOptions options;
+  std::string traceFile;
+
+  try {
+    po::options_description desc("Allowed options");
+    desc.add_options()("help,h", "produce help message")(
+        "input-file", po::value<std::string>(&options.inputFile),
+        "input file to render")(
+        "render", po::value<std::string>(&options.outputFile)->required(),
+        "PNG file to write the view to")(
+        "raw", po::value<std::string>(&options.raw),
+        "layout of a raw dump or YUV frame dump input-file, as "
+        "width,height,format[,rowPitch[,offset[,flip]]]")(
+        "zoom", po::value<float>(&options.zoom)->default_value(1.0f),
+        "view zoom")("pan", po::value<std::string>(&options.pan),
+                     "view pan, as x,y in screen pixels")(
+        "range", po::value<std::string>(&options.range),
+        "value range, as min,max (default: auto)")(
+        "size", po::value<std::string>(&options.size),
+        "output size, as WxH (default: zoomed image size)")(
+        "trace", po::value<std::string>(&traceFile),
+        "write a Chrome trace of the timing zones");
+
+    po::positional_options_description p;
+    p.add("input-file", -1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv)
+                  .options(desc)
+                  .positional(p)
+                  .run(),
+              vm);
+    if (vm.count("help")) {
+      std::cout << desc << "\n";
+      return 0;
+    }
+    po::notify(vm);
+  } catch (const std::exception &e) {
+    std::cerr << "Error parsing command line arguments: " << e.what() << "\n";
+    return 1;
+  }
+
+  if (!traceFile.empty()) {
+    Profiler::Get().Enable(traceFile);
+    Profiler::Get().SetThreadName("Main");
+  }
+  int result = RunHeadlessRender(options);
+  Profiler::Get().WriteTrace();
+  return result;
+}
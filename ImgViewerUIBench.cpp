@@ -0,0 +1,510 @@
+// Headless replay benchmark for the ImgViewerUI frame cost.
+//
+// Drives ImGui without a platform or renderer backend (the UI is built with
+// IMGVIEWER_HEADLESS, so DX12Renderer/ImageRenderer are stand-ins), replays
+// an input script and reports per-frame CPU time percentiles and allocation
+// counts:
+//
+//   imgViewerUIBench --image big.hdr --script session.txt --out ui.json
+//   imgViewerUIBench --megapixels 64 --baseline ui.json --tolerance 0.15
+//
+// Scripts are recorded by the app with --record-input. Without --script a
+// built-in session (hover, zoom, pan, range handle drags, magnifier) is used.
+#include "BenchCommon.h"
+#include "ImgViewerUI.h"
+#include "InputScript.h"
+#include "Profiler.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "stb_image_write.h"
+#include <algorithm>
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+namespace fs = std::filesystem;
+
+// ---- Allocation counting ----
+
+// Counts every operator new and ImGui allocation made by the process
+static std::atomic<uint64_t> g_AllocCount{0};
+static std::atomic<uint64_t> g_AllocBytes{0};
+
+static inline void CountAllocation(size_t size) {
+  g_AllocCount.fetch_add(1, std::memory_order_relaxed);
+  g_AllocBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void *operator new(size_t size) {
+  CountAllocation(size);
+  void *ptr = std::malloc(size ? size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+static void *CountingImGuiAlloc(size_t size, void *) {
+  CountAllocation(size);
+  return std::malloc(size);
+}
+
+static void CountingImGuiFree(void *ptr, void *) { std::free(ptr); }
+
+// ---- Headless ImGui ----
+
+static void InitImGui(float width, float height) {
+  ImGui::SetAllocatorFunctions(CountingImGuiAlloc, CountingImGuiFree);
+  ImGui::CreateContext();
+
+  // Same configuration as the app, minus the backends
+  ImGuiIO &io = ImGui::GetIO();
+  io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+  io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+  io.IniFilename = nullptr;
+  io.DisplaySize = ImVec2(width, height);
+  io.BackendPlatformName = "imgViewerUIBench";
+  io.BackendRendererName = "imgViewerUIBench";
+  ImGui::StyleColorsDark();
+
+  // Body and title fonts, like main.cpp (the built-in font, as the Windows
+  // fonts are not available everywhere)
+  io.Fonts->AddFontDefault();
+  ImFontConfig titleFont;
+  titleFont.SizePixels = 24.0f;
+  io.Fonts->AddFontDefault(&titleFont);
+
+#if IMGUI_VERSION_NUM >= 19200
+  io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+#else
+  unsigned char *pixels = nullptr;
+  int atlasWidth = 0, atlasHeight = 0;
+  io.Fonts->GetTexDataAsRGBA32(&pixels, &atlasWidth, &atlasHeight);
+  io.Fonts->SetTexID((ImTextureID)1);
+#endif
+}
+
+// Plays the part of the renderer backend for ImGui's texture requests
+static void ProcessTextureRequests() {
+#if IMGUI_VERSION_NUM >= 19200
+  for (ImTextureData *texture : ImGui::GetPlatformIO().Textures) {
+    if (texture->Status == ImTextureStatus_WantCreate ||
+        texture->Status == ImTextureStatus_WantUpdates) {
+      texture->SetTexID((ImTextureID)1);
+      texture->SetStatus(ImTextureStatus_OK);
+    } else if (texture->Status == ImTextureStatus_WantDestroy) {
+      texture->SetTexID(ImTextureID_Invalid);
+      texture->SetStatus(ImTextureStatus_Destroyed);
+    }
+  }
+#endif
+}
+
+// ---- Built-in session ----
+
+namespace {
+/**
+ * @brief Appends frames to an input script.
+ */
+class ScriptBuilder {
+public:
+  ScriptBuilder(std::vector<InputFrame> &frames, const InputFrame &start)
+      : m_frames(frames), m_state(start) {}
+
+  /// Moves the mouse linearly to (x, y) over the given number of frames
+  void Move(float x, float y, int frameCount) {
+    if (m_state.mouseX == -FLT_MAX || m_state.mouseY == -FLT_MAX) {
+      // Mouse enters the window: jump straight there
+      m_state.mouseX = x;
+      m_state.mouseY = y;
+    }
+    float startX = m_state.mouseX, startY = m_state.mouseY;
+    for (int i = 1; i <= frameCount; i++) {
+      float t = (float)i / frameCount;
+      m_state.mouseX = startX + (x - startX) * t;
+      m_state.mouseY = startY + (y - startY) * t;
+      Emit();
+    }
+  }
+
+  void Press(ImGuiMouseButton button) {
+    m_state.mouseButtons |= 1u << button;
+    Emit();
+  }
+
+  void Release(ImGuiMouseButton button) {
+    m_state.mouseButtons &= ~(1u << button);
+    Emit();
+  }
+
+  void Wheel(float delta, int frameCount) {
+    for (int i = 0; i < frameCount; i++) {
+      m_state.wheel = delta;
+      Emit();
+    }
+    m_state.wheel = 0.0f;
+  }
+
+  void Idle(int frameCount) {
+    for (int i = 0; i < frameCount; i++)
+      Emit();
+  }
+
+private:
+  void Emit() { m_frames.push_back(m_state); }
+
+  std::vector<InputFrame> &m_frames;
+  InputFrame m_state;
+};
+} // namespace
+
+static bool GetWorkRect(const char *windowName, ImRect &rect) {
+  ImGuiWindow *window = ImGui::FindWindowByName(windowName);
+  if (!window)
+    return false;
+  rect = window->WorkRect;
+  return rect.GetWidth() > 0.0f && rect.GetHeight() > 0.0f;
+}
+
+/**
+ * @brief Builds the default session from the current window layout.
+ */
+static bool BuildDefaultScript(const InputFrame &start,
+                               std::vector<InputFrame> &frames) {
+  ImRect view, plot;
+  if (!GetWorkRect("Image View", view) || !GetWorkRect("Plot", plot))
+    return false;
+
+  ScriptBuilder script(frames, start);
+  ImVec2 center = view.GetCenter();
+  float w = view.GetWidth(), h = view.GetHeight();
+
+  // Hover sweep: pixel readout and crosshair
+  script.Move(view.Min.x + w * 0.1f, view.Min.y + h * 0.1f, 1);
+  script.Move(view.Max.x - w * 0.1f, view.Max.y - h * 0.1f, 120);
+
+  // Zoom in and out around the center
+  script.Move(center.x, center.y, 10);
+  script.Wheel(1.0f, 30);
+  script.Wheel(-1.0f, 30);
+
+  // Pan with the middle button
+  script.Press(ImGuiMouseButton_Middle);
+  script.Move(center.x + w * 0.2f, center.y + h * 0.15f, 60);
+  script.Move(center.x - w * 0.2f, center.y - h * 0.15f, 60);
+  script.Release(ImGuiMouseButton_Middle);
+
+  // Drag the range handles. After a load they sit at the plot edges, and the
+  // plot fills the bottom of its window.
+  float plotY = plot.Max.y - 8.0f;
+  script.Move(plot.Min.x + 2.0f, plotY, 10);
+  script.Press(ImGuiMouseButton_Left);
+  script.Move(plot.Min.x + plot.GetWidth() * 0.3f, plotY, 60);
+  script.Release(ImGuiMouseButton_Left);
+  script.Move(plot.Max.x - 2.0f, plotY, 10);
+  script.Press(ImGuiMouseButton_Left);
+  script.Move(plot.Max.x - plot.GetWidth() * 0.3f, plotY, 60);
+  script.Release(ImGuiMouseButton_Left);
+
+  // Magnifier: right button held while moving over the image
+  script.Move(center.x, center.y, 10);
+  script.Press(ImGuiMouseButton_Right);
+  script.Move(center.x + w * 0.25f, center.y, 60);
+  script.Move(center.x, center.y + h * 0.25f, 60);
+  script.Release(ImGuiMouseButton_Right);
+
+  script.Idle(30);
+  return true;
+}
+
+// ---- Statistics ----
+
+static double Percentile(std::vector<double> values, double fraction) {
+  if (values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  size_t index = (size_t)(fraction * (double)(values.size() - 1) + 0.5);
+  return values[std::min(index, values.size() - 1)];
+}
+
+static double Mean(const std::vector<double> &values) {
+  double sum = 0.0;
+  for (double value : values)
+    sum += value;
+  return values.empty() ? 0.0 : sum / (double)values.size();
+}
+
+namespace {
+struct Metric {
+  std::string name;
+  double value;
+  const char *unit;
+};
+} // namespace
+
+static void AddDistribution(std::vector<Metric> &metrics, const char *prefix,
+                            const std::vector<double> &values,
+                            const char *unit) {
+  std::string name = prefix;
+  metrics.push_back({name + "/mean", Mean(values), unit});
+  metrics.push_back({name + "/p50", Percentile(values, 0.50), unit});
+  metrics.push_back({name + "/p90", Percentile(values, 0.90), unit});
+  metrics.push_back({name + "/p99", Percentile(values, 0.99), unit});
+  metrics.push_back({name + "/max", Percentile(values, 1.0), unit});
+}
+
+static void WriteMetrics(std::ostream &out, const std::vector<Metric> &metrics,
+                         size_t frameCount) {
+  // One result per line, readable by ReadBaselineValues
+  out << "{\n  \"frames\": " << frameCount << ",\n  \"results\": [\n";
+  for (size_t i = 0; i < metrics.size(); i++) {
+    char line[256];
+    snprintf(line, sizeof(line),
+             "    {\"name\": \"%s\", \"value\": %.6f, \"unit\": \"%s\"}%s\n",
+             metrics[i].name.c_str(), metrics[i].value, metrics[i].unit,
+             i + 1 < metrics.size() ? "," : "");
+    out << line;
+  }
+  out << "  ]\n}\n";
+}
+
+/**
+ * @brief Compares metrics (lower is better) against a baseline.
+ * @return Number of metrics that grew by more than tolerance.
+ */
+static int CompareToBaseline(const std::vector<Metric> &metrics,
+                             const std::map<std::string, double> &baseline,
+                             double tolerance) {
+  int regressions = 0;
+  printf("\n%-24s %12s %12s %8s\n", "Metric", "Baseline", "Current", "Change");
+  for (const Metric &metric : metrics) {
+    auto it = baseline.find(metric.name);
+    if (it == baseline.end())
+      continue;
+
+    bool regressed = metric.value > it->second * (1.0 + tolerance);
+    double change =
+        it->second > 0.0 ? metric.value / it->second - 1.0 : 0.0;
+    if (regressed)
+      regressions++;
+    printf("%-24s %12.3f %12.3f %+7.1f%%%s\n", metric.name.c_str(),
+           it->second, metric.value, change * 100.0,
+           regressed ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+// ---- Main ----
+
+static bool WriteSyntheticImage(const fs::path &path, int megapixels) {
+  int side = (int)std::sqrt((double)megapixels * 1024.0 * 1024.0);
+  std::vector<float> pixels((size_t)side * side * 3);
+  for (int y = 0; y < side; y++) {
+    for (int x = 0; x < side; x++) {
+      float *pixel = &pixels[((size_t)y * side + x) * 3];
+      float exposure = std::exp2((float)x / side * 8.0f - 4.0f);
+      pixel[0] = (float)x / side * exposure;
+      pixel[1] = (float)y / side * exposure;
+      pixel[2] = 0.5f * exposure;
+    }
+  }
+  return stbi_write_hdr(path.u8string().c_str(), side, side, 3,
+                        pixels.data()) != 0;
+}
+
+int main(int argc, char **argv) {
+  std::string imageFile;
+  int megapixels = 16;
+  std::string scriptFile;
+  int warmupFrames = 10;
+  int repeat = 3;
+  std::string outputFile;
+  std::string baselineFile;
+  double tolerance = 0.15;
+  std::string traceFile;
+
+  try {
+    po::options_description desc("Allowed options");
+    desc.add_options()("help,h", "produce help message")(
+        "image", po::value<std::string>(&imageFile),
+        "image to load (default: synthetic HDR image)")(
+        "megapixels", po::value<int>(&megapixels)->default_value(16),
+        "size of the synthetic image")(
+        "script", po::value<std::string>(&scriptFile),
+        "input script recorded with imgViewer --record-input (default: "
+        "built-in session)")(
+        "warmup", po::value<int>(&warmupFrames)->default_value(10),
+        "idle frames before measuring")(
+        "repeat", po::value<int>(&repeat)->default_value(3),
+        "number of times the script is replayed")(
+        "out", po::value<std::string>(&outputFile),
+        "write results to a JSON file")(
+        "baseline", po::value<std::string>(&baselineFile),
+        "compare against a JSON file written by --out")(
+        "tolerance", po::value<double>(&tolerance)->default_value(0.15),
+        "allowed increase relative to the baseline (0.15 = 15%)")(
+        "trace", po::value<std::string>(&traceFile),
+        "write a Chrome trace of the timing zones");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+      std::cout << desc << "\n";
+      return 0;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Error parsing command line arguments: " << e.what() << "\n";
+    return 1;
+  }
+
+  std::vector<InputFrame> script;
+  if (!scriptFile.empty() && !LoadInputScript(scriptFile, script)) {
+    std::cerr << "Cannot read input script " << scriptFile << "\n";
+    return 1;
+  }
+
+  if (!traceFile.empty()) {
+    Profiler::Get().Enable(traceFile);
+    Profiler::Get().SetThreadName("Main");
+  }
+
+  fs::path syntheticPath;
+  if (imageFile.empty()) {
+    syntheticPath = fs::temp_directory_path() /
+                    ("imgViewerUIBench_" + std::to_string(megapixels) + ".hdr");
+    if (!WriteSyntheticImage(syntheticPath, std::max(1, megapixels))) {
+      std::cerr << "Cannot write " << syntheticPath.string() << "\n";
+      return 1;
+    }
+    imageFile = syntheticPath.u8string();
+  }
+
+  InputFrame idle = script.empty() ? InputFrame() : script.front();
+  idle.mouseButtons = 0;
+  idle.wheel = 0.0f;
+  InitImGui(idle.displayWidth, idle.displayHeight);
+
+  DX12Renderer renderer;
+  renderer.OnResize((UINT)idle.displayWidth, (UINT)idle.displayHeight);
+  ImgViewerUI ui;
+  ui.Initialize(&renderer);
+  ui.HandleDragDrop(imageFile);
+  if (!ui.GetImgViewer().HasImage()) {
+    std::cerr << "Failed to load " << imageFile << "\n";
+    return 1;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> frameMs, uiMs, allocations, allocatedKB;
+  InputFrame previous = idle;
+
+  auto runFrame = [&](const InputFrame &frame, bool measure) {
+    ApplyInputFrame(frame, previous);
+    previous = frame;
+
+    uint64_t allocStart = g_AllocCount.load(std::memory_order_relaxed);
+    uint64_t bytesStart = g_AllocBytes.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+
+    ImGui::NewFrame();
+    auto uiStart = Clock::now();
+    ui.Render();
+    auto uiEnd = Clock::now();
+    ImGui::Render();
+    ui.RenderImageToTexture(renderer.GetCommandList());
+
+    auto end = Clock::now();
+    uint64_t allocEnd = g_AllocCount.load(std::memory_order_relaxed);
+    uint64_t bytesEnd = g_AllocBytes.load(std::memory_order_relaxed);
+
+    ProcessTextureRequests();
+    ui.OnFramePresented();
+
+    if (measure) {
+      frameMs.push_back(
+          std::chrono::duration<double, std::milli>(end - start).count());
+      uiMs.push_back(
+          std::chrono::duration<double, std::milli>(uiEnd - uiStart).count());
+      allocations.push_back((double)(allocEnd - allocStart));
+      allocatedKB.push_back((double)(bytesEnd - bytesStart) / 1024.0);
+    }
+  };
+
+  // Let the docking layout settle before building or replaying the script
+  for (int i = 0; i < std::max(2, warmupFrames); i++)
+    runFrame(idle, false);
+
+  if (script.empty() && !BuildDefaultScript(idle, script)) {
+    std::cerr << "Cannot find the UI windows to build the default session\n";
+    return 1;
+  }
+
+  for (int pass = 0; pass < std::max(1, repeat); pass++) {
+    if (pass > 0) {
+      // Reload so view, range and handles start from the same state
+      ui.HandleDragDrop(imageFile);
+      runFrame(idle, false);
+    }
+    for (const InputFrame &frame : script)
+      runFrame(frame, true);
+    runFrame(idle, false);
+  }
+
+  ImGui::DestroyContext();
+  if (!syntheticPath.empty()) {
+    std::error_code ec;
+    fs::remove(syntheticPath, ec);
+  }
+
+  std::vector<Metric> metrics;
+  AddDistribution(metrics, "frame", frameMs, "ms");
+  AddDistribution(metrics, "ui", uiMs, "ms");
+  AddDistribution(metrics, "allocs", allocations, "count");
+  AddDistribution(metrics, "allocKB", allocatedKB, "KB");
+
+  printf("%zu frames replayed\n", frameMs.size());
+  for (const Metric &metric : metrics)
+    printf("%-16s %12.3f %s\n", metric.name.c_str(), metric.value,
+           metric.unit);
+
+  Profiler::Get().WriteTrace();
+
+  if (!outputFile.empty()) {
+    std::ofstream out(outputFile);
+    if (!out) {
+      std::cerr << "Cannot write " << outputFile << "\n";
+      return 1;
+    }
+    WriteMetrics(out, metrics, frameMs.size());
+  }
+
+  if (!baselineFile.empty()) {
+    std::map<std::string, double> baseline;
+    if (!ReadBaselineValues(baselineFile, "value", baseline)) {
+      std::cerr << "Cannot read baseline " << baselineFile << "\n";
+      return 1;
+    }
+    int regressions = CompareToBaseline(metrics, baseline, tolerance);
+    if (regressions > 0) {
+      printf("\n%d metric(s) regressed by more than %.0f%%\n", regressions,
+             tolerance * 100.0);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include "InputScript.h"
+#include <cstdio>
+#include <sstream>
+
+// Mouse buttons tracked in scripts (left, right, middle)
+static const int g_ScriptMouseButtons = 3;
+
+bool LoadInputScript(const std::string &filename,
+                     std::vector<InputFrame> &frames) {
+  std::ifstream file(filename);
+  if (!file.is_open())
+    return false;
+
+  frames.clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream stream(line);
+    InputFrame frame;
+    int ctrl = 0;
+    stream >> frame.deltaTime >> frame.displayWidth >> frame.displayHeight >>
+        frame.mouseX >> frame.mouseY >> frame.mouseButtons >> frame.wheel >>
+        ctrl;
+    if (stream.fail())
+      return false;
+
+    frame.ctrl = ctrl != 0;
+    frames.push_back(frame);
+  }
+  return true;
+}
+
+void ApplyInputFrame(const InputFrame &frame, const InputFrame &previous) {
+  ImGuiIO &io = ImGui::GetIO();
+  io.DisplaySize = ImVec2(frame.displayWidth, frame.displayHeight);
+  io.DeltaTime = frame.deltaTime > 0.0f ? frame.deltaTime : 1.0f / 60.0f;
+
+  if (frame.mouseX != previous.mouseX || frame.mouseY != previous.mouseY)
+    io.AddMousePosEvent(frame.mouseX, frame.mouseY);
+
+  for (int button = 0; button < g_ScriptMouseButtons; button++) {
+    bool down = (frame.mouseButtons & (1u << button)) != 0;
+    bool wasDown = (previous.mouseButtons & (1u << button)) != 0;
+    if (down != wasDown)
+      io.AddMouseButtonEvent(button, down);
+  }
+
+  if (frame.wheel != 0.0f)
+    io.AddMouseWheelEvent(0.0f, frame.wheel);
+
+  if (frame.ctrl != previous.ctrl)
+    io.AddKeyEvent(ImGuiMod_Ctrl, frame.ctrl);
+}
+
+bool InputRecorder::Open(const std::string &filename) {
+  Close();
+  m_file.open(filename, std::ios::out | std::ios::trunc);
+  if (!m_file.is_open())
+    return false;
+
+  m_file << "# ImgViewer input script\n"
+         << "# deltaTime displayWidth displayHeight mouseX mouseY buttons "
+            "wheel ctrl\n";
+  return true;
+}
+
+void InputRecorder::RecordFrame(const ImGuiIO &io) {
+  if (!m_file.is_open())
+    return;
+
+  unsigned int buttons = 0;
+  for (int button = 0; button < g_ScriptMouseButtons; button++) {
+    if (io.MouseDown[button])
+      buttons |= 1u << button;
+  }
+
+  // An invalid mouse position is stored as -FLT_MAX so replay matches
+  float mouseX = ImGui::IsMousePosValid(&io.MousePos) ? io.MousePos.x : -FLT_MAX;
+  float mouseY = ImGui::IsMousePosValid(&io.MousePos) ? io.MousePos.y : -FLT_MAX;
+
+  char line[256];
+  snprintf(line, sizeof(line), "%.6f %g %g %.9g %.9g %u %g %d\n", io.DeltaTime,
+           io.DisplaySize.x, io.DisplaySize.y, mouseX, mouseY, buttons,
+           io.MouseWheel, io.KeyCtrl ? 1 : 0);
+  m_file << line;
+}
+
+void InputRecorder::Close() {
+  if (m_file.is_open())
+    m_file.close();
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "imgui.h"
+#include <cfloat>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Mouse and keyboard state of one UI frame.
+ *
+ * Input scripts are text files with one frame per line:
+ * `deltaTime displayWidth displayHeight mouseX mouseY buttons wheel ctrl`,
+ * where buttons has bit i set while ImGuiMouseButton i is down. Lines
+ * starting with '#' are comments.
+ */
+struct InputFrame {
+  float deltaTime = 1.0f / 60.0f;
+  float displayWidth = 1600.0f;
+  float displayHeight = 900.0f;
+  float mouseX = -FLT_MAX; ///< -FLT_MAX = mouse outside the window
+  float mouseY = -FLT_MAX;
+  unsigned int mouseButtons = 0;
+  float wheel = 0.0f;
+  bool ctrl = false;
+};
+
+/**
+ * @brief Reads an input script.
+ * @return False if the file cannot be opened or a line is malformed.
+ */
+bool LoadInputScript(const std::string &filename,
+                     std::vector<InputFrame> &frames);
+
+/**
+ * @brief Queues the ImGui input events that turn `previous` into `frame` and
+ * sets the display size and delta time. Call before ImGui::NewFrame().
+ */
+void ApplyInputFrame(const InputFrame &frame, const InputFrame &previous);
+
+/**
+ * @brief Records the ImGui input of each frame to an input script.
+ */
+class InputRecorder {
+public:
+  bool Open(const std::string &filename);
+  bool IsOpen() const { return m_file.is_open(); }
+
+  /**
+   * @brief Appends the current frame's input.
+   * \note Call after ImGui::NewFrame(), when io holds this frame's state.
+   */
+  void RecordFrame(const ImGuiIO &io);
+
+  void Close();
+
+private:
+  std::ofstream m_file;
+};
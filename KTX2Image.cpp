@@ -0,0 +1,437 @@
+#include "KTX2Image.h"
+#include "BCDecoder.h"
+#include "HalfFloat.h"
+#include "Logger.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+#include <zstd.h>
+
+namespace {
+
+// Supercompression schemes (KTX2 spec, section 3.9.1)
+enum : uint32_t {
+  SupercompressionNone = 0,
+  SupercompressionBasisLZ = 1,
+  SupercompressionZstd = 2,
+  SupercompressionZlib = 3,
+};
+
+enum class ComponentType { UNorm8, UNorm16, Float16, Float32, Block };
+
+struct VkFormatInfo {
+  uint32_t vkFormat;
+  const char *name;
+  int channels;
+  ComponentType type;
+  bool bgr;          // Stored as BGR(A)
+  BCFormat bcFormat; // For ComponentType::Block
+};
+
+// Formats the viewer reads. sRGB data is shown as stored.
+const VkFormatInfo g_VkFormats[] = {
+    {9, "R8", 1, ComponentType::UNorm8, false},
+    {15, "R8 sRGB", 1, ComponentType::UNorm8, false},
+    {16, "RG8", 2, ComponentType::UNorm8, false},
+    {22, "RG8 sRGB", 2, ComponentType::UNorm8, false},
+    {23, "RGB8", 3, ComponentType::UNorm8, false},
+    {29, "RGB8 sRGB", 3, ComponentType::UNorm8, false},
+    {30, "BGR8", 3, ComponentType::UNorm8, true},
+    {36, "BGR8 sRGB", 3, ComponentType::UNorm8, true},
+    {37, "RGBA8", 4, ComponentType::UNorm8, false},
+    {43, "RGBA8 sRGB", 4, ComponentType::UNorm8, false},
+    {44, "BGRA8", 4, ComponentType::UNorm8, true},
+    {50, "BGRA8 sRGB", 4, ComponentType::UNorm8, true},
+    {70, "R16", 1, ComponentType::UNorm16, false},
+    {76, "R16F", 1, ComponentType::Float16, false},
+    {77, "RG16", 2, ComponentType::UNorm16, false},
+    {83, "RG16F", 2, ComponentType::Float16, false},
+    {84, "RGB16", 3, ComponentType::UNorm16, false},
+    {90, "RGB16F", 3, ComponentType::Float16, false},
+    {91, "RGBA16", 4, ComponentType::UNorm16, false},
+    {97, "RGBA16F", 4, ComponentType::Float16, false},
+    {100, "R32F", 1, ComponentType::Float32, false},
+    {103, "RG32F", 2, ComponentType::Float32, false},
+    {106, "RGB32F", 3, ComponentType::Float32, false},
+    {109, "RGBA32F", 4, ComponentType::Float32, false},
+    {131, "BC1 RGB", 3, ComponentType::Block, false, BCFormat::BC1},
+    {132, "BC1 RGB sRGB", 3, ComponentType::Block, false, BCFormat::BC1},
+    {133, "BC1", 4, ComponentType::Block, false, BCFormat::BC1},
+    {134, "BC1 sRGB", 4, ComponentType::Block, false, BCFormat::BC1},
+    {135, "BC2", 4, ComponentType::Block, false, BCFormat::BC2},
+    {136, "BC2 sRGB", 4, ComponentType::Block, false, BCFormat::BC2},
+    {137, "BC3", 4, ComponentType::Block, false, BCFormat::BC3},
+    {138, "BC3 sRGB", 4, ComponentType::Block, false, BCFormat::BC3},
+    {139, "BC4", 1, ComponentType::Block, false, BCFormat::BC4U},
+    {140, "BC4 SNORM", 1, ComponentType::Block, false, BCFormat::BC4S},
+    {141, "BC5", 2, ComponentType::Block, false, BCFormat::BC5U},
+    {142, "BC5 SNORM", 2, ComponentType::Block, false, BCFormat::BC5S},
+    {143, "BC6H UF16", 3, ComponentType::Block, false, BCFormat::BC6HU},
+    {144, "BC6H SF16", 3, ComponentType::Block, false, BCFormat::BC6HS},
+    {145, "BC7", 4, ComponentType::Block, false, BCFormat::BC7},
+    {146, "BC7 sRGB", 4, ComponentType::Block, false, BCFormat::BC7},
+};
+
+int FindVkFormat(uint32_t vkFormat) {
+  for (int i = 0; i < (int)(sizeof(g_VkFormats) / sizeof(g_VkFormats[0]));
+       i++) {
+    if (g_VkFormats[i].vkFormat == vkFormat)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * @brief Gets the size of one tightly packed 2D image in bytes.
+ */
+size_t GetImageSize(const VkFormatInfo &info, int width, int height) {
+  size_t componentSize = 0;
+  switch (info.type) {
+  case ComponentType::UNorm8:
+    componentSize = 1;
+    break;
+  case ComponentType::UNorm16:
+  case ComponentType::Float16:
+    componentSize = 2;
+    break;
+  case ComponentType::Float32:
+    componentSize = 4;
+    break;
+  case ComponentType::Block:
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) *
+           GetBCBlockSize(info.bcFormat);
+  }
+  return (size_t)width * height * info.channels * componentSize;
+}
+
+uint32_t ReadU32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t ReadU64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/**
+ * @brief Expands tightly packed rows of T components to RGBA32F.
+ * Missing channels become (r, 0, 0, 1).
+ */
+template <typename T, typename Convert>
+void ConvertImage(const uint8_t *src, const VkFormatInfo &info, int width,
+                  int height, float *dst, Convert convert) {
+  size_t srcStride = (size_t)width * info.channels * sizeof(T);
+  ParallelFor(height, 0, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      const uint8_t *srcRow = src + y * srcStride;
+      float *dstRow = dst + (size_t)y * width * 4;
+
+      for (int x = 0; x < width; x++) {
+        float rgba[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        for (int c = 0; c < info.channels; c++) {
+          T value;
+          memcpy(&value, srcRow + ((size_t)x * info.channels + c) * sizeof(T),
+                 sizeof(T));
+          rgba[c] = convert(value);
+        }
+        if (info.bgr)
+          std::swap(rgba[0], rgba[2]);
+        memcpy(dstRow + (size_t)x * 4, rgba, sizeof(rgba));
+      }
+    }
+  });
+}
+
+} // namespace
+
+/**
+ * @brief Streaming decompressor for one supercompressed level.
+ */
+struct KTX2Image::Inflater {
+  int mip = -1;
+  std::vector<uint8_t> output;
+  size_t outputSize = 0; // Bytes inflated so far
+  ZSTD_DStream *zstd = nullptr;
+  ZSTD_inBuffer zstdInput = {};
+  z_stream zlib = {};
+  bool zlibActive = false;
+
+  ~Inflater() { Reset(); }
+
+  void Reset() {
+    if (zstd)
+      ZSTD_freeDStream(zstd);
+    zstd = nullptr;
+    if (zlibActive)
+      inflateEnd(&zlib);
+    zlibActive = false;
+    mip = -1;
+    outputSize = 0;
+  }
+};
+
+KTX2Image::KTX2Image() : m_inflater(std::make_unique<Inflater>()) {}
+
+KTX2Image::~KTX2Image() = default;
+
+bool KTX2Image::Open(const std::string &filepath) {
+  PROFILE_SCOPE("KTX2 Open");
+  static const uint8_t s_Identifier[12] = {0xAB, 'K',  'T',  'X', ' ',  '2',
+                                           '0',  0xBB, '\r', '\n', 0x1A, '\n'};
+  const size_t headerSize = 80; // Identifier, header and index
+  const size_t levelEntrySize = 24;
+
+  m_levels.clear();
+  m_inflater->Reset();
+
+  if (!m_file.Open(filepath)) {
+    LOG_ERROR("Failed to open KTX2 file: %s", filepath.c_str());
+    return false;
+  }
+
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+  if (size < headerSize || memcmp(data, s_Identifier, 12) != 0) {
+    LOG_ERROR("Not a KTX2 file: %s", filepath.c_str());
+    return false;
+  }
+
+  m_vkFormat = ReadU32(data + 12);
+  uint32_t pixelWidth = ReadU32(data + 20);
+  uint32_t pixelHeight = ReadU32(data + 24);
+  uint32_t pixelDepth = ReadU32(data + 28);
+  uint32_t layerCount = ReadU32(data + 32);
+  uint32_t faceCount = ReadU32(data + 36);
+  uint32_t levelCount = ReadU32(data + 40);
+  m_supercompression = ReadU32(data + 44);
+
+  if (pixelWidth == 0 || pixelWidth > 65536 || pixelHeight > 65536 ||
+      pixelDepth > 65536 || layerCount > 65536 ||
+      (faceCount != 1 && faceCount != 6) || levelCount > 32) {
+    LOG_ERROR("Invalid KTX2 header: %s", filepath.c_str());
+    return false;
+  }
+
+  m_formatIndex = FindVkFormat(m_vkFormat);
+  if (m_formatIndex < 0) {
+    LOG_ERROR("Unsupported KTX2 vkFormat %u: %s", m_vkFormat,
+              filepath.c_str());
+    return false;
+  }
+
+  if (m_supercompression != SupercompressionNone &&
+      m_supercompression != SupercompressionZstd &&
+      m_supercompression != SupercompressionZlib) {
+    LOG_ERROR("Unsupported KTX2 supercompression scheme %u: %s",
+              m_supercompression, filepath.c_str());
+    return false;
+  }
+
+  // levelCount 0 asks the loader to generate mips; only level 0 is stored
+  uint32_t storedLevels = levelCount > 0 ? levelCount : 1;
+  if (size < headerSize + storedLevels * levelEntrySize) {
+    LOG_ERROR("Truncated KTX2 level index: %s", filepath.c_str());
+    return false;
+  }
+
+  for (uint32_t i = 0; i < storedLevels; i++) {
+    const uint8_t *entry = data + headerSize + i * levelEntrySize;
+    Level level;
+    level.offset = ReadU64(entry);
+    level.length = ReadU64(entry + 8);
+    level.uncompressedLength = ReadU64(entry + 16);
+    if (level.offset > size || level.length > size - level.offset) {
+      LOG_ERROR("KTX2 level %u is out of bounds: %s", i, filepath.c_str());
+      return false;
+    }
+    if (m_supercompression == SupercompressionNone)
+      level.uncompressedLength = level.length;
+    m_levels.push_back(level);
+  }
+
+  const VkFormatInfo &info = g_VkFormats[m_formatIndex];
+  m_layout = SubresourceLayout();
+  m_layout.width = (int)pixelWidth;
+  m_layout.height = pixelHeight > 0 ? (int)pixelHeight : 1;
+  m_layout.depth = pixelDepth > 0 ? (int)pixelDepth : 1;
+  m_layout.mipLevels = (int)storedLevels;
+  m_layout.arraySize = layerCount > 0 ? (int)layerCount : 1;
+  m_layout.faceCount = (int)faceCount;
+  m_layout.format = "KTX2";
+  m_layout.pixelFormat = info.name;
+  m_layout.channels = info.channels;
+
+  // Supercompressed levels are inflated into a buffer of their declared
+  // size, so it has to be exactly the size of the level's images
+  if (m_supercompression != SupercompressionNone) {
+    for (int mip = 0; mip < m_layout.mipLevels; mip++) {
+      uint64_t imageSize =
+          GetImageSize(info, std::max(1, m_layout.width >> mip),
+                       std::max(1, m_layout.height >> mip));
+      uint64_t imageCount = (uint64_t)m_layout.arraySize *
+                            m_layout.faceCount * m_layout.GetMipDepth(mip);
+      if (imageSize > UINT64_MAX / imageCount ||
+          m_levels[mip].uncompressedLength != imageSize * imageCount) {
+        LOG_ERROR("KTX2 level %d has the wrong uncompressed size: %s", mip,
+                  filepath.c_str());
+        return false;
+      }
+    }
+  }
+
+  LOG("Opened KTX2 %dx%dx%d, %d mips, %d layers, %d faces, %s (scheme %u)",
+      m_layout.width, m_layout.height, m_layout.depth, m_layout.mipLevels,
+      m_layout.arraySize, m_layout.faceCount, info.name, m_supercompression);
+  return true;
+}
+
+const uint8_t *KTX2Image::GetLevelData(int mip, size_t requiredBytes) {
+  const Level &level = m_levels[mip];
+  const uint8_t *stored = m_file.GetData() + level.offset;
+
+  // Uncompressed levels are used in place; only touched pages are read
+  if (m_supercompression == SupercompressionNone)
+    return stored;
+
+  Inflater &inflater = *m_inflater;
+  if (inflater.mip == mip && inflater.outputSize >= requiredBytes)
+    return inflater.output.data();
+
+  PROFILE_SCOPE("KTX2 Inflate");
+  if (inflater.mip != mip) {
+    inflater.Reset();
+    inflater.output.resize((size_t)level.uncompressedLength);
+
+    if (m_supercompression == SupercompressionZstd) {
+      inflater.zstd = ZSTD_createDStream();
+      if (!inflater.zstd || ZSTD_isError(ZSTD_initDStream(inflater.zstd)))
+        return nullptr;
+      inflater.zstdInput = {stored, (size_t)level.length, 0};
+    } else {
+      if (level.length > UINT32_MAX || inflateInit(&inflater.zlib) != Z_OK)
+        return nullptr;
+      inflater.zlibActive = true;
+      inflater.zlib.next_in = const_cast<Bytef *>(stored);
+      inflater.zlib.avail_in = (uInt)level.length;
+    }
+    inflater.mip = mip;
+  }
+
+  // Inflate only up to the end of the requested image
+  if (m_supercompression == SupercompressionZstd) {
+    ZSTD_outBuffer out = {inflater.output.data(), requiredBytes,
+                          inflater.outputSize};
+    while (out.pos < out.size) {
+      size_t previous = out.pos;
+      size_t result =
+          ZSTD_decompressStream(inflater.zstd, &out, &inflater.zstdInput);
+      if (ZSTD_isError(result)) {
+        LOG_ERROR("KTX2 zstd error in level %d: %s", mip,
+                  ZSTD_getErrorName(result));
+        break;
+      }
+      if (result == 0 || out.pos == previous)
+        break; // End of frame or no more input
+    }
+    inflater.outputSize = out.pos;
+  } else {
+    inflater.zlib.next_out = inflater.output.data() + inflater.outputSize;
+    inflater.zlib.avail_out = (uInt)(requiredBytes - inflater.outputSize);
+    int result = inflate(&inflater.zlib, Z_SYNC_FLUSH);
+    if (result != Z_OK && result != Z_STREAM_END)
+      LOG_ERROR("KTX2 zlib error %d in level %d", result, mip);
+    inflater.outputSize = requiredBytes - inflater.zlib.avail_out;
+  }
+
+  if (inflater.outputSize < requiredBytes) {
+    LOG_ERROR("KTX2 level %d is truncated", mip);
+    inflater.Reset();
+    return nullptr;
+  }
+  return inflater.output.data();
+}
+
+bool KTX2Image::Decode(const SubresourceIndex &index, ImageData &out) {
+  PROFILE_SCOPE("KTX2 Decode");
+  // Only stored slices; BrickedVolume slices volumes across other axes
+  if (!m_layout.Contains(index) || index.axis != SliceAxis::Z)
+    return false;
+
+  const VkFormatInfo &info = g_VkFormats[m_formatIndex];
+  int width = std::max(1, m_layout.width >> index.mip);
+  int height = std::max(1, m_layout.height >> index.mip);
+  int depth = m_layout.GetMipDepth(index.mip);
+
+  // Images in a level are tightly packed: layers, then faces, then slices
+  size_t imageSize = GetImageSize(info, width, height);
+  size_t imageIndex =
+      ((size_t)index.layer * m_layout.faceCount + index.face) * depth +
+      index.slice;
+  if ((imageIndex + 1) * imageSize > m_levels[index.mip].uncompressedLength) {
+    LOG_ERROR("KTX2 level %d is smaller than its images", index.mip);
+    return false;
+  }
+
+  const uint8_t *level =
+      GetLevelData(index.mip, (imageIndex + 1) * imageSize);
+  if (!level)
+    return false;
+  const uint8_t *src = level + imageIndex * imageSize;
+
+  out.width = width;
+  out.height = height;
+  out.channels = info.channels;
+  out.format = m_layout.format;
+  out.pixelFormat = info.name;
+  out.vectors = info.channels == 2 && (info.type == ComponentType::Float16 ||
+                                       info.type == ComponentType::Float32);
+
+  // RGBA half floats are kept as stored
+  if (info.type == ComponentType::Float16 && info.channels == 4) {
+    out.pixels.clear();
+    uint8_t *dst;
+    out.stored =
+        AllocatePixelBuffer(PixelFormat::RGBA16F, width, height, dst);
+    memcpy(dst, src, imageSize);
+    return true;
+  }
+
+  out.stored = PixelBuffer();
+  out.pixels.resize((size_t)width * height * 4);
+
+  PROFILE_SCOPE("KTX2 Convert");
+  float *dst = out.pixels.data();
+  switch (info.type) {
+  case ComponentType::UNorm8:
+    ConvertImage<uint8_t>(src, info, width, height, dst,
+                          [](uint8_t v) { return v / 255.0f; });
+    break;
+  case ComponentType::UNorm16:
+    ConvertImage<uint16_t>(src, info, width, height, dst,
+                           [](uint16_t v) { return v / 65535.0f; });
+    break;
+  case ComponentType::Float16:
+    ConvertImage<uint16_t>(src, info, width, height, dst, HalfToFloat);
+    break;
+  case ComponentType::Float32:
+    ConvertImage<float>(src, info, width, height, dst,
+                        [](float v) { return v; });
+    break;
+  case ComponentType::Block:
+    DecodeBCImage(info.bcFormat, src, 0, width, height, dst);
+    if (info.bcFormat == BCFormat::BC1 && info.channels == 3) {
+      // BC1 without alpha: the punch-through entry is opaque black
+      for (size_t i = 3; i < out.pixels.size(); i += 4)
+        out.pixels[i] = 1.0f;
+    }
+    break;
+  }
+  return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "ImageSource.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief KTX2 texture read through a memory mapping.
+ *
+ * Open() parses the header and level index only. Decode() touches just the
+ * image it needs: uncompressed levels are read straight from the mapping,
+ * Zstandard/zlib supercompressed levels are streamed only as far as the
+ * requested layer/face/slice and the partial level is kept, so stepping
+ * through an array continues where the last decode stopped.
+ * BasisLZ/UASTC transcoding is not supported.
+ */
+class KTX2Image : public ImageSource {
+public:
+  KTX2Image();
+  ~KTX2Image() override;
+
+  /**
+   * @brief Maps the file and reads its header and level index.
+   * @return False if the file is not a KTX2 file or uses an unsupported
+   * format or supercompression scheme.
+   */
+  bool Open(const std::string &filepath);
+
+  const SubresourceLayout &GetLayout() const override { return m_layout; }
+
+  bool Decode(const SubresourceIndex &index, ImageData &out) override;
+
+private:
+  struct Level {
+    uint64_t offset;             ///< Byte offset in the file
+    uint64_t length;             ///< Stored (possibly compressed) size
+    uint64_t uncompressedLength; ///< Size after supercompression is undone
+  };
+
+  struct Inflater;
+
+  /**
+   * @brief Gets the uncompressed bytes of a mip level.
+   * @param requiredBytes Prefix of the level that must be available.
+   * @return nullptr if the level cannot be read or inflated.
+   */
+  const uint8_t *GetLevelData(int mip, size_t requiredBytes);
+
+  MappedFile m_file;
+  SubresourceLayout m_layout;
+  uint32_t m_vkFormat = 0;
+  uint32_t m_supercompression = 0;
+  int m_formatIndex = -1; // Entry in the supported format table
+  std::vector<Level> m_levels;
+
+  // Partially inflated level of a supercompressed file
+  std::unique_ptr<Inflater> m_inflater;
+};
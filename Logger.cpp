@@ -0,0 +1,263 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Writer wake-up interval while records keep coming. Producers only signal
+// the writer when it is idle, so this bounds the log latency.
+static const std::chrono::milliseconds g_WriterInterval(10);
+
+// Longest Flush() waits, in case a record is never published
+static const std::chrono::seconds g_FlushTimeout(1);
+
+// Batches larger than this are written in several chunks
+static const size_t g_MaxBatchSize = 256 * 1024;
+
+Logger::Logger() : m_records(new Record[RecordCount]) {
+  for (size_t i = 0; i < RecordCount; i++) {
+    m_records[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+Logger::DrainLock::DrainLock(Logger &logger) : m_logger(logger) {
+  m_logger.m_drainMutex.lock();
+  m_logger.m_drainOwner.store(std::this_thread::get_id());
+}
+
+Logger::DrainLock::~DrainLock() {
+  m_logger.m_drainOwner.store(std::thread::id());
+  m_logger.m_drainMutex.unlock();
+}
+
+void Logger::Init(const std::string &filename) {
+  Close();
+
+  DrainLock lock(*this);
+  m_file.open(filename, std::ios::out | std::ios::trunc);
+  if (!m_file.is_open())
+    return;
+
+  m_file << "=== ImgViewer Log Started ===\n";
+  m_file.flush();
+
+  {
+    std::lock_guard<std::mutex> wakeLock(m_wakeMutex);
+    m_stop = false;
+  }
+  m_writer = std::thread(&Logger::WriterThread, this);
+  m_running.store(true, std::memory_order_release);
+}
+
+void Logger::Log(const char *format, ...) {
+  if (!m_running.load(std::memory_order_relaxed))
+    return;
+
+  va_list args;
+  va_start(args, format);
+  Enqueue(false, format, args);
+  va_end(args);
+}
+
+void Logger::LogError(const char *format, ...) {
+  if (!m_running.load(std::memory_order_relaxed))
+    return;
+
+  va_list args;
+  va_start(args, format);
+  Enqueue(true, format, args);
+  va_end(args);
+}
+
+void Logger::Enqueue(bool isError, const char *format, va_list args) {
+  // Bounded MPSC queue: each slot carries a sequence number telling
+  // producers whether it is free for the position they want to claim.
+  size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+  Record *record;
+  for (;;) {
+    record = &m_records[pos & (RecordCount - 1)];
+    size_t sequence = record->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+    if (diff == 0) {
+      if (m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // Ring is full: wake the writer and wait for it to catch up
+      if (!m_running.load(std::memory_order_relaxed))
+        return;
+      m_wake.notify_one();
+      std::this_thread::yield();
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+    } else {
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Format directly into the claimed slot
+  vsnprintf(record->text, MaxMessageLength, format, args);
+  record->isError = isError;
+
+  // Publishing and checking m_writerIdle are both sequentially consistent,
+  // so either the idle writer sees this record or it is notified
+  record->sequence.store(pos + 1, std::memory_order_seq_cst);
+  if (m_writerIdle.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_wake.notify_one();
+  }
+}
+
+size_t Logger::Drain(std::string &batch, bool skipUnpublished) {
+  size_t drained = 0;
+  batch.clear();
+
+  // Records up to here were claimed; some may never be published
+  size_t claimedEnd =
+      skipUnpublished ? m_enqueuePos.load(std::memory_order_acquire) : 0;
+
+  for (;;) {
+    Record &record = m_records[m_dequeuePos & (RecordCount - 1)];
+    bool ready = record.sequence.load(std::memory_order_acquire) ==
+                 m_dequeuePos + 1;
+
+    if (ready) {
+      if (record.isError)
+        batch += "[ERROR] ";
+      batch += record.text;
+      batch += '\n';
+
+      // Hand the slot back to producers one lap ahead
+      record.sequence.store(m_dequeuePos + RecordCount,
+                            std::memory_order_release);
+      m_dequeuePos++;
+      drained++;
+    } else if (m_dequeuePos < claimedEnd) {
+      m_dequeuePos++;
+      continue;
+    }
+
+    if (!ready || batch.size() >= g_MaxBatchSize) {
+      if (!batch.empty()) {
+        m_file.write(batch.data(), (std::streamsize)batch.size());
+        batch.clear();
+      }
+      if (!ready)
+        break;
+    }
+  }
+
+  if (drained > 0) {
+    m_file.flush();
+    m_writtenPos.store(m_dequeuePos, std::memory_order_release);
+  }
+  return drained;
+}
+
+bool Logger::HasPublished() const {
+  size_t pos = m_writtenPos.load(std::memory_order_acquire);
+  return m_records[pos & (RecordCount - 1)].sequence.load(
+             std::memory_order_seq_cst) == pos + 1;
+}
+
+void Logger::WriterThread() {
+  std::string batch;
+  batch.reserve(g_MaxBatchSize);
+
+  bool idle = false;
+  for (;;) {
+    bool stop;
+    {
+      std::unique_lock<std::mutex> lock(m_wakeMutex);
+      if (idle) {
+        // Nothing came in since the last pass: sleep until a producer
+        // publishes the next record
+        m_writerIdle.store(true, std::memory_order_seq_cst);
+        m_wake.wait(lock, [this]() { return m_stop || HasPublished(); });
+        m_writerIdle.store(false, std::memory_order_relaxed);
+      } else {
+        m_wake.wait_for(lock, g_WriterInterval);
+      }
+      stop = m_stop;
+    }
+
+    size_t drained;
+    {
+      DrainLock lock(*this);
+      drained = Drain(batch);
+    }
+    if (drained > 0) {
+      std::lock_guard<std::mutex> lock(m_wakeMutex);
+      m_written.notify_all();
+    }
+    idle = drained == 0;
+
+    if (stop)
+      break;
+  }
+}
+
+void Logger::Flush() {
+  if (!m_running.load(std::memory_order_acquire))
+    return;
+
+  size_t target = m_enqueuePos.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(m_wakeMutex);
+  m_wake.notify_one();
+  m_written.wait_for(lock, g_FlushTimeout, [&]() {
+    return m_writtenPos.load(std::memory_order_acquire) >= target ||
+           !m_running.load(std::memory_order_acquire);
+  });
+}
+
+void Logger::EmergencyFlush(const char *message) {
+  // Stop taking records, so producers waiting on a full ring give up and
+  // nobody waits for the slots skipped below
+  if (!m_running.exchange(false, std::memory_order_acq_rel))
+    return;
+
+  // Locking again from the thread that holds the lock is undefined, and
+  // that thread crashed in the middle of writing the file
+  if (m_drainOwner.load() == std::this_thread::get_id())
+    return;
+
+  // The writer may be holding the lock, so do not wait for it indefinitely
+  if (!m_drainMutex.try_lock_for(std::chrono::milliseconds(100)))
+    return;
+  m_drainOwner.store(std::this_thread::get_id());
+
+  if (m_file.is_open()) {
+    std::string batch;
+    Drain(batch, true);
+    if (message)
+      m_file << "[ERROR] " << message << '\n';
+    m_file.flush();
+  }
+
+  m_drainOwner.store(std::thread::id());
+  m_drainMutex.unlock();
+}
+
+void Logger::Close() {
+  // After EmergencyFlush the writer is still there to stop
+  if (!m_running.exchange(false, std::memory_order_acq_rel) &&
+      !m_writer.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  if (m_writer.joinable())
+    m_writer.join();
+
+  // Pick up records published while the writer was shutting down
+  DrainLock lock(*this);
+  std::string batch;
+  Drain(batch);
+
+  if (m_file.is_open()) {
+    m_file << "=== Log Closed ===\n";
+    m_file.close();
+  }
+}
@@ -1,76 +1,106 @@
-#pragma once
-#include <cstdarg>
-#include <fstream>
-#include <mutex>
-#include <string>
-
-
-class Logger {
-public:
-  static Logger &Get() {
-    static Logger instance;
-    return instance;
-  }
-
-  void Init(const std::string &filename) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_file.is_open())
-      m_file.close();
-    m_file.open(filename, std::ios::out | std::ios::trunc);
-    if (m_file.is_open()) {
-      m_file << "=== ImgViewer Log Started ===" << std::endl;
-      m_file.flush();
-    }
-  }
-
-  void Log(const char *format, ...) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (!m_file.is_open())
-      return;
-
-    char buffer[2048];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-
-    m_file << buffer << std::endl;
-    m_file.flush();
-  }
-
-  void LogError(const char *format, ...) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (!m_file.is_open())
-      return;
-
-    char buffer[2048];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-
-    m_file << "[ERROR] " << buffer << std::endl;
-    m_file.flush();
-  }
-
-  void Close() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_file.is_open()) {
-      m_file << "=== Log Closed ===" << std::endl;
-      m_file.close();
-    }
-  }
-
-  ~Logger() { Close(); }
-
-private:
-  Logger() = default;
-  Logger(const Logger &) = delete;
-  Logger &operator=(const Logger &) = delete;
-
-  std::ofstream m_file;
-  std::mutex m_mutex;
-};
-
-#define LOG(fmt, ...) Logger::Get().Log(fmt, ##__VA_ARGS__)
-#define LOG_ERROR(fmt, ...) Logger::Get().LogError(fmt, ##__VA_ARGS__)
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Asynchronous logger.
+ *
+ * Log calls format the message straight into a slot of a lock-free MPSC ring
+ * buffer and return; a background thread drains the ring and writes the
+ * records in batches, and sleeps while nothing is logged. Flush() blocks
+ * until everything logged so far is on disk, and EmergencyFlush() drains
+ * from the calling thread for crash handlers.
+ */
+class Logger {
+public:
+  static Logger &Get() {
+    static Logger instance;
+    return instance;
+  }
+
+  /**
+   * @brief Opens the log file and starts the writer thread.
+   */
+  void Init(const std::string &filename);
+
+  void Log(const char *format, ...);
+  void LogError(const char *format, ...);
+
+  /**
+   * @brief Blocks until all records logged so far have been written, or
+   * for at most a second.
+   */
+  void Flush();
+
+  /**
+   * @brief Stops logging and writes the published records from the calling
+   * thread, followed by an error line with the message.
+   * \note Intended for crash handlers, where the writer thread may never run
+   * again. Nothing is enqueued, slots that were claimed but never published
+   * are skipped, and it gives up if another thread holds the file for long
+   * or the calling thread was writing it.
+   * @param message Error line written last, or nullptr.
+   */
+  void EmergencyFlush(const char *message = nullptr);
+
+  /**
+   * @brief Flushes, stops the writer thread and closes the file.
+   */
+  void Close();
+
+  ~Logger() { Close(); }
+
+private:
+  Logger();
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  static const size_t RecordCount = 2048; // Must be a power of two
+  static const size_t MaxMessageLength = 2048;
+
+  struct Record {
+    std::atomic<size_t> sequence;
+    bool isError;
+    char text[MaxMessageLength];
+  };
+
+  // Locks m_drainMutex and records the owner for EmergencyFlush
+  class DrainLock {
+  public:
+    explicit DrainLock(Logger &logger);
+    ~DrainLock();
+
+  private:
+    Logger &m_logger;
+  };
+
+  void Enqueue(bool isError, const char *format, va_list args);
+  size_t Drain(std::string &batch, bool skipUnpublished = false);
+  bool HasPublished() const;
+  void WriterThread();
+
+  std::unique_ptr<Record[]> m_records;
+  alignas(64) std::atomic<size_t> m_enqueuePos{0};
+  alignas(64) size_t m_dequeuePos = 0;     // Owned by whoever holds m_drainMutex
+  std::atomic<size_t> m_writtenPos{0};     // Records written to the file so far
+  std::atomic<bool> m_running{false};
+
+  std::ofstream m_file;
+  std::timed_mutex m_drainMutex; // Serializes consumers and file access
+  std::atomic<std::thread::id> m_drainOwner{};
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;    // Wakes the writer
+  std::condition_variable m_written; // Signals Flush() after each write
+  std::atomic<bool> m_writerIdle{false}; // Writer sleeps until notified
+  bool m_stop = false;
+  std::thread m_writer;
+};
+
+#define LOG(fmt, ...) Logger::Get().Log(fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) Logger::Get().LogError(fmt, ##__VA_ARGS__)
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Pages are only read from disk when touched, so parsing a header or
+ * decoding one part of a large file does not read the rest of it.
+ */
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile() { Close(); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief Maps the file at a UTF-8 path.
+   * @return False if the file cannot be opened, is empty or cannot be mapped.
+   */
+  bool Open(const std::string &filepath);
+
+  /**
+   * @brief Unmaps the file. Pointers from GetData() become invalid.
+   */
+  void Close();
+
+  bool IsOpen() const { return m_data != nullptr; }
+  const uint8_t *GetData() const { return m_data; }
+  size_t GetSize() const { return m_size; }
+
+private:
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void *m_file = nullptr;    // HANDLE
+  void *m_mapping = nullptr; // HANDLE
+#endif
+};
@@ -0,0 +1,112 @@
+#include "MotionField.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Largest cell; a single arrow covers the image long before this
+const int g_MaxMotionCellSize = 4096;
+
+// Sums of the vectors of one column of cells, over the rows of a cell row
+struct CellSums {
+  double sumX = 0.0;
+  double sumY = 0.0;
+  int count = 0;
+  float longestX = 0.0f;
+  float longestY = 0.0f;
+  float longestSquared = 0.0f;
+};
+
+} // namespace
+
+int GetMotionCellSize(float zoom, float spacing) {
+  int cellSize = 1;
+  while (cellSize * zoom < spacing && cellSize < g_MaxMotionCellSize)
+    cellSize *= 2;
+  return cellSize;
+}
+
+bool ReduceMotionField(const ImageData &image, int cellSize,
+                       MotionField &field, int threadCount) {
+  PROFILE_SCOPE("ReduceMotionField");
+  int width = image.width;
+  int height = image.height;
+  if (width <= 0 || height <= 0 || cellSize <= 0 ||
+      image.GetPixelCount() != (size_t)width * height)
+    return false;
+
+  field.cellSize = cellSize;
+  field.columns = (width + cellSize - 1) / cellSize;
+  field.rows = (height + cellSize - 1) / cellSize;
+  size_t cellCount = (size_t)field.columns * field.rows;
+  field.mean.assign(cellCount * 2, 0.0f);
+  field.longest.assign(cellCount * 2, 0.0f);
+
+  int columns = field.columns;
+  int rows = field.rows;
+  std::vector<float> chunkMax(GetParallelChunkCount(rows, threadCount), 0.0f);
+  ParallelForChunks(rows, threadCount, [&](int chunk, int begin, int end) {
+    std::vector<float> converted;
+    std::vector<CellSums> sums(columns);
+    float maxSquared = 0.0f;
+    for (int cellY = begin; cellY < end; cellY++) {
+      std::fill(sums.begin(), sums.end(), CellSums());
+      int yEnd = std::min((cellY + 1) * cellSize, height);
+      for (int y = cellY * cellSize; y < yEnd; y++) {
+        // RG32F rows are read as they are, other stored formats converted
+        const float *row;
+        int stride = 4;
+        if (!image.HasStoredPixels()) {
+          row = image.pixels.data() + (size_t)y * width * 4;
+        } else if (image.stored.format == PixelFormat::RG32F) {
+          row = (const float *)image.stored.GetRow(y);
+          stride = 2;
+        } else {
+          converted.resize((size_t)width * 4);
+          ConvertPixels(image.stored, (size_t)y * width,
+                        (size_t)(y + 1) * width, converted.data());
+          row = converted.data();
+        }
+
+        for (int cellX = 0; cellX < columns; cellX++) {
+          CellSums &cell = sums[cellX];
+          int xEnd = std::min((cellX + 1) * cellSize, width);
+          for (int x = cellX * cellSize; x < xEnd; x++) {
+            float vx = row[x * stride];
+            float vy = row[x * stride + 1];
+            if (!std::isfinite(vx + vy))
+              continue;
+            cell.sumX += vx;
+            cell.sumY += vy;
+            cell.count++;
+            float squared = vx * vx + vy * vy;
+            if (squared > cell.longestSquared) {
+              cell.longestX = vx;
+              cell.longestY = vy;
+              cell.longestSquared = squared;
+            }
+          }
+        }
+      }
+
+      float *mean = &field.mean[(size_t)cellY * columns * 2];
+      float *longest = &field.longest[(size_t)cellY * columns * 2];
+      for (int cellX = 0; cellX < columns; cellX++) {
+        const CellSums &cell = sums[cellX];
+        if (cell.count > 0) {
+          mean[cellX * 2] = (float)(cell.sumX / cell.count);
+          mean[cellX * 2 + 1] = (float)(cell.sumY / cell.count);
+        }
+        longest[cellX * 2] = cell.longestX;
+        longest[cellX * 2 + 1] = cell.longestY;
+        maxSquared = std::max(maxSquared, cell.longestSquared);
+      }
+    }
+    chunkMax[chunk] = maxSquared;
+  });
+  field.maxLength =
+      std::sqrt(*std::max_element(chunkMax.begin(), chunkMax.end()));
+  return true;
+}
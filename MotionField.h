@@ -0,0 +1,38 @@
+#pragma once
+#include "ImageData.h"
+#include <vector>
+
+/**
+ * @brief Motion vectors of an image reduced to a grid of square cells, one
+ * arrow per cell.
+ *
+ * Vectors are the R and G channels, in whatever units the image holds them.
+ * Vectors that are not finite are skipped; cells without any are zero.
+ */
+struct MotionField {
+  int cellSize = 0; ///< Width and height of a cell in image pixels
+  int columns = 0;  ///< Cells across; the last may be partly outside
+  int rows = 0;     ///< Cells down; the last may be partly outside
+  std::vector<float> mean;    ///< Mean (R, G) of each cell, row by row
+  std::vector<float> longest; ///< Longest (R, G) of each cell, row by row
+  float maxLength = 0.0f;     ///< Length of the longest vector of the image
+};
+
+/**
+ * @brief Gets the cell size that puts arrows at least spacing screen pixels
+ * apart at a zoom level.
+ *
+ * Cell sizes are powers of two, so every zoom level between two of them
+ * shares one field.
+ */
+int GetMotionCellSize(float zoom, float spacing);
+
+/**
+ * @brief Reduces the motion vectors of an image to cells of cellSize
+ * pixels, in parallel over rows of cells; stored pixels are converted a row
+ * at a time.
+ * @param threadCount 0 = hardware threads.
+ * @return False if the image has no pixels or cellSize is not positive.
+ */
+bool ReduceMotionField(const ImageData &image, int cellSize,
+                       MotionField &field, int threadCount = 0);
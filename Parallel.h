@@ -0,0 +1,69 @@
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Gets the default worker count (hardware threads, at least 1).
+ */
+inline int GetDefaultThreadCount() {
+  unsigned int count = std::thread::hardware_concurrency();
+  return count > 0 ? (int)count : 1;
+}
+
+/**
+ * @brief Gets the number of chunks ParallelForChunks splits count items into.
+ * @param threadCount Requested threads (0 = hardware threads).
+ */
+inline int GetParallelChunkCount(int count, int threadCount) {
+  if (count <= 0)
+    return 0;
+  if (threadCount <= 0)
+    threadCount = GetDefaultThreadCount();
+  return std::min(threadCount, count);
+}
+
+/**
+ * @brief Splits [0, count) into contiguous chunks and runs them in parallel.
+ * @param count Number of work items (e.g. image rows).
+ * @param threadCount Number of threads to use (0 = hardware threads).
+ * @param fn Callable invoked as fn(chunkIndex, begin, end) once per chunk,
+ * with chunkIndex in [0, GetParallelChunkCount(count, threadCount)).
+ * @note The calling thread processes the first chunk itself.
+ */
+template <typename Fn>
+void ParallelForChunks(int count, int threadCount, Fn &&fn) {
+  int chunkCount = GetParallelChunkCount(count, threadCount);
+  if (chunkCount == 0)
+    return;
+
+  if (chunkCount == 1) {
+    fn(0, 0, count);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  workers.reserve(chunkCount - 1);
+
+  int chunk = (count + chunkCount - 1) / chunkCount;
+  for (int t = 1; t < chunkCount; t++) {
+    int begin = std::min(count, t * chunk);
+    int end = std::min(count, begin + chunk);
+    workers.emplace_back([&fn, t, begin, end]() { fn(t, begin, end); });
+  }
+
+  fn(0, 0, std::min(count, chunk));
+
+  for (auto &worker : workers)
+    worker.join();
+}
+
+/**
+ * @brief Splits [0, count) into contiguous chunks and runs them in parallel.
+ * @param fn Callable invoked as fn(begin, end) once per chunk.
+ * @see ParallelForChunks
+ */
+template <typename Fn> void ParallelFor(int count, int threadCount, Fn &&fn) {
+  ParallelForChunks(count, threadCount,
+                    [&fn](int, int begin, int end) { fn(begin, end); });
+}
@@ -0,0 +1,588 @@
+#include "PixelFormat.h"
+#include "HalfFloat.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_FORMAT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Indexed by PixelFormat
+static const PixelFormatInfo g_PixelFormats[] = {
+    {"RGBA32F", 4, PixelComponentType::Float32, false, false, 0},
+    {"RGBA16F", 4, PixelComponentType::Float16, false, false, 0},
+    {"L16", 1, PixelComponentType::UNorm16, true, false, 0},
+    {"LA16", 2, PixelComponentType::UNorm16, true, false, 0},
+    {"RGB16", 3, PixelComponentType::UNorm16, false, false, 0},
+    {"RGBA16", 4, PixelComponentType::UNorm16, false, false, 0},
+    {"L8", 1, PixelComponentType::UNorm8, true, false, 0},
+    {"RGB8", 3, PixelComponentType::UNorm8, false, false, 0},
+    {"RGBA8", 4, PixelComponentType::UNorm8, false, false, 0},
+    {"BGRA8", 4, PixelComponentType::UNorm8, false, true, 0},
+    {"L16BE", 1, PixelComponentType::UNorm16BE, true, false, 0},
+    {"RGB16BE", 3, PixelComponentType::UNorm16BE, false, false, 0},
+    {"L32F", 1, PixelComponentType::Float32, true, false, 0},
+    {"RG32F", 2, PixelComponentType::Float32, false, false, 0},
+    {"RGB32F", 3, PixelComponentType::Float32, false, false, 0},
+    {"R11G11B10F", 3, PixelComponentType::Packed, false, false, 4},
+    {"RGB10A2", 4, PixelComponentType::Packed, false, false, 4},
+    {"RGB9E5", 3, PixelComponentType::Packed, false, false, 4},
+    {"B5G6R5", 3, PixelComponentType::Packed, false, false, 2},
+    {"R8UI", 1, PixelComponentType::UInt8, false, false, 0},
+    {"R8I", 1, PixelComponentType::SInt8, false, false, 0},
+    {"RG8UI", 2, PixelComponentType::UInt8, false, false, 0},
+    {"RG8I", 2, PixelComponentType::SInt8, false, false, 0},
+    {"RGBA8UI", 4, PixelComponentType::UInt8, false, false, 0},
+    {"RGBA8I", 4, PixelComponentType::SInt8, false, false, 0},
+    {"R16UI", 1, PixelComponentType::UInt16, false, false, 0},
+    {"R16I", 1, PixelComponentType::SInt16, false, false, 0},
+    {"RG16UI", 2, PixelComponentType::UInt16, false, false, 0},
+    {"RG16I", 2, PixelComponentType::SInt16, false, false, 0},
+    {"RGBA16UI", 4, PixelComponentType::UInt16, false, false, 0},
+    {"RGBA16I", 4, PixelComponentType::SInt16, false, false, 0},
+    {"R32UI", 1, PixelComponentType::UInt32, false, false, 0},
+    {"R32I", 1, PixelComponentType::SInt32, false, false, 0},
+    {"RG32UI", 2, PixelComponentType::UInt32, false, false, 0},
+    {"RG32I", 2, PixelComponentType::SInt32, false, false, 0},
+    {"RGB32UI", 3, PixelComponentType::UInt32, false, false, 0},
+    {"RGB32I", 3, PixelComponentType::SInt32, false, false, 0},
+    {"RGBA32UI", 4, PixelComponentType::UInt32, false, false, 0},
+    {"RGBA32I", 4, PixelComponentType::SInt32, false, false, 0},
+};
+
+// Pixels widened per step when channels have to be spread out to RGBA
+static const size_t g_ConvertBatch = 256;
+
+const PixelFormatInfo &GetPixelFormatInfo(PixelFormat format) {
+  return g_PixelFormats[(int)format];
+}
+
+int GetPixelFormatCount() {
+  return (int)(sizeof(g_PixelFormats) / sizeof(g_PixelFormats[0]));
+}
+
+bool FindPixelFormat(const std::string &name, PixelFormat &format) {
+  for (int i = 0; i < GetPixelFormatCount(); i++) {
+    const char *candidate = g_PixelFormats[i].name;
+    if (name.size() == strlen(candidate) &&
+        std::equal(name.begin(), name.end(), candidate, [](char a, char b) {
+          return toupper((unsigned char)a) == toupper((unsigned char)b);
+        })) {
+      format = (PixelFormat)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t GetComponentSize(PixelComponentType type) {
+  switch (type) {
+  case PixelComponentType::UNorm8:
+  case PixelComponentType::UInt8:
+  case PixelComponentType::SInt8:
+    return 1;
+  case PixelComponentType::UNorm16:
+  case PixelComponentType::UNorm16BE:
+  case PixelComponentType::Float16:
+  case PixelComponentType::UInt16:
+  case PixelComponentType::SInt16:
+    return 2;
+  case PixelComponentType::Float32:
+  case PixelComponentType::UInt32:
+  case PixelComponentType::SInt32:
+    return 4;
+  case PixelComponentType::Packed:
+    return 0;
+  }
+  return 0;
+}
+
+PixelBuffer AllocatePixelBuffer(PixelFormat format, int width, int height,
+                                uint8_t *&pixels) {
+  size_t rowPitch = (size_t)width * GetPixelSize(format);
+  auto storage = std::make_shared<std::vector<uint8_t>>(rowPitch * height);
+
+  PixelBuffer buffer;
+  buffer.format = format;
+  buffer.width = width;
+  buffer.height = height;
+  buffer.rowPitch = (ptrdiff_t)rowPitch;
+  buffer.data = storage->data();
+  buffer.owner = storage;
+  pixels = storage->data();
+  return buffer;
+}
+
+static inline uint16_t SwapBytes(uint16_t value) {
+  return (uint16_t)((value << 8) | (value >> 8));
+}
+
+// Converts count UNORM8 values to [0, 1]. Division (not multiplication by
+// the reciprocal) keeps the SIMD and scalar results identical.
+static void ConvertUNorm8(const uint8_t *src, size_t count, float *dst) {
+  size_t i = 0;
+#ifdef PIXEL_FORMAT_SSE2
+  const __m128i vZero = _mm_setzero_si128();
+  const __m128 vMax = _mm_set1_ps(255.0f);
+  for (; i + 16 <= count; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i lo = _mm_unpacklo_epi8(v, vZero);
+    __m128i hi = _mm_unpackhi_epi8(v, vZero);
+    __m128i words[4] = {
+        _mm_unpacklo_epi16(lo, vZero), _mm_unpackhi_epi16(lo, vZero),
+        _mm_unpacklo_epi16(hi, vZero), _mm_unpackhi_epi16(hi, vZero)};
+    for (int j = 0; j < 4; j++)
+      _mm_storeu_ps(dst + i + j * 4,
+                    _mm_div_ps(_mm_cvtepi32_ps(words[j]), vMax));
+  }
+#endif
+  for (; i < count; i++)
+    dst[i] = src[i] / 255.0f;
+}
+
+// Same for UNORM16, optionally stored big-endian
+static void ConvertUNorm16(const uint8_t *src, size_t count, bool bigEndian,
+                           float *dst) {
+  size_t i = 0;
+#ifdef PIXEL_FORMAT_SSE2
+  const __m128i vZero = _mm_setzero_si128();
+  const __m128 vMax = _mm_set1_ps(65535.0f);
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+    if (bigEndian)
+      v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, vZero));
+    __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, vZero));
+    _mm_storeu_ps(dst + i, _mm_div_ps(lo, vMax));
+    _mm_storeu_ps(dst + i + 4, _mm_div_ps(hi, vMax));
+  }
+#endif
+  for (; i < count; i++) {
+    uint16_t value;
+    memcpy(&value, src + i * 2, sizeof(value));
+    if (bigEndian)
+      value = SwapBytes(value);
+    dst[i] = value / 65535.0f;
+  }
+}
+
+// Integers keep their value; memcpy since src may be unaligned
+template <typename T>
+static void ConvertIntegers(const uint8_t *src, size_t count, float *dst) {
+  for (size_t i = 0; i < count; i++) {
+    T value;
+    memcpy(&value, src + i * sizeof(T), sizeof(T));
+    dst[i] = (float)value;
+  }
+}
+
+static void ConvertComponents(PixelComponentType type, const uint8_t *src,
+                              size_t count, float *dst) {
+  switch (type) {
+  case PixelComponentType::UNorm8:
+    ConvertUNorm8(src, count, dst);
+    break;
+  case PixelComponentType::UNorm16:
+  case PixelComponentType::UNorm16BE:
+    ConvertUNorm16(src, count, type == PixelComponentType::UNorm16BE, dst);
+    break;
+  case PixelComponentType::Float16: {
+    // Copied out first in case src is not 2-byte aligned
+    uint16_t halves[g_ConvertBatch * 4];
+    for (size_t i = 0; i < count; i += g_ConvertBatch * 4) {
+      size_t n = std::min(count - i, g_ConvertBatch * 4);
+      memcpy(halves, src + i * 2, n * 2);
+      HalfToFloatArray(halves, dst + i, n);
+    }
+    break;
+  }
+  case PixelComponentType::Float32:
+    memcpy(dst, src, count * sizeof(float));
+    break;
+  case PixelComponentType::Packed:
+    break;
+  case PixelComponentType::UInt8:
+    ConvertIntegers<uint8_t>(src, count, dst);
+    break;
+  case PixelComponentType::SInt8:
+    ConvertIntegers<int8_t>(src, count, dst);
+    break;
+  case PixelComponentType::UInt16:
+    ConvertIntegers<uint16_t>(src, count, dst);
+    break;
+  case PixelComponentType::SInt16:
+    ConvertIntegers<int16_t>(src, count, dst);
+    break;
+  case PixelComponentType::UInt32:
+    ConvertIntegers<uint32_t>(src, count, dst);
+    break;
+  case PixelComponentType::SInt32:
+    ConvertIntegers<int32_t>(src, count, dst);
+    break;
+  }
+}
+
+// Widens an unsigned float field with a 5-bit exponent (bias 15, like a
+// half) and mantissaBits of mantissa. The field is moved into a float's
+// bits and scaled by 2^112 to rebias the exponent, which is exact for
+// normals and denormals; an all-ones exponent becomes Inf or NaN.
+static inline float UnpackSmallFloat(uint32_t field, int mantissaBits) {
+  uint32_t half = field << (10 - mantissaBits);
+  uint32_t bits = half << 13;
+  if (half >= 0x7C00)
+    bits |= 0x7F800000;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return half >= 0x7C00 ? value : value * 0x1p112f;
+}
+
+// 2^(exponent - 24): the scale of RGB9E5's 9-bit mantissas
+static inline float GetSharedExponentScale(uint32_t exponent) {
+  uint32_t bits = (exponent + 103) << 23;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+#ifdef PIXEL_FORMAT_SSE2
+// UnpackSmallFloat() for four fields
+static inline __m128 UnpackSmallFloat4(__m128i field, int mantissaBits) {
+  __m128i half = _mm_slli_epi32(field, 10 - mantissaBits);
+  __m128i bits = _mm_slli_epi32(half, 13);
+  __m128 special = _mm_castsi128_ps(
+      _mm_cmpgt_epi32(half, _mm_set1_epi32(0x7BFF)));
+  __m128 normal = _mm_mul_ps(_mm_castsi128_ps(bits), _mm_set1_ps(0x1p112f));
+  __m128 infNaN =
+      _mm_castsi128_ps(_mm_or_si128(bits, _mm_set1_epi32(0x7F800000)));
+  return _mm_or_ps(_mm_and_ps(special, infNaN),
+                   _mm_andnot_ps(special, normal));
+}
+
+static inline __m128 GetField4(__m128i words, int shift, uint32_t mask) {
+  return _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(words, shift),
+                                       _mm_set1_epi32((int)mask)));
+}
+#endif
+
+// Unpackers of the Packed formats: one word to RGBA, and with SSE2 four
+// words to four R, G, B and A values. Division (not multiplication by the
+// reciprocal) keeps the SIMD and scalar results identical.
+struct UnpackR11G11B10F {
+  static const size_t size = 4;
+  static void Unpack(uint32_t v, float *rgba) {
+    rgba[0] = UnpackSmallFloat(v & 0x7FF, 6);
+    rgba[1] = UnpackSmallFloat((v >> 11) & 0x7FF, 6);
+    rgba[2] = UnpackSmallFloat(v >> 22, 5);
+    rgba[3] = 1.0f;
+  }
+#ifdef PIXEL_FORMAT_SSE2
+  static void Unpack4(__m128i v, __m128 *rgba) {
+    const __m128i vMask = _mm_set1_epi32(0x7FF);
+    rgba[0] = UnpackSmallFloat4(_mm_and_si128(v, vMask), 6);
+    rgba[1] = UnpackSmallFloat4(_mm_and_si128(_mm_srli_epi32(v, 11), vMask),
+                                6);
+    rgba[2] = UnpackSmallFloat4(_mm_srli_epi32(v, 22), 5);
+    rgba[3] = _mm_set1_ps(1.0f);
+  }
+#endif
+};
+
+struct UnpackRGB10A2 {
+  static const size_t size = 4;
+  static void Unpack(uint32_t v, float *rgba) {
+    rgba[0] = (v & 0x3FF) / 1023.0f;
+    rgba[1] = ((v >> 10) & 0x3FF) / 1023.0f;
+    rgba[2] = ((v >> 20) & 0x3FF) / 1023.0f;
+    rgba[3] = (v >> 30) / 3.0f;
+  }
+#ifdef PIXEL_FORMAT_SSE2
+  static void Unpack4(__m128i v, __m128 *rgba) {
+    const __m128 vMax = _mm_set1_ps(1023.0f);
+    rgba[0] = _mm_div_ps(GetField4(v, 0, 0x3FF), vMax);
+    rgba[1] = _mm_div_ps(GetField4(v, 10, 0x3FF), vMax);
+    rgba[2] = _mm_div_ps(GetField4(v, 20, 0x3FF), vMax);
+    rgba[3] = _mm_div_ps(GetField4(v, 30, 0x3), _mm_set1_ps(3.0f));
+  }
+#endif
+};
+
+struct UnpackRGB9E5 {
+  static const size_t size = 4;
+  static void Unpack(uint32_t v, float *rgba) {
+    float scale = GetSharedExponentScale(v >> 27);
+    rgba[0] = (float)(v & 0x1FF) * scale;
+    rgba[1] = (float)((v >> 9) & 0x1FF) * scale;
+    rgba[2] = (float)((v >> 18) & 0x1FF) * scale;
+    rgba[3] = 1.0f;
+  }
+#ifdef PIXEL_FORMAT_SSE2
+  static void Unpack4(__m128i v, __m128 *rgba) {
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_add_epi32(_mm_srli_epi32(v, 27), _mm_set1_epi32(103)), 23));
+    rgba[0] = _mm_mul_ps(GetField4(v, 0, 0x1FF), scale);
+    rgba[1] = _mm_mul_ps(GetField4(v, 9, 0x1FF), scale);
+    rgba[2] = _mm_mul_ps(GetField4(v, 18, 0x1FF), scale);
+    rgba[3] = _mm_set1_ps(1.0f);
+  }
+#endif
+};
+
+struct UnpackB5G6R5 {
+  static const size_t size = 2;
+  static void Unpack(uint32_t v, float *rgba) {
+    rgba[0] = (v >> 11) / 31.0f;
+    rgba[1] = ((v >> 5) & 0x3F) / 63.0f;
+    rgba[2] = (v & 0x1F) / 31.0f;
+    rgba[3] = 1.0f;
+  }
+#ifdef PIXEL_FORMAT_SSE2
+  static void Unpack4(__m128i v, __m128 *rgba) {
+    const __m128 vMax5 = _mm_set1_ps(31.0f);
+    rgba[0] = _mm_div_ps(GetField4(v, 11, 0x1F), vMax5);
+    rgba[1] = _mm_div_ps(GetField4(v, 5, 0x3F), _mm_set1_ps(63.0f));
+    rgba[2] = _mm_div_ps(GetField4(v, 0, 0x1F), vMax5);
+    rgba[3] = _mm_set1_ps(1.0f);
+  }
+#endif
+};
+
+// Reads the packed word of pixel i
+static inline uint32_t ReadPackedWord(const uint8_t *src, size_t size,
+                                      size_t i) {
+  if (size == 2) {
+    uint16_t value;
+    memcpy(&value, src + i * 2, sizeof(value));
+    return value;
+  }
+  uint32_t value;
+  memcpy(&value, src + i * 4, sizeof(value));
+  return value;
+}
+
+template <typename Unpacker>
+static void ConvertPackedRow(const uint8_t *src, size_t count, float *rgba) {
+  size_t i = 0;
+#ifdef PIXEL_FORMAT_SSE2
+  for (; i + 4 <= count; i += 4) {
+    __m128i words;
+    if (Unpacker::size == 2)
+      words = _mm_unpacklo_epi16(
+          _mm_loadl_epi64((const __m128i *)(src + i * 2)),
+          _mm_setzero_si128());
+    else
+      words = _mm_loadu_si128((const __m128i *)(src + i * 4));
+    __m128 c[4];
+    Unpacker::Unpack4(words, c);
+    _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+    for (int j = 0; j < 4; j++)
+      _mm_storeu_ps(rgba + (i + j) * 4, c[j]);
+  }
+#endif
+  for (; i < count; i++)
+    Unpacker::Unpack(ReadPackedWord(src, Unpacker::size, i), rgba + i * 4);
+}
+
+void ConvertPixelRow(PixelFormat format, const uint8_t *src, size_t count,
+                     float *rgba) {
+  switch (format) {
+  case PixelFormat::R11G11B10F:
+    ConvertPackedRow<UnpackR11G11B10F>(src, count, rgba);
+    return;
+  case PixelFormat::RGB10A2:
+    ConvertPackedRow<UnpackRGB10A2>(src, count, rgba);
+    return;
+  case PixelFormat::RGB9E5:
+    ConvertPackedRow<UnpackRGB9E5>(src, count, rgba);
+    return;
+  case PixelFormat::B5G6R5:
+    ConvertPackedRow<UnpackB5G6R5>(src, count, rgba);
+    return;
+  default:
+    break;
+  }
+
+  const PixelFormatInfo &info = GetPixelFormatInfo(format);
+  if (info.channels == 4 && !info.bgr) {
+    ConvertComponents(info.type, src, count * 4, rgba);
+    return;
+  }
+
+  // Widen a batch of components, then spread them out to RGBA
+  size_t pixelSize = GetPixelSize(format);
+  float values[g_ConvertBatch * 4];
+  for (size_t begin = 0; begin < count; begin += g_ConvertBatch) {
+    size_t n = std::min(count - begin, g_ConvertBatch);
+    ConvertComponents(info.type, src + begin * pixelSize, n * info.channels,
+                      values);
+
+    float *dst = rgba + begin * 4;
+    for (size_t i = 0; i < n; i++) {
+      const float *v = values + i * info.channels;
+      float *out = dst + i * 4;
+      if (info.gray) {
+        out[0] = out[1] = out[2] = v[0];
+        out[3] = info.channels > 1 ? v[1] : 1.0f;
+      } else if (info.bgr) {
+        out[0] = v[2];
+        out[1] = v[1];
+        out[2] = v[0];
+        out[3] = v[3];
+      } else {
+        out[0] = v[0];
+        out[1] = info.channels > 1 ? v[1] : 0.0f;
+        out[2] = info.channels > 2 ? v[2] : 0.0f;
+        out[3] = 1.0f;
+      }
+    }
+  }
+}
+
+void ConvertPixels(const PixelBuffer &buffer, size_t begin, size_t end,
+                   float *rgba) {
+  size_t pixelSize = GetPixelSize(buffer.format);
+  size_t width = (size_t)buffer.width;
+  while (begin < end) {
+    int y = (int)(begin / width);
+    size_t x = begin % width;
+    size_t n = std::min(end - begin, width - x);
+    ConvertPixelRow(buffer.format, buffer.GetRow(y) + x * pixelSize, n, rgba);
+    rgba += n * 4;
+    begin += n;
+  }
+}
+
+// The bit field of one channel of a Packed format
+static bool FormatPackedValue(PixelFormat format, uint32_t v, int channel,
+                              char *text, size_t textSize) {
+  switch (format) {
+  case PixelFormat::R11G11B10F:
+    if (channel == 3)
+      return false;
+    if (channel == 2)
+      snprintf(text, textSize, "0x%03X", v >> 22);
+    else
+      snprintf(text, textSize, "0x%03X", (v >> (channel * 11)) & 0x7FF);
+    return true;
+  case PixelFormat::RGB10A2:
+    snprintf(text, textSize, "%u", (v >> (channel * 10)) & 0x3FF);
+    return true;
+  case PixelFormat::RGB9E5:
+    if (channel == 3)
+      return false;
+    snprintf(text, textSize, "%u, e%u", (v >> (channel * 9)) & 0x1FF,
+             v >> 27);
+    return true;
+  case PixelFormat::B5G6R5: {
+    static const int s_Shifts[] = {11, 5, 0};
+    static const uint32_t s_Masks[] = {0x1F, 0x3F, 0x1F};
+    if (channel == 3)
+      return false;
+    snprintf(text, textSize, "%u",
+             (v >> s_Shifts[channel]) & s_Masks[channel]);
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+bool FormatStoredValue(const PixelBuffer &buffer, int x, int y, int channel,
+                       char *text, size_t textSize) {
+  const PixelFormatInfo &info = GetPixelFormatInfo(buffer.format);
+  if (info.type == PixelComponentType::Packed) {
+    uint32_t word = ReadPackedWord(buffer.GetRow(y), info.packedSize, x);
+    return FormatPackedValue(buffer.format, word, channel, text, textSize);
+  }
+
+  // Gray formats store R, G and B in their first component
+  int component = channel;
+  if (info.gray)
+    component = channel == 3 ? 1 : 0;
+  else if (info.bgr && channel < 3)
+    component = 2 - channel;
+  if (component >= info.channels)
+    return false;
+
+  size_t componentSize = GetComponentSize(info.type);
+  const uint8_t *src = buffer.GetRow(y) +
+                       ((size_t)x * info.channels + component) * componentSize;
+  switch (info.type) {
+  case PixelComponentType::UNorm8:
+    snprintf(text, textSize, "%u", *src);
+    break;
+  case PixelComponentType::UNorm16:
+  case PixelComponentType::UNorm16BE: {
+    uint16_t value;
+    memcpy(&value, src, sizeof(value));
+    if (info.type == PixelComponentType::UNorm16BE)
+      value = SwapBytes(value);
+    snprintf(text, textSize, "%u", value);
+    break;
+  }
+  case PixelComponentType::Float16: {
+    uint16_t value;
+    memcpy(&value, src, sizeof(value));
+    snprintf(text, textSize, "0x%04X", value);
+    break;
+  }
+  case PixelComponentType::Float32: {
+    float value;
+    memcpy(&value, src, sizeof(value));
+    snprintf(text, textSize, "%.9g", value);
+    break;
+  }
+  case PixelComponentType::Packed:
+    return false;
+  case PixelComponentType::UInt8:
+  case PixelComponentType::SInt8:
+  case PixelComponentType::UInt16:
+  case PixelComponentType::SInt16:
+  case PixelComponentType::UInt32:
+  case PixelComponentType::SInt32: {
+    const uint8_t *pixel =
+        buffer.GetRow(y) + (size_t)x * info.channels * componentSize;
+    snprintf(text, textSize, "%lld",
+             (long long)ReadStoredInteger(info.type, pixel, component));
+    break;
+  }
+  }
+  return true;
+}
+
+int64_t ReadStoredInteger(PixelComponentType type, const uint8_t *pixel,
+                          int component) {
+  const uint8_t *src = pixel + component * GetComponentSize(type);
+  switch (type) {
+  case PixelComponentType::UInt8:
+    return *src;
+  case PixelComponentType::SInt8:
+    return (int8_t)*src;
+  case PixelComponentType::UInt16: {
+    uint16_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+  }
+  case PixelComponentType::SInt16: {
+    int16_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+  }
+  case PixelComponentType::UInt32: {
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+  }
+  case PixelComponentType::SInt32: {
+    int32_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+  }
+  default:
+    return 0;
+  }
+}
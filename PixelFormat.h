@@ -0,0 +1,190 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Layouts in which an image can be kept without widening it to
+ * RGBA32F.
+ *
+ * L (luminance) formats show their value in R, G and B; R/RG formats leave
+ * missing channels at 0 (color) and 1 (alpha). Integer (UI/I) formats show
+ * their values as they are, not normalized.
+ */
+enum class PixelFormat {
+  RGBA32F,    ///< 4 x float
+  RGBA16F,    ///< 4 x half
+  L16,        ///< 16-bit UNORM gray
+  LA16,       ///< 16-bit UNORM gray + alpha
+  RGB16,      ///< 3 x 16-bit UNORM
+  RGBA16,     ///< 4 x 16-bit UNORM
+  L8,         ///< 8-bit UNORM gray
+  RGB8,       ///< 3 x 8-bit UNORM
+  RGBA8,      ///< 4 x 8-bit UNORM
+  BGRA8,      ///< 4 x 8-bit UNORM, blue first
+  L16BE,      ///< 16-bit UNORM gray, big-endian (PGM)
+  RGB16BE,    ///< 3 x 16-bit UNORM, big-endian (PPM)
+  L32F,       ///< float gray
+  RG32F,      ///< 2 x float
+  RGB32F,     ///< 3 x float
+  R11G11B10F, ///< 11/11/10-bit unsigned floats in 32 bits
+  RGB10A2,    ///< 10/10/10-bit UNORM color, 2-bit UNORM alpha in 32 bits
+  RGB9E5,     ///< 9-bit mantissas with a shared 5-bit exponent in 32 bits
+  B5G6R5,     ///< 5/6/5-bit UNORM in 16 bits, blue in the low bits
+  R8UI,       ///< 8-bit unsigned integer
+  R8I,        ///< 8-bit signed integer
+  RG8UI,      ///< 2 x 8-bit unsigned integer
+  RG8I,       ///< 2 x 8-bit signed integer
+  RGBA8UI,    ///< 4 x 8-bit unsigned integer
+  RGBA8I,     ///< 4 x 8-bit signed integer
+  R16UI,      ///< 16-bit unsigned integer
+  R16I,       ///< 16-bit signed integer
+  RG16UI,     ///< 2 x 16-bit unsigned integer
+  RG16I,      ///< 2 x 16-bit signed integer
+  RGBA16UI,   ///< 4 x 16-bit unsigned integer
+  RGBA16I,    ///< 4 x 16-bit signed integer
+  R32UI,      ///< 32-bit unsigned integer
+  R32I,       ///< 32-bit signed integer
+  RG32UI,     ///< 2 x 32-bit unsigned integer
+  RG32I,      ///< 2 x 32-bit signed integer
+  RGB32UI,    ///< 3 x 32-bit unsigned integer
+  RGB32I,     ///< 3 x 32-bit signed integer
+  RGBA32UI,   ///< 4 x 32-bit unsigned integer
+  RGBA32I,    ///< 4 x 32-bit signed integer
+};
+
+/// How the components of a PixelFormat are stored
+enum class PixelComponentType {
+  UNorm8,
+  UNorm16,
+  UNorm16BE,
+  Float16,
+  Float32,
+  Packed, ///< Bit fields of one 16 or 32-bit word per pixel
+  UInt8,
+  SInt8,
+  UInt16,
+  SInt16,
+  UInt32,
+  SInt32,
+};
+
+/**
+ * @brief Static description of a PixelFormat.
+ */
+struct PixelFormatInfo {
+  const char *name;        ///< Display name (e.g., "RGBA16")
+  int channels;            ///< Stored components per pixel
+  PixelComponentType type; ///< Component encoding
+  bool gray;               ///< First component is luminance
+  bool bgr;                ///< First and third components are B and R
+  int packedSize;          ///< Bytes per pixel of Packed formats, else 0
+};
+
+/**
+ * @brief Gets the description of a format.
+ */
+const PixelFormatInfo &GetPixelFormatInfo(PixelFormat format);
+
+/**
+ * @brief Gets the number of PixelFormat values, for listing them.
+ */
+int GetPixelFormatCount();
+
+/**
+ * @brief Looks up a format by its display name (case-insensitive).
+ * @return False if no format has this name.
+ */
+bool FindPixelFormat(const std::string &name, PixelFormat &format);
+
+/**
+ * @brief Gets the size of one component in bytes (0 for Packed).
+ */
+size_t GetComponentSize(PixelComponentType type);
+
+/**
+ * @brief Checks if components of this type are integers.
+ */
+inline bool IsIntegerType(PixelComponentType type) {
+  return type >= PixelComponentType::UInt8;
+}
+
+/**
+ * @brief Gets the size of one pixel in bytes.
+ */
+inline size_t GetPixelSize(PixelFormat format) {
+  const PixelFormatInfo &info = GetPixelFormatInfo(format);
+  if (info.type == PixelComponentType::Packed)
+    return info.packedSize;
+  return info.channels * GetComponentSize(info.type);
+}
+
+/**
+ * @brief Pixels viewed in their stored format.
+ *
+ * The memory is owned by whatever `owner` points to (a heap buffer, a
+ * decoder's allocation, ...), so copies of the buffer share it.
+ */
+struct PixelBuffer {
+  PixelFormat format = PixelFormat::RGBA32F;
+  int width = 0;
+  int height = 0;
+  const uint8_t *data = nullptr; ///< First (top) row
+  ptrdiff_t rowPitch = 0;        ///< Bytes to the next row, < 0 if bottom-up
+  std::shared_ptr<const void> owner;
+
+  const uint8_t *GetRow(int y) const { return data + y * rowPitch; }
+
+  /**
+   * @brief Gets the number of bytes covered by the rows.
+   */
+  size_t GetByteSize() const {
+    return (size_t)(rowPitch < 0 ? -rowPitch : rowPitch) * height;
+  }
+};
+
+/**
+ * @brief Allocates a tightly packed buffer.
+ * @param pixels Receives a writable pointer to the first row.
+ */
+PixelBuffer AllocatePixelBuffer(PixelFormat format, int width, int height,
+                                uint8_t *&pixels);
+
+/**
+ * @brief Converts a run of pixels to RGBA32F.
+ *
+ * UNORM components are divided by their maximum (after swapping the bytes
+ * of big-endian formats), halves are converted exactly; whole rows are
+ * converted with SIMD where available. Packed formats are unpacked from the
+ * stored words on each call, four pixels at a time with SSE2. Integers keep
+ * their value, rounded above 2^24.
+ */
+void ConvertPixelRow(PixelFormat format, const uint8_t *src, size_t count,
+                     float *rgba);
+
+/**
+ * @brief Converts pixels [begin, end) of a buffer, in row-major order, to
+ * RGBA32F. The range may span several rows.
+ */
+void ConvertPixels(const PixelBuffer &buffer, size_t begin, size_t end,
+                   float *rgba);
+
+/**
+ * @brief Formats the stored value of one channel for the pixel inspector:
+ * integers for UNORM formats, the bit pattern for halves, full precision
+ * for floats. Packed formats show the channel's bit field: an integer for
+ * UNORM fields, the bit pattern for small floats, and the mantissa and
+ * shared exponent for RGB9E5. Integer formats show the exact integer.
+ * @param channel 0-3 (R, G, B, A).
+ * @return False if the format does not store this channel.
+ */
+bool FormatStoredValue(const PixelBuffer &buffer, int x, int y, int channel,
+                       char *text, size_t textSize);
+
+/**
+ * @brief Reads one component of an integer format exactly.
+ * @param component Index of the stored component, not the RGBA channel.
+ */
+int64_t ReadStoredInteger(PixelComponentType type, const uint8_t *pixel,
+                          int component);
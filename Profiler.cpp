@@ -0,0 +1,133 @@
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+static int64_t GetTicks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Zone and thread names are plain identifiers, but escape anyway so the
+// trace always parses.
+static void WriteJsonString(FILE *file, const char *str) {
+  fputc('"', file);
+  for (const char *c = str; *c; c++) {
+    if (*c == '"' || *c == '\\')
+      fputc('\\', file);
+    if ((unsigned char)*c < 0x20)
+      continue;
+    fputc(*c, file);
+  }
+  fputc('"', file);
+}
+
+Profiler::Profiler() : m_startTicks(GetTicks()) {}
+
+void Profiler::Enable(const std::string &filename) {
+  m_filename = filename;
+  m_enabled.store(true, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::Now() const {
+  return (uint64_t)(GetTicks() - m_startTicks);
+}
+
+Profiler::ThreadBuffer *Profiler::GetThreadBuffer() {
+  // Buffers are owned by the profiler so zones from short-lived worker
+  // threads survive until the trace is written. ParallelForChunks starts
+  // new threads on every call, so a buffer is handed back when its thread
+  // exits and the next thread appends to it under the same tid.
+  struct Holder {
+    Profiler *profiler = nullptr;
+    ThreadBuffer *buffer = nullptr;
+    ~Holder() {
+      if (buffer)
+        profiler->ReleaseThreadBuffer(buffer);
+    }
+  };
+  thread_local Holder holder;
+  if (!holder.buffer) {
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    if (!m_freeBuffers.empty()) {
+      holder.buffer = m_freeBuffers.back();
+      m_freeBuffers.pop_back();
+    } else {
+      m_buffers.push_back(std::make_unique<ThreadBuffer>());
+      holder.buffer = m_buffers.back().get();
+      holder.buffer->threadId = (int)m_buffers.size();
+      holder.buffer->zones.reserve(1024);
+    }
+    holder.profiler = this;
+  }
+  return holder.buffer;
+}
+
+void Profiler::ReleaseThreadBuffer(ThreadBuffer *buffer) {
+  // A named thread keeps its row in the trace to itself
+  if (!buffer->threadName.empty())
+    return;
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+  m_freeBuffers.push_back(buffer);
+}
+
+void Profiler::AddZone(const char *name, uint64_t startNs, uint64_t endNs) {
+  ThreadBuffer *buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  buffer->zones.push_back({name, startNs, endNs});
+}
+
+void Profiler::SetThreadName(const char *name) {
+  ThreadBuffer *buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  buffer->threadName = name;
+}
+
+bool Profiler::WriteTrace() {
+  if (!IsEnabled() || m_written)
+    return false;
+  m_written = true;
+  m_enabled.store(false, std::memory_order_relaxed);
+
+#ifdef _WIN32
+  FILE *file = _wfopen(std::filesystem::u8path(m_filename).c_str(), L"wb");
+#else
+  FILE *file = fopen(m_filename.c_str(), "wb");
+#endif
+  if (!file)
+    return false;
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first = true;
+
+  std::lock_guard<std::mutex> buffersLock(m_buffersMutex);
+  for (auto &buffer : m_buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    if (!buffer->threadName.empty()) {
+      fprintf(file,
+              "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+              "\"tid\":%d,\"args\":{\"name\":",
+              first ? "" : ",", buffer->threadId);
+      WriteJsonString(file, buffer->threadName.c_str());
+      fprintf(file, "}}");
+      first = false;
+    }
+
+    for (const Zone &zone : buffer->zones) {
+      fprintf(file, "%s\n{\"name\":", first ? "" : ",");
+      WriteJsonString(file, zone.name);
+      // Chrome trace timestamps are in microseconds
+      fprintf(file,
+              ",\"cat\":\"ImgViewer\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+              "\"ts\":%.3f,\"dur\":%.3f}",
+              buffer->threadId, zone.startNs / 1000.0,
+              (zone.endNs - zone.startNs) / 1000.0);
+      first = false;
+    }
+  }
+
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
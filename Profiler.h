@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lightweight scoped timing zones with Chrome trace export.
+ *
+ * Zones are recorded into per-thread buffers, so recording never contends
+ * with other threads. When profiling is disabled a zone costs one relaxed
+ * atomic load. The trace can be opened in chrome://tracing or Perfetto.
+ */
+class Profiler {
+public:
+  static Profiler &Get() {
+    static Profiler instance;
+    return instance;
+  }
+
+  /**
+   * @brief Enables zone recording. The trace is written to filename by
+   * WriteTrace().
+   */
+  void Enable(const std::string &filename);
+
+  bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Gets the current time in nanoseconds since the profiler started.
+   */
+  uint64_t Now() const;
+
+  /**
+   * @brief Records a completed zone on the calling thread.
+   * @param name Zone name. Must outlive the profiler (string literal).
+   */
+  void AddZone(const char *name, uint64_t startNs, uint64_t endNs);
+
+  /**
+   * @brief Names the calling thread in the trace.
+   */
+  void SetThreadName(const char *name);
+
+  /**
+   * @brief Writes all recorded zones as Chrome trace JSON.
+   * @return True if the file was written.
+   * @note Only the first call writes; later calls are ignored.
+   */
+  bool WriteTrace();
+
+private:
+  Profiler();
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+
+  struct Zone {
+    const char *name;
+    uint64_t startNs;
+    uint64_t endNs;
+  };
+
+  struct ThreadBuffer {
+    std::mutex mutex; // Only contended while the trace is written
+    std::vector<Zone> zones;
+    std::string threadName;
+    int threadId = 0;
+  };
+
+  ThreadBuffer *GetThreadBuffer();
+  void ReleaseThreadBuffer(ThreadBuffer *buffer);
+
+  std::atomic<bool> m_enabled{false};
+  bool m_written = false;
+  std::string m_filename;
+  int64_t m_startTicks = 0;
+
+  std::mutex m_buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+  std::vector<ThreadBuffer *> m_freeBuffers; ///< Of exited, unnamed threads
+};
+
+/**
+ * @brief Records a zone spanning the lifetime of the object.
+ */
+class ProfileScope {
+public:
+  explicit ProfileScope(const char *name) : m_name(name) {
+    Profiler &profiler = Profiler::Get();
+    m_active = profiler.IsEnabled();
+    if (m_active)
+      m_startNs = profiler.Now();
+  }
+
+  ~ProfileScope() {
+    if (m_active) {
+      Profiler &profiler = Profiler::Get();
+      profiler.AddZone(m_name, m_startNs, profiler.Now());
+    }
+  }
+
+private:
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+  const char *m_name;
+  uint64_t m_startNs = 0;
+  bool m_active = false;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)                                                    \
+  ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
@@ -0,0 +1,255 @@
+#include "RGBEDecoder.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RGBE_DECODER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Scanlines are run-length encoded only for widths in this range
+const int g_MinRLEWidth = 8;
+const int g_MaxRLEWidth = 32767;
+
+// Header lines longer than this are rejected, like stb_image does
+const size_t g_MaxHeaderLine = 1024;
+
+// 2^(E - 136) for every exponent byte; 0 for E = 0
+struct RGBEScaleTable {
+  float scale[256];
+  RGBEScaleTable() {
+    scale[0] = 0.0f;
+    for (int e = 1; e < 256; e++)
+      scale[e] = (float)ldexp(1.0f, e - (128 + 8));
+  }
+};
+const RGBEScaleTable g_RGBEScale;
+
+bool ReadLine(const uint8_t *data, size_t size, size_t &pos,
+              std::string &line) {
+  line.clear();
+  while (pos < size && data[pos] != '\n') {
+    if (line.size() >= g_MaxHeaderLine)
+      return false;
+    line += (char)data[pos++];
+  }
+  if (pos >= size)
+    return false;
+  pos++; // '\n'
+  return true;
+}
+
+// Parses "Y H X W" after the signs have been checked
+bool ParseResolution(const std::string &line, int &height, int &width) {
+  const char *text = line.c_str() + 3;
+  char *end;
+  long h = strtol(text, &end, 10);
+  while (*end == ' ')
+    end++;
+  if (strncmp(end, "+X ", 3) != 0)
+    return false;
+  long w = strtol(end + 3, &end, 10);
+  if (h <= 0 || w <= 0 || h > (1 << 24) || w > (1 << 24))
+    return false;
+  height = (int)h;
+  width = (int)w;
+  return true;
+}
+
+// Like stb_image, the first scanline decides between RLE and flat pixels
+bool IsRLEImage(const uint8_t *data, size_t size, size_t pos, int width) {
+  return width >= g_MinRLEWidth && width <= g_MaxRLEWidth && size - pos >= 4 &&
+         data[pos] == 2 && data[pos + 1] == 2 && !(data[pos + 2] & 0x80);
+}
+
+// Walks the runs of one RLE scanline without decoding it
+bool SkipRLEScanline(const uint8_t *data, size_t size, size_t &pos,
+                     int width) {
+  if (size - pos < 4 || data[pos] != 2 || data[pos + 1] != 2 ||
+      (data[pos + 2] & 0x80) ||
+      ((data[pos + 2] << 8) | data[pos + 3]) != width)
+    return false;
+  pos += 4;
+
+  for (int channel = 0; channel < 4; channel++) {
+    for (int x = 0; x < width;) {
+      if (pos >= size)
+        return false;
+      int count = data[pos++];
+      bool run = count > 128;
+      if (run)
+        count -= 128;
+      if (count == 0 || count > width - x)
+        return false;
+      size_t bytes = run ? 1 : (size_t)count;
+      if (size - pos < bytes)
+        return false;
+      pos += bytes;
+      x += count;
+    }
+  }
+  return true;
+}
+
+// Expands an RLE scanline (already validated) into four planes of width bytes
+void DecodeRLEScanline(const uint8_t *src, int width, uint8_t *planes) {
+  src += 4;
+  for (int channel = 0; channel < 4; channel++) {
+    uint8_t *plane = planes + (size_t)channel * width;
+    for (int x = 0; x < width;) {
+      int count = *src++;
+      if (count > 128) {
+        count -= 128;
+        memset(plane + x, *src++, count);
+      } else {
+        memcpy(plane + x, src, count);
+        src += count;
+      }
+      x += count;
+    }
+  }
+}
+
+inline void ConvertRGBEPixel(uint8_t r, uint8_t g, uint8_t b, uint8_t e,
+                             float *rgba) {
+  float scale = g_RGBEScale.scale[e];
+  rgba[0] = r * scale;
+  rgba[1] = g * scale;
+  rgba[2] = b * scale;
+  rgba[3] = 1.0f;
+}
+
+// Converts planar R, G, B, E bytes to RGBA32F
+void ConvertRGBEPlanes(const uint8_t *planes, int width, float *dst) {
+  const uint8_t *r = planes;
+  const uint8_t *g = r + width;
+  const uint8_t *b = g + width;
+  const uint8_t *e = b + width;
+  int x = 0;
+#ifdef RGBE_DECODER_SSE2
+  // Four pixels per step: widen each plane, scale, transpose to RGBA
+  const __m128i vZero = _mm_setzero_si128();
+  const float *scale = g_RGBEScale.scale;
+  auto load4 = [&](const uint8_t *src) {
+    int32_t bytes;
+    memcpy(&bytes, src, sizeof(bytes));
+    __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), vZero);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, vZero));
+  };
+  for (; x + 4 <= width; x += 4) {
+    __m128 vScale = _mm_setr_ps(scale[e[x]], scale[e[x + 1]],
+                                scale[e[x + 2]], scale[e[x + 3]]);
+    __m128 vR = _mm_mul_ps(load4(r + x), vScale);
+    __m128 vG = _mm_mul_ps(load4(g + x), vScale);
+    __m128 vB = _mm_mul_ps(load4(b + x), vScale);
+    __m128 vA = _mm_set1_ps(1.0f);
+    _MM_TRANSPOSE4_PS(vR, vG, vB, vA);
+    float *out = dst + (size_t)x * 4;
+    _mm_storeu_ps(out, vR);
+    _mm_storeu_ps(out + 4, vG);
+    _mm_storeu_ps(out + 8, vB);
+    _mm_storeu_ps(out + 12, vA);
+  }
+#endif
+  for (; x < width; x++)
+    ConvertRGBEPixel(r[x], g[x], b[x], e[x], dst + (size_t)x * 4);
+}
+
+} // namespace
+
+bool ReadRGBEHeader(const uint8_t *data, size_t size, RGBEHeader &header) {
+  size_t pos = 0;
+  std::string line;
+  if (!ReadLine(data, size, pos, line) ||
+      (line != "#?RADIANCE" && line != "#?RGBE"))
+    return false;
+
+  // Variables up to an empty line; only the pixel format matters here
+  for (;;) {
+    if (!ReadLine(data, size, pos, line))
+      return false;
+    if (line.empty())
+      break;
+    if (line.compare(0, 7, "FORMAT=") == 0 &&
+        line != "FORMAT=32-bit_rle_rgbe")
+      return false;
+  }
+
+  if (!ReadLine(data, size, pos, line))
+    return false;
+  bool topDown = line.compare(0, 3, "-Y ") == 0;
+  bool bottomUp = line.compare(0, 3, "+Y ") == 0;
+  if ((!topDown && !bottomUp) ||
+      !ParseResolution(line, header.height, header.width))
+    return false;
+
+  // Scanlines take at least 4 bytes per pixel flat, or a marker and a
+  // 2-byte run of up to 127 pixels per channel; callers allocate after this
+  size_t rowSize = (size_t)header.width * 4;
+  if (IsRLEImage(data, size, pos, header.width))
+    rowSize = 4 + 4 * 2 * (((size_t)header.width + 126) / 127);
+  if ((size - pos) / rowSize < (size_t)header.height)
+    return false;
+
+  header.bottomUp = bottomUp;
+  header.dataOffset = pos;
+  return true;
+}
+
+bool DecodeRGBEImage(const uint8_t *data, size_t size,
+                     const RGBEHeader &header, float *dst, int threadCount) {
+  PROFILE_SCOPE("DecodeRGBEImage");
+  const int width = header.width;
+  const int height = header.height;
+  size_t pos = header.dataOffset;
+  if (pos >= size)
+    return false;
+
+  auto dstRow = [&](int y) {
+    int row = header.bottomUp ? height - 1 - y : y;
+    return dst + (size_t)row * width * 4;
+  };
+
+  if (!IsRLEImage(data, size, pos, width)) {
+    size_t rowSize = (size_t)width * 4;
+    if ((size - pos) / rowSize < (size_t)height)
+      return false;
+    ParallelFor(height, threadCount, [&](int begin, int end) {
+      for (int y = begin; y < end; y++) {
+        const uint8_t *src = data + pos + rowSize * y;
+        float *out = dstRow(y);
+        for (int x = 0; x < width; x++, src += 4)
+          ConvertRGBEPixel(src[0], src[1], src[2], src[3], out + x * 4);
+      }
+    });
+    return true;
+  }
+
+  // Scanlines have variable sizes; find where each starts first
+  std::vector<size_t> offsets(height);
+  {
+    PROFILE_SCOPE("Scan Offsets");
+    for (int y = 0; y < height; y++) {
+      offsets[y] = pos;
+      if (!SkipRLEScanline(data, size, pos, width))
+        return false;
+    }
+  }
+
+  ParallelFor(height, threadCount, [&](int begin, int end) {
+    std::vector<uint8_t> planes((size_t)width * 4);
+    for (int y = begin; y < end; y++) {
+      DecodeRLEScanline(data + offsets[y], width, planes.data());
+      ConvertRGBEPlanes(planes.data(), width, dstRow(y));
+    }
+  });
+  return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Header of a Radiance picture (.hdr) with RGBE pixels.
+ */
+struct RGBEHeader {
+  int width = 0;
+  int height = 0;
+  bool bottomUp = false; ///< "+Y" resolution: scanlines start at the bottom
+  size_t dataOffset = 0; ///< Offset of the first scanline
+};
+
+/**
+ * @brief Parses the header and resolution line of a Radiance picture.
+ *
+ * Accepts "#?RADIANCE" and "#?RGBE" files in 32-bit_rle_rgbe format with
+ * "-Y H +X W" (top-down) or "+Y H +X W" (bottom-up) resolution lines.
+ * The resolution is checked against the smallest scanlines the rest of the
+ * file could hold, so callers can allocate width * height pixels after it.
+ * @return False if the file is not such a picture or is too small for its
+ * resolution.
+ */
+bool ReadRGBEHeader(const uint8_t *data, size_t size, RGBEHeader &header);
+
+/**
+ * @brief Decodes the pixels of a Radiance picture to RGBA32F.
+ *
+ * Scanline offsets are found with a quick serial pass over the run lengths,
+ * then scanlines are decoded in parallel and converted to float straight
+ * into dst. Values match stb_image bit for bit: RGB * 2^(E - 136), alpha 1.
+ *
+ * @param data Whole file, as read by ReadRGBEHeader().
+ * @param dst Receives width * height RGBA pixels, top row first.
+ * @param threadCount Number of threads to use (0 = hardware threads).
+ * @return False if the pixel data is truncated or its runs are corrupt.
+ */
+bool DecodeRGBEImage(const uint8_t *data, size_t size,
+                     const RGBEHeader &header, float *dst,
+                     int threadCount = 0);
@@ -0,0 +1,325 @@
+#include "RawImage.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// Largest PFM/PNM header field we accept, in characters
+const size_t g_MaxHeaderToken = 32;
+
+// Frame sizes tried for YUV dumps, largest first
+const int g_VideoSizes[][2] = {
+    {3840, 2160}, {2560, 1440}, {1920, 1088}, {1920, 1080},
+    {1280, 720},  {720, 576},   {720, 480},   {640, 480},
+    {352, 288},   {320, 240},   {176, 144},
+};
+
+// Reads the next whitespace-separated field of a PFM/PNM header, skipping
+// '#' comments. pos is left on the character after the field.
+bool ReadHeaderToken(const uint8_t *data, size_t size, size_t &pos,
+                     std::string &token) {
+  token.clear();
+  while (pos < size) {
+    if (data[pos] == '#') {
+      while (pos < size && data[pos] != '\n')
+        pos++;
+    } else if (isspace(data[pos])) {
+      pos++;
+    } else {
+      break;
+    }
+  }
+  while (pos < size && !isspace(data[pos]) && token.size() < g_MaxHeaderToken)
+    token += (char)data[pos++];
+  return !token.empty() && pos < size && isspace(data[pos]);
+}
+
+bool ParseDimension(const std::string &token, int &value) {
+  char *end;
+  long parsed = strtol(token.c_str(), &end, 10);
+  if (*end != '\0' || parsed <= 0 || parsed > INT32_MAX)
+    return false;
+  value = (int)parsed;
+  return true;
+}
+
+bool ParseSize(const std::string &token, uint64_t &value) {
+  char *end;
+  value = strtoull(token.c_str(), &end, 10);
+  return !token.empty() && *end == '\0' && token[0] != '-';
+}
+
+// Views rows starting at offset in the mapping, unless the file is too small
+bool ViewMappedPixels(const std::shared_ptr<MappedFile> &file, uint64_t offset,
+                      PixelFormat format, int width, int height,
+                      uint64_t rowPitch, bool flipY, PixelBuffer &buffer) {
+  uint64_t size = file->GetSize();
+  uint64_t rowSize = (uint64_t)width * GetPixelSize(format);
+  if (rowPitch < rowSize || rowPitch > size || offset > size ||
+      rowPitch * (height - 1) + rowSize > size - offset)
+    return false;
+
+  const uint8_t *first = file->GetData() + offset;
+  buffer = PixelBuffer();
+  buffer.format = format;
+  buffer.width = width;
+  buffer.height = height;
+  buffer.data = flipY ? first + rowPitch * (height - 1) : first;
+  buffer.rowPitch = flipY ? -(ptrdiff_t)rowPitch : (ptrdiff_t)rowPitch;
+  buffer.owner = file;
+  return true;
+}
+
+} // namespace
+
+bool IsRawImagePath(const std::string &filepath) {
+  size_t dot = filepath.find_last_of('.');
+  if (dot == std::string::npos)
+    return false;
+  std::string ext = filepath.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  return ext == "raw" || ext == "bin" || ext == "yuv" || ext == "nv12" ||
+         ext == "p010" || ext == "yuy2" || ext == "i420";
+}
+
+uint64_t GetRawImageBytes(const RawImageLayout &layout) {
+  if (layout.width <= 0 || layout.height <= 0)
+    return 0;
+  if (layout.yuvFormat != YUVFormat::None)
+    return GetYUVFrameSize(layout.yuvFormat, layout.width, layout.height,
+                           layout.rowPitch);
+  uint64_t rowSize = (uint64_t)layout.width * GetPixelSize(layout.format);
+  uint64_t rowPitch = layout.rowPitch ? layout.rowPitch : rowSize;
+  return rowPitch * (layout.height - 1) + rowSize;
+}
+
+bool OpenRawImage(const std::string &filepath, const RawImageLayout &layout,
+                  PixelBuffer &buffer) {
+  PROFILE_SCOPE("OpenRawImage");
+  auto file = std::make_shared<MappedFile>();
+  if (!file->Open(filepath)) {
+    LOG_ERROR("Failed to open raw file: %s", filepath.c_str());
+    return false;
+  }
+  if (layout.width <= 0 || layout.height <= 0)
+    return false;
+
+  uint64_t rowPitch = layout.rowPitch;
+  if (rowPitch == 0)
+    rowPitch = (uint64_t)layout.width * GetPixelSize(layout.format);
+  if (!ViewMappedPixels(file, layout.offset, layout.format, layout.width,
+                        layout.height, rowPitch, layout.flipY, buffer)) {
+    LOG_ERROR("Raw layout %s does not fit %s (%zu bytes)",
+              FormatRawImageLayout(layout).c_str(), filepath.c_str(),
+              file->GetSize());
+    return false;
+  }
+
+  LOG("Mapped raw %dx%d %s, %zu bytes", layout.width, layout.height,
+      GetPixelFormatInfo(layout.format).name, file->GetSize());
+  return true;
+}
+
+bool OpenPortableMap(const std::string &filepath, PixelBuffer &buffer) {
+  PROFILE_SCOPE("OpenPortableMap");
+  auto file = std::make_shared<MappedFile>();
+  if (!file->Open(filepath)) {
+    LOG_ERROR("Failed to open file: %s", filepath.c_str());
+    return false;
+  }
+  const uint8_t *data = file->GetData();
+  size_t size = file->GetSize();
+
+  std::string magic, widthToken, heightToken, lastToken;
+  size_t pos = 0;
+  int width, height;
+  if (!ReadHeaderToken(data, size, pos, magic) ||
+      !ReadHeaderToken(data, size, pos, widthToken) ||
+      !ReadHeaderToken(data, size, pos, heightToken) ||
+      !ReadHeaderToken(data, size, pos, lastToken) ||
+      !ParseDimension(widthToken, width) ||
+      !ParseDimension(heightToken, height))
+    return false;
+
+  // A single whitespace character separates the header from the samples
+  size_t offset = pos + 1;
+
+  if (magic == "PF" || magic == "Pf") {
+    // The scale's sign gives the byte order; rows are stored bottom-up
+    PixelFormat format =
+        magic == "PF" ? PixelFormat::RGB32F : PixelFormat::L32F;
+    double scale = atof(lastToken.c_str());
+    if (scale == 0.0 || !std::isfinite(scale))
+      return false;
+
+    uint64_t rowPitch = (uint64_t)width * GetPixelSize(format);
+    if (scale < 0.0) {
+      if (!ViewMappedPixels(file, offset, format, width, height, rowPitch,
+                            true, buffer)) {
+        LOG_ERROR("PFM file is truncated: %s", filepath.c_str());
+        return false;
+      }
+      return true;
+    }
+
+    // Big-endian files are copied with their bytes swapped
+    if (offset + rowPitch * height > size) {
+      LOG_ERROR("PFM file is truncated: %s", filepath.c_str());
+      return false;
+    }
+    LOG("Big-endian PFM is copied to swap its bytes: %s", filepath.c_str());
+    uint8_t *dst;
+    buffer = AllocatePixelBuffer(format, width, height, dst);
+    for (int y = 0; y < height; y++) {
+      const uint8_t *src = data + offset + rowPitch * (height - 1 - y);
+      uint8_t *row = dst + rowPitch * y;
+      for (size_t i = 0; i < rowPitch; i += 4) {
+        row[i + 0] = src[i + 3];
+        row[i + 1] = src[i + 2];
+        row[i + 2] = src[i + 1];
+        row[i + 3] = src[i + 0];
+      }
+    }
+    return true;
+  }
+
+  if (magic == "P5" || magic == "P6") {
+    // 16-bit samples are big-endian; other maximums would need rescaling
+    bool gray = magic == "P5";
+    int maxValue;
+    if (!ParseDimension(lastToken, maxValue))
+      return false;
+    PixelFormat format;
+    if (maxValue == 255) {
+      format = gray ? PixelFormat::L8 : PixelFormat::RGB8;
+    } else if (maxValue == 65535) {
+      format = gray ? PixelFormat::L16BE : PixelFormat::RGB16BE;
+    } else {
+      LOG("PNM maximum %d cannot be viewed in place: %s", maxValue,
+          filepath.c_str());
+      return false;
+    }
+
+    uint64_t rowPitch = (uint64_t)width * GetPixelSize(format);
+    if (!ViewMappedPixels(file, offset, format, width, height, rowPitch,
+                          false, buffer)) {
+      LOG_ERROR("PNM file is truncated: %s", filepath.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+bool GuessRawImageSize(uint64_t fileSize, RawImageLayout &layout) {
+  if (fileSize <= layout.offset)
+    return false;
+  if (layout.yuvFormat != YUVFormat::None) {
+    for (const auto &size : g_VideoSizes) {
+      uint64_t frameSize = GetYUVFrameSize(layout.yuvFormat, size[0], size[1]);
+      if ((fileSize - layout.offset) % frameSize == 0) {
+        layout.width = size[0];
+        layout.height = size[1];
+        layout.rowPitch = 0;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint64_t pixels = (fileSize - layout.offset) / GetPixelSize(layout.format);
+  uint64_t side = (uint64_t)std::sqrt((double)pixels);
+  while (side * side > pixels)
+    side--;
+  while ((side + 1) * (side + 1) <= pixels)
+    side++;
+  if (side == 0 || side * side != pixels || side > INT32_MAX)
+    return false;
+
+  layout.width = layout.height = (int)side;
+  layout.rowPitch = 0;
+  return true;
+}
+
+bool ParseRawImageLayout(const std::string &text, RawImageLayout &layout) {
+  std::vector<std::string> fields;
+  std::istringstream stream(text);
+  std::string field;
+  while (std::getline(stream, field, ','))
+    fields.push_back(field);
+  if (fields.size() < 3 || fields.size() > 6)
+    return false;
+
+  RawImageLayout parsed;
+  uint64_t rowPitch = 0;
+  if (!ParseDimension(fields[0], parsed.width) ||
+      !ParseDimension(fields[1], parsed.height) ||
+      (!FindPixelFormat(fields[2], parsed.format) &&
+       !FindYUVFormat(fields[2], parsed.yuvFormat)) ||
+      (fields.size() > 3 && !ParseSize(fields[3], rowPitch)) ||
+      (fields.size() > 4 && !ParseSize(fields[4], parsed.offset)) ||
+      (fields.size() > 5 && fields[5] != "flip"))
+    return false;
+
+  parsed.rowPitch = (size_t)rowPitch;
+  parsed.flipY = fields.size() > 5;
+  layout = parsed;
+  return true;
+}
+
+std::string FormatRawImageLayout(const RawImageLayout &layout) {
+  const char *format = layout.yuvFormat != YUVFormat::None
+                           ? GetYUVFormatName(layout.yuvFormat)
+                           : GetPixelFormatInfo(layout.format).name;
+  char text[128];
+  snprintf(text, sizeof(text), "%d,%d,%s,%llu,%llu%s", layout.width,
+           layout.height, format,
+           (unsigned long long)layout.rowPitch,
+           (unsigned long long)layout.offset, layout.flipY ? ",flip" : "");
+  return text;
+}
+
+bool ReadRawImageLayouts(const std::string &filepath,
+                         RawImageLayouts &layouts) {
+  std::ifstream file(std::filesystem::u8path(filepath));
+  if (!file.is_open())
+    return false;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t tab = line.find('\t');
+    if (line.empty() || line[0] == '#' || tab == std::string::npos)
+      continue;
+
+    RawImageLayout layout;
+    if (ParseRawImageLayout(line.substr(0, tab), layout))
+      layouts[line.substr(tab + 1)] = layout;
+  }
+  return true;
+}
+
+bool WriteRawImageLayouts(const std::string &filepath,
+                          const RawImageLayouts &layouts) {
+  std::ofstream file(std::filesystem::u8path(filepath),
+                     std::ios::out | std::ios::trunc);
+  if (!file.is_open())
+    return false;
+
+  file << "# ImgViewer raw image layouts\n"
+       << "# width,height,format,rowPitch,offset[,flip] <tab> path\n";
+  for (const auto &entry : layouts)
+    file << FormatRawImageLayout(entry.second) << '\t' << entry.first << '\n';
+  return file.good();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "PixelFormat.h"
+#include "YUVImage.h"
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * @brief Where the pixels of a headerless dump (.raw/.bin) are.
+ */
+struct RawImageLayout {
+  int width = 0;
+  int height = 0;
+  PixelFormat format = PixelFormat::RGBA8;
+  size_t rowPitch = 0; ///< Bytes per row in the file (0 = tightly packed)
+  uint64_t offset = 0; ///< Bytes before the first row
+  bool flipY = false;  ///< Rows are stored bottom-up (OpenGL readbacks)
+  /// Frames of YUV video instead of pixels of format; flipY is ignored
+  YUVFormat yuvFormat = YUVFormat::None;
+};
+
+/**
+ * @brief Checks if a path has an extension used for headerless dumps.
+ */
+bool IsRawImagePath(const std::string &filepath);
+
+/**
+ * @brief Gets the number of bytes a layout reads after its offset: one
+ * frame for YUV layouts.
+ */
+uint64_t GetRawImageBytes(const RawImageLayout &layout);
+
+/**
+ * @brief Maps a headerless dump and views its pixels in place.
+ *
+ * Nothing is read or copied here; pages are loaded when the pixels are
+ * first touched. The mapping stays alive as long as the buffer's owner.
+ * @return False if the file cannot be mapped or is too small for the layout.
+ */
+bool OpenRawImage(const std::string &filepath, const RawImageLayout &layout,
+                  PixelBuffer &buffer);
+
+/**
+ * @brief Maps a PFM, or a binary PGM/PPM (P5/P6), and views its pixels in
+ * place.
+ *
+ * Bottom-up PFM rows are viewed through a negative row pitch. Big-endian
+ * PFM files are the only ones copied, to swap their bytes.
+ * @return False if the file is not one of these formats, or its samples
+ * cannot be viewed as stored (a maximum value other than 255 or 65535).
+ */
+bool OpenPortableMap(const std::string &filepath, PixelBuffer &buffer);
+
+/**
+ * @brief Sets the layout's size to the square image of its format that
+ * fills the file after the offset, as a first guess for an unknown dump.
+ * YUV layouts get the largest common video size whose frames fill it.
+ * @return False if the remaining size is not a square number of pixels
+ * (or a whole number of frames).
+ */
+bool GuessRawImageSize(uint64_t fileSize, RawImageLayout &layout);
+
+/**
+ * @brief Parses "WIDTH,HEIGHT,FORMAT[,ROWPITCH[,OFFSET[,flip]]]"; FORMAT is
+ * a pixel format or a YUV format name.
+ */
+bool ParseRawImageLayout(const std::string &text, RawImageLayout &layout);
+
+/**
+ * @brief Formats a layout the way ParseRawImageLayout() reads it.
+ */
+std::string FormatRawImageLayout(const RawImageLayout &layout);
+
+/// Layouts of the dumps opened before, by UTF-8 path
+using RawImageLayouts = std::map<std::string, RawImageLayout>;
+
+/**
+ * @brief Reads remembered layouts, one "LAYOUT<tab>PATH" per line.
+ * @return False if the file cannot be opened.
+ */
+bool ReadRawImageLayouts(const std::string &filepath, RawImageLayouts &layouts);
+
+/**
+ * @brief Writes remembered layouts in the format ReadRawImageLayouts() reads.
+ */
+bool WriteRawImageLayouts(const std::string &filepath,
+                          const RawImageLayouts &layouts);
@@ -0,0 +1,248 @@
+#include "Reprojection.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define REPROJECTION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const float g_Pi = 3.14159265358979f;
+
+// Widest reprojected image; cube crosses are 4 faces of up to a quarter of it
+const int g_MaxReprojectedWidth = 8192;
+
+// Face of a horizontal cross at each cell of its 4 x 3 grid, -1 for none
+const int g_CrossFaces[3][4] = {
+    {-1, 2, -1, -1}, // +Y
+    {1, 4, 0, 5},    // -X +Z +X -Z
+    {-1, 3, -1, -1}, // -Y
+};
+
+// Direction at longitude u and latitude v in [0, 1] of a lat-long image
+void GetLatLongDirection(float u, float v, float dir[3]) {
+  float longitude = (u - 0.5f) * 2.0f * g_Pi;
+  float latitude = (0.5f - v) * g_Pi;
+  float c = std::cos(latitude);
+  dir[0] = c * std::sin(longitude);
+  dir[1] = std::sin(latitude);
+  dir[2] = c * std::cos(longitude);
+}
+
+// Weight of a texel out of 65535
+uint16_t ToWeight(float weight) {
+  return (uint16_t)(std::min(std::max(weight, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+// Splits a texel coordinate (texel centers at 0.5) into the first of two
+// texels within [0, size) and the weight of the second
+void ClampTexel(float coord, int size, int &texel, uint16_t &weight) {
+  float p = std::min(std::max(coord - 0.5f, 0.0f), (float)(size - 1));
+  texel = std::min((int)p, size - 2);
+  weight = ToWeight(p - texel);
+}
+
+// Tap of the texels around a direction in six faces of faceSize texels
+void GetCubeTap(const float dir[3], int faceSize,
+                ReprojectionTable::Tap &tap) {
+  float ax = std::fabs(dir[0]);
+  float ay = std::fabs(dir[1]);
+  float az = std::fabs(dir[2]);
+  int face;
+  float major, s, t;
+  if (ax >= ay && ax >= az) {
+    face = dir[0] > 0.0f ? 0 : 1;
+    major = ax;
+    s = dir[0] > 0.0f ? -dir[2] : dir[2];
+    t = -dir[1];
+  } else if (ay >= az) {
+    face = dir[1] > 0.0f ? 2 : 3;
+    major = ay;
+    s = dir[0];
+    t = dir[1] > 0.0f ? dir[2] : -dir[2];
+  } else {
+    face = dir[2] > 0.0f ? 4 : 5;
+    major = az;
+    s = dir[2] > 0.0f ? dir[0] : -dir[0];
+    t = -dir[1];
+  }
+
+  // Filtering stays within the face; edges are clamped
+  float scale = 0.5f * faceSize / major;
+  int x, y;
+  ClampTexel((s + major) * scale, faceSize, x, tap.weightX);
+  ClampTexel((t + major) * scale, faceSize, y, tap.weightY);
+  tap.index0 = ((uint32_t)face * faceSize + y) * faceSize + x;
+  tap.index1 = tap.index0 + 1;
+}
+
+// Tap of the texels around a direction in a width x height lat-long image
+void GetLatLongTap(const float dir[3], int width, int height,
+                   ReprojectionTable::Tap &tap) {
+  float length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+  float u = std::atan2(dir[0], dir[2]) / (2.0f * g_Pi) + 0.5f;
+  float v = 0.5f - std::asin(std::min(std::max(dir[1] / length, -1.0f),
+                                      1.0f)) / g_Pi;
+
+  // Longitude wraps around; latitude is clamped at the poles
+  float px = u * width - 0.5f;
+  float x0 = std::floor(px);
+  tap.weightX = ToWeight(px - x0);
+  int x = (int)x0 % width;
+  if (x < 0)
+    x += width;
+  int y;
+  ClampTexel(v * height, height, y, tap.weightY);
+  tap.index0 = (uint32_t)y * width + x;
+  tap.index1 = (uint32_t)y * width + (x + 1 < width ? x + 1 : 0);
+}
+
+// Filters one output pixel; the texels below are stride floats further on
+inline void FilterTap(const float *source, const ReprojectionTable::Tap &tap,
+                      size_t stride, float *out) {
+  const float weightScale = 1.0f / 65535.0f;
+  const float *p0 = source + (size_t)tap.index0 * 4;
+  const float *p1 = source + (size_t)tap.index1 * 4;
+  float fx = tap.weightX * weightScale;
+  float fy = tap.weightY * weightScale;
+#ifdef REPROJECTION_SSE2
+  __m128 vFx = _mm_set1_ps(fx);
+  __m128 vFy = _mm_set1_ps(fy);
+  __m128 top00 = _mm_loadu_ps(p0);
+  __m128 top10 = _mm_loadu_ps(p1);
+  __m128 bottom00 = _mm_loadu_ps(p0 + stride);
+  __m128 bottom10 = _mm_loadu_ps(p1 + stride);
+  __m128 top = _mm_add_ps(top00, _mm_mul_ps(_mm_sub_ps(top10, top00), vFx));
+  __m128 bottom =
+      _mm_add_ps(bottom00, _mm_mul_ps(_mm_sub_ps(bottom10, bottom00), vFx));
+  _mm_storeu_ps(out, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), vFy)));
+#else
+  for (int c = 0; c < 4; c++) {
+    float top = p0[c] + (p1[c] - p0[c]) * fx;
+    float bottom = p0[stride + c] + (p1[stride + c] - p0[stride + c]) * fx;
+    out[c] = top + (bottom - top) * fy;
+  }
+#endif
+}
+
+} // namespace
+
+void GetCubeFaceDirection(int face, float s, float t, float dir[3]) {
+  switch (face) {
+  case 0: // +X
+    dir[0] = 1.0f, dir[1] = -t, dir[2] = -s;
+    break;
+  case 1: // -X
+    dir[0] = -1.0f, dir[1] = -t, dir[2] = s;
+    break;
+  case 2: // +Y
+    dir[0] = s, dir[1] = 1.0f, dir[2] = t;
+    break;
+  case 3: // -Y
+    dir[0] = s, dir[1] = -1.0f, dir[2] = -t;
+    break;
+  case 4: // +Z
+    dir[0] = s, dir[1] = -t, dir[2] = 1.0f;
+    break;
+  default: // -Z
+    dir[0] = -s, dir[1] = -t, dir[2] = -1.0f;
+    break;
+  }
+}
+
+void GetReprojectedSize(Reprojection reprojection, int sourceWidth,
+                        int &width, int &height) {
+  if (reprojection == Reprojection::CubeToLatLong) {
+    width = std::min(4 * sourceWidth, g_MaxReprojectedWidth);
+    height = std::max(width / 2, 1);
+    return;
+  }
+  int faceSize = std::max(std::min(sourceWidth, g_MaxReprojectedWidth) / 4, 1);
+  width = 4 * faceSize;
+  height = 3 * faceSize;
+}
+
+bool BuildReprojectionTable(Reprojection reprojection, int sourceWidth,
+                            int sourceHeight, ReprojectionTable &table,
+                            int threadCount) {
+  if (sourceWidth < 2 || sourceHeight < 2)
+    return false;
+  uint64_t sourceTexels = (uint64_t)sourceWidth * sourceHeight;
+  if (reprojection == Reprojection::CubeToLatLong)
+    sourceTexels *= 6;
+  if (sourceTexels >= ReprojectionTable::EmptyTap)
+    return false;
+
+  int width, height;
+  GetReprojectedSize(reprojection, sourceWidth, width, height);
+  if (table.reprojection == reprojection &&
+      table.sourceWidth == sourceWidth && table.sourceHeight == sourceHeight &&
+      table.width == width && table.height == height)
+    return true;
+
+  PROFILE_SCOPE("BuildReprojectionTable");
+  table.reprojection = reprojection;
+  table.sourceWidth = sourceWidth;
+  table.sourceHeight = sourceHeight;
+  table.width = width;
+  table.height = height;
+  table.rowStride = sourceWidth;
+  table.taps.resize((size_t)width * height);
+
+  ReprojectionTable::Tap *taps = table.taps.data();
+  ParallelFor(height, threadCount, [&](int begin, int end) {
+    float dir[3];
+    for (int y = begin; y < end; y++) {
+      ReprojectionTable::Tap *row = taps + (size_t)y * width;
+      if (reprojection == Reprojection::CubeToLatLong) {
+        float v = (y + 0.5f) / height;
+        for (int x = 0; x < width; x++) {
+          GetLatLongDirection((x + 0.5f) / width, v, dir);
+          GetCubeTap(dir, sourceWidth, row[x]);
+        }
+        continue;
+      }
+
+      int faceSize = width / 4;
+      int cellY = y / faceSize;
+      float t = 2.0f * (y - cellY * faceSize + 0.5f) / faceSize - 1.0f;
+      for (int x = 0; x < width; x++) {
+        int cellX = x / faceSize;
+        int face = g_CrossFaces[cellY][cellX];
+        if (face < 0) {
+          row[x] = {ReprojectionTable::EmptyTap, 0, 0, 0};
+          continue;
+        }
+        float s = 2.0f * (x - cellX * faceSize + 0.5f) / faceSize - 1.0f;
+        GetCubeFaceDirection(face, s, t, dir);
+        GetLatLongTap(dir, sourceWidth, sourceHeight, row[x]);
+      }
+    }
+  });
+  return true;
+}
+
+void Reproject(const ReprojectionTable &table, const float *source,
+               float *out, int threadCount) {
+  PROFILE_SCOPE("Reproject");
+  size_t stride = (size_t)table.rowStride * 4;
+  ParallelFor(table.height, threadCount, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      const ReprojectionTable::Tap *taps =
+          table.taps.data() + (size_t)y * table.width;
+      float *dst = out + (size_t)y * table.width * 4;
+      for (int x = 0; x < table.width; x++, dst += 4) {
+        if (taps[x].index0 == ReprojectionTable::EmptyTap) {
+          dst[0] = dst[1] = dst[2] = dst[3] = 0.0f;
+          continue;
+        }
+        FilterTap(source, taps[x], stride, dst);
+      }
+    }
+  });
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Direction an environment map is reprojected in.
+ *
+ * Lat-long images have longitude across (-Z at the edges, +Z at the center)
+ * and +Y up. Cubemaps are six square faces in D3D order (+X, -X, +Y, -Y,
+ * +Z, -Z), one after another; they are shown as a horizontal cross.
+ */
+enum class Reprojection {
+  CubeToLatLong, ///< Cubemap faces to a lat-long image, 4 x 2 faces wide
+  LatLongToCube  ///< Lat-long image to a cross of 4 x 3 faces
+};
+
+/**
+ * @brief Gets the direction through (s, t) in [-1, 1] on a cube face, s to
+ * the right and t down. The direction is not normalized.
+ */
+void GetCubeFaceDirection(int face, float s, float t, float dir[3]);
+
+/**
+ * @brief Lookup table from each pixel of a reprojected environment map to
+ * the source texels it is filtered from.
+ *
+ * The direction of every output pixel and the texels around it in the
+ * source are found once; Reproject() then only filters. A table stays valid
+ * until the source or output size changes.
+ */
+struct ReprojectionTable {
+  /// Bilinear filter of one output pixel: texels index0 and index1 of a
+  /// source row, and the texels rowStride after them
+  struct Tap {
+    uint32_t index0;  ///< Left texel; EmptyTap outside the faces of a cross
+    uint32_t index1;  ///< Right texel; wraps around lat-long images
+    uint16_t weightX; ///< Weight of the right texels (65535 = 1)
+    uint16_t weightY; ///< Weight of the lower texels (65535 = 1)
+  };
+  static constexpr uint32_t EmptyTap = 0xFFFFFFFFu;
+
+  Reprojection reprojection = Reprojection::CubeToLatLong;
+  int sourceWidth = 0;  ///< Width of the source; face size of cubemaps
+  int sourceHeight = 0; ///< Height of the source; face size of cubemaps
+  int width = 0;        ///< Width of the output
+  int height = 0;       ///< Height of the output
+  int rowStride = 0;    ///< Texels between a source row and the next
+  std::vector<Tap> taps;
+};
+
+/**
+ * @brief Gets the size of the output of a reprojection.
+ * @param sourceWidth Width of the lat-long image or cube face.
+ *
+ * Lat-long images are 4 faces wide and cube faces a quarter of the lat-long
+ * width, so texels keep about the same size. Outputs are limited to 8192
+ * pixels across.
+ */
+void GetReprojectedSize(Reprojection reprojection, int sourceWidth,
+                        int &width, int &height);
+
+/**
+ * @brief Fills a lookup table for a source size, in parallel over output
+ * rows, unless the table already is for that reprojection and size.
+ * @param sourceWidth Width of the lat-long image or cube face.
+ * @param threadCount 0 = hardware threads.
+ * @return False if the source is smaller than 2 x 2 texels or has more
+ * texels than 32-bit indices reach.
+ */
+bool BuildReprojectionTable(Reprojection reprojection, int sourceWidth,
+                            int sourceHeight, ReprojectionTable &table,
+                            int threadCount = 0);
+
+/**
+ * @brief Reprojects an environment map through a lookup table with bilinear
+ * filtering, in parallel over rows.
+ * @param source RGBA32F lat-long image, or the six faces of a cubemap.
+ * @param out Receives table.width x table.height RGBA32F pixels; pixels
+ * outside the faces of a cross are transparent black.
+ * @param threadCount 0 = hardware threads.
+ */
+void Reproject(const ReprojectionTable &table, const float *source,
+               float *out, int threadCount = 0);
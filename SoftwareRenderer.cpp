@@ -0,0 +1,192 @@
+#include "SoftwareRenderer.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstring>
+
+#define STBIW_WINDOWS_UTF8
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RENDERER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Matches the clear color used by ImageRenderer::RenderToTexture
+static const float g_ClearColor[4] = {0.1f, 0.1f, 0.1f, 1.0f};
+
+// Float to UNORM8 as done by the output merger (saturate, round to nearest)
+static inline unsigned char ToUnorm8(float value) {
+  // Written so that NaN maps to 0, like saturate() on the GPU
+  if (!(value > 0.0f))
+    return 0;
+  if (value >= 1.0f)
+    return 255;
+  return (unsigned char)(int)(value * 255.0f + 0.5f);
+}
+
+// Maps an output coordinate to a texel index along one axis. The quad spans
+// [offset, offset + imageSize * zoom) in output pixels and is sampled at
+// pixel centers with a point/clamp sampler.
+static inline int MapToTexel(int outCoord, float offset, float displaySize,
+                             int imageSize) {
+  float uv = ((float)outCoord + 0.5f - offset) / displaySize;
+  if (!(uv >= 0.0f && uv < 1.0f))
+    return -1;
+  return std::min(imageSize - 1, (int)(uv * (float)imageSize));
+}
+
+// Shader constants derived from the view parameters
+struct ShadeConstants {
+  float rangeMin;
+  float rangeSize;
+  float mask[4];
+};
+
+static ShadeConstants GetShadeConstants(const SoftwareViewParams &params) {
+  ShadeConstants constants;
+  constants.rangeMin = params.rangeMin;
+  constants.rangeSize = params.rangeMax - params.rangeMin;
+  if (!(constants.rangeSize > 0.0001f)) {
+    constants.rangeMin = 0.0f;
+    constants.rangeSize = 1.0f;
+  }
+  constants.mask[0] = params.showR ? 1.0f : 0.0f;
+  constants.mask[1] = params.showG ? 1.0f : 0.0f;
+  constants.mask[2] = params.showB ? 1.0f : 0.0f;
+  constants.mask[3] = 1.0f;
+  return constants;
+}
+
+static inline void ShadeTexelScalar(const float *texel,
+                                    const ShadeConstants &constants,
+                                    unsigned char *out) {
+  for (int c = 0; c < 3; c++) {
+    float value = (texel[c] - constants.rangeMin) / constants.rangeSize;
+    out[c] = ToUnorm8(value * constants.mask[c]);
+  }
+  out[3] = ToUnorm8(texel[3]);
+}
+
+SoftwareRenderer::SoftwareRenderer(int threadCount)
+    : m_threadCount(threadCount) {}
+
+void SoftwareRenderer::ShadeTexel(const float *texel,
+                                  const SoftwareViewParams &params,
+                                  unsigned char *outRGBA) {
+  ShadeTexelScalar(texel, GetShadeConstants(params), outRGBA);
+}
+
+bool SoftwareRenderer::Render(const ImageData &imageData,
+                              const SoftwareViewParams &params, int width,
+                              int height, std::vector<unsigned char> &outRGBA) {
+  if (width <= 0 || height <= 0 || width > MaxOutputSize ||
+      height > MaxOutputSize)
+    return false;
+
+  if (imageData.width <= 0 || imageData.height <= 0 ||
+      imageData.GetPixelCount() < (size_t)imageData.width * imageData.height ||
+      !(params.zoom > 0.0f))
+    return false;
+
+  outRGBA.resize((size_t)width * height * 4);
+
+  // Same transform as RenderToTexture / HandleImageInteraction: the image is
+  // centered in the view, scaled by zoom, then offset by pan (screen pixels).
+  float displayWidth = imageData.width * params.zoom;
+  float displayHeight = imageData.height * params.zoom;
+  float offsetX = (width - displayWidth) * 0.5f + params.panX;
+  float offsetY = (height - displayHeight) * 0.5f + params.panY;
+
+  m_columnTexels.resize(width);
+  for (int x = 0; x < width; x++) {
+    m_columnTexels[x] = MapToTexel(x, offsetX, displayWidth, imageData.width);
+  }
+
+  const ShadeConstants constants = GetShadeConstants(params);
+
+  unsigned char clear[4];
+  for (int c = 0; c < 4; c++)
+    clear[c] = ToUnorm8(g_ClearColor[c]);
+
+  const int *columns = m_columnTexels.data();
+  const float *src = imageData.pixels.data();
+  const PixelBuffer &stored = imageData.stored;
+  bool convert = imageData.HasStoredPixels();
+  unsigned char *dst = outRGBA.data();
+  int imageWidth = imageData.width;
+  int imageHeight = imageData.height;
+
+  ParallelFor(height, m_threadCount, [&](int rowBegin, int rowEnd) {
+#ifdef SOFTWARE_RENDERER_SSE2
+    // Alpha passes through the remap untouched: (a - 0) / 1
+    const float rangeMin = constants.rangeMin;
+    const float rangeSize = constants.rangeSize;
+    const __m128 vMin = _mm_setr_ps(rangeMin, rangeMin, rangeMin, 0.0f);
+    const __m128 vSize = _mm_setr_ps(rangeSize, rangeSize, rangeSize, 1.0f);
+    const __m128 vMask = _mm_loadu_ps(constants.mask);
+    const __m128 vZero = _mm_setzero_ps();
+    const __m128 vOne = _mm_set1_ps(1.0f);
+    const __m128 vScale = _mm_set1_ps(255.0f);
+    const __m128 vHalf = _mm_set1_ps(0.5f);
+#endif
+
+    // Stored rows are widened to RGBA32F when they are sampled
+    std::vector<float> rowBuffer;
+
+    for (int y = rowBegin; y < rowEnd; y++) {
+      unsigned char *dstRow = dst + (size_t)y * width * 4;
+      int ty = MapToTexel(y, offsetY, displayHeight, imageHeight);
+
+      if (ty < 0) {
+        for (int x = 0; x < width; x++)
+          memcpy(dstRow + x * 4, clear, 4);
+        continue;
+      }
+
+      const float *srcRow = src + (size_t)ty * imageWidth * 4;
+      if (convert) {
+        rowBuffer.resize((size_t)imageWidth * 4);
+        ConvertPixelRow(stored.format, stored.GetRow(ty), imageWidth,
+                        rowBuffer.data());
+        srcRow = rowBuffer.data();
+      }
+      for (int x = 0; x < width; x++) {
+        int tx = columns[x];
+        if (tx < 0) {
+          memcpy(dstRow + x * 4, clear, 4);
+          continue;
+        }
+
+        const float *texel = srcRow + (size_t)tx * 4;
+#ifdef SOFTWARE_RENDERER_SSE2
+        __m128 color = _mm_loadu_ps(texel);
+        color = _mm_div_ps(_mm_sub_ps(color, vMin), vSize);
+        color = _mm_mul_ps(color, vMask);
+        // max(x, 0) returns the second operand for NaN, so NaN -> 0
+        color = _mm_min_ps(_mm_max_ps(color, vZero), vOne);
+        __m128i bytes =
+            _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(color, vScale), vHalf));
+        bytes = _mm_packs_epi32(bytes, bytes);
+        bytes = _mm_packus_epi16(bytes, bytes);
+        int packed = _mm_cvtsi128_si32(bytes);
+        memcpy(dstRow + x * 4, &packed, 4);
+#else
+        ShadeTexelScalar(texel, constants, dstRow + x * 4);
+#endif
+      }
+    }
+  });
+
+  return true;
+}
+
+bool SoftwareRenderer::WritePNG(const std::string &filepath,
+                                const std::vector<unsigned char> &rgba,
+                                int width, int height) {
+  if (rgba.size() < (size_t)width * height * 4)
+    return false;
+  return stbi_write_png(filepath.c_str(), width, height, 4, rgba.data(),
+                        width * 4) != 0;
+}
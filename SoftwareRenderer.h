@@ -0,0 +1,76 @@
+#pragma once
+#include "ImageData.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief View parameters mirroring the constants consumed by g_PixelShader.
+ */
+struct SoftwareViewParams {
+  float zoom = 1.0f;     ///< Image pixel size / screen pixel size
+  float panX = 0.0f;     ///< Pan offset in screen pixels
+  float panY = 0.0f;     ///< Pan offset in screen pixels
+  float rangeMin = 0.0f; ///< Lower bound of the value remap
+  float rangeMax = 1.0f; ///< Upper bound of the value remap
+  bool showR = true;     ///< Channel mask (red)
+  bool showG = true;     ///< Channel mask (green)
+  bool showB = true;     ///< Channel mask (blue)
+};
+
+/**
+ * @brief CPU reference implementation of the image view pass.
+ *
+ * Reproduces ImageRenderer::RenderToTexture (zoom/pan transform, point
+ * sampling with clamp, range remap, channel mask, saturate and UNORM8
+ * conversion) without a GPU. Rows are rendered in parallel.
+ */
+class SoftwareRenderer {
+public:
+  /// Largest output width or height (the D3D12 texture size limit)
+  static constexpr int MaxOutputSize = 16384;
+
+  /**
+   * @brief Constructor.
+   * @param threadCount Worker threads to use (0 = hardware threads).
+   */
+  explicit SoftwareRenderer(int threadCount = 0);
+
+  /**
+   * @brief Renders the view of an image into an RGBA8 buffer.
+   * @param imageData Source image (RGBA32F).
+   * @param params View transform and color mapping.
+   * @param width Output width in pixels (the view size).
+   * @param height Output height in pixels (the view size).
+   * @param outRGBA Receives width * height * 4 bytes.
+   * @return False if the image is empty, zoom is not positive or the
+   * output size is outside 1..MaxOutputSize.
+   */
+  bool Render(const ImageData &imageData, const SoftwareViewParams &params,
+              int width, int height, std::vector<unsigned char> &outRGBA);
+
+  /**
+   * @brief Shades one texel the way Render does, without SIMD.
+   *
+   * Render uses SSE2 where available; this scalar form is the reference it
+   * must match bit for bit, including NaN and infinities.
+   * @param texel RGBA32F source value.
+   * @param outRGBA Receives 4 bytes.
+   */
+  static void ShadeTexel(const float *texel, const SoftwareViewParams &params,
+                         unsigned char *outRGBA);
+
+  /**
+   * @brief Writes an RGBA8 buffer as a PNG file.
+   * @return True if successful.
+   */
+  static bool WritePNG(const std::string &filepath,
+                       const std::vector<unsigned char> &rgba, int width,
+                       int height);
+
+private:
+  int m_threadCount = 0;
+
+  // Source texel column for each output column (-1 = outside the quad).
+  // Cached between calls since it only depends on the transform.
+  std::vector<int> m_columnTexels;
+};
@@ -0,0 +1,956 @@
+#include "TIFFImage.h"
+#include "HalfFloat.h"
+#include "Logger.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <zlib.h>
+
+namespace {
+
+// Tags read from the directories
+enum : uint16_t {
+  TagNewSubfileType = 254,
+  TagImageWidth = 256,
+  TagImageLength = 257,
+  TagBitsPerSample = 258,
+  TagCompression = 259,
+  TagPhotometric = 262,
+  TagStripOffsets = 273,
+  TagSamplesPerPixel = 277,
+  TagRowsPerStrip = 278,
+  TagStripByteCounts = 279,
+  TagPlanarConfig = 284,
+  TagPredictor = 317,
+  TagColorMap = 320,
+  TagTileWidth = 322,
+  TagTileLength = 323,
+  TagTileOffsets = 324,
+  TagTileByteCounts = 325,
+  TagSampleFormat = 339,
+};
+
+// Field types whose values are unsigned integers
+enum : uint16_t {
+  TypeByte = 1,
+  TypeShort = 3,
+  TypeLong = 4,
+  TypeIFD = 13,
+  TypeLong8 = 16,
+  TypeIFD8 = 18,
+};
+
+enum : int {
+  CompressionNone = 1,
+  CompressionLZW = 5,
+  CompressionDeflate = 8,
+  CompressionPackBits = 32773,
+  CompressionDeflateOld = 32946,
+};
+
+enum : int { SampleUInt = 1, SampleInt = 2, SampleFloat = 3 };
+
+enum : int {
+  PhotometricMinIsWhite = 0,
+  PhotometricMinIsBlack = 1,
+  PhotometricRGB = 2,
+  PhotometricPalette = 3,
+};
+
+enum : int { PredictorNone = 1, PredictorHorizontal = 2, PredictorFloat = 3 };
+
+// NewSubfileType bit of thumbnails and pyramid levels
+const uint32_t g_ReducedResolution = 0x1;
+
+// Directory chains longer than this are taken as damaged
+const int g_MaxDirectories = 4096;
+
+// Sizes above this are taken as a damaged header
+const uint64_t g_MaxDimension = 1 << 24;
+
+// Strips and tiles that would decompress to more than this are rejected
+const uint64_t g_MaxChunkBytes = 1ull << 31;
+
+const char *GetCompressionName(int compression) {
+  switch (compression) {
+  case CompressionNone:
+    return "none";
+  case CompressionLZW:
+    return "LZW";
+  case CompressionDeflate:
+  case CompressionDeflateOld:
+    return "Deflate";
+  case CompressionPackBits:
+    return "PackBits";
+  default:
+    return "unknown";
+  }
+}
+
+struct Reader {
+  const uint8_t *data;
+  size_t size;
+  bool bigEndian;
+
+  uint16_t U16(uint64_t pos) const {
+    const uint8_t *p = data + pos;
+    return bigEndian ? (uint16_t)(p[0] << 8 | p[1])
+                     : (uint16_t)(p[0] | p[1] << 8);
+  }
+  uint32_t U32(uint64_t pos) const {
+    uint32_t hi = U16(pos), lo = U16(pos + 2);
+    return bigEndian ? hi << 16 | lo : lo << 16 | hi;
+  }
+  uint64_t U64(uint64_t pos) const {
+    uint64_t hi = U32(pos), lo = U32(pos + 4);
+    return bigEndian ? hi << 32 | lo : lo << 32 | hi;
+  }
+};
+
+size_t GetTypeSize(uint16_t type) {
+  switch (type) {
+  case 1: // BYTE
+  case 2: // ASCII
+  case 6: // SBYTE
+  case 7: // UNDEFINED
+    return 1;
+  case 3: // SHORT
+  case 8: // SSHORT
+    return 2;
+  case 4:  // LONG
+  case 9:  // SLONG
+  case 11: // FLOAT
+  case 13: // IFD
+    return 4;
+  case 5:  // RATIONAL
+  case 10: // SRATIONAL
+  case 12: // DOUBLE
+  case 16: // LONG8
+  case 17: // SLONG8
+  case 18: // IFD8
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+// Reads the unsigned integer values of a field stored at pos
+bool ReadValues(const Reader &reader, uint16_t type, uint64_t count,
+                uint64_t pos, std::vector<uint64_t> &values) {
+  size_t typeSize = GetTypeSize(type);
+  if (typeSize == 0 || pos > reader.size ||
+      count > (reader.size - pos) / typeSize)
+    return false;
+  values.resize((size_t)count);
+  for (size_t i = 0; i < values.size(); i++) {
+    uint64_t at = pos + i * typeSize;
+    switch (type) {
+    case TypeByte:
+      values[i] = reader.data[at];
+      break;
+    case TypeShort:
+      values[i] = reader.U16(at);
+      break;
+    case TypeLong:
+    case TypeIFD:
+      values[i] = reader.U32(at);
+      break;
+    case TypeLong8:
+    case TypeIFD8:
+      values[i] = reader.U64(at);
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+// ---- Decompression ----
+
+// TIFF LZW: MSB-first codes of 9-12 bits, widened one code early. Each
+// table entry is a run of the output, so strings are copied, not chained.
+// Returns the number of bytes written.
+size_t DecodeLZW(const uint8_t *src, size_t size, uint8_t *dst,
+                 size_t dstSize) {
+  const int clearCode = 256;
+  const int endCode = 257;
+  struct Entry {
+    size_t offset;
+    size_t length;
+  };
+  Entry table[4096];
+
+  size_t out = 0;
+  size_t pos = 0;
+  uint32_t bits = 0;
+  int bitCount = 0;
+  int width = 9;
+  int next = 258;
+  bool havePrev = false;
+  size_t prevOffset = 0, prevLength = 0;
+
+  while (out < dstSize) {
+    while (bitCount < width && pos < size) {
+      bits = bits << 8 | src[pos++];
+      bitCount += 8;
+    }
+    if (bitCount < width)
+      break;
+    int code = (int)(bits >> (bitCount - width)) & ((1 << width) - 1);
+    bitCount -= width;
+
+    if (code == endCode)
+      break;
+    if (code == clearCode) {
+      width = 9;
+      next = 258;
+      havePrev = false;
+      continue;
+    }
+
+    size_t offset = out;
+    size_t length;
+    if (code < 256) {
+      dst[out++] = (uint8_t)code;
+      length = 1;
+    } else if (code < next && code > endCode) {
+      length = std::min(table[code].length, dstSize - out);
+      memcpy(dst + out, dst + table[code].offset, length);
+      out += length;
+    } else if (code == next && havePrev) {
+      // The entry being defined: the previous string and its first byte
+      length = std::min(prevLength + 1, dstSize - out);
+      for (size_t i = 0; i < length; i++)
+        dst[out + i] = dst[prevOffset + (i < prevLength ? i : 0)];
+      out += length;
+    } else {
+      break; // Corrupt
+    }
+
+    // The new entry is the previous string and the first byte of this one,
+    // which follows it in the output
+    if (havePrev && next < 4096) {
+      table[next++] = {prevOffset, prevLength + 1};
+      if (next >= (1 << width) - 1 && width < 12)
+        width++;
+    }
+    havePrev = true;
+    prevOffset = offset;
+    prevLength = length;
+  }
+  return out;
+}
+
+size_t DecodePackBits(const uint8_t *src, size_t size, uint8_t *dst,
+                      size_t dstSize) {
+  size_t out = 0;
+  size_t pos = 0;
+  while (pos < size && out < dstSize) {
+    int n = (int8_t)src[pos++];
+    if (n >= 0) {
+      size_t count = std::min<size_t>(n + 1, size - pos);
+      count = std::min(count, dstSize - out);
+      memcpy(dst + out, src + pos, count);
+      pos += n + 1;
+      out += count;
+    } else if (n != -128) {
+      if (pos >= size)
+        break;
+      size_t count = std::min<size_t>(1 - n, dstSize - out);
+      memset(dst + out, src[pos++], count);
+      out += count;
+    }
+  }
+  return out;
+}
+
+size_t DecodeDeflate(const uint8_t *src, size_t size, uint8_t *dst,
+                     size_t dstSize) {
+  z_stream stream = {};
+  if (inflateInit(&stream) != Z_OK)
+    return 0;
+  stream.next_in = const_cast<Bytef *>(src);
+  stream.avail_in = (uInt)std::min<size_t>(size, 0xffffffffu);
+  stream.next_out = dst;
+  stream.avail_out = (uInt)dstSize;
+  // Filling the strip is enough; some writers leave the stream unfinished
+  inflate(&stream, Z_FINISH);
+  size_t out = dstSize - stream.avail_out;
+  inflateEnd(&stream);
+  return out;
+}
+
+// ---- Predictors ----
+
+template <typename T>
+void UndoHorizontal(uint8_t *row, size_t count, int stride) {
+  T *samples = (T *)row;
+  for (size_t i = stride; i < count; i++)
+    samples[i] = (T)(samples[i] + samples[i - stride]);
+}
+
+// Horizontal differences of 8 to 64-bit samples, in native byte order
+void UndoHorizontalPredictor(uint8_t *row, size_t count, int stride,
+                             int bytes) {
+  switch (bytes) {
+  case 1:
+    UndoHorizontal<uint8_t>(row, count, stride);
+    break;
+  case 2:
+    UndoHorizontal<uint16_t>(row, count, stride);
+    break;
+  case 4:
+    UndoHorizontal<uint32_t>(row, count, stride);
+    break;
+  case 8:
+    UndoHorizontal<uint64_t>(row, count, stride);
+    break;
+  }
+}
+
+// The floating-point predictor differences the bytes of a row after
+// splitting the samples into byte planes, most significant first
+void UndoFloatPredictor(uint8_t *row, size_t count, int stride, int bytes,
+                        std::vector<uint8_t> &temp) {
+  size_t rowBytes = count * bytes;
+  for (size_t i = stride; i < rowBytes; i++)
+    row[i] = (uint8_t)(row[i] + row[i - stride]);
+  temp.assign(row, row + rowBytes);
+  for (size_t i = 0; i < count; i++) {
+    for (int b = 0; b < bytes; b++)
+      row[i * bytes + b] = temp[(bytes - 1 - b) * count + i];
+  }
+}
+
+void SwapBytes(uint8_t *data, size_t size, int bytes) {
+  for (size_t i = 0; i + bytes <= size; i += bytes)
+    std::reverse(data + i, data + i + bytes);
+}
+
+// ---- Conversion ----
+
+// Samples of a row as floats: UNORM for unsigned integers, as they are for
+// signed integers and floats
+void ReadSamples(const uint8_t *src, int sampleFormat, int bits,
+                 size_t count, float *dst) {
+  if (sampleFormat == SampleFloat) {
+    if (bits == 16) {
+      HalfToFloatArray((const uint16_t *)src, dst, count);
+    } else if (bits == 32) {
+      memcpy(dst, src, count * sizeof(float));
+    } else {
+      const double *values = (const double *)src;
+      for (size_t i = 0; i < count; i++)
+        dst[i] = (float)values[i];
+    }
+  } else if (sampleFormat == SampleInt) {
+    for (size_t i = 0; i < count; i++) {
+      dst[i] = bits == 8    ? (float)((const int8_t *)src)[i]
+               : bits == 16 ? (float)((const int16_t *)src)[i]
+                            : (float)((const int32_t *)src)[i];
+    }
+  } else if (bits == 8) {
+    for (size_t i = 0; i < count; i++)
+      dst[i] = src[i] / 255.0f;
+  } else if (bits == 16) {
+    const uint16_t *values = (const uint16_t *)src;
+    for (size_t i = 0; i < count; i++)
+      dst[i] = values[i] / 65535.0f;
+  } else {
+    const uint32_t *values = (const uint32_t *)src;
+    for (size_t i = 0; i < count; i++)
+      dst[i] = (float)(values[i] / 4294967295.0);
+  }
+}
+
+// A layout kept as stored
+struct DirectFormat {
+  int sampleFormat;
+  int bits;
+  bool rgb;
+  int channels;
+  PixelFormat format;
+};
+
+const DirectFormat g_DirectFormats[] = {
+    {SampleUInt, 8, false, 1, PixelFormat::L8},
+    {SampleUInt, 8, true, 3, PixelFormat::RGB8},
+    {SampleUInt, 8, true, 4, PixelFormat::RGBA8},
+    {SampleUInt, 16, false, 1, PixelFormat::L16},
+    {SampleUInt, 16, false, 2, PixelFormat::LA16},
+    {SampleUInt, 16, true, 3, PixelFormat::RGB16},
+    {SampleUInt, 16, true, 4, PixelFormat::RGBA16},
+    {SampleUInt, 32, false, 1, PixelFormat::R32UI},
+    {SampleUInt, 32, false, 2, PixelFormat::RG32UI},
+    {SampleUInt, 32, true, 3, PixelFormat::RGB32UI},
+    {SampleUInt, 32, true, 4, PixelFormat::RGBA32UI},
+    {SampleInt, 8, false, 1, PixelFormat::R8I},
+    {SampleInt, 8, false, 2, PixelFormat::RG8I},
+    {SampleInt, 8, true, 4, PixelFormat::RGBA8I},
+    {SampleInt, 16, false, 1, PixelFormat::R16I},
+    {SampleInt, 16, false, 2, PixelFormat::RG16I},
+    {SampleInt, 16, true, 4, PixelFormat::RGBA16I},
+    {SampleInt, 32, false, 1, PixelFormat::R32I},
+    {SampleInt, 32, false, 2, PixelFormat::RG32I},
+    {SampleInt, 32, true, 3, PixelFormat::RGB32I},
+    {SampleInt, 32, true, 4, PixelFormat::RGBA32I},
+    {SampleFloat, 16, true, 4, PixelFormat::RGBA16F},
+    {SampleFloat, 32, false, 1, PixelFormat::L32F},
+    {SampleFloat, 32, true, 3, PixelFormat::RGB32F},
+    {SampleFloat, 32, true, 4, PixelFormat::RGBA32F},
+};
+
+// Samples of each pixel that are shown: gray (+ alpha), RGB (+ alpha) or a
+// palette index
+int GetShownSamples(int photometric, int samplesPerPixel) {
+  if (photometric == PhotometricRGB)
+    return std::min(samplesPerPixel, 4);
+  if (photometric == PhotometricPalette)
+    return 1;
+  return std::min(samplesPerPixel, 2);
+}
+
+} // namespace
+
+TIFFImage::TIFFImage() {}
+
+TIFFImage::~TIFFImage() {}
+
+bool TIFFImage::ReadDirectory(uint64_t offset, Page &page, uint64_t &next,
+                              bool &reduced) const {
+  Reader reader{m_file.GetData(), m_file.GetSize(), m_bigEndian};
+  const size_t countSize = m_bigTIFF ? 8 : 2;
+  const size_t entrySize = m_bigTIFF ? 20 : 12;
+  const size_t inlineSize = m_bigTIFF ? 8 : 4;
+  if (offset > reader.size || reader.size - offset < countSize)
+    return false;
+  uint64_t count = m_bigTIFF ? reader.U64(offset) : reader.U16(offset);
+  uint64_t entries = offset + countSize;
+  if (count > (reader.size - entries) / entrySize ||
+      reader.size - entries - count * entrySize < inlineSize)
+    return false;
+
+  reduced = false;
+  uint64_t rowsPerStrip = 0;
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t entry = entries + i * entrySize;
+    uint16_t tag = reader.U16(entry);
+    uint16_t type = reader.U16(entry + 2);
+    uint64_t valueCount =
+        m_bigTIFF ? reader.U64(entry + 4) : reader.U32(entry + 4);
+    uint64_t field = entry + (m_bigTIFF ? 12 : 8);
+    // Values that fit in the entry are stored in it
+    size_t typeSize = GetTypeSize(type);
+    uint64_t pos = field;
+    if (typeSize == 0 || valueCount > reader.size / typeSize)
+      continue;
+    if (valueCount * typeSize > inlineSize)
+      pos = m_bigTIFF ? reader.U64(field) : reader.U32(field);
+    if (tag != TagNewSubfileType && (tag < TagImageWidth ||
+                                     tag > TagSampleFormat))
+      continue;
+    if (!ReadValues(reader, type, valueCount, pos, values) || values.empty())
+      continue;
+
+    // Fields with one value per sample must agree on it
+    auto single = [&values]() -> int {
+      for (uint64_t v : values) {
+        if (v != values[0])
+          return -1;
+      }
+      return values[0] > 0xffff ? -1 : (int)values[0];
+    };
+    switch (tag) {
+    case TagNewSubfileType:
+      reduced = (values[0] & g_ReducedResolution) != 0;
+      break;
+    case TagImageWidth:
+      page.width = (int)std::min<uint64_t>(values[0], g_MaxDimension + 1);
+      break;
+    case TagImageLength:
+      page.height = (int)std::min<uint64_t>(values[0], g_MaxDimension + 1);
+      break;
+    case TagBitsPerSample:
+      page.bitsPerSample = single();
+      break;
+    case TagCompression:
+      page.compression = (int)values[0];
+      break;
+    case TagPhotometric:
+      page.photometric = (int)values[0];
+      break;
+    case TagStripOffsets:
+    case TagTileOffsets:
+      page.offsets = values;
+      page.tiled = tag == TagTileOffsets;
+      break;
+    case TagSamplesPerPixel:
+      page.samplesPerPixel = (int)std::min<uint64_t>(values[0], 0xffff);
+      break;
+    case TagRowsPerStrip:
+      rowsPerStrip = values[0];
+      break;
+    case TagStripByteCounts:
+    case TagTileByteCounts:
+      page.byteCounts = values;
+      break;
+    case TagPlanarConfig:
+      page.planar = values[0] == 2;
+      break;
+    case TagPredictor:
+      page.predictor = (int)values[0];
+      break;
+    case TagColorMap:
+      page.colorMap.assign(values.begin(), values.end());
+      break;
+    case TagTileWidth:
+      page.chunkWidth = (int)std::min<uint64_t>(values[0], g_MaxDimension);
+      break;
+    case TagTileLength:
+      page.chunkHeight = (int)std::min<uint64_t>(values[0], g_MaxDimension);
+      break;
+    case TagSampleFormat:
+      page.sampleFormat = single();
+      break;
+    }
+  }
+
+  if (!page.tiled) {
+    // Strips span the width; one strip holds the whole image by default
+    page.chunkWidth = page.width;
+    page.chunkHeight = rowsPerStrip == 0 || rowsPerStrip > (uint64_t)page.height
+                           ? page.height
+                           : (int)rowsPerStrip;
+  }
+  uint64_t nextField = entries + count * entrySize;
+  next = m_bigTIFF ? reader.U64(nextField) : reader.U32(nextField);
+  return true;
+}
+
+bool TIFFImage::PreparePage(Page &page, std::string &reason) const {
+  char text[128];
+  if (page.width <= 0 || page.height <= 0 ||
+      (uint64_t)page.width > g_MaxDimension ||
+      (uint64_t)page.height > g_MaxDimension || page.chunkWidth <= 0 ||
+      page.chunkHeight <= 0) {
+    reason = "invalid size";
+    return false;
+  }
+  if (page.compression != CompressionNone &&
+      page.compression != CompressionLZW &&
+      page.compression != CompressionDeflate &&
+      page.compression != CompressionDeflateOld &&
+      page.compression != CompressionPackBits) {
+    snprintf(text, sizeof(text), "compression %d", page.compression);
+    reason = text;
+    return false;
+  }
+
+  const int bits = page.bitsPerSample;
+  const int spp = page.samplesPerPixel;
+  bool validType =
+      page.sampleFormat == SampleFloat
+          ? bits == 16 || bits == 32 || bits == 64
+          : (page.sampleFormat == SampleUInt ||
+             page.sampleFormat == SampleInt) &&
+                (bits == 8 || bits == 16 || bits == 32);
+  if (!validType) {
+    snprintf(text, sizeof(text), "%d-bit samples of format %d", bits,
+             page.sampleFormat);
+    reason = text;
+    return false;
+  }
+  if (spp < 1 || (page.photometric == PhotometricRGB && spp < 3)) {
+    reason = "invalid samples per pixel";
+    return false;
+  }
+  if (page.photometric == PhotometricPalette) {
+    // Indices of 8 or 16 bits into a table of 16-bit R, G and B
+    if (page.sampleFormat != SampleUInt || bits > 16 ||
+        page.colorMap.size() < (size_t)3 << bits) {
+      reason = "invalid palette";
+      return false;
+    }
+  } else if (page.photometric != PhotometricMinIsWhite &&
+             page.photometric != PhotometricMinIsBlack &&
+             page.photometric != PhotometricRGB) {
+    snprintf(text, sizeof(text), "photometric interpretation %d",
+             page.photometric);
+    reason = text;
+    return false;
+  }
+  if (page.predictor != PredictorNone &&
+      page.predictor != PredictorHorizontal &&
+      !(page.predictor == PredictorFloat && page.sampleFormat == SampleFloat)) {
+    snprintf(text, sizeof(text), "predictor %d", page.predictor);
+    reason = text;
+    return false;
+  }
+
+  // Every strip or tile must be in the file
+  const int bytes = bits / 8;
+  const int planes = page.planar ? spp : 1;
+  uint64_t across = (page.width + page.chunkWidth - 1) / page.chunkWidth;
+  uint64_t down = (page.height + page.chunkHeight - 1) / page.chunkHeight;
+  uint64_t chunkCount = across * down * planes;
+  uint64_t chunkBytes = (uint64_t)page.chunkWidth * page.chunkHeight *
+                        (page.planar ? 1 : spp) * bytes;
+  if (chunkBytes > g_MaxChunkBytes || chunkCount > INT_MAX) {
+    reason = "strips or tiles too large";
+    return false;
+  }
+  // Offsets are read from the file, so checking them first bounds the
+  // byte counts made up for uncompressed files by the file size
+  if (page.offsets.size() < chunkCount) {
+    reason = "missing strip or tile offsets";
+    return false;
+  }
+  if (page.byteCounts.empty() && page.compression == CompressionNone)
+    page.byteCounts.assign((size_t)chunkCount, chunkBytes);
+  if (page.byteCounts.size() < chunkCount) {
+    reason = "missing strip or tile byte counts";
+    return false;
+  }
+  size_t size = m_file.GetSize();
+  for (uint64_t i = 0; i < chunkCount; i++) {
+    if (page.offsets[i] > size || page.byteCounts[i] > size - page.offsets[i]) {
+      reason = "truncated file";
+      return false;
+    }
+  }
+
+  // Layouts that match a PixelFormat are kept as they are
+  int shown = GetShownSamples(page.photometric, spp);
+  bool rgb = page.photometric == PhotometricRGB;
+  page.direct = false;
+  if (page.photometric == PhotometricMinIsBlack || rgb) {
+    for (const DirectFormat &format : g_DirectFormats) {
+      if (format.sampleFormat == page.sampleFormat && format.bits == bits &&
+          format.rgb == rgb && format.channels == shown) {
+        page.direct = true;
+        page.format = format.format;
+        break;
+      }
+    }
+  }
+
+  const char *type = page.sampleFormat == SampleFloat ? "float"
+                     : page.sampleFormat == SampleInt ? "int"
+                                                      : "uint";
+  snprintf(text, sizeof(text), "%s%d", type, bits);
+  page.pixelFormat = text;
+  if (page.photometric == PhotometricPalette)
+    page.pixelFormat += " palette";
+  else if (spp > 1)
+    page.pixelFormat += " x " + std::to_string(spp);
+  page.pixelFormat += std::string(", ") + GetCompressionName(page.compression);
+  if (page.predictor != PredictorNone)
+    page.pixelFormat += " + predictor";
+  if (page.tiled)
+    page.pixelFormat += ", tiled";
+  return true;
+}
+
+bool TIFFImage::Open(const std::string &filepath) {
+  PROFILE_SCOPE("TIFF Open");
+  m_pages.clear();
+
+  if (!m_file.Open(filepath)) {
+    LOG_ERROR("Failed to open TIFF file: %s", filepath.c_str());
+    return false;
+  }
+
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+  if (size < 8 || !((data[0] == 'I' && data[1] == 'I') ||
+                    (data[0] == 'M' && data[1] == 'M'))) {
+    LOG_ERROR("Not a TIFF file: %s", filepath.c_str());
+    return false;
+  }
+  m_bigEndian = data[0] == 'M';
+  Reader reader{data, size, m_bigEndian};
+  uint16_t version = reader.U16(2);
+  m_bigTIFF = version == 43;
+  uint64_t offset;
+  if (version == 42) {
+    offset = reader.U32(4);
+  } else if (m_bigTIFF && size >= 16 && reader.U16(4) == 8) {
+    offset = reader.U64(8);
+  } else {
+    LOG_ERROR("Not a TIFF file: %s", filepath.c_str());
+    return false;
+  }
+
+  std::set<uint64_t> visited;
+  std::string reason;
+  for (int i = 0; offset != 0 && i < g_MaxDirectories; i++) {
+    if (!visited.insert(offset).second)
+      break;
+    Page page;
+    bool reduced;
+    uint64_t next;
+    if (!ReadDirectory(offset, page, next, reduced)) {
+      LOG_ERROR("Truncated TIFF directory %d: %s", i, filepath.c_str());
+      break;
+    }
+    offset = next;
+    if (reduced)
+      continue;
+    if (!PreparePage(page, reason)) {
+      LOG("Skipping TIFF directory %d (%s): %s", i, reason.c_str(),
+          filepath.c_str());
+      continue;
+    }
+    m_pages.push_back(std::move(page));
+  }
+  if (m_pages.empty()) {
+    LOG_ERROR("No readable pages in TIFF file (%s): %s",
+              reason.empty() ? "no directories" : reason.c_str(),
+              filepath.c_str());
+    return false;
+  }
+
+  const Page &first = m_pages[0];
+  m_layout = SubresourceLayout();
+  m_layout.width = first.width;
+  m_layout.height = first.height;
+  m_layout.arraySize = (int)m_pages.size();
+  m_layout.format = "TIFF";
+  m_layout.pixelFormat = first.pixelFormat;
+  m_layout.channels = first.photometric == PhotometricPalette
+                          ? 3
+                          : GetShownSamples(first.photometric,
+                                            first.samplesPerPixel);
+  if (m_pages.size() > 1) {
+    for (size_t i = 0; i < m_pages.size(); i++)
+      m_layout.layerNames.push_back("Page " + std::to_string(i + 1));
+  }
+  LOG("TIFF: %dx%d, %zu page(s), %s", first.width, first.height,
+      m_pages.size(), first.pixelFormat.c_str());
+  return true;
+}
+
+bool TIFFImage::Decode(const SubresourceIndex &index, ImageData &out) {
+  PROFILE_SCOPE("TIFF Decode");
+  if (!m_layout.Contains(index))
+    return false;
+
+  const Page &page = m_pages[index.layer];
+  const int width = page.width;
+  const int height = page.height;
+  const int spp = page.samplesPerPixel;
+  const int bytes = page.bitsPerSample / 8;
+  const int chunkSamples = page.planar ? 1 : spp;
+  const size_t chunkRowBytes = (size_t)page.chunkWidth * chunkSamples * bytes;
+  const int across = (width + page.chunkWidth - 1) / page.chunkWidth;
+  const int down = (height + page.chunkHeight - 1) / page.chunkHeight;
+  const int chunksPerPlane = across * down;
+  const int shown = GetShownSamples(page.photometric, spp);
+  // Planes of samples that are not shown are not decoded
+  const int chunkCount = chunksPerPlane * (page.planar ? shown : 1);
+  const bool swap = m_bigEndian && bytes > 1 &&
+                    page.predictor != PredictorFloat;
+
+  out.width = width;
+  out.height = height;
+  out.channels = page.photometric == PhotometricPalette ? 3 : shown;
+  out.format = m_layout.format;
+  out.pixelFormat = page.pixelFormat;
+
+  uint8_t *directPixels = nullptr;
+  size_t pixelSize = 0;
+  ptrdiff_t pitch = 0;
+  float *floatPixels = nullptr;
+  if (page.direct) {
+    out.pixels = std::vector<float>();
+    {
+      PROFILE_SCOPE("Allocate");
+      out.stored = AllocatePixelBuffer(page.format, width, height,
+                                       directPixels);
+    }
+    pixelSize = GetPixelSize(page.format);
+    pitch = out.stored.rowPitch;
+  } else {
+    out.stored = PixelBuffer();
+    {
+      PROFILE_SCOPE("Allocate");
+      out.pixels.resize((size_t)width * height * 4);
+    }
+    floatPixels = out.pixels.data();
+  }
+
+  const uint8_t *data = m_file.GetData();
+  std::atomic<bool> failed(false);
+
+  struct Scratch {
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> temp;
+    std::vector<float> values;
+  };
+
+  auto decodeChunk = [&](int chunk, Scratch &scratch) {
+    const int plane = chunk / chunksPerPlane;
+    const int tile = chunk % chunksPerPlane;
+    const int x0 = (tile % across) * page.chunkWidth;
+    const int y0 = (tile / across) * page.chunkHeight;
+    // Tiles are stored whole; the last strip only has the rows left
+    const int storedRows =
+        page.tiled ? page.chunkHeight : std::min(page.chunkHeight,
+                                                 height - y0);
+    const int rows = std::min(page.chunkHeight, height - y0);
+    const int columns = std::min(page.chunkWidth, width - x0);
+    const size_t expected = chunkRowBytes * storedRows;
+
+    const size_t fileChunk = (size_t)plane * chunksPerPlane + tile;
+    const uint8_t *src = data + page.offsets[fileChunk];
+    size_t srcSize = (size_t)page.byteCounts[fileChunk];
+
+    const uint8_t *rowsData;
+    if (page.compression == CompressionNone && !swap &&
+        page.predictor == PredictorNone) {
+      // Viewed in the mapping, without a copy
+      if (srcSize < expected)
+        return false;
+      rowsData = src;
+    } else {
+      scratch.chunk.resize(expected);
+      uint8_t *dst = scratch.chunk.data();
+      size_t produced;
+      switch (page.compression) {
+      case CompressionLZW:
+        // Old-style (LSB-first) LZW is not read
+        if (srcSize >= 2 && src[0] == 0 && (src[1] & 1))
+          return false;
+        produced = DecodeLZW(src, srcSize, dst, expected);
+        break;
+      case CompressionDeflate:
+      case CompressionDeflateOld:
+        produced = DecodeDeflate(src, srcSize, dst, expected);
+        break;
+      case CompressionPackBits:
+        produced = DecodePackBits(src, srcSize, dst, expected);
+        break;
+      default:
+        produced = std::min(srcSize, expected);
+        memcpy(dst, src, produced);
+        break;
+      }
+      if (produced < expected)
+        return false;
+
+      if (swap)
+        SwapBytes(dst, expected, bytes);
+      size_t rowSamples = (size_t)page.chunkWidth * chunkSamples;
+      for (int y = 0; y < storedRows; y++) {
+        uint8_t *row = dst + chunkRowBytes * y;
+        if (page.predictor == PredictorHorizontal)
+          UndoHorizontalPredictor(row, rowSamples, chunkSamples, bytes);
+        else if (page.predictor == PredictorFloat)
+          UndoFloatPredictor(row, rowSamples, chunkSamples, bytes,
+                             scratch.temp);
+      }
+      rowsData = dst;
+    }
+
+    for (int y = 0; y < rows; y++) {
+      const uint8_t *row = rowsData + chunkRowBytes * y;
+      const int imageY = y0 + y;
+
+      if (directPixels) {
+        uint8_t *dst = directPixels + pitch * imageY + pixelSize * x0;
+        if (page.planar) {
+          // One sample per pixel into its channel
+          for (int x = 0; x < columns; x++)
+            memcpy(dst + pixelSize * x + (size_t)bytes * plane,
+                   row + (size_t)bytes * x, bytes);
+        } else if ((size_t)spp * bytes == pixelSize) {
+          memcpy(dst, row, pixelSize * columns);
+        } else {
+          // Extra samples are dropped
+          for (int x = 0; x < columns; x++)
+            memcpy(dst + pixelSize * x, row + (size_t)spp * bytes * x,
+                   pixelSize);
+        }
+        continue;
+      }
+
+      float *dst = floatPixels + ((size_t)imageY * width + x0) * 4;
+      if (page.photometric == PhotometricPalette) {
+        const size_t colors = (size_t)1 << page.bitsPerSample;
+        for (int x = 0; x < columns; x++) {
+          size_t i = bytes == 1 ? row[x] : ((const uint16_t *)row)[x];
+          for (int c = 0; c < 3; c++)
+            dst[x * 4 + c] = page.colorMap[c * colors + i] / 65535.0f;
+          dst[x * 4 + 3] = 1.0f;
+        }
+        continue;
+      }
+
+      size_t count = (size_t)columns * chunkSamples;
+      scratch.values.resize(count);
+      float *values = scratch.values.data();
+      ReadSamples(row, page.sampleFormat, page.bitsPerSample, count, values);
+      if (page.photometric == PhotometricMinIsWhite &&
+          (!page.planar || plane == 0)) {
+        // Only the gray sample is inverted, not alpha
+        for (size_t i = 0; i < count; i += chunkSamples)
+          values[i] = 1.0f - values[i];
+      }
+
+      const bool rgb = page.photometric == PhotometricRGB;
+      for (int x = 0; x < columns; x++) {
+        float *pixel = dst + x * 4;
+        if (page.planar) {
+          float v = values[x];
+          if (plane == 0 && !rgb) {
+            pixel[0] = pixel[1] = pixel[2] = v;
+          } else if (plane == shown - 1 && shown == (rgb ? 4 : 2)) {
+            pixel[3] = v;
+          } else {
+            pixel[plane] = v;
+          }
+          if (plane == 0 && shown < (rgb ? 4 : 2))
+            pixel[3] = 1.0f;
+          continue;
+        }
+        const float *s = values + (size_t)x * spp;
+        if (rgb) {
+          pixel[0] = s[0];
+          pixel[1] = s[1];
+          pixel[2] = s[2];
+          pixel[3] = shown == 4 ? s[3] : 1.0f;
+        } else {
+          pixel[0] = pixel[1] = pixel[2] = s[0];
+          pixel[3] = shown == 2 ? s[1] : 1.0f;
+        }
+      }
+    }
+    return true;
+  };
+
+  {
+    PROFILE_SCOPE("TIFF Chunks");
+    ParallelFor(chunkCount, m_threadCount, [&](int begin, int end) {
+      Scratch scratch;
+      for (int i = begin; i < end && !failed; i++) {
+        if (!decodeChunk(i, scratch))
+          failed = true;
+      }
+    });
+  }
+
+  if (failed) {
+    LOG_ERROR("TIFF page %d is truncated or corrupt", index.layer + 1);
+    out.pixels = std::vector<float>();
+    out.stored = PixelBuffer();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "ImageSource.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief TIFF image read through a memory mapping.
+ *
+ * Open() parses the image file directories (IFDs) only. Each full
+ * resolution page is exposed as an array layer; reduced-resolution
+ * subfiles (thumbnails, pyramid levels) are skipped. Decode() decompresses
+ * the strips or tiles of one page in parallel and writes each straight to
+ * its place in the result.
+ *
+ * Classic and BigTIFF files of either byte order are read, in strips or
+ * tiles, chunky or planar, uncompressed or with LZW, Deflate or PackBits
+ * compression and the horizontal or floating-point predictor. Samples may
+ * be 8, 16 or 32-bit integers or 16, 32 or 64-bit floats. Layouts that
+ * match a PixelFormat (such as L8, RGB16, L32F, RGBA16F or R32UI) stay in
+ * it; gray with alpha, palette, MinIsWhite, double and other layouts are
+ * converted to RGBA32F. Samples past the fourth are ignored.
+ */
+class TIFFImage : public ImageSource {
+public:
+  TIFFImage();
+  ~TIFFImage() override;
+
+  /**
+   * @brief Maps the file and reads its directories.
+   * @return False if the file is not a TIFF file or has no page this reader
+   * can decode.
+   */
+  bool Open(const std::string &filepath);
+
+  const SubresourceLayout &GetLayout() const override { return m_layout; }
+
+  bool Decode(const SubresourceIndex &index, ImageData &out) override;
+
+  /**
+   * @brief Sets the number of threads used by Decode() (0 = hardware
+   * threads).
+   */
+  void SetThreadCount(int threadCount) { m_threadCount = threadCount; }
+
+private:
+  struct Page {
+    int width = 0;
+    int height = 0;
+    int samplesPerPixel = 1;
+    int bitsPerSample = 1;
+    int sampleFormat = 1; ///< 1 = unsigned, 2 = signed, 3 = float
+    int photometric = 1;  ///< 0 = MinIsWhite, 1 = MinIsBlack, 2 = RGB, ...
+    int compression = 1;
+    int predictor = 1; ///< 1 = none, 2 = horizontal, 3 = floating point
+    bool planar = false; ///< One plane per sample instead of interleaved
+    bool tiled = false;
+    int chunkWidth = 0;  ///< Tile width, or the image width for strips
+    int chunkHeight = 0; ///< Tile height, or rows per strip
+    std::vector<uint64_t> offsets;    ///< Strip or tile offsets in the file
+    std::vector<uint64_t> byteCounts; ///< Stored size of each strip or tile
+    std::vector<uint16_t> colorMap;   ///< R, then G, then B of palettes
+    bool direct = false;  ///< Kept in `format` instead of RGBA32F
+    PixelFormat format = PixelFormat::RGBA32F;
+    std::string pixelFormat; ///< Description shown in the Info panel
+  };
+
+  /**
+   * @brief Reads the directory at offset into page and gets the offset of
+   * the next one (0 at the end).
+   * @return False if the directory is truncated.
+   */
+  bool ReadDirectory(uint64_t offset, Page &page, uint64_t &next,
+                     bool &reduced) const;
+
+  /**
+   * @brief Checks that a page is a layout this reader decodes and picks the
+   * format it is kept in.
+   * @return False with a reason if it is not.
+   */
+  bool PreparePage(Page &page, std::string &reason) const;
+
+  MappedFile m_file;
+  SubresourceLayout m_layout;
+  bool m_bigEndian = false;
+  bool m_bigTIFF = false;
+  std::vector<Page> m_pages;
+  int m_threadCount = 0;
+};
@@ -0,0 +1,503 @@
+#include "YUVImage.h"
+#include "Logger.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YUV_IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum class PlaneLayout {
+  Planar,     ///< Y, U and V planes
+  SemiPlanar, ///< Y plane, then one plane of U/V pairs
+  Packed,     ///< Y0 U Y1 V
+};
+
+struct YUVFormatInfo {
+  const char *name;
+  PlaneLayout layout;
+  int sampleSize; ///< Bytes per sample
+  int bits;       ///< Bits of each code
+  int shift;      ///< Position of the code in its sample
+  bool halfHeight; ///< Chroma has half as many rows as luma
+};
+
+const YUVFormatInfo g_YUVFormats[] = {
+    {"None", PlaneLayout::Planar, 1, 8, 0, true},
+    {"I420", PlaneLayout::Planar, 1, 8, 0, true},
+    {"I420P10", PlaneLayout::Planar, 2, 10, 0, true},
+    {"NV12", PlaneLayout::SemiPlanar, 1, 8, 0, true},
+    {"P010", PlaneLayout::SemiPlanar, 2, 10, 6, true},
+    {"YUY2", PlaneLayout::Packed, 1, 8, 0, false},
+};
+
+const int g_YUVFormatCount = sizeof(g_YUVFormats) / sizeof(g_YUVFormats[0]);
+
+// The Y4M header line is short; anything longer is not a Y4M file
+const size_t g_MaxY4MLine = 1024;
+
+const YUVFormatInfo &GetInfo(YUVFormat format) {
+  return g_YUVFormats[(int)format];
+}
+
+// Bytes per row of the Y plane (or of the packed pixels) when tightly packed
+uint64_t GetPackedLumaPitch(const YUVFormatInfo &info, int width) {
+  if (info.layout == PlaneLayout::Packed)
+    return (uint64_t)(width + 1) / 2 * 4;
+  return (uint64_t)width * info.sampleSize;
+}
+
+// Planar chroma rows are half the Y pitch, rounded up to whole samples so
+// the (width + 1) / 2 samples of odd widths fit
+uint64_t GetChromaPitch(const YUVFormatInfo &info, int width,
+                        uint64_t rowPitch) {
+  uint64_t chromaWidth = (uint64_t)(width + 1) / 2;
+  switch (info.layout) {
+  case PlaneLayout::Planar:
+    return rowPitch ? (rowPitch / info.sampleSize + 1) / 2 * info.sampleSize
+                    : chromaWidth * info.sampleSize;
+  case PlaneLayout::SemiPlanar:
+    return rowPitch ? rowPitch : chromaWidth * 2 * info.sampleSize;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * Where the planes of one frame are, and how to read codes from them.
+ */
+struct FramePlanes {
+  const YUVFormatInfo &info;
+  const uint8_t *data;
+  int width;
+  int height;
+  uint64_t lumaPitch;
+  uint64_t chromaPitch;
+
+  int GetChromaWidth() const { return (width + 1) / 2; }
+  int GetChromaHeight() const {
+    return info.halfHeight ? (height + 1) / 2 : height;
+  }
+
+  uint16_t ReadSample(const uint8_t *src, size_t index) const {
+    if (info.sampleSize == 1)
+      return src[index];
+    uint16_t value;
+    memcpy(&value, src + index * 2, sizeof(value));
+    return (uint16_t)(value >> info.shift);
+  }
+
+  void ReadLumaRow(int y, uint16_t *luma) const {
+    const uint8_t *row = data + lumaPitch * y;
+    if (info.layout == PlaneLayout::Packed) {
+      for (int x = 0; x < width; x++)
+        luma[x] = row[x * 2];
+    } else if (info.sampleSize == 1) {
+      for (int x = 0; x < width; x++)
+        luma[x] = row[x];
+    } else {
+      for (int x = 0; x < width; x++)
+        luma[x] = ReadSample(row, x);
+    }
+  }
+
+  void ReadChromaRow(int cy, uint16_t *cb, uint16_t *cr) const {
+    int chromaWidth = GetChromaWidth();
+    const uint8_t *chroma = data + lumaPitch * height;
+    switch (info.layout) {
+    case PlaneLayout::Planar: {
+      const uint8_t *u = chroma + chromaPitch * cy;
+      const uint8_t *v = chroma + chromaPitch * (GetChromaHeight() + cy);
+      for (int x = 0; x < chromaWidth; x++) {
+        cb[x] = ReadSample(u, x);
+        cr[x] = ReadSample(v, x);
+      }
+      break;
+    }
+    case PlaneLayout::SemiPlanar: {
+      const uint8_t *uv = chroma + chromaPitch * cy;
+      for (int x = 0; x < chromaWidth; x++) {
+        cb[x] = ReadSample(uv, (size_t)x * 2);
+        cr[x] = ReadSample(uv, (size_t)x * 2 + 1);
+      }
+      break;
+    }
+    case PlaneLayout::Packed: {
+      const uint8_t *row = data + lumaPitch * cy;
+      for (int x = 0; x < chromaWidth; x++) {
+        cb[x] = row[x * 4 + 1];
+        cr[x] = row[x * 4 + 3];
+      }
+      break;
+    }
+    }
+  }
+};
+
+// Codes to RGB: Y' = Y * yScale + yOffset (same for Cb/Cr with cScale and
+// cOffset), then R = Y' + rCr Cr', G = Y' + gCb Cb' + gCr Cr',
+// B = Y' + bCb Cb'
+struct YUVCoefficients {
+  float yScale, yOffset, cScale, cOffset;
+  float rCr, gCb, gCr, bCb;
+};
+
+YUVCoefficients GetCoefficients(const YUVSettings &settings, int bits) {
+  static const float s_Kr[] = {0.299f, 0.2126f, 0.2627f};
+  static const float s_Kb[] = {0.114f, 0.0722f, 0.0593f};
+  float kr = s_Kr[(int)settings.matrix];
+  float kb = s_Kb[(int)settings.matrix];
+  float kg = 1.0f - kr - kb;
+
+  YUVCoefficients k;
+  float step = (float)(1 << (bits - 8)); // One 8-bit code
+  if (settings.fullRange) {
+    float maxCode = (float)((1 << bits) - 1);
+    k.yScale = 1.0f / maxCode;
+    k.yOffset = 0.0f;
+    k.cScale = 1.0f / maxCode;
+    k.cOffset = -(float)(1 << (bits - 1)) / maxCode;
+  } else {
+    k.yScale = 1.0f / (219.0f * step);
+    k.yOffset = -16.0f / 219.0f;
+    k.cScale = 1.0f / (224.0f * step);
+    k.cOffset = -128.0f / 224.0f;
+  }
+  k.rCr = 2.0f * (1.0f - kr);
+  k.gCb = -2.0f * kb * (1.0f - kb) / kg;
+  k.gCr = -2.0f * kr * (1.0f - kr) / kg;
+  k.bCb = 2.0f * (1.0f - kb);
+  return k;
+}
+
+inline void ConvertYUVPixel(uint16_t y, uint16_t cb, uint16_t cr,
+                            const YUVCoefficients &k, float *rgba) {
+  float luma = y * k.yScale + k.yOffset;
+  float u = cb * k.cScale + k.cOffset;
+  float v = cr * k.cScale + k.cOffset;
+  rgba[0] = luma + k.rCr * v;
+  rgba[1] = luma + k.gCb * u + k.gCr * v;
+  rgba[2] = luma + k.bCb * u;
+  rgba[3] = 1.0f;
+}
+
+// Converts one row of codes to RGBA32F; chroma has one code per two pixels
+void ConvertYUVRow(const uint16_t *luma, const uint16_t *cb,
+                   const uint16_t *cr, int width, const YUVCoefficients &k,
+                   float *dst) {
+  int x = 0;
+#ifdef YUV_IMAGE_SSE2
+  // Four pixels per step: widen the codes, scale, transpose to RGBA
+  const __m128i vZero = _mm_setzero_si128();
+  const __m128 vYScale = _mm_set1_ps(k.yScale);
+  const __m128 vYOffset = _mm_set1_ps(k.yOffset);
+  const __m128 vCScale = _mm_set1_ps(k.cScale);
+  const __m128 vCOffset = _mm_set1_ps(k.cOffset);
+  const __m128 vRCr = _mm_set1_ps(k.rCr);
+  const __m128 vGCb = _mm_set1_ps(k.gCb);
+  const __m128 vGCr = _mm_set1_ps(k.gCr);
+  const __m128 vBCb = _mm_set1_ps(k.bCb);
+  auto loadChroma = [&](const uint16_t *src) {
+    int32_t pair;
+    memcpy(&pair, src, sizeof(pair));
+    __m128i v = _mm_cvtsi32_si128(pair);
+    v = _mm_unpacklo_epi16(v, v); // c0 c0 c1 c1
+    __m128 codes = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, vZero));
+    return _mm_add_ps(_mm_mul_ps(codes, vCScale), vCOffset);
+  };
+  for (; x + 4 <= width; x += 4) {
+    __m128i y16 = _mm_loadl_epi64((const __m128i *)(luma + x));
+    __m128 vY = _mm_cvtepi32_ps(_mm_unpacklo_epi16(y16, vZero));
+    vY = _mm_add_ps(_mm_mul_ps(vY, vYScale), vYOffset);
+    __m128 vU = loadChroma(cb + x / 2);
+    __m128 vV = loadChroma(cr + x / 2);
+
+    __m128 vR = _mm_add_ps(vY, _mm_mul_ps(vRCr, vV));
+    __m128 vG = _mm_add_ps(
+        vY, _mm_add_ps(_mm_mul_ps(vGCb, vU), _mm_mul_ps(vGCr, vV)));
+    __m128 vB = _mm_add_ps(vY, _mm_mul_ps(vBCb, vU));
+    __m128 vA = _mm_set1_ps(1.0f);
+    _MM_TRANSPOSE4_PS(vR, vG, vB, vA);
+    float *out = dst + (size_t)x * 4;
+    _mm_storeu_ps(out, vR);
+    _mm_storeu_ps(out + 4, vG);
+    _mm_storeu_ps(out + 8, vB);
+    _mm_storeu_ps(out + 12, vA);
+  }
+#endif
+  for (; x < width; x++)
+    ConvertYUVPixel(luma[x], cb[x / 2], cr[x / 2], k, dst + (size_t)x * 4);
+}
+
+// Parses the integer at the start of text; false if there is none
+bool ParseInt(const char *text, long &value, const char **end = nullptr) {
+  char *stop;
+  value = strtol(text, &stop, 10);
+  if (end)
+    *end = stop;
+  return stop != text;
+}
+
+} // namespace
+
+const char *GetYUVFormatName(YUVFormat format) {
+  return GetInfo(format).name;
+}
+
+bool FindYUVFormat(const std::string &name, YUVFormat &format) {
+  std::string upper = name;
+  std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+  for (int i = 1; i < g_YUVFormatCount; i++) {
+    if (upper == g_YUVFormats[i].name) {
+      format = (YUVFormat)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t GetYUVFrameSize(YUVFormat format, int width, int height,
+                         uint64_t rowPitch) {
+  const YUVFormatInfo &info = GetInfo(format);
+  if (format == YUVFormat::None || width <= 0 || height <= 0)
+    return 0;
+  uint64_t lumaPitch = rowPitch ? rowPitch : GetPackedLumaPitch(info, width);
+  uint64_t chromaPitch = GetChromaPitch(info, width, rowPitch);
+  uint64_t chromaHeight = info.halfHeight ? (height + 1) / 2 : height;
+  uint64_t chromaPlanes = info.layout == PlaneLayout::Planar ? 2 : 1;
+  return lumaPitch * height + chromaPitch * chromaHeight * chromaPlanes;
+}
+
+YUVImage::YUVImage() {}
+
+YUVImage::~YUVImage() {}
+
+void YUVImage::SetLayout(YUVFormat format, int width, int height,
+                         uint64_t rowPitch) {
+  const YUVFormatInfo &info = GetInfo(format);
+  m_format = format;
+  m_width = width;
+  m_height = height;
+  m_lumaPitch = rowPitch ? rowPitch : GetPackedLumaPitch(info, width);
+  m_chromaPitch = GetChromaPitch(info, width, rowPitch);
+
+  // HD and larger video is usually BT.709, 10-bit UHD BT.2020
+  m_settings = YUVSettings();
+  if (info.bits > 8 && width >= 3840)
+    m_settings.matrix = YUVMatrix::BT2020;
+  else if (width >= 1280 || height >= 720)
+    m_settings.matrix = YUVMatrix::BT709;
+  else
+    m_settings.matrix = YUVMatrix::BT601;
+}
+
+bool YUVImage::OpenY4M(const std::string &filepath) {
+  PROFILE_SCOPE("YUVImage::OpenY4M");
+  if (!m_file.Open(filepath))
+    return false;
+  const uint8_t *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+
+  static const char s_Magic[] = "YUV4MPEG2 ";
+  const size_t magicSize = sizeof(s_Magic) - 1;
+  if (size < magicSize || memcmp(data, s_Magic, magicSize) != 0)
+    return false;
+  const uint8_t *end = (const uint8_t *)memchr(
+      data, '\n', std::min(size, g_MaxY4MLine));
+  if (!end)
+    return false;
+
+  // Space separated tags, each a letter followed by its value
+  std::string header((const char *)data + magicSize, (const char *)end);
+  long width = 0, height = 0, rateNum = 0, rateDen = 0;
+  std::string colorspace = "420jpeg";
+  bool fullRange = false;
+  size_t pos = 0;
+  while (pos < header.size()) {
+    size_t space = header.find(' ', pos);
+    if (space == std::string::npos)
+      space = header.size();
+    std::string tag = header.substr(pos, space - pos);
+    pos = space + 1;
+    if (tag.empty())
+      continue;
+
+    const char *value = tag.c_str() + 1;
+    const char *rest;
+    switch (tag[0]) {
+    case 'W':
+      ParseInt(value, width);
+      break;
+    case 'H':
+      ParseInt(value, height);
+      break;
+    case 'F':
+      if (ParseInt(value, rateNum, &rest) && *rest == ':')
+        ParseInt(rest + 1, rateDen);
+      break;
+    case 'C':
+      colorspace = value;
+      break;
+    case 'X':
+      if (tag == "XCOLORRANGE=FULL")
+        fullRange = true;
+      break;
+    }
+  }
+
+  YUVFormat format;
+  if (colorspace == "420jpeg" || colorspace == "420mpeg2" ||
+      colorspace == "420paldv" || colorspace == "420") {
+    format = YUVFormat::I420;
+  } else if (colorspace == "420p10") {
+    format = YUVFormat::I420P10;
+  } else {
+    LOG_ERROR("Unsupported Y4M colorspace C%s: %s", colorspace.c_str(),
+              filepath.c_str());
+    return false;
+  }
+  if (width <= 0 || height <= 0 || width > 65536 || height > 65536)
+    return false;
+  SetLayout(format, (int)width, (int)height, 0);
+  m_settings.fullRange = fullRange;
+  if (rateNum > 0 && rateDen > 0)
+    m_frameDuration = (double)rateDen / rateNum;
+
+  // Each frame is "FRAME", optional tags and a newline, then the planes
+  uint64_t frameSize = GetYUVFrameSize(format, m_width, m_height);
+  size_t offset = end - data + 1;
+  while (size - offset >= 5 && memcmp(data + offset, "FRAME", 5) == 0) {
+    const uint8_t *lineEnd = (const uint8_t *)memchr(
+        data + offset, '\n', std::min(size - offset, g_MaxY4MLine));
+    if (!lineEnd)
+      break;
+    offset = lineEnd - data + 1;
+    if (size - offset < frameSize)
+      break;
+    m_frames.push_back(offset);
+    offset += frameSize;
+  }
+
+  if (m_frames.empty()) {
+    LOG_ERROR("Y4M file has no complete frame: %s", filepath.c_str());
+    return false;
+  }
+  m_y4m = true;
+  LOG("Mapped Y4M %dx%d %s, %zu frames", m_width, m_height,
+      GetYUVFormatName(format), m_frames.size());
+  return true;
+}
+
+bool YUVImage::OpenRaw(const std::string &filepath, YUVFormat format,
+                       int width, int height, uint64_t rowPitch,
+                       uint64_t offset) {
+  PROFILE_SCOPE("YUVImage::OpenRaw");
+  // Semi-planar chroma rows share the pitch and are longer for odd widths
+  const YUVFormatInfo &info = GetInfo(format);
+  if (format == YUVFormat::None || width <= 0 || height <= 0 ||
+      (rowPitch && rowPitch < std::max(GetPackedLumaPitch(info, width),
+                                       GetChromaPitch(info, width, 0))))
+    return false;
+  if (!m_file.Open(filepath)) {
+    LOG_ERROR("Failed to open raw file: %s", filepath.c_str());
+    return false;
+  }
+
+  SetLayout(format, width, height, rowPitch);
+  uint64_t frameSize = GetYUVFrameSize(format, width, height, rowPitch);
+  uint64_t size = m_file.GetSize();
+  for (uint64_t pos = offset; pos <= size && size - pos >= frameSize;
+       pos += frameSize)
+    m_frames.push_back(pos);
+
+  if (m_frames.empty()) {
+    LOG_ERROR("%dx%d %s frame does not fit %s (%llu bytes)", width, height,
+              GetYUVFormatName(format), filepath.c_str(),
+              (unsigned long long)size);
+    return false;
+  }
+  LOG("Mapped raw %dx%d %s, %zu frames", width, height,
+      GetYUVFormatName(format), m_frames.size());
+  return true;
+}
+
+bool YUVImage::DecodeFrame(int frame, ImageData &out) {
+  PROFILE_SCOPE("YUVImage::DecodeFrame");
+  if (frame < 0 || frame >= GetFrameCount())
+    return false;
+
+  const YUVFormatInfo &info = GetInfo(m_format);
+  FramePlanes planes = {info,    m_file.GetData() + m_frames[frame],
+                        m_width, m_height,
+                        m_lumaPitch, m_chromaPitch};
+  int chromaWidth = planes.GetChromaWidth();
+  uint8_t *dst;
+
+  if (m_settings.plane == YUVPlane::RGB) {
+    YUVCoefficients k = GetCoefficients(m_settings, info.bits);
+    out.stored =
+        AllocatePixelBuffer(PixelFormat::RGBA32F, m_width, m_height, dst);
+    ptrdiff_t pitch = out.stored.rowPitch;
+    ParallelFor(m_height, m_threadCount, [&](int begin, int end) {
+      std::vector<uint16_t> luma(m_width), cb(chromaWidth), cr(chromaWidth);
+      for (int y = begin; y < end; y++) {
+        planes.ReadLumaRow(y, luma.data());
+        planes.ReadChromaRow(info.halfHeight ? y / 2 : y, cb.data(),
+                             cr.data());
+        ConvertYUVRow(luma.data(), cb.data(), cr.data(), m_width, k,
+                      (float *)(dst + pitch * y));
+      }
+    });
+    out.width = m_width;
+    out.height = m_height;
+    out.channels = 3;
+    out.pixelFormat = info.name;
+  } else {
+    // Codes of one plane, at the plane's size
+    bool luma = m_settings.plane == YUVPlane::Y;
+    int width = luma ? m_width : chromaWidth;
+    int height = luma ? m_height : planes.GetChromaHeight();
+    bool wide = info.bits > 8;
+    out.stored = AllocatePixelBuffer(wide ? PixelFormat::L16 : PixelFormat::L8,
+                                     width, height, dst);
+    ptrdiff_t pitch = out.stored.rowPitch;
+    int shift = 16 - info.bits;
+    ParallelFor(height, m_threadCount, [&](int begin, int end) {
+      std::vector<uint16_t> codes(width), other(width);
+      for (int y = begin; y < end; y++) {
+        if (luma)
+          planes.ReadLumaRow(y, codes.data());
+        else if (m_settings.plane == YUVPlane::U)
+          planes.ReadChromaRow(y, codes.data(), other.data());
+        else
+          planes.ReadChromaRow(y, other.data(), codes.data());
+
+        uint8_t *row = dst + pitch * y;
+        for (int x = 0; x < width; x++) {
+          if (wide) {
+            uint16_t value = (uint16_t)(codes[x] << shift);
+            memcpy(row + x * 2, &value, sizeof(value));
+          } else {
+            row[x] = (uint8_t)codes[x];
+          }
+        }
+      }
+    });
+    static const char *s_PlaneNames[] = {"", "Y", "U", "V"};
+    out.width = width;
+    out.height = height;
+    out.channels = 1;
+    out.pixelFormat = std::string(info.name) + " " +
+                      s_PlaneNames[(int)m_settings.plane];
+  }
+  out.format = m_y4m ? "Y4M" : "YUV";
+  return true;
+}
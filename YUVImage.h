@@ -0,0 +1,129 @@
+#pragma once
+#include "FrameSource.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Planar and packed YUV layouts of video frames.
+ */
+enum class YUVFormat {
+  None,    ///< Not a YUV layout
+  I420,    ///< 8-bit Y plane, then U and V planes at half width and height
+  I420P10, ///< I420 with 16-bit little-endian samples holding 10 bits
+  NV12,    ///< 8-bit Y plane, then interleaved UV at half width and height
+  P010,    ///< NV12 with 16-bit little-endian samples, 10 bits at the top
+  YUY2,    ///< 8-bit Y0 U Y1 V for each pair of pixels
+};
+
+/// Color matrix of the YUV to RGB conversion
+enum class YUVMatrix { BT601, BT709, BT2020 };
+
+/// What a YUV frame is shown as
+enum class YUVPlane { RGB, Y, U, V };
+
+/**
+ * @brief How YUV frames are converted for display.
+ */
+struct YUVSettings {
+  YUVMatrix matrix = YUVMatrix::BT709;
+  bool fullRange = false; ///< Codes use the full range instead of 16-235
+  YUVPlane plane = YUVPlane::RGB;
+};
+
+/**
+ * @brief Gets the display name of a format (e.g., "NV12").
+ */
+const char *GetYUVFormatName(YUVFormat format);
+
+/**
+ * @brief Looks up a format by its display name (case-insensitive).
+ * @return False if no YUV format has this name.
+ */
+bool FindYUVFormat(const std::string &name, YUVFormat &format);
+
+/**
+ * @brief Gets the number of bytes of one frame.
+ * @param rowPitch Bytes per row of the Y plane (0 = tightly packed); the
+ * chroma rows of planar formats are half as long, rounded up to a sample.
+ */
+uint64_t GetYUVFrameSize(YUVFormat format, int width, int height,
+                         uint64_t rowPitch = 0);
+
+/**
+ * @brief Frames of YUV video: Y4M files and headerless dumps, read through a
+ * memory mapping.
+ *
+ * Frames are converted to RGBA32F row by row in parallel, with SSE2 for the
+ * color matrix. Chroma is not interpolated; each chroma sample covers the
+ * pixels it was subsampled from. Values outside [0, 1] (from codes outside
+ * the limited range) are kept. With a plane selected, the frame shows the
+ * codes of that plane alone (L8, or L16 with 10-bit codes at the top), at
+ * the plane's own size.
+ */
+class YUVImage : public FrameSource {
+public:
+  YUVImage();
+  ~YUVImage() override;
+
+  /**
+   * @brief Maps a YUV4MPEG2 file and indexes its frames.
+   *
+   * 4:2:0 8-bit ("C420jpeg", "C420mpeg2", "C420paldv", "C420") and 10-bit
+   * ("C420p10") files are read. XCOLORRANGE=FULL selects full range.
+   * @return False if the file is not such a file or has no complete frame.
+   */
+  bool OpenY4M(const std::string &filepath);
+
+  /**
+   * @brief Maps a headerless dump of frames stored back to back.
+   * @param rowPitch Bytes per row of the Y plane (0 = tightly packed); at
+   * least a row of luma and, for NV12 and P010, of interleaved chroma.
+   * @param offset Bytes before the first frame.
+   * @return False if the file does not hold a single frame or the pitch is
+   * too small.
+   */
+  bool OpenRaw(const std::string &filepath, YUVFormat format, int width,
+               int height, uint64_t rowPitch, uint64_t offset);
+
+  /**
+   * @brief Gets the settings: a guess from the size and header after
+   * opening, until changed.
+   */
+  const YUVSettings &GetSettings() const { return m_settings; }
+  void SetSettings(const YUVSettings &settings) { m_settings = settings; }
+
+  /**
+   * @brief Sets the number of threads used by DecodeFrame() (0 = hardware
+   * threads).
+   */
+  void SetThreadCount(int threadCount) { m_threadCount = threadCount; }
+
+  YUVFormat GetFormat() const { return m_format; }
+  int GetWidth() const { return m_width; }
+  int GetHeight() const { return m_height; }
+
+  int GetFrameCount() const override { return (int)m_frames.size(); }
+  double GetFrameDuration(int) const override { return m_frameDuration; }
+  bool DecodeFrame(int frame, ImageData &out) override;
+
+private:
+  /**
+   * @brief Sets the plane pitches and guesses the settings once the format
+   * and size are known.
+   */
+  void SetLayout(YUVFormat format, int width, int height, uint64_t rowPitch);
+
+  MappedFile m_file;
+  YUVFormat m_format = YUVFormat::None;
+  int m_width = 0;
+  int m_height = 0;
+  uint64_t m_lumaPitch = 0;
+  uint64_t m_chromaPitch = 0;
+  std::vector<uint64_t> m_frames; ///< Offsets of the frames in the file
+  double m_frameDuration = 0.0;   ///< Seconds; 0 for dumps
+  bool m_y4m = false;
+  YUVSettings m_settings;
+  int m_threadCount = 0;
+};
@@ -1,21 +1,25 @@
-#ifndef PCH_H
-#define PCH_H
-
-#include "framework.h"
-
-// C++ Standard Library
-#include <string>
-#include <vector>
-#include <algorithm>
-#include <cmath>
-
-// DirectX
-#include <wrl.h>
-#include <d3d12.h>
-#include <dxgi.h>
-#include <dxgi1_4.h>
-#include <dxgi1_6.h>
-#include <d3dcompiler.h>
-#include <DirectXMath.h>
-
-#endif //PCH_H
+#ifndef PCH_H
+#define PCH_H
+
+#ifdef _WIN32
+#include "framework.h"
+#endif
+
+// C++ Standard Library
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// DirectX (headless builds use the stand-ins from HeadlessRenderer.h)
+#if defined(_WIN32) && !defined(IMGVIEWER_HEADLESS)
+#include <wrl.h>
+#include <d3d12.h>
+#include <dxgi.h>
+#include <dxgi1_4.h>
+#include <dxgi1_6.h>
+#include <d3dcompiler.h>
+#endif
+#include <DirectXMath.h>
+
+#endif //PCH_H